@@ -0,0 +1,22 @@
+#!/usr/bin/env bash
+
+set -ex
+
+# Local, offline alternative to x86-runs-zstd.sh: runs the same benchmarks
+# through libzstd with software-hostbench (lzbench's methodology) on this
+# machine, and writes the baseline CSV draw-plot-zstd.py takes as --xeon-csv.
+
+THISDIR=$(pwd)
+BENCH_DIR=$THISDIR/../software/benchmarks/HyperCompressBench/extracted_benchmarks
+HOSTBENCH_DIR=$THISDIR/../software-hostbench
+
+make -C $HOSTBENCH_DIR
+
+mkdir -p intermediates/host-compress intermediates/host-decompress
+$HOSTBENCH_DIR/hostbench --dir $BENCH_DIR/ZSTD-COMPRESS --op compress --codecs zstd --out-dir intermediates/host-compress
+$HOSTBENCH_DIR/hostbench --dir $BENCH_DIR/ZSTD-DECOMPRESS --op decompress --codecs zstd --out-dir intermediates/host-decompress
+
+HOST_RESULT=hyper_results/HOST_ZSTD_FINAL_RESULT.csv
+head -n 1 intermediates/host-compress/HOST_ZSTD_RESULT.csv > $HOST_RESULT
+grep "^COMPRESS" intermediates/host-compress/HOST_ZSTD_RESULT.csv >> $HOST_RESULT
+grep "^DECOMPRESS" intermediates/host-decompress/HOST_ZSTD_RESULT.csv >> $HOST_RESULT
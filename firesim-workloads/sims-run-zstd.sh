@@ -78,11 +78,10 @@ cd $CURRENT_DIR
 
 date
 
+# each binary sweeps every placement (RoCC, Chiplet, PCIe+Cache,
+# PCIe+NoCache), so one run per shard covers all of them
 configs_to_run_zstd_decompress=(
-    "config_runtime_zstd_decompress_rocc.yaml"
-    "config_runtime_zstd_decompress_chiplet.yaml"
-    "config_runtime_zstd_decompress_pciec.yaml"
-    "config_runtime_zstd_decompress_pcienc.yaml"
+    "config_runtime_zstd_decompress_sweep.yaml"
 )
 
 for i in {0..12}
@@ -95,44 +94,15 @@ riscv64-unknown-elf-gcc -static -fno-common -fno-builtin-printf -specs=htif_nano
 # Build driver
 echo "Building FireSim Driver for ${configs_to_run_zstd_decompress[0]}"
 build_firesim_driver "${configs_to_run_zstd_decompress[0]}"
-build_firesim_driver "${configs_to_run_zstd_decompress[1]}"
-build_firesim_driver "${configs_to_run_zstd_decompress[2]}"
-build_firesim_driver "${configs_to_run_zstd_decompress[3]}"
 
 
 # Infrasetup and runworkload
-# RoCC
 echo "Running FireSim Simulation for ${configs_to_run_zstd_decompress[0]}"
-cp ../software-zstd/decompress/zstd-decompress-external-baremetal/RoCC/* ../software-zstd/decompress/zstd-decompress-external-baremetal
 for i in {0..12}
 do
     marshal install ../software-zstd/decompress/zstd-decompress-external-baremetal-$i.json
     run_firesim_workload "${configs_to_run_zstd_decompress[0]}"
 done
-# Chiplet
-echo "Running FireSim Simulation for ${configs_to_run_zstd_decompress[1]}"
-cp ../software-zstd/decompress/zstd-decompress-external-baremetal/Chiplet/* ../software-zstd/decompress/zstd-decompress-external-baremetal
-for i in {0..12}
-do
-    marshal install ../software-zstd/decompress/zstd-decompress-external-baremetal-$i.json
-    run_firesim_workload "${configs_to_run_zstd_decompress[1]}"
-done
-# PCIe+Cache
-echo "Running FireSim Simulation for ${configs_to_run_zstd_decompress[2]}"
-cp ../software-zstd/decompress/zstd-decompress-external-baremetal/PCIeC/* ../software-zstd/decompress/zstd-decompress-external-baremetal
-for i in {0..12}
-do
-    marshal install ../software-zstd/decompress/zstd-decompress-external-baremetal-$i.json
-    run_firesim_workload "${configs_to_run_zstd_decompress[2]}"
-done
-# PCIe+NoCache
-echo "Running FireSim Simulation for ${configs_to_run_zstd_decompress[3]}"
-cp ../software-zstd/decompress/zstd-decompress-external-baremetal/PCIeNC/* ../software-zstd/decompress/zstd-decompress-external-baremetal
-for i in {0..12}
-do
-    marshal install ../software-zstd/decompress/zstd-decompress-external-baremetal-$i.json
-    run_firesim_workload "${configs_to_run_zstd_decompress[3]}"
-done
 
 # Terminate FPGAs
 echo "Terminating FireSim Run Farm for Workloads"
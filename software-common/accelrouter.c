@@ -0,0 +1,272 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include "accelrouter.h"
+
+#ifdef __riscv
+#include "encoding.h"
+#define router_now() rdcycle()
+#else
+#include <time.h>
+static uint64_t router_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+#define ACCEL_ROUTER_MAX_CALIBRATION_POINTS 24
+
+static accel_route_t routes[ACCEL_ROUTER_MAX_ROUTES];
+static int num_routes = 0;
+
+int AccelRouterAddRoute(const char * name,
+                        accel_codec_fn accel_fn, void * accel_ctx,
+                        accel_codec_fn cpu_fn, void * cpu_ctx,
+                        accel_codec_fn prepare_fn, void * prepare_ctx) {
+    assert(num_routes < ACCEL_ROUTER_MAX_ROUTES);
+    assert(accel_fn != NULL);
+
+    accel_route_t * r = &routes[num_routes];
+    memset(r, 0, sizeof(accel_route_t));
+    strncpy(r->name, name, ACCEL_ROUTER_NAME_LEN - 1);
+    r->accel_fn = accel_fn;
+    r->accel_ctx = accel_ctx;
+    r->cpu_fn = cpu_fn;
+    r->cpu_ctx = cpu_ctx;
+    r->prepare_fn = prepare_fn;
+    r->prepare_ctx = prepare_ctx;
+    // until calibrated (or without a CPU codec) everything goes to the accelerator
+    r->crossover_bytes = 0;
+    r->calibrated = false;
+
+    return num_routes++;
+}
+
+accel_route_t * AccelRouterGetRoute(int route) {
+    assert((route >= 0) && (route < num_routes));
+    return &routes[route];
+}
+
+bool AccelRouterUseAccel(int route, size_t src_len) {
+    accel_route_t * r = AccelRouterGetRoute(route);
+    if (r->cpu_fn == NULL) {
+        return true;
+    }
+    return (uint64_t)src_len >= r->crossover_bytes;
+}
+
+uint64_t AccelRouterRun(int route,
+                        const unsigned char * src,
+                        size_t src_len,
+                        unsigned char * dst,
+                        size_t dst_capacity) {
+    accel_route_t * r = AccelRouterGetRoute(route);
+    if (AccelRouterUseAccel(route, src_len)) {
+        r->accel_calls++;
+        return r->accel_fn(src, src_len, dst, dst_capacity, r->accel_ctx);
+    }
+    r->cpu_calls++;
+    return r->cpu_fn(src, src_len, dst, dst_capacity, r->cpu_ctx);
+}
+
+static uint64_t AccelRouterTimeCall(accel_codec_fn fn, void * ctx,
+                                    const unsigned char * src, size_t src_len,
+                                    unsigned char * dst, size_t dst_capacity) {
+    uint64_t samples[ACCEL_ROUTER_CALIBRATION_REPS];
+    for (int i = 0; i < ACCEL_ROUTER_CALIBRATION_REPS; i++) {
+        uint64_t t1 = router_now();
+        uint64_t ret = fn(src, src_len, dst, dst_capacity, ctx);
+        uint64_t t2 = router_now();
+        if (ret == 0) {
+            return ACCEL_ROUTER_NEVER_ACCEL;
+        }
+        samples[i] = t2 - t1;
+    }
+    // median of a handful of samples
+    for (int i = 1; i < ACCEL_ROUTER_CALIBRATION_REPS; i++) {
+        for (int j = i; (j > 0) && (samples[j - 1] > samples[j]); j--) {
+            uint64_t tmp = samples[j];
+            samples[j] = samples[j - 1];
+            samples[j - 1] = tmp;
+        }
+    }
+    return samples[ACCEL_ROUTER_CALIBRATION_REPS / 2];
+}
+
+// The crossover goes between the last point where the CPU wins and the first
+// point from which the accelerator wins at every larger size.
+static void AccelRouterSetCrossover(accel_route_t * r,
+                                    const uint64_t * input_sizes,
+                                    const bool * accel_wins,
+                                    int num_points) {
+    int first_win = num_points;
+    while ((first_win > 0) && accel_wins[first_win - 1]) {
+        first_win--;
+    }
+
+    if (num_points == 0) {
+        r->crossover_bytes = 0;
+    } else if (first_win == num_points) {
+        r->crossover_bytes = ACCEL_ROUTER_NEVER_ACCEL;
+    } else if (first_win == 0) {
+        r->crossover_bytes = 0;
+    } else {
+        r->crossover_bytes = (input_sizes[first_win - 1] + input_sizes[first_win]) / 2;
+    }
+    r->calibrated = true;
+}
+
+// Times both codecs on prefixes of the sample at doubling sizes. scratch is
+// split in half: prepared input and codec output.
+uint64_t AccelRouterCalibrate(int route,
+                              const unsigned char * sample,
+                              size_t sample_len,
+                              unsigned char * scratch,
+                              size_t scratch_len) {
+    accel_route_t * r = AccelRouterGetRoute(route);
+    if (r->cpu_fn == NULL) {
+        r->crossover_bytes = 0;
+        r->calibrated = true;
+        return r->crossover_bytes;
+    }
+
+    size_t half = scratch_len / 2;
+    unsigned char * input_area = scratch;
+    unsigned char * output_area = scratch + half;
+
+    uint64_t input_sizes[ACCEL_ROUTER_MAX_CALIBRATION_POINTS];
+    bool accel_wins[ACCEL_ROUTER_MAX_CALIBRATION_POINTS];
+    int num_points = 0;
+
+    for (size_t raw_len = ACCEL_ROUTER_CALIBRATION_MIN_BYTES;
+         (raw_len <= sample_len) && (num_points < ACCEL_ROUTER_MAX_CALIBRATION_POINTS);
+         raw_len *= 2) {
+        const unsigned char * input = sample;
+        size_t input_len = raw_len;
+        if (r->prepare_fn) {
+            input_len = (size_t)r->prepare_fn(sample, raw_len, input_area, half, r->prepare_ctx);
+            input = input_area;
+            if (input_len == 0) {
+                break;
+            }
+        }
+
+        uint64_t cpu_cycles = AccelRouterTimeCall(r->cpu_fn, r->cpu_ctx, input, input_len, output_area, half);
+        uint64_t accel_cycles = AccelRouterTimeCall(r->accel_fn, r->accel_ctx, input, input_len, output_area, half);
+
+        input_sizes[num_points] = input_len;
+        accel_wins[num_points] = accel_cycles < cpu_cycles;
+        num_points++;
+
+        printf("ROUTER CALIBRATE: route %s input %" PRIu64 " bytes cpu %" PRIu64 " accel %" PRIu64 "\n",
+               r->name, (uint64_t)input_len, cpu_cycles, accel_cycles);
+    }
+
+    AccelRouterSetCrossover(r, input_sizes, accel_wins, num_points);
+    return r->crossover_bytes;
+}
+
+// Same, timed on inputs the caller already has (e.g. compressed benchmarks
+// for a decompression route, which can't be cut from a raw sample), given in
+// increasing size. dst takes each codec's output.
+uint64_t AccelRouterCalibrateInputs(int route,
+                                    const unsigned char * const * inputs,
+                                    const size_t * input_lens,
+                                    int num_inputs,
+                                    unsigned char * dst,
+                                    size_t dst_capacity) {
+    accel_route_t * r = AccelRouterGetRoute(route);
+    if (r->cpu_fn == NULL) {
+        r->crossover_bytes = 0;
+        r->calibrated = true;
+        return r->crossover_bytes;
+    }
+
+    uint64_t input_sizes[ACCEL_ROUTER_MAX_CALIBRATION_POINTS];
+    bool accel_wins[ACCEL_ROUTER_MAX_CALIBRATION_POINTS];
+    int num_points = 0;
+
+    for (int i = 0; (i < num_inputs) && (num_points < ACCEL_ROUTER_MAX_CALIBRATION_POINTS); i++) {
+        uint64_t cpu_cycles = AccelRouterTimeCall(r->cpu_fn, r->cpu_ctx, inputs[i], input_lens[i], dst, dst_capacity);
+        uint64_t accel_cycles = AccelRouterTimeCall(r->accel_fn, r->accel_ctx, inputs[i], input_lens[i], dst, dst_capacity);
+
+        input_sizes[num_points] = input_lens[i];
+        accel_wins[num_points] = accel_cycles < cpu_cycles;
+        num_points++;
+
+        printf("ROUTER CALIBRATE: route %s input %" PRIu64 " bytes cpu %" PRIu64 " accel %" PRIu64 "\n",
+               r->name, (uint64_t)input_lens[i], cpu_cycles, accel_cycles);
+    }
+
+    AccelRouterSetCrossover(r, input_sizes, accel_wins, num_points);
+    return r->crossover_bytes;
+}
+
+// Profile format: one "<route name> <crossover bytes>" line per route.
+int AccelRouterLoadProfile(const char * path) {
+    FILE * f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+
+    int loaded = 0;
+    char name[ACCEL_ROUTER_NAME_LEN];
+    uint64_t crossover;
+    while (fscanf(f, "%31s %" SCNu64, name, &crossover) == 2) {
+        for (int i = 0; i < num_routes; i++) {
+            if (strcmp(routes[i].name, name) == 0) {
+                routes[i].crossover_bytes = crossover;
+                routes[i].calibrated = true;
+                loaded++;
+            }
+        }
+    }
+    fclose(f);
+    return loaded;
+}
+
+int AccelRouterSaveProfile(const char * path) {
+    FILE * f = fopen(path, "w");
+    if (f == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < num_routes; i++) {
+        if (routes[i].calibrated) {
+            fprintf(f, "%s %" PRIu64 "\n", routes[i].name, routes[i].crossover_bytes);
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+// Startup entry point: take crossovers from the profile if it has them,
+// calibrate whatever is missing and write the profile back.
+int AccelRouterCalibrateOrLoad(const char * profile_path,
+                               const unsigned char * sample,
+                               size_t sample_len,
+                               unsigned char * scratch,
+                               size_t scratch_len) {
+    AccelRouterLoadProfile(profile_path);
+
+    int calibrated = 0;
+    for (int i = 0; i < num_routes; i++) {
+        if (!routes[i].calibrated) {
+            AccelRouterCalibrate(i, sample, sample_len, scratch, scratch_len);
+            calibrated++;
+        }
+    }
+    if (calibrated > 0) {
+        AccelRouterSaveProfile(profile_path);
+    }
+    return calibrated;
+}
+
+void AccelRouterPrintStats() {
+    for (int i = 0; i < num_routes; i++) {
+        printf("ROUTER: route %s crossover %" PRIu64 " bytes accel calls %" PRIu64 " cpu calls %" PRIu64 "\n",
+               routes[i].name, routes[i].crossover_bytes, routes[i].accel_calls, routes[i].cpu_calls);
+    }
+}
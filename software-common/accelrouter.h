@@ -0,0 +1,86 @@
+#ifndef __ACCEL_ROUTER_H
+#define __ACCEL_ROUTER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Size-aware CPU/accelerator routing.
+//
+// Each route (e.g. "snappy-compress") pairs an accelerator codec with an
+// optional CPU codec and a crossover size: calls of at least crossover_bytes
+// go to the accelerator, smaller ones to the CPU. Crossovers come from a short
+// microbenchmark at startup and are kept in a profile file so later runs can
+// skip it.
+
+#define ACCEL_ROUTER_MAX_ROUTES 8
+#define ACCEL_ROUTER_NAME_LEN 32
+#define ACCEL_ROUTER_CALIBRATION_MIN_BYTES 64
+#define ACCEL_ROUTER_CALIBRATION_REPS 3
+#define ACCEL_ROUTER_NEVER_ACCEL (~0ULL)
+
+// One call of a codec. Returns the number of bytes produced (or any nonzero
+// value on success if the codec can't tell), 0 on failure.
+typedef uint64_t (*accel_codec_fn)(const unsigned char * src,
+                                   size_t src_len,
+                                   unsigned char * dst,
+                                   size_t dst_capacity,
+                                   void * ctx);
+
+typedef struct {
+  char name[ACCEL_ROUTER_NAME_LEN];
+  accel_codec_fn accel_fn;
+  void * accel_ctx;
+  accel_codec_fn cpu_fn;
+  void * cpu_ctx;
+  // Turns a raw calibration sample into this route's input (e.g. compresses
+  // it for a decompression route). NULL if the route consumes raw data.
+  accel_codec_fn prepare_fn;
+  void * prepare_ctx;
+  uint64_t crossover_bytes;
+  bool calibrated;
+  uint64_t accel_calls;
+  uint64_t cpu_calls;
+} accel_route_t;
+
+int AccelRouterAddRoute(const char * name,
+                        accel_codec_fn accel_fn, void * accel_ctx,
+                        accel_codec_fn cpu_fn, void * cpu_ctx,
+                        accel_codec_fn prepare_fn, void * prepare_ctx);
+
+accel_route_t * AccelRouterGetRoute(int route);
+
+bool AccelRouterUseAccel(int route, size_t src_len);
+
+uint64_t AccelRouterRun(int route,
+                        const unsigned char * src,
+                        size_t src_len,
+                        unsigned char * dst,
+                        size_t dst_capacity);
+
+uint64_t AccelRouterCalibrate(int route,
+                              const unsigned char * sample,
+                              size_t sample_len,
+                              unsigned char * scratch,
+                              size_t scratch_len);
+
+uint64_t AccelRouterCalibrateInputs(int route,
+                                    const unsigned char * const * inputs,
+                                    const size_t * input_lens,
+                                    int num_inputs,
+                                    unsigned char * dst,
+                                    size_t dst_capacity);
+
+int AccelRouterLoadProfile(const char * path);
+
+int AccelRouterSaveProfile(const char * path);
+
+int AccelRouterCalibrateOrLoad(const char * profile_path,
+                               const unsigned char * sample,
+                               size_t sample_len,
+                               unsigned char * scratch,
+                               size_t scratch_len);
+
+void AccelRouterPrintStats();
+
+#endif //__ACCEL_ROUTER_H
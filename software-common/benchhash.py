@@ -0,0 +1,46 @@
+
+
+# Host side of BenchHash64 (benchverify.c): the expected-output hashes
+# splitter.py and corpus.py store next to each benchmark. The two must stay
+# in sync.
+
+import struct
+
+MASK64 = (1 << 64) - 1
+PRIME1 = 0x9E3779B97F4A7C15
+PRIME2 = 0xC2B2AE3D27D4EB4F
+
+
+def rotl(v, r):
+    return ((v << r) | (v >> (64 - r))) & MASK64
+
+
+def step(lane, word):
+    return (rotl(lane ^ ((word * PRIME1) & MASK64), 31) * PRIME2) & MASK64
+
+
+def bench_hash64(data):
+    lanes = [(PRIME1 * (k + 1)) & MASK64 for k in range(4)]
+    num_words = len(data) // 8
+
+    # word i goes to lane i % 4, then the tail bytes as one more word
+    words = list(struct.unpack_from(f"<{num_words}Q", data))
+    if len(data) & 7:
+        words.append(int.from_bytes(data[num_words * 8:], "little"))
+    for i, word in enumerate(words):
+        lanes[i & 3] = step(lanes[i & 3], word)
+
+    h = len(data)
+    for lane in lanes:
+        h = (rotl(h ^ lane, 27) * PRIME1) & MASK64
+    h ^= h >> 33
+    h = (h * 0xFF51AFD7ED558CCD) & MASK64
+    h ^= h >> 33
+    h = (h * 0xC4CEB9FE1A85EC53) & MASK64
+    h ^= h >> 33
+    return h if h != 0 else 1
+
+
+def bench_hash64_file(path):
+    with open(path, 'rb') as f:
+        return bench_hash64(f.read())
@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "benchreport.h"
+
+static int BenchReportCompare(const void * a, const void * b) {
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
+
+// nearest rank: the smallest sample with at least pct% of them at or below it
+static uint64_t BenchReportPercentile(const uint64_t * sorted, size_t n, unsigned int pct) {
+    size_t rank = (n * pct + 99) / 100;
+    return sorted[(rank == 0) ? 0 : (rank - 1)];
+}
+
+void BenchReportDist(const uint64_t * samples, size_t count, size_t stride,
+                     uint64_t * scratch, bench_dist_t * dist) {
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t sample = samples[i * stride];
+        if (sample != BENCH_REPORT_NO_SAMPLE) {
+            scratch[n++] = sample;
+        }
+    }
+
+    dist->count = n;
+    if (n == 0) {
+        dist->min = dist->p50 = dist->p99 = dist->max = 0;
+        return;
+    }
+    qsort(scratch, n, sizeof(uint64_t), BenchReportCompare);
+    dist->min = scratch[0];
+    dist->p50 = BenchReportPercentile(scratch, n, 50);
+    dist->p99 = BenchReportPercentile(scratch, n, 99);
+    dist->max = scratch[n - 1];
+}
+
+unsigned int BenchReportSizeBucket(uint64_t size) {
+    unsigned int bucket = 0;
+    while (size > 1) {
+        size >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void BenchReportPrintString(const char * s) {
+    putchar('"');
+    for (; *s; s++) {
+        unsigned char c = (unsigned char) *s;
+        if ((c == '"') || (c == '\\')) {
+            printf("\\%c", c);
+        } else if (c < 0x20) {
+            printf("\\u%04x", c);
+        } else {
+            putchar(c);
+        }
+    }
+    putchar('"');
+}
+
+void BenchReportPrintDist(const char * prefix, const bench_dist_t * dist, bool with_p99) {
+    printf(",\"%s_min\":%" PRIu64 ",\"%s_p50\":%" PRIu64, prefix, dist->min, prefix, dist->p50);
+    if (with_p99) {
+        printf(",\"%s_p99\":%" PRIu64, prefix, dist->p99);
+    }
+    printf(",\"%s_max\":%" PRIu64, prefix, dist->max);
+}
+
+bool BenchReportRunInit(bench_report_run_t * run, const char * harness,
+                        unsigned int num_calls, unsigned int num_reps) {
+    size_t num_samples = (size_t)num_reps * num_calls;
+    run->harness = harness;
+    run->num_calls = num_calls;
+    run->num_reps = num_reps;
+    run->call_cycles = (uint64_t *) malloc(num_samples * sizeof(uint64_t) + 1);
+    run->uncomp_bytes = (uint64_t *) malloc(num_calls * sizeof(uint64_t) + 1);
+    run->comp_bytes = (uint64_t *) malloc(num_calls * sizeof(uint64_t) + 1);
+    run->names = (const char **) malloc(num_calls * sizeof(const char *) + 1);
+    // per-rep totals are kept after the samples they are sorted from
+    run->scratch = (uint64_t *) malloc((num_samples + num_reps) * sizeof(uint64_t) + 1);
+    if ((run->call_cycles == NULL) || (run->uncomp_bytes == NULL) || (run->comp_bytes == NULL) ||
+        (run->names == NULL) || (run->scratch == NULL)) {
+        BenchReportRunFree(run);
+        return false;
+    }
+    BenchReportRunReset(run);
+    return true;
+}
+
+void BenchReportRunFree(bench_report_run_t * run) {
+    free(run->call_cycles);
+    free(run->uncomp_bytes);
+    free(run->comp_bytes);
+    free(run->names);
+    free(run->scratch);
+    run->call_cycles = NULL;
+    run->uncomp_bytes = NULL;
+    run->comp_bytes = NULL;
+    run->names = NULL;
+    run->scratch = NULL;
+}
+
+void BenchReportRunReset(bench_report_run_t * run) {
+    for (size_t i = 0; i < (size_t)run->num_reps * run->num_calls; i++) {
+        run->call_cycles[i] = BENCH_REPORT_NO_SAMPLE;
+    }
+    for (unsigned int i = 0; i < run->num_calls; i++) {
+        run->uncomp_bytes[i] = 0;
+        run->comp_bytes[i] = 0;
+        run->names[i] = "";
+    }
+}
+
+void BenchReportRunSample(bench_report_run_t * run, unsigned int rep, unsigned int call,
+                          const char * name, uint64_t uncomp_bytes, uint64_t comp_bytes,
+                          uint64_t cycles) {
+    run->call_cycles[(size_t)rep * run->num_calls + call] = cycles;
+    run->uncomp_bytes[call] = uncomp_bytes;
+    run->comp_bytes[call] = comp_bytes;
+    run->names[call] = name;
+}
+
+void BenchReportRunPrint(bench_report_run_t * run, const char * config, int records) {
+    if (records == BENCH_RECORDS_NONE) {
+        return;
+    }
+
+    unsigned int num_calls = run->num_calls;
+    unsigned int num_reps = run->num_reps;
+    uint64_t * rep_cycles = run->scratch + (size_t)num_reps * num_calls;
+    for (unsigned int rep = 0; rep < num_reps; rep++) {
+        rep_cycles[rep] = 0;
+        for (unsigned int i = 0; i < num_calls; i++) {
+            uint64_t cycles = run->call_cycles[(size_t)rep * num_calls + i];
+            if (cycles != BENCH_REPORT_NO_SAMPLE) {
+                rep_cycles[rep] += cycles;
+            }
+        }
+    }
+    uint64_t uncomp_bytes = 0;
+    uint64_t comp_bytes = 0;
+    for (unsigned int i = 0; i < num_calls; i++) {
+        uncomp_bytes += run->uncomp_bytes[i];
+        comp_bytes += run->comp_bytes[i];
+    }
+
+    bench_dist_t totals, calls;
+    BenchReportDist(rep_cycles, num_reps, 1, run->scratch, &totals);
+    BenchReportDist(run->call_cycles, (size_t)num_reps * num_calls, 1, run->scratch, &calls);
+
+    printf("{\"schema\":\"" BENCH_REPORT_RUN_SUMMARY_SCHEMA "\",\"harness\":");
+    BenchReportPrintString(run->harness);
+    printf(",\"config\":");
+    BenchReportPrintString(config);
+    printf(",\"calls\":%u,\"reps\":%u,\"failed\":%" PRIu64
+           ",\"uncomp_bytes\":%" PRIu64 ",\"comp_bytes\":%" PRIu64,
+           num_calls, num_reps, (uint64_t)num_reps * num_calls - calls.count,
+           uncomp_bytes, comp_bytes);
+    BenchReportPrintDist("total_cycles", &totals, false);
+    BenchReportPrintDist("call_cycles", &calls, true);
+    printf("}\n");
+
+    if (records != BENCH_RECORDS_CALLS) {
+        return;
+    }
+    for (unsigned int i = 0; i < num_calls; i++) {
+        bench_dist_t bench;
+        BenchReportDist(&run->call_cycles[i], num_reps, num_calls, run->scratch, &bench);
+
+        printf("{\"schema\":\"" BENCH_REPORT_RUN_CALL_SCHEMA "\",\"harness\":");
+        BenchReportPrintString(run->harness);
+        printf(",\"config\":");
+        BenchReportPrintString(config);
+        printf(",\"bench\":");
+        BenchReportPrintString(run->names[i]);
+        printf(",\"benchno\":%u,\"uncomp_bytes\":%" PRIu64 ",\"comp_bytes\":%" PRIu64 ",\"reps\":%u,\"failed\":%" PRIu64,
+               i, run->uncomp_bytes[i], run->comp_bytes[i], num_reps, (uint64_t)num_reps - bench.count);
+        BenchReportPrintDist("cycles", &bench, true);
+        printf("}\n");
+    }
+}
@@ -0,0 +1,134 @@
+#ifndef __BENCH_REPORT_H
+#define __BENCH_REPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Machine-readable benchmark records
+//
+// The harness prints one JSON object per line, next to its human-readable
+// output; every record starts with {"schema": naming its layout, so
+// process-records.py can pick them out of a uartlog. Cycle distributions are
+// over per-call rdcycle deltas of the calls that verified (or all calls
+// without verification), with nearest-rank percentiles.
+//
+// The Zstd decompress sweep (test-decompress.c) prints:
+//
+//   hcb-decompress-summary/1  one (placement, hist SRAM size) pair
+//     placement, hist, calls (benchmarks per rep), reps, failed (calls),
+//     uncomp_bytes and comp_bytes (per rep), total_cycles_{min,p50,max}
+//     (per-rep totals), call_cycles_{min,p50,p99,max} (every call)
+//
+//   hcb-decompress-call/1  one benchmark of such a pair, over its reps
+//     placement, hist, bench, benchno, uncomp_bytes, comp_bytes, reps,
+//     failed, cycles_{min,p50,p99,max}
+//
+//   hcb-decompress-bucket/1  the benchmarks of such a pair whose uncompressed
+//     size is in [2^bucket, 2^(bucket+1)), one record per non-empty bucket
+//     placement, hist, bucket, calls (benchmarks per rep), reps, failed,
+//     uncomp_bytes and comp_bytes (per rep), timed_calls, timed_uncomp_bytes
+//     and timed_cycles (sums over the calls in the distribution),
+//     call_cycles_{min,p50,p99,max}
+//
+// Bucket records carry sums rather than ratios (printf has no floating point
+// on bare metal); process-records.py derives throughput, compression ratio
+// and the fixed per-call setup overhead from them.
+//
+// The other harnesses (the Snappy ones, Zstd compress test.c and
+// test-complete.c) report through bench_report_run_t, one configuration of
+// their sweep at a time. harness is the source it came from, e.g.
+// "snappy/test-complete", and config names the configuration in the
+// harness's own terms, e.g. "hist=65536 ht=14":
+//
+//   hcb-run-summary/1  one configuration of a harness
+//     harness, config, calls (benchmarks per rep), reps, failed (calls),
+//     uncomp_bytes and comp_bytes (per rep), total_cycles_{min,p50,max}
+//     (per-rep totals), call_cycles_{min,p50,p99,max} (every call)
+//
+//   hcb-run-call/1  one benchmark of such a configuration, over its reps
+//     harness, config, bench, benchno, uncomp_bytes, comp_bytes, reps,
+//     failed, cycles_{min,p50,p99,max}
+//
+// Those harnesses take no arguments, so their pass counts are build flags,
+// e.g. BENCH_FLAGS="-DBENCH_REPS=5 -DBENCH_RECORDS=BENCH_RECORDS_CALLS";
+// each harness sets its own BENCH_WARMUPS default.
+
+#define BENCH_REPORT_SUMMARY_SCHEMA "hcb-decompress-summary/1"
+#define BENCH_REPORT_CALL_SCHEMA "hcb-decompress-call/1"
+#define BENCH_REPORT_BUCKET_SCHEMA "hcb-decompress-bucket/1"
+#define BENCH_REPORT_RUN_SUMMARY_SCHEMA "hcb-run-summary/1"
+#define BENCH_REPORT_RUN_CALL_SCHEMA "hcb-run-call/1"
+
+#define BENCH_RECORDS_NONE 0
+#define BENCH_RECORDS_SUMMARY 1
+#define BENCH_RECORDS_CALLS 2
+
+#ifndef BENCH_RECORDS
+#define BENCH_RECORDS BENCH_RECORDS_SUMMARY
+#endif
+
+// reported passes per configuration
+#ifndef BENCH_REPS
+#define BENCH_REPS 1
+#endif
+
+// log2 size buckets: bucket b holds sizes in [2^b, 2^(b+1)), sizes 0 and 1
+// are bucket 0.
+#define BENCH_REPORT_NUM_BUCKETS 64
+
+// Marks a call that failed verification in a sample array.
+#define BENCH_REPORT_NO_SAMPLE UINT64_MAX
+
+typedef struct {
+    uint64_t count;
+    uint64_t min;
+    uint64_t p50;
+    uint64_t p99;
+    uint64_t max;
+} bench_dist_t;
+
+// Distribution of samples[0], samples[stride], ... (count of them), skipping
+// BENCH_REPORT_NO_SAMPLE. scratch holds count entries. All zero if there are
+// no samples.
+void BenchReportDist(const uint64_t * samples, size_t count, size_t stride,
+                     uint64_t * scratch, bench_dist_t * dist);
+
+unsigned int BenchReportSizeBucket(uint64_t size);
+
+// JSON output helpers: a string value, escaped, and "<prefix>_min": ... for
+// the fields of a distribution (with a leading comma).
+void BenchReportPrintString(const char * s);
+void BenchReportPrintDist(const char * prefix, const bench_dist_t * dist, bool with_p99);
+
+// Samples of one configuration: call_cycles is num_reps rows of num_calls,
+// BENCH_REPORT_NO_SAMPLE for calls that failed (or were not run).
+typedef struct {
+    const char * harness;
+    unsigned int num_calls;
+    unsigned int num_reps;
+    uint64_t * call_cycles;
+    uint64_t * uncomp_bytes;
+    uint64_t * comp_bytes;
+    const char ** names;
+    uint64_t * scratch;
+} bench_report_run_t;
+
+// Returns false if the samples could not be allocated.
+bool BenchReportRunInit(bench_report_run_t * run, const char * harness,
+                        unsigned int num_calls, unsigned int num_reps);
+void BenchReportRunFree(bench_report_run_t * run);
+
+// Forgets the samples of the previous configuration.
+void BenchReportRunReset(bench_report_run_t * run);
+
+// cycles is BENCH_REPORT_NO_SAMPLE for a call that failed. Sizes are per
+// benchmark, the last rep's are kept.
+void BenchReportRunSample(bench_report_run_t * run, unsigned int rep, unsigned int call,
+                          const char * name, uint64_t uncomp_bytes, uint64_t comp_bytes,
+                          uint64_t cycles);
+
+// Prints the records of one configuration, records is one of BENCH_RECORDS_*.
+void BenchReportRunPrint(bench_report_run_t * run, const char * config, int records);
+
+#endif //__BENCH_REPORT_H
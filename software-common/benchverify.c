@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include "benchverify.h"
+
+#define BENCH_HASH_PRIME1 0x9E3779B97F4A7C15ULL
+#define BENCH_HASH_PRIME2 0xC2B2AE3D27D4EB4FULL
+
+static inline uint64_t BenchHashRotl(uint64_t v, unsigned int r) {
+    return (v << r) | (v >> (64 - r));
+}
+
+static inline uint64_t BenchHashStep(uint64_t lane, uint64_t word) {
+    return BenchHashRotl(lane ^ (word * BENCH_HASH_PRIME1), 31) * BENCH_HASH_PRIME2;
+}
+
+static inline bool BenchVerifyAligned(const void * p) {
+    return ((uintptr_t)p & 7) == 0;
+}
+
+// little-endian, like the host side
+static inline uint64_t BenchVerifyLoadBytes(const unsigned char * p, size_t len) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < len; i++) {
+        v |= ((uint64_t)p[i]) << (8 * i);
+    }
+    return v;
+}
+
+uint64_t BenchHash64(const unsigned char * data, size_t len) {
+    uint64_t lanes[4] = {
+        BENCH_HASH_PRIME1,
+        BENCH_HASH_PRIME1 * 2,
+        BENCH_HASH_PRIME1 * 3,
+        BENCH_HASH_PRIME1 * 4
+    };
+    size_t num_words = len / 8;
+    size_t i = 0;
+
+    // word i goes to lane i % 4
+    if (BenchVerifyAligned(data)) {
+        const uint64_t * data_by8 = (const uint64_t *) data;
+        for (; i + 4 <= num_words; i += 4) {
+            lanes[0] = BenchHashStep(lanes[0], data_by8[i]);
+            lanes[1] = BenchHashStep(lanes[1], data_by8[i + 1]);
+            lanes[2] = BenchHashStep(lanes[2], data_by8[i + 2]);
+            lanes[3] = BenchHashStep(lanes[3], data_by8[i + 3]);
+        }
+    }
+    for (; i < num_words; i++) {
+        lanes[i & 3] = BenchHashStep(lanes[i & 3], BenchVerifyLoadBytes(data + i * 8, 8));
+    }
+    if (len & 7) {
+        lanes[i & 3] = BenchHashStep(lanes[i & 3], BenchVerifyLoadBytes(data + i * 8, len & 7));
+    }
+
+    uint64_t h = len;
+    for (int lane = 0; lane < 4; lane++) {
+        h = BenchHashRotl(h ^ lanes[lane], 27) * BENCH_HASH_PRIME1;
+    }
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return (h == BENCH_VERIFY_NO_HASH) ? 1 : h;
+}
+
+static inline void BenchVerifyStoreTag(unsigned char * p, uint64_t tag) {
+    if (BenchVerifyAligned(p)) {
+        *(uint64_t *) p = tag;
+    } else {
+        for (int i = 0; i < 8; i++) {
+            p[i] = (unsigned char)(tag >> (8 * i));
+        }
+    }
+}
+
+void BenchVerifyStamp(unsigned char * region, size_t len, uint64_t generation) {
+    uint64_t tag = BenchHashStep(0xB5AD4ECEDA1CE2A9ULL, generation);
+    if (len < 8) {
+        for (size_t i = 0; i < len; i++) {
+            region[i] = (unsigned char)(tag >> (8 * i));
+        }
+        return;
+    }
+    for (size_t off = 0; off + 8 <= len; off += BENCH_VERIFY_TAG_STRIDE) {
+        BenchVerifyStoreTag(region + off, tag);
+    }
+    // the end too, so a short output is caught
+    BenchVerifyStoreTag(region + len - 8, tag);
+}
+
+// Index of the first differing byte, len if none.
+static size_t BenchVerifyFirstMismatch(const unsigned char * output, const unsigned char * expected, size_t len) {
+    size_t i = 0;
+    if (BenchVerifyAligned(output) && BenchVerifyAligned(expected)) {
+        const uint64_t * output_by8 = (const uint64_t *) output;
+        const uint64_t * expected_by8 = (const uint64_t *) expected;
+        size_t num_words = len / 8;
+        size_t w = 0;
+        // 32 bytes per iteration, one branch
+        for (; w + 4 <= num_words; w += 4) {
+            uint64_t diff = (output_by8[w] ^ expected_by8[w]) |
+                            (output_by8[w + 1] ^ expected_by8[w + 1]) |
+                            (output_by8[w + 2] ^ expected_by8[w + 2]) |
+                            (output_by8[w + 3] ^ expected_by8[w + 3]);
+            if (diff) {
+                break;
+            }
+        }
+        i = w * 8;
+    }
+    for (; i < len; i++) {
+        if (output[i] != expected[i]) {
+            return i;
+        }
+    }
+    return len;
+}
+
+bool BenchVerifyOutput(const unsigned char * output, const unsigned char * expected,
+                       size_t len, uint64_t expected_hash, const char * what) {
+    uint64_t output_hash = BENCH_VERIFY_NO_HASH;
+    if (expected_hash != BENCH_VERIFY_NO_HASH) {
+        output_hash = BenchHash64(output, len);
+        if (output_hash == expected_hash) {
+            return true;
+        }
+    }
+
+    size_t i = BenchVerifyFirstMismatch(output, expected, len);
+    if (i == len) {
+        if (expected_hash != BENCH_VERIFY_NO_HASH) {
+            // the data is right, so the precomputed hash is stale
+            printf("WARN: %s: output matches but its hash 0x%016" PRIx64 " doesn't match the expected 0x%016" PRIx64 "\n",
+                   what, output_hash, expected_hash);
+        }
+        return true;
+    }
+
+    size_t word = i / 8;
+    size_t word_len = ((word * 8 + 8) <= len) ? 8 : (len - word * 8);
+    printf("FAIL: %s: mismatch at byte %" PRIu64 " of %" PRIu64 ": expected: 0x%016" PRIx64 ", got: 0x%016" PRIx64 "\n",
+           what, (uint64_t)i, (uint64_t)len,
+           BenchVerifyLoadBytes(expected + word * 8, word_len),
+           BenchVerifyLoadBytes(output + word * 8, word_len));
+    return false;
+}
@@ -0,0 +1,139 @@
+import sys
+import os
+import json
+
+# Collects the JSON line records the harnesses print (schemas in
+# benchreport.h) from uartlogs and writes them out as CSV.
+#
+# usage: process-records.py [summary|calls|buckets|runs|runcalls] [uartlog or results dir ...]
+#
+# summary, calls and buckets are the Zstd decompress sweep's records; runs
+# and runcalls those of the other harnesses, one row per configuration or
+# per benchmark of a configuration.
+#
+# defaults to the summary records of every run under the FireSim results
+# directory.
+#
+# buckets adds, per log2 call-size bucket: bytes_per_cycle, comp_ratio,
+# setup_cycles and setup_share. setup_cycles is the fixed cost of one call,
+# from a least squares fit of cycles = setup + bytes * cycles_per_byte over
+# the bucket means of one (uartlog, placement, hist) run, weighted by timed
+# calls; setup_share is the part of the bucket's cycles it accounts for.
+# Both are left empty when fewer than two buckets were timed.
+
+results_basedir = "../../../sims/firesim/deploy/results-workload/"
+
+schemas = {
+    "summary": ("hcb-decompress-summary/1", [
+        "placement", "hist", "calls", "reps", "failed", "uncomp_bytes", "comp_bytes",
+        "total_cycles_min", "total_cycles_p50", "total_cycles_max",
+        "call_cycles_min", "call_cycles_p50", "call_cycles_p99", "call_cycles_max",
+    ]),
+    "calls": ("hcb-decompress-call/1", [
+        "placement", "hist", "bench", "benchno", "uncomp_bytes", "comp_bytes", "reps", "failed",
+        "cycles_min", "cycles_p50", "cycles_p99", "cycles_max",
+    ]),
+    "buckets": ("hcb-decompress-bucket/1", [
+        "placement", "hist", "bucket", "calls", "reps", "failed", "uncomp_bytes", "comp_bytes",
+        "timed_calls", "timed_uncomp_bytes", "timed_cycles",
+        "call_cycles_min", "call_cycles_p50", "call_cycles_p99", "call_cycles_max",
+    ]),
+    "runs": ("hcb-run-summary/1", [
+        "harness", "config", "calls", "reps", "failed", "uncomp_bytes", "comp_bytes",
+        "total_cycles_min", "total_cycles_p50", "total_cycles_max",
+        "call_cycles_min", "call_cycles_p50", "call_cycles_p99", "call_cycles_max",
+    ]),
+    "runcalls": ("hcb-run-call/1", [
+        "harness", "config", "bench", "benchno", "uncomp_bytes", "comp_bytes", "reps", "failed",
+        "cycles_min", "cycles_p50", "cycles_p99", "cycles_max",
+    ]),
+}
+
+bucket_derived_fields = ["bytes_per_cycle", "comp_ratio", "setup_cycles", "setup_share"]
+
+
+def find_uartlogs(path):
+    if os.path.isfile(path):
+        return [path]
+    found = []
+    for dirpath, dirnames, filenames in os.walk(path):
+        if "uartlog" in filenames:
+            found.append(dirpath + "/uartlog")
+    return sorted(found)
+
+
+def read_records(filename, schema):
+    records = []
+    with open(filename, 'r', errors='replace') as f:
+        for line in f:
+            start = line.find('{"schema":')
+            if start < 0:
+                continue
+            try:
+                record = json.loads(line[start:])
+            except ValueError:
+                # cut off, e.g. by a simulation that was stopped
+                print(f"{filename}: skipping malformed record", file=sys.stderr)
+                continue
+            if record["schema"] == schema:
+                records.append(record)
+    return records
+
+
+# setup cycles per call for one run's bucket records, None if it can't be fit
+def fit_setup_cycles(records):
+    points = [(r["timed_uncomp_bytes"] / r["timed_calls"], r["timed_cycles"] / r["timed_calls"], r["timed_calls"])
+              for r in records if r["timed_calls"] > 0]
+    if len(points) < 2:
+        return None
+    weight = sum(w for x, y, w in points)
+    mean_x = sum(x * w for x, y, w in points) / weight
+    mean_y = sum(y * w for x, y, w in points) / weight
+    sxx = sum(w * (x - mean_x) ** 2 for x, y, w in points)
+    if sxx == 0:
+        return None
+    sxy = sum(w * (x - mean_x) * (y - mean_y) for x, y, w in points)
+    return mean_y - (sxy / sxx) * mean_x
+
+
+def add_bucket_fields(records):
+    runs = {}
+    for record in records:
+        runs.setdefault((record["placement"], record["hist"]), []).append(record)
+    for run in runs.values():
+        setup = fit_setup_cycles(run)
+        for record in run:
+            timed = record["timed_cycles"] > 0
+            record["bytes_per_cycle"] = record["timed_uncomp_bytes"] / record["timed_cycles"] if timed else ""
+            record["comp_ratio"] = record["uncomp_bytes"] / record["comp_bytes"] if record["comp_bytes"] > 0 else ""
+            record["setup_cycles"] = setup if setup is not None else ""
+            record["setup_share"] = setup * record["timed_calls"] / record["timed_cycles"] if (setup is not None) and timed else ""
+
+
+def csv_field(value):
+    value = str(value)
+    if any(c in value for c in ',"\n'):
+        value = '"' + value.replace('"', '""') + '"'
+    return value
+
+
+kind = "summary"
+args = sys.argv[1:]
+if args and args[0] in schemas:
+    kind = args[0]
+    args = args[1:]
+if not args:
+    args = [results_basedir]
+
+schema, fields = schemas[kind]
+if kind == "buckets":
+    fields = fields + bucket_derived_fields
+
+print(",".join(["uartlog"] + fields))
+for path in args:
+    for filename in find_uartlogs(path):
+        records = read_records(filename, schema)
+        if kind == "buckets":
+            add_bucket_fields(records)
+        for record in records:
+            print(",".join(csv_field(x) for x in [filename] + [record[field] for field in fields]))
@@ -0,0 +1,130 @@
+
+
+
+# Plans how a benchmark directory is split into shards, balancing predicted
+# simulation time instead of dealing files out round-robin as splitter.py
+# does on its own, so a sharded run ends close to the average shard time
+# rather than at the largest shard's.
+#
+# required arguments:
+# abs path to benchmark input files
+# number of shards
+# algorithm (zstd or snappy)
+# direction (compress, decompress or complete)
+# output manifest file
+#
+# optional, after those: cost_per_byte=X cost_per_call=Y to override the
+# cost model below.
+#
+# Each benchmark's cost is cost_per_call + uncompressed bytes * cost_per_byte
+# for its algorithm and direction, in simulated cycles. Shards are then
+# packed LPT style: most expensive benchmark first, each onto the shard with
+# the least cost so far.
+#
+# The manifest is read by splitter.py (its optional last argument) and by
+# the corpus loader (manifest= in the decompress sweep, see benchcorpus.h).
+# It is plain text, one benchmark per line:
+#
+#   # hcb-shard-manifest/1 shards=<num shards> algorithm=... direction=...
+#   # shard <s> benchmarks <n> bytes <b> cost <c>
+#   <shard> <benchmark name>
+#
+# lines starting with # are comments. Benchmark names are file names
+# without .raw, as in the generated headers and the corpus.
+
+
+
+import sys
+import os
+import heapq
+
+assert len(sys.argv) >= 6
+
+input_path = sys.argv[1]
+num_shards = int(sys.argv[2])
+algorithm = sys.argv[3]
+direction = sys.argv[4]
+output_file = sys.argv[5]
+
+assert num_shards > 0
+
+
+# (cost per call, cost per byte) in simulated cycles: harness setup,
+# verification and the accelerator run itself. These are rough starting
+# points; override them with measured values (process-records.py buckets
+# gives setup_cycles and bytes_per_cycle). Only the ratio of the two matters
+# for balancing, the absolute values just make the printed estimates
+# readable.
+cost_model = {
+    ("zstd", "compress"): (20000, 6.0),
+    ("zstd", "decompress"): (15000, 3.0),
+    ("snappy", "compress"): (10000, 2.5),
+    ("snappy", "decompress"): (8000, 1.5),
+}
+
+if direction == "complete":
+    # compress then decompress each benchmark
+    cost_per_call = cost_model[(algorithm, "compress")][0] + cost_model[(algorithm, "decompress")][0]
+    cost_per_byte = cost_model[(algorithm, "compress")][1] + cost_model[(algorithm, "decompress")][1]
+else:
+    cost_per_call, cost_per_byte = cost_model[(algorithm, direction)]
+
+for setting in sys.argv[6:]:
+    key, value = setting.split("=")
+    if key == "cost_per_byte":
+        cost_per_byte = float(value)
+    elif key == "cost_per_call":
+        cost_per_call = float(value)
+    else:
+        assert False, f"unknown setting {setting}"
+
+
+all_benchmarks = os.listdir(input_path)
+
+benchmarks = []
+
+for filename in all_benchmarks:
+    if not filename.endswith(".comp"):
+        size = os.stat(input_path + "/" + filename).st_size
+        benchmarks.append([filename.replace(".raw", ''), size, cost_per_call + size * cost_per_byte])
+
+
+# most expensive first, by name among equals so plans are reproducible
+benchmarks = sorted(benchmarks, key=lambda x: x[0])
+benchmarks = sorted(benchmarks, key=lambda x: x[2], reverse=True)
+
+shards = [[] for shard in range(num_shards)]
+shard_bytes = [0] * num_shards
+shard_costs = [0.0] * num_shards
+
+# (cost so far, shard), so ties go to the lowest numbered shard
+least_loaded = [(0.0, shard) for shard in range(num_shards)]
+
+for name, size, cost in benchmarks:
+    load, shard = heapq.heappop(least_loaded)
+    shards[shard].append(name)
+    shard_bytes[shard] += size
+    shard_costs[shard] += cost
+    heapq.heappush(least_loaded, (load + cost, shard))
+
+
+# what splitter.py's round-robin deal would have cost, for comparison
+round_robin_costs = [0.0] * num_shards
+for index, benchmark in enumerate(sorted(sorted(benchmarks, key=lambda x: x[0]), key=lambda x: x[1])):
+    round_robin_costs[index % num_shards] += benchmark[2]
+
+
+with open(output_file, 'w', encoding='utf-8') as f:
+    f.write(f"# hcb-shard-manifest/1 shards={num_shards} algorithm={algorithm} direction={direction}\n")
+    f.write(f"# cost_per_call {cost_per_call} cost_per_byte {cost_per_byte}\n")
+    for shard in range(num_shards):
+        f.write(f"# shard {shard} benchmarks {len(shards[shard])} bytes {shard_bytes[shard]} cost {shard_costs[shard]:.0f}\n")
+    for shard in range(num_shards):
+        for name in shards[shard]:
+            f.write(f"{shard} {name}\n")
+
+
+average_cost = sum(shard_costs) / num_shards
+print(f"{output_file}: {len(benchmarks)} benchmarks in {num_shards} shards, "
+      f"predicted cost avg {average_cost:.0f} max {max(shard_costs):.0f} "
+      f"(round-robin max {max(round_robin_costs):.0f})")
@@ -0,0 +1,167 @@
+#include "accelout.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "../software-zstd/compress/benchdump.h"
+
+namespace {
+
+struct ByteWrite {
+  uint64_t addr;
+  uint64_t seq;  // position in the log, so later writes win
+  uint8_t byte;
+};
+
+// Puts the writes of one call back together into out->data.
+void FinishCall(std::vector<ByteWrite>* writes, AccelOutput* out) {
+  if (writes->empty()) {
+    out->error = "no writes";
+    return;
+  }
+  // completion flag
+  writes->pop_back();
+
+  std::sort(writes->begin(), writes->end(), [](const ByteWrite& a, const ByteWrite& b) {
+    return (a.addr < b.addr) || ((a.addr == b.addr) && (a.seq < b.seq));
+  });
+  for (size_t i = 0; i < writes->size(); i++) {
+    const ByteWrite& w = (*writes)[i];
+    if ((i + 1 < writes->size()) && ((*writes)[i + 1].addr == w.addr)) {
+      continue;
+    }
+    if (!out->data.empty() && (w.addr != (*writes)[0].addr + out->data.size()) &&
+        out->error.empty()) {
+      char msg[96];
+      snprintf(msg, sizeof(msg), "hole before 0x%llx", (unsigned long long)w.addr);
+      out->error = msg;
+    }
+    out->data.push_back(w.byte);
+  }
+  writes->clear();
+}
+
+// "cy: <n>, WRITE_BYTE ADDR: 0x<addr> BYTE: 0x<byte> <helper>"
+bool ParseWriteByte(const char* line, BenchFormat format, ByteWrite* w) {
+  const char* p = strstr(line, "WRITE_BYTE ADDR: ");
+  if (p == nullptr) {
+    return false;
+  }
+  char* end;
+  w->addr = strtoull(p + strlen("WRITE_BYTE ADDR: "), &end, 16);
+  if (strncmp(end, " BYTE: ", 7) != 0) {
+    return false;
+  }
+  w->byte = (uint8_t)strtoul(end + 7, &end, 16);
+  // sequences the match finder hands to software, not part of the stream
+  if ((format == BenchFormat::kZstd) && (strstr(end, "mf_seqwriter") != nullptr)) {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool ReadWriteByteLog(const std::string& path, BenchFormat format,
+                      std::vector<AccelOutput>* outputs) {
+  FILE* f = fopen(path.c_str(), "r");
+  if (f == nullptr) {
+    fprintf(stderr, "could not open %s\n", path.c_str());
+    return false;
+  }
+
+  static const char kCallStart[] = "Starting benchmark num ";
+  std::vector<ByteWrite> writes;
+  AccelOutput call;
+  call.source = path;
+  call.call = 0;
+  bool in_call = false;
+  uint64_t seq = 0;
+
+  char* line = nullptr;
+  size_t line_capacity = 0;
+  while (getline(&line, &line_capacity, f) >= 0) {
+    ByteWrite w;
+    if (ParseWriteByte(line, format, &w)) {
+      w.seq = seq++;
+      writes.push_back(w);
+      in_call = true;
+      continue;
+    }
+    const char* start = strstr(line, kCallStart);
+    if (start == nullptr) {
+      continue;
+    }
+    if (in_call) {
+      FinishCall(&writes, &call);
+      outputs->push_back(call);
+      call = AccelOutput();
+      call.source = path;
+      call.call = outputs->size();
+    }
+    // "<n>: <name>"
+    const char* name = strstr(start, ": ");
+    if (name != nullptr) {
+      call.name.assign(name + 2, strcspn(name + 2, "\r\n"));
+    }
+    in_call = true;
+  }
+  free(line);
+  bool ok = !ferror(f);
+  fclose(f);
+  if (!ok) {
+    fprintf(stderr, "error reading %s\n", path.c_str());
+    return false;
+  }
+
+  if (in_call) {
+    FinishCall(&writes, &call);
+    outputs->push_back(call);
+  }
+  return true;
+}
+
+bool ReadOutputDump(const std::string& path, std::vector<AccelOutput>* outputs) {
+  FILE* f = fopen(path.c_str(), "rb");
+  if (f == nullptr) {
+    fprintf(stderr, "could not open %s\n", path.c_str());
+    return false;
+  }
+  char magic[sizeof(BENCH_DUMP_MAGIC) - 1];
+  if ((fread(magic, 1, sizeof(magic), f) != sizeof(magic)) ||
+      (memcmp(magic, BENCH_DUMP_MAGIC, sizeof(magic)) != 0)) {
+    fprintf(stderr, "%s is not an output dump\n", path.c_str());
+    fclose(f);
+    return false;
+  }
+
+  bench_dump_record_t record;
+  size_t got;
+  while ((got = fread(&record, 1, sizeof(record), f)) > 0) {
+    AccelOutput out;
+    out.source = path;
+    out.call = outputs->size();
+    if (got != sizeof(record)) {
+      out.error = "truncated record";
+      outputs->push_back(out);
+      break;
+    }
+    out.name.resize(record.name_len);
+    out.data.resize(record.data_len);
+    if ((fread(&out.name[0], 1, record.name_len, f) != record.name_len) ||
+        (fread(out.data.data(), 1, record.data_len, f) != record.data_len)) {
+      out.error = "truncated record";
+      outputs->push_back(out);
+      break;
+    }
+    outputs->push_back(out);
+  }
+  bool ok = !ferror(f);
+  fclose(f);
+  if (!ok) {
+    fprintf(stderr, "error reading %s\n", path.c_str());
+  }
+  return ok;
+}
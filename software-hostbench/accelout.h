@@ -0,0 +1,37 @@
+#ifndef __HOSTBENCH_ACCELOUT_H
+#define __HOSTBENCH_ACCELOUT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "benchset.h"
+
+// One compressed stream written by the accelerator, as recovered on the host.
+struct AccelOutput {
+  std::string source;  // file it came from
+  std::string name;    // benchmark name, empty if the source doesn't say
+  unsigned int call;   // index of the call in the source
+  std::vector<uint8_t> data;
+  std::string error;   // set if the stream couldn't be put back together
+};
+
+// Reads a simulation log with the accelerator's WRITE_BYTE lines (L2MemHelper
+// built with printWriteBytes) line by line, without holding the log in
+// memory, and rebuilds each call's output from its writes the way
+// get-compressed.py does: the last write of a call is its completion flag
+// and is dropped, zstd match finder sequence writes are skipped, and the
+// remaining bytes are put in address order (a later write to an address
+// wins). A "Starting benchmark num <n>: <name>" line from the harness starts
+// a new call and names it; a log without them is one call. Returns false
+// (after printing why) if the log can't be read.
+bool ReadWriteByteLog(const std::string& path, BenchFormat format,
+                      std::vector<AccelOutput>* outputs);
+
+// Reads an output dump written by the harness (benchdump.h): one output per
+// record, named by the record. Returns false (after printing why) if the
+// file can't be read or isn't a dump; records read before a truncated one
+// are kept, and the truncated one is returned with its error set.
+bool ReadOutputDump(const std::string& path, std::vector<AccelOutput>* outputs);
+
+#endif  // __HOSTBENCH_ACCELOUT_H
@@ -0,0 +1,186 @@
+#include "benchset.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <set>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+extern "C" {
+#include "../software-zstd/decompress/benchcorpus.h"
+}
+
+int BenchmarkLevel(const std::string& name) {
+  size_t first = name.find('_');
+  if (first == std::string::npos) {
+    return 3;
+  }
+  size_t second = name.find('_', first + 1);
+  std::string field = name.substr(first + 1, second - first - 1);
+  if (field.compare(0, 2, "cl") != 0) {
+    return 3;
+  }
+  int level = atoi(field.c_str() + 2);
+  return (level == 0) ? 3 : level;
+}
+
+static bool ReadFile(const std::string& path, std::vector<uint8_t>* data) {
+  FILE* f = fopen(path.c_str(), "rb");
+  if (f == nullptr) {
+    return false;
+  }
+  data->clear();
+  uint8_t buf[1 << 16];
+  size_t got;
+  while ((got = fread(buf, 1, sizeof(buf), f)) > 0) {
+    data->insert(data->end(), buf, buf + got);
+  }
+  bool ok = !ferror(f);
+  fclose(f);
+  return ok;
+}
+
+static bool EndsWith(const std::string& s, const std::string& suffix) {
+  return (s.size() >= suffix.size()) &&
+         (s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0);
+}
+
+// The benchmark names of one shard of a shard manifest, as
+// BenchCorpusOpenManifest reads it.
+static bool ReadManifestShard(const std::string& path, uint32_t shard,
+                              std::set<std::string>* names) {
+  std::ifstream manifest(path);
+  std::string line;
+  const std::string magic = std::string("# ") + BENCH_CORPUS_MANIFEST_MAGIC + " shards=";
+  if (!std::getline(manifest, line) || (line.compare(0, magic.size(), magic) != 0) ||
+      (shard >= strtoul(line.c_str() + magic.size(), nullptr, 10))) {
+    fprintf(stderr, "%s is not a shard manifest with a shard %u\n", path.c_str(), shard);
+    return false;
+  }
+  while (std::getline(manifest, line)) {
+    if (line.empty() || (line[0] == '#')) {
+      continue;
+    }
+    size_t space = line.find(' ');
+    if ((space != std::string::npos) &&
+        (strtoul(line.substr(0, space).c_str(), nullptr, 10) == shard)) {
+      names->insert(line.substr(space + 1));
+    }
+  }
+  return true;
+}
+
+bool LoadBenchmarkDir(const std::string& path, BenchFormat format,
+                      const std::string& manifest, uint32_t shard,
+                      uint32_t num_shards, std::vector<Benchmark>* benchmarks) {
+  std::set<std::string> planned;
+  if (!manifest.empty() && !ReadManifestShard(manifest, shard, &planned)) {
+    return false;
+  }
+
+  DIR* dir = opendir(path.c_str());
+  if (dir == nullptr) {
+    fprintf(stderr, "could not open benchmark directory %s\n", path.c_str());
+    return false;
+  }
+
+  // splitter.py: every non-.comp file, by name, then (stable) by size
+  std::vector<std::pair<std::string, off_t>> files;
+  while (struct dirent* entry = readdir(dir)) {
+    std::string name = entry->d_name;
+    struct stat st;
+    if (EndsWith(name, ".comp") || (stat((path + "/" + name).c_str(), &st) != 0) ||
+        !S_ISREG(st.st_mode)) {
+      continue;
+    }
+    files.emplace_back(name, st.st_size);
+  }
+  closedir(dir);
+  std::sort(files.begin(), files.end());
+  std::stable_sort(files.begin(), files.end(),
+                   [](const std::pair<std::string, off_t>& a,
+                      const std::pair<std::string, off_t>& b) {
+                     return a.second < b.second;
+                   });
+
+  for (size_t i = 0; i < files.size(); i++) {
+    if (manifest.empty() && (num_shards > 1) && ((i % num_shards) != shard)) {
+      continue;
+    }
+    Benchmark bench;
+    bench.name = files[i].first;
+    size_t raw_suffix = bench.name.find(".raw");
+    if (raw_suffix != std::string::npos) {
+      bench.name.erase(raw_suffix, 4);
+    }
+    if (!manifest.empty() && (planned.erase(bench.name) == 0)) {
+      continue;
+    }
+    bench.level = BenchmarkLevel(bench.name);
+
+    if (!ReadFile(path + "/" + files[i].first, &bench.raw)) {
+      fprintf(stderr, "could not read %s/%s\n", path.c_str(), files[i].first.c_str());
+      return false;
+    }
+    if (!ReadFile(path + "/" + bench.name + ".comp", &bench.comp)) {
+#ifdef HAVE_ZSTD
+      if (format == BenchFormat::kZstd) {
+        bench.comp.resize(ZSTD_compressBound(bench.raw.size()));
+        size_t comp_len = ZSTD_compress(bench.comp.data(), bench.comp.size(),
+                                        bench.raw.data(), bench.raw.size(),
+                                        bench.level);
+        if (ZSTD_isError(comp_len)) {
+          fprintf(stderr, "could not compress %s: %s\n", bench.name.c_str(),
+                  ZSTD_getErrorName(comp_len));
+          return false;
+        }
+        bench.comp.resize(comp_len);
+      } else
+#endif
+      {
+        fprintf(stderr, "%s/%s.comp is missing\n", path.c_str(), bench.name.c_str());
+        return false;
+      }
+    }
+    benchmarks->push_back(std::move(bench));
+  }
+  if (!planned.empty()) {
+    fprintf(stderr, "%s lists %s, which is not in %s\n", manifest.c_str(),
+            planned.begin()->c_str(), path.c_str());
+    return false;
+  }
+  (void)format;
+  return true;
+}
+
+bool LoadBenchmarkCorpus(const std::string& path, const std::string& manifest,
+                         uint32_t shard, uint32_t num_shards,
+                         std::vector<Benchmark>* benchmarks) {
+  bench_corpus_t corpus;
+  int ret = manifest.empty()
+                ? BenchCorpusOpen(&corpus, path.c_str(), shard, num_shards)
+                : BenchCorpusOpenManifest(&corpus, path.c_str(), manifest.c_str(), shard);
+  if (ret != 0) {
+    fprintf(stderr, "could not load benchmark corpus %s, shard %u\n", path.c_str(), shard);
+    return false;
+  }
+  for (uint32_t i = 0; i < corpus.num_entries; i++) {
+    const bench_corpus_entry_t& entry = corpus.entries[i];
+    Benchmark bench;
+    bench.name = entry.name;
+    bench.level = BenchmarkLevel(bench.name);
+    bench.raw.assign(entry.uncompressed, entry.uncompressed + entry.uncompressed_len);
+    bench.comp.assign(entry.compressed, entry.compressed + entry.compressed_len);
+    benchmarks->push_back(std::move(bench));
+  }
+  BenchCorpusClose(&corpus);
+  return true;
+}
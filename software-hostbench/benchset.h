@@ -0,0 +1,40 @@
+#ifndef __HOSTBENCH_BENCHSET_H
+#define __HOSTBENCH_BENCHSET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One HyperCompressBench call: the uncompressed input and its compressed
+// form, each used whole, as the accelerator harnesses and lzbench do.
+struct Benchmark {
+  std::string name;
+  int level;  // zstd level from the _cl<N>_ part of the name
+  std::vector<uint8_t> raw;
+  std::vector<uint8_t> comp;
+};
+
+enum class BenchFormat { kZstd, kSnappy };
+
+// Loads shard `shard` of `num_shards` of an extracted_benchmarks directory
+// (<name>.raw plus <name>.comp). Files are ordered and dealt out like
+// splitter.py, so shard s of n holds the benchmarks of chunk s of n. For
+// zstd, a missing .comp is made with libzstd at the benchmark's level when
+// it is available. With a manifest (from shardplan.py), shard is a shard of
+// its plan and num_shards is unused. Returns false (after printing why) on
+// failure.
+bool LoadBenchmarkDir(const std::string& path, BenchFormat format,
+                      const std::string& manifest, uint32_t shard,
+                      uint32_t num_shards, std::vector<Benchmark>* benchmarks);
+
+// The same from a corpus archive built by corpus.py.
+bool LoadBenchmarkCorpus(const std::string& path, const std::string& manifest,
+                         uint32_t shard, uint32_t num_shards,
+                         std::vector<Benchmark>* benchmarks);
+
+// The level splitter.py compresses a benchmark at: from its name, with 0
+// meaning zstd's default of 3.
+int BenchmarkLevel(const std::string& name);
+
+#endif  // __HOSTBENCH_BENCHSET_H
@@ -0,0 +1,204 @@
+#include "codecs.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_SNAPPY
+#include <snappy.h>
+#endif
+
+// the untraced copy (reference_decoder_untraced.c), so timings don't include
+// the performance model's hooks
+extern "C" size_t RefZstdDecompressUntraced(void* const dst, const size_t dst_len,
+                                            const void* const src, const size_t src_len);
+
+namespace {
+
+class ReferenceDecoder : public Codec {
+ public:
+  const char* Name() const override { return "reference"; }
+  BenchFormat Format() const override { return BenchFormat::kZstd; }
+  bool CanDecompress() const override { return true; }
+
+  size_t Decompress(const uint8_t* src, size_t src_len,
+                    uint8_t* dst, size_t dst_capacity) override {
+    size_t got = RefZstdDecompressUntraced(dst, dst_capacity, src, src_len);
+    // the reference decoder reports errors as (size_t)-1 or its ERROR_CODE
+    return ((got > dst_capacity)) ? 0 : got;
+  }
+};
+
+#ifdef HAVE_ZSTD
+class LibZstd : public Codec {
+ public:
+  LibZstd() : cctx_(ZSTD_createCCtx()), dctx_(ZSTD_createDCtx()) {}
+  ~LibZstd() override {
+    ZSTD_freeCCtx(cctx_);
+    ZSTD_freeDCtx(dctx_);
+  }
+
+  const char* Name() const override { return "zstd"; }
+  BenchFormat Format() const override { return BenchFormat::kZstd; }
+  bool CanCompress() const override { return true; }
+  bool CanDecompress() const override { return true; }
+
+  size_t Compress(const uint8_t* src, size_t src_len, int level,
+                  uint8_t* dst, size_t dst_capacity) override {
+    size_t got = ZSTD_compressCCtx(cctx_, dst, dst_capacity, src, src_len, level);
+    return ZSTD_isError(got) ? 0 : got;
+  }
+
+  size_t Decompress(const uint8_t* src, size_t src_len,
+                    uint8_t* dst, size_t dst_capacity) override {
+    size_t got = ZSTD_decompressDCtx(dctx_, dst, dst_capacity, src, src_len);
+    return ZSTD_isError(got) ? 0 : got;
+  }
+
+ private:
+  ZSTD_CCtx* cctx_;
+  ZSTD_DCtx* dctx_;
+};
+#endif
+
+#ifdef HAVE_SNAPPY
+class LibSnappy : public Codec {
+ public:
+  const char* Name() const override { return "snappy"; }
+  BenchFormat Format() const override { return BenchFormat::kSnappy; }
+  bool CanCompress() const override { return true; }
+  bool CanDecompress() const override { return true; }
+
+  size_t Compress(const uint8_t* src, size_t src_len, int level,
+                  uint8_t* dst, size_t dst_capacity) override {
+    if (dst_capacity < snappy::MaxCompressedLength(src_len)) {
+      return 0;
+    }
+    size_t got;
+    snappy::RawCompress(reinterpret_cast<const char*>(src), src_len,
+                        reinterpret_cast<char*>(dst), &got);
+    return got;
+  }
+
+  size_t Decompress(const uint8_t* src, size_t src_len,
+                    uint8_t* dst, size_t dst_capacity) override {
+    size_t got;
+    const char* in = reinterpret_cast<const char*>(src);
+    if (!snappy::GetUncompressedLength(in, src_len, &got) || (got > dst_capacity) ||
+        !snappy::RawUncompress(in, src_len, reinterpret_cast<char*>(dst))) {
+      return 0;
+    }
+    return got;
+  }
+};
+#endif
+
+class AccelThroughputModel : public ReferenceDecoder {
+ public:
+  AccelThroughputModel(std::string name, double bytes_per_second)
+      : name_(std::move(name)), bytes_per_second_(bytes_per_second) {}
+
+  const char* Name() const override { return name_.c_str(); }
+  bool Modeled() const override { return true; }
+  double ModeledDecompressSeconds(size_t comp_len, size_t uncomp_len) const override {
+    return uncomp_len / bytes_per_second_;
+  }
+
+ private:
+  std::string name_;
+  double bytes_per_second_;
+};
+
+class AccelPerformanceModel : public Codec {
+ public:
+  AccelPerformanceModel(std::string name, const ZstdModelConfig& config, double clock_ghz)
+      : name_(std::move(name)), config_(config), clock_ghz_(clock_ghz) {}
+
+  const char* Name() const override { return name_.c_str(); }
+  BenchFormat Format() const override { return BenchFormat::kZstd; }
+  bool CanDecompress() const override { return true; }
+
+  size_t Decompress(const uint8_t* src, size_t src_len,
+                    uint8_t* dst, size_t dst_capacity) override {
+    size_t got = TraceZstdCall(src, src_len, dst, dst_capacity, &trace_);
+    cycles_ = (got > 0) ? ZstdModelCycles(&trace_, config_) : 0.0;
+    return got;
+  }
+
+  // the cycles of the last call, which is the one being asked about
+  bool Modeled() const override { return true; }
+  double ModeledDecompressSeconds(size_t comp_len, size_t uncomp_len) const override {
+    return cycles_ / (clock_ghz_ * 1e9);
+  }
+
+ private:
+  std::string name_;
+  ZstdModelConfig config_;
+  double clock_ghz_;
+  ZstdCallTrace trace_;
+  double cycles_ = 0.0;
+};
+
+}  // namespace
+
+std::vector<std::unique_ptr<Codec>> MakeHostCodecs() {
+  std::vector<std::unique_ptr<Codec>> codecs;
+  codecs.emplace_back(new ReferenceDecoder());
+#ifdef HAVE_ZSTD
+  codecs.emplace_back(new LibZstd());
+#endif
+#ifdef HAVE_SNAPPY
+  codecs.emplace_back(new LibSnappy());
+#endif
+  return codecs;
+}
+
+std::unique_ptr<Codec> MakeAccelThroughputModel(const std::string& csv_path,
+                                                const std::string& placement,
+                                                uint64_t hist_sram_bytes,
+                                                double clock_ghz) {
+  std::ifstream csv(csv_path);
+  if (!csv) {
+    fprintf(stderr, "could not open accelerator results %s\n", csv_path.c_str());
+    return nullptr;
+  }
+
+  // placement,sram_size,cycles,uncomp_data_size,area
+  std::string line;
+  while (std::getline(csv, line)) {
+    std::vector<std::string> fields;
+    std::stringstream ss(line);
+    std::string field;
+    while (std::getline(ss, field, ',')) {
+      fields.push_back(field);
+    }
+    if ((fields.size() < 4) || (fields[0] != placement) ||
+        (strtoull(fields[1].c_str(), nullptr, 10) != hist_sram_bytes)) {
+      continue;
+    }
+    double cycles = strtod(fields[2].c_str(), nullptr);
+    double bytes = strtod(fields[3].c_str(), nullptr);
+    if ((cycles <= 0) || (bytes <= 0)) {
+      break;
+    }
+    std::string name = "accel-" + placement + "-" + std::to_string(hist_sram_bytes);
+    return std::unique_ptr<Codec>(
+        new AccelThroughputModel(name, bytes / cycles * clock_ghz * 1e9));
+  }
+  fprintf(stderr, "%s has no results for placement %s, hist SRAM %llu\n",
+          csv_path.c_str(), placement.c_str(), (unsigned long long)hist_sram_bytes);
+  return nullptr;
+}
+
+std::unique_ptr<Codec> MakeAccelPerformanceModel(const std::string& placement,
+                                                 const ZstdModelConfig& config,
+                                                 double clock_ghz) {
+  std::string name = "accel-model-" + placement + "-" + std::to_string(config.hist_sram_bytes) +
+                     "-w" + std::to_string(config.huf_speculation);
+  return std::unique_ptr<Codec>(new AccelPerformanceModel(name, config, clock_ghz));
+}
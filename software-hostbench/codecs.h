@@ -0,0 +1,62 @@
+#ifndef __HOSTBENCH_CODECS_H
+#define __HOSTBENCH_CODECS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "benchset.h"
+#include "zstdmodel.h"
+
+// A codec under test. Each call is one whole benchmark, compressed or
+// decompressed, the way the accelerator harnesses issue them.
+class Codec {
+ public:
+  virtual ~Codec() {}
+
+  virtual const char* Name() const = 0;
+  virtual BenchFormat Format() const = 0;
+  virtual bool CanCompress() const { return false; }
+  virtual bool CanDecompress() const { return false; }
+
+  // Bytes produced, 0 on failure.
+  virtual size_t Compress(const uint8_t* src, size_t src_len, int level,
+                          uint8_t* dst, size_t dst_capacity) {
+    return 0;
+  }
+  virtual size_t Decompress(const uint8_t* src, size_t src_len,
+                            uint8_t* dst, size_t dst_capacity) {
+    return 0;
+  }
+
+  // Models report the time a call would take on the modeled hardware instead
+  // of being timed on the host. Only asked after a successful call.
+  virtual bool Modeled() const { return false; }
+  virtual double ModeledDecompressSeconds(size_t comp_len, size_t uncomp_len) const {
+    return 0.0;
+  }
+};
+
+// Every codec built in, in report order: the in-tree reference decoder,
+// then libzstd and snappy when the Makefile found them.
+std::vector<std::unique_ptr<Codec>> MakeHostCodecs();
+
+// The accelerator throughput model: decodes with the reference decoder, and
+// charges each call its size over the bytes/cycle FireSim measured for one
+// placement and hist SRAM size, from the CSV process-resultdir-decompress.py
+// writes. Returns nullptr (after printing why) if the CSV has no such row.
+std::unique_ptr<Codec> MakeAccelThroughputModel(const std::string& csv_path,
+                                                const std::string& placement,
+                                                uint64_t hist_sram_bytes,
+                                                double clock_ghz);
+
+// The accelerator performance model (zstdmodel.h): decodes with the
+// reference decoder, recording the call, and charges it the cycles the model
+// gives for config (set up for placement) at clock_ghz.
+std::unique_ptr<Codec> MakeAccelPerformanceModel(const std::string& placement,
+                                                 const ZstdModelConfig& config,
+                                                 double clock_ghz);
+
+#endif  // __HOSTBENCH_CODECS_H
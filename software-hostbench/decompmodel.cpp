@@ -0,0 +1,431 @@
+// Design sweep of the Zstd decompressor on the host with the performance
+// model (zstdmodel.h): every benchmark of a HyperCompressBench shard is
+// decoded and recorded once, then costed for each placement, hist SRAM size
+// and Huffman speculation width. Writes one row per design point in
+// process-resultdir-decompress.py's schema with the width added, so
+// draw-plot and hostbench --accel-csv take it like FireSim results; area is
+// left empty.
+//
+// --calibrate fits the model's calibration (base memory latency, scale and
+// per-call overhead) to a CSV of FireSim TOTAL: results for the same
+// benchmarks, reports the error per row, and sweeps with it. The RoCC,
+// Chiplet and PCIe rows are taken at the first --widths width (the sweeps
+// build WithZstdDecompressor16), SpecN rows at width N.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchset.h"
+#include "zstdmodel.h"
+
+namespace {
+
+struct Options {
+  std::string dir;
+  std::string corpus;
+  std::string manifest;
+  uint32_t shard = 0;
+  uint32_t num_shards = 1;
+  std::vector<std::string> placements = {"RoCC", "Chiplet", "PCIeLocalCache", "PCIeNoCache"};
+  std::vector<uint64_t> hists = {65536, 32768, 16384, 8192, 4096, 2048};
+  std::vector<int> widths = {16};
+  uint32_t reps = 1;
+  std::string calibration;
+  std::string calibrate_csv;
+  std::string save;
+  std::string out;
+  unsigned int threads = 0;  // 0: one per core
+};
+
+// One row of process-resultdir-decompress.py's CSV.
+struct FireSimRow {
+  std::string placement;
+  uint64_t sram_size;
+  double cycles;
+  double uncomp_bytes;
+};
+
+void Usage(const char* argv0) {
+  fprintf(stderr,
+          "usage: %s (--dir <benchmark dir> | --corpus <corpus file>) [options]\n"
+          "  --shard N --shards M      run shard N of M (default: everything)\n"
+          "  --manifest F              or shard N of this shardplan.py manifest\n"
+          "  --placements a,b,...      (default RoCC,Chiplet,PCIeLocalCache,PCIeNoCache;\n"
+          "                            SpecN is RoCC at width N)\n"
+          "  --hists a,b,...           hist SRAM bytes (default 65536 down to 2048)\n"
+          "  --widths a,b,...          Huffman speculation widths (default 16)\n"
+          "  --reps N                  calls per benchmark, as the FireSim runs\n"
+          "                            repeat them (default 1)\n"
+          "  --calibration F           start from this calibration\n"
+          "  --calibrate F             fit the calibration to this FireSim CSV\n"
+          "  --save F                  and write it to F\n"
+          "  --out F                   the sweep CSV (default stdout)\n"
+          "  --threads N               tracing threads (default: one per core)\n",
+          argv0);
+}
+
+template <typename T, typename Parse>
+std::vector<T> SplitList(const std::string& list, Parse parse) {
+  std::vector<T> items;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (!item.empty()) {
+      items.push_back(parse(item));
+    }
+  }
+  return items;
+}
+
+bool ParseOptions(int argc, char** argv, Options* opts) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      fprintf(stderr, "%s needs a value\n", arg.c_str());
+      return false;
+    }
+    std::string value = argv[++i];
+    if (arg == "--dir") {
+      opts->dir = value;
+    } else if (arg == "--corpus") {
+      opts->corpus = value;
+    } else if (arg == "--manifest") {
+      opts->manifest = value;
+    } else if (arg == "--shard") {
+      opts->shard = strtoul(value.c_str(), nullptr, 0);
+    } else if (arg == "--shards") {
+      opts->num_shards = strtoul(value.c_str(), nullptr, 0);
+    } else if (arg == "--placements") {
+      opts->placements = SplitList<std::string>(value, [](const std::string& s) { return s; });
+    } else if (arg == "--hists") {
+      opts->hists = SplitList<uint64_t>(
+          value, [](const std::string& s) { return strtoull(s.c_str(), nullptr, 0); });
+    } else if (arg == "--widths") {
+      opts->widths = SplitList<int>(
+          value, [](const std::string& s) { return (int)strtol(s.c_str(), nullptr, 0); });
+    } else if (arg == "--reps") {
+      opts->reps = strtoul(value.c_str(), nullptr, 0);
+    } else if (arg == "--calibration") {
+      opts->calibration = value;
+    } else if (arg == "--calibrate") {
+      opts->calibrate_csv = value;
+    } else if (arg == "--save") {
+      opts->save = value;
+    } else if (arg == "--out") {
+      opts->out = value;
+    } else if (arg == "--threads") {
+      opts->threads = strtoul(value.c_str(), nullptr, 0);
+    } else {
+      fprintf(stderr, "unknown option %s\n", arg.c_str());
+      return false;
+    }
+  }
+
+  if (opts->dir.empty() == opts->corpus.empty()) {
+    fprintf(stderr, "give exactly one of --dir and --corpus\n");
+    return false;
+  }
+  if (opts->placements.empty() || opts->hists.empty() || opts->widths.empty()) {
+    fprintf(stderr, "nothing to sweep\n");
+    return false;
+  }
+  for (int width : opts->widths) {
+    if (width <= 0) {
+      fprintf(stderr, "bad speculation width %d\n", width);
+      return false;
+    }
+  }
+  ZstdModelConfig check;
+  for (const std::string& placement : opts->placements) {
+    if (!SetZstdModelPlacement(placement, &check)) {
+      fprintf(stderr, "unknown placement %s\n", placement.c_str());
+      return false;
+    }
+  }
+  if (opts->reps == 0) {
+    fprintf(stderr, "--reps must be at least 1\n");
+    return false;
+  }
+  if (!opts->save.empty() && opts->calibrate_csv.empty()) {
+    fprintf(stderr, "--save needs --calibrate\n");
+    return false;
+  }
+  return true;
+}
+
+// Decodes and records every benchmark, in parallel. Returns false (after
+// printing why) if one doesn't decode to its input.
+bool TraceBenchmarks(const std::vector<Benchmark>& benchmarks, unsigned int num_threads,
+                     std::vector<ZstdCallTrace>* traces) {
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  num_threads = std::max<size_t>(1, std::min<size_t>(num_threads, benchmarks.size()));
+  traces->resize(benchmarks.size());
+  std::vector<char> ok(benchmarks.size(), 0);
+  std::vector<std::thread> workers;
+  for (unsigned int t = 0; t < num_threads; t++) {
+    workers.emplace_back([&, t]() {
+      std::vector<uint8_t> dst;
+      for (size_t i = t; i < benchmarks.size(); i += num_threads) {
+        const Benchmark& bench = benchmarks[i];
+        dst.resize(bench.raw.size() + 1);
+        size_t got = TraceZstdCall(bench.comp.data(), bench.comp.size(), dst.data(), dst.size(),
+                                   &(*traces)[i]);
+        ok[i] = (got == bench.raw.size()) && (memcmp(dst.data(), bench.raw.data(), got) == 0);
+      }
+    });
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  for (size_t i = 0; i < benchmarks.size(); i++) {
+    if (!ok[i]) {
+      fprintf(stderr, "FAIL: reference decode of %s\n", benchmarks[i].name.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ReadFireSimCsv(const std::string& path, std::vector<FireSimRow>* rows) {
+  std::ifstream csv(path);
+  if (!csv) {
+    fprintf(stderr, "could not open FireSim results %s\n", path.c_str());
+    return false;
+  }
+  // placement,sram_size,cycles,uncomp_data_size,area
+  std::string line;
+  while (std::getline(csv, line)) {
+    std::vector<std::string> fields = SplitList<std::string>(line, [](const std::string& s) {
+      return s;
+    });
+    if ((fields.size() < 4) || (fields[0] == "placement")) {
+      continue;
+    }
+    FireSimRow row = {fields[0], strtoull(fields[1].c_str(), nullptr, 10),
+                      strtod(fields[2].c_str(), nullptr), strtod(fields[3].c_str(), nullptr)};
+    if (row.cycles > 0) {
+      rows->push_back(row);
+    }
+  }
+  if (rows->empty()) {
+    fprintf(stderr, "%s has no results\n", path.c_str());
+    return false;
+  }
+  return true;
+}
+
+// The config a row of a FireSim CSV was run with.
+bool RowConfig(const Options& opts, const FireSimRow& row, ZstdModelConfig* config) {
+  config->huf_speculation = opts.widths[0];
+  config->hist_sram_bytes = row.sram_size;
+  return SetZstdModelPlacement(row.placement, config);
+}
+
+double TotalRawCycles(std::vector<ZstdCallTrace>* traces, const ZstdModelConfig& config) {
+  double cycles = 0;
+  for (ZstdCallTrace& trace : *traces) {
+    cycles += ZstdModelRawCycles(&trace, config);
+  }
+  return cycles;
+}
+
+// Fits the calibration to the FireSim rows: mem_latency by search, and for
+// each candidate scale and call_overhead by least squares on the relative
+// error of every row's total cycles.
+bool Calibrate(const Options& opts, std::vector<ZstdCallTrace>* traces,
+               const std::vector<FireSimRow>& rows, ZstdModelConfig* base) {
+  std::vector<FireSimRow> used;
+  std::vector<ZstdModelConfig> configs;
+  double uncomp_bytes = 0;
+  for (const ZstdCallTrace& trace : *traces) {
+    uncomp_bytes += trace.uncomp_len;
+  }
+  uncomp_bytes *= opts.reps;
+  for (const FireSimRow& row : rows) {
+    ZstdModelConfig config = *base;
+    if (!RowConfig(opts, row, &config)) {
+      fprintf(stderr, "skipping row of unknown placement %s\n", row.placement.c_str());
+      continue;
+    }
+    if (std::fabs(row.uncomp_bytes - uncomp_bytes) > 0.001 * uncomp_bytes) {
+      fprintf(stderr, "warning: %s %llu decompressed %.0f bytes, these benchmarks x %u reps are %.0f\n",
+              row.placement.c_str(), (unsigned long long)row.sram_size, row.uncomp_bytes,
+              opts.reps, uncomp_bytes);
+    }
+    used.push_back(row);
+    configs.push_back(config);
+  }
+  if (used.empty()) {
+    fprintf(stderr, "no FireSim rows to calibrate against\n");
+    return false;
+  }
+  double calls = (double)traces->size() * opts.reps;
+
+  struct Fit {
+    double mem_latency, scale, call_overhead, error;
+  };
+  auto fit_at = [&](double mem_latency) {
+    double a = 0, b = 0, c = 0, d = 0, e = 0;
+    std::vector<double> raw(used.size());
+    for (size_t i = 0; i < used.size(); i++) {
+      configs[i].mem_latency = mem_latency;
+      raw[i] = TotalRawCycles(traces, configs[i]) * opts.reps;
+      double w = 1.0 / (used[i].cycles * used[i].cycles);
+      a += w * raw[i] * raw[i];
+      b += w * raw[i] * calls;
+      c += w * calls * calls;
+      d += w * raw[i] * used[i].cycles;
+      e += w * calls * used[i].cycles;
+    }
+    Fit fit = {mem_latency, 0, 0, 0};
+    double det = a * c - b * b;
+    if (det > 1e-9 * a * c) {
+      fit.scale = (d * c - e * b) / det;
+      fit.call_overhead = (a * e - b * d) / det;
+    }
+    if ((det <= 1e-9 * a * c) || (fit.call_overhead < 0) || (fit.scale <= 0)) {
+      fit.scale = d / a;
+      fit.call_overhead = 0;
+    }
+    for (size_t i = 0; i < used.size(); i++) {
+      double rel = (fit.scale * raw[i] + fit.call_overhead * calls) / used[i].cycles - 1;
+      fit.error += rel * rel;
+    }
+    fit.error = std::sqrt(fit.error / used.size());
+    return fit;
+  };
+
+  // coarse, then around the best
+  Fit best = fit_at(0);
+  for (double lat = 4; lat <= 400; lat += 4) {
+    Fit fit = fit_at(lat);
+    if (fit.error < best.error) {
+      best = fit;
+    }
+  }
+  double center = best.mem_latency;
+  for (double lat = std::max(0.0, center - 4); lat <= center + 4; lat += 0.5) {
+    Fit fit = fit_at(lat);
+    if (fit.error < best.error) {
+      best = fit;
+    }
+  }
+  base->mem_latency = best.mem_latency;
+  base->scale = best.scale;
+  base->call_overhead = best.call_overhead;
+
+  fprintf(stderr, "calibration: mem_latency %.1f scale %.4f call_overhead %.0f, rms error %.2f%%\n",
+          base->mem_latency, base->scale, base->call_overhead, 100 * best.error);
+  fprintf(stderr, "%-16s %10s %16s %16s %8s\n", "placement", "sram_size", "firesim", "model",
+          "error");
+  for (size_t i = 0; i < used.size(); i++) {
+    ZstdModelConfig config = configs[i];
+    config.mem_latency = base->mem_latency;
+    config.scale = base->scale;
+    config.call_overhead = base->call_overhead;
+    double model = 0;
+    for (ZstdCallTrace& trace : *traces) {
+      model += ZstdModelCycles(&trace, config);
+    }
+    model *= opts.reps;
+    fprintf(stderr, "%-16s %10llu %16.0f %16.0f %7.2f%%\n", used[i].placement.c_str(),
+            (unsigned long long)used[i].sram_size, used[i].cycles, model,
+            100 * (model / used[i].cycles - 1));
+  }
+  return opts.save.empty() || SaveZstdModelCalibration(opts.save, *base);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opts;
+  if (!ParseOptions(argc, argv, &opts)) {
+    Usage(argv[0]);
+    return 2;
+  }
+
+  std::vector<ZstdCallTrace> traces;
+  uint64_t uncomp_bytes = 0;
+  {
+    std::vector<Benchmark> benchmarks;
+    bool loaded = opts.corpus.empty()
+                      ? LoadBenchmarkDir(opts.dir, BenchFormat::kZstd, opts.manifest, opts.shard,
+                                         opts.num_shards, &benchmarks)
+                      : LoadBenchmarkCorpus(opts.corpus, opts.manifest, opts.shard,
+                                            opts.num_shards, &benchmarks);
+    if (!loaded) {
+      return 1;
+    }
+    if (benchmarks.empty()) {
+      fprintf(stderr, "no benchmarks\n");
+      return 1;
+    }
+    if (!TraceBenchmarks(benchmarks, opts.threads, &traces)) {
+      return 1;
+    }
+    for (const Benchmark& bench : benchmarks) {
+      uncomp_bytes += bench.raw.size();
+    }
+  }
+  fprintf(stderr, "%zu benchmarks traced\n", traces.size());
+
+  ZstdModelConfig base;
+  if (!opts.calibration.empty() && !LoadZstdModelCalibration(opts.calibration, &base)) {
+    return 1;
+  }
+  if (!opts.calibrate_csv.empty()) {
+    std::vector<FireSimRow> rows;
+    if (!ReadFireSimCsv(opts.calibrate_csv, &rows) ||
+        !Calibrate(opts, &traces, rows, &base)) {
+      return 1;
+    }
+  }
+
+  FILE* out = stdout;
+  if (!opts.out.empty()) {
+    out = fopen(opts.out.c_str(), "w");
+    if (out == nullptr) {
+      fprintf(stderr, "could not write %s\n", opts.out.c_str());
+      return 1;
+    }
+  }
+  auto start = std::chrono::steady_clock::now();
+  size_t points = 0;
+  fprintf(out, "placement,sram_size,cycles,uncomp_data_size,area,width\n");
+  for (const std::string& placement : opts.placements) {
+    for (int width : opts.widths) {
+      for (uint64_t hist : opts.hists) {
+        ZstdModelConfig config = base;
+        config.huf_speculation = width;
+        config.hist_sram_bytes = hist;
+        SetZstdModelPlacement(placement, &config);
+        double cycles = 0;
+        for (ZstdCallTrace& trace : traces) {
+          cycles += ZstdModelCycles(&trace, config);
+        }
+        fprintf(out, "%s,%llu,%.0f,%llu,,%d\n", placement.c_str(), (unsigned long long)hist,
+                cycles * opts.reps, (unsigned long long)uncomp_bytes * opts.reps,
+                config.huf_speculation);
+        points++;
+      }
+    }
+  }
+  double took = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  fprintf(stderr, "%zu design points in %.2f s\n", points, took);
+  if ((out != stdout) && (fclose(out) != 0)) {
+    fprintf(stderr, "could not write %s\n", opts.out.c_str());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,455 @@
+// Native host benchmark: runs a HyperCompressBench shard through the software
+// codecs built in (and the accelerator models: the throughput model when
+// given its FireSim results, the performance model when asked for) with
+// lzbench's methodology, and writes one draw-plot baseline CSV per codec.
+//
+// Each benchmark file is one call, compressed at its own level or
+// decompressed from its .comp. A call is repeated until --min-time-ms has
+// passed and the fastest repetition counts, as lzbench -t does with
+// LZBENCH_DIFF applied; every call's output is checked against the input.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "benchset.h"
+#include "codecs.h"
+
+namespace {
+
+struct Options {
+  std::string dir;
+  std::string corpus;
+  std::string manifest;
+  BenchFormat format = BenchFormat::kZstd;
+  uint32_t shard = 0;
+  uint32_t num_shards = 1;
+  bool compress = true;
+  bool decompress = true;
+  std::vector<std::string> codecs;  // empty: every codec of the format
+  double min_time_ms = 100.0;
+  std::string out_dir = ".";
+  bool buckets = false;
+
+  std::string accel_csv;
+  bool accel_model = false;
+  std::string accel_calibration;
+  std::string accel_placement = "RoCC";
+  uint64_t accel_hist = 64 << 10;
+  int accel_width = 16;
+  double accel_ghz = 2.0;
+};
+
+struct Totals {
+  uint64_t uncomp_bytes = 0;
+  uint64_t comp_bytes = 0;
+  double seconds = 0.0;
+  uint32_t calls = 0;
+
+  void Add(const Benchmark& bench, size_t comp_len, double call_seconds) {
+    uncomp_bytes += bench.raw.size();
+    comp_bytes += comp_len;
+    seconds += call_seconds;
+    calls++;
+  }
+};
+
+// Totals per log2 uncompressed size bucket, as the sweep driver's
+// hcb-decompress-bucket records: bucket b holds sizes in [2^b, 2^(b+1)).
+typedef std::map<unsigned int, Totals> BucketTotals;
+
+unsigned int SizeBucket(uint64_t size) {
+  unsigned int bucket = 0;
+  while (size > 1) {
+    size >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+void AddCall(const Benchmark& bench, size_t comp_len, double call_seconds,
+             Totals* totals, BucketTotals* buckets) {
+  totals->Add(bench, comp_len, call_seconds);
+  (*buckets)[SizeBucket(bench.raw.size())].Add(bench, comp_len, call_seconds);
+}
+
+void Usage(const char* argv0) {
+  fprintf(stderr,
+          "usage: %s (--dir <benchmark dir> | --corpus <corpus file>) [options]\n"
+          "  --format zstd|snappy      benchmark format (default zstd)\n"
+          "  --shard N --shards M      run shard N of M (default: everything)\n"
+          "  --manifest F              or shard N of this shardplan.py manifest\n"
+          "  --op compress|decompress|both   (default both)\n"
+          "  --codecs a,b,...          codecs to run (default: all of the format)\n"
+          "  --min-time-ms T           per-call repetition time (default 100)\n"
+          "  --out-dir D               where HOST_<CODEC>_RESULT.csv go (default .)\n"
+          "  --buckets 0|1             also write HOST_<CODEC>_BUCKETS.csv, per\n"
+          "                            log2 call-size bucket (default 0)\n"
+          "  --accel-csv F             add the accelerator model, from the CSV\n"
+          "                            process-resultdir-decompress.py writes\n"
+          "  --accel-model 0|1         add the accelerator performance model\n"
+          "                            (zstdmodel.h, default 0)\n"
+          "  --calibration F           its decompmodel calibration\n"
+          "  --width N                 its Huffman speculation width (default 16)\n"
+          "  --placement P --hist B    the models' placement and hist SRAM bytes\n"
+          "                            (default RoCC, 65536)\n"
+          "  --ghz G                   their clock (default 2.0, as draw-plot)\n",
+          argv0);
+}
+
+std::vector<std::string> SplitList(const std::string& list) {
+  std::vector<std::string> items;
+  size_t start = 0;
+  while (start <= list.size()) {
+    size_t end = list.find(',', start);
+    if (end == std::string::npos) {
+      end = list.size();
+    }
+    if (end > start) {
+      items.push_back(list.substr(start, end - start));
+    }
+    start = end + 1;
+  }
+  return items;
+}
+
+bool ParseOptions(int argc, char** argv, Options* opts) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      fprintf(stderr, "%s needs a value\n", arg.c_str());
+      return false;
+    }
+    std::string value = argv[++i];
+    if (arg == "--dir") {
+      opts->dir = value;
+    } else if (arg == "--corpus") {
+      opts->corpus = value;
+    } else if (arg == "--format") {
+      if (value == "zstd") {
+        opts->format = BenchFormat::kZstd;
+      } else if (value == "snappy") {
+        opts->format = BenchFormat::kSnappy;
+      } else {
+        fprintf(stderr, "unknown format %s\n", value.c_str());
+        return false;
+      }
+    } else if (arg == "--shard") {
+      opts->shard = strtoul(value.c_str(), nullptr, 0);
+    } else if (arg == "--manifest") {
+      opts->manifest = value;
+    } else if (arg == "--shards") {
+      opts->num_shards = strtoul(value.c_str(), nullptr, 0);
+    } else if (arg == "--op") {
+      opts->compress = (value == "compress") || (value == "both");
+      opts->decompress = (value == "decompress") || (value == "both");
+      if (!opts->compress && !opts->decompress) {
+        fprintf(stderr, "unknown op %s\n", value.c_str());
+        return false;
+      }
+    } else if (arg == "--codecs") {
+      opts->codecs = SplitList(value);
+    } else if (arg == "--min-time-ms") {
+      opts->min_time_ms = strtod(value.c_str(), nullptr);
+    } else if (arg == "--out-dir") {
+      opts->out_dir = value;
+    } else if (arg == "--buckets") {
+      opts->buckets = (value == "1");
+    } else if (arg == "--accel-csv") {
+      opts->accel_csv = value;
+    } else if (arg == "--accel-model") {
+      opts->accel_model = (value == "1");
+    } else if (arg == "--calibration") {
+      opts->accel_calibration = value;
+    } else if (arg == "--width") {
+      opts->accel_width = strtol(value.c_str(), nullptr, 0);
+    } else if (arg == "--placement") {
+      opts->accel_placement = value;
+    } else if (arg == "--hist") {
+      opts->accel_hist = strtoull(value.c_str(), nullptr, 0);
+    } else if (arg == "--ghz") {
+      opts->accel_ghz = strtod(value.c_str(), nullptr);
+    } else {
+      fprintf(stderr, "unknown option %s\n", arg.c_str());
+      return false;
+    }
+  }
+
+  if (opts->dir.empty() == opts->corpus.empty()) {
+    fprintf(stderr, "give exactly one of --dir and --corpus\n");
+    return false;
+  }
+  if (!opts->corpus.empty() && (opts->format != BenchFormat::kZstd)) {
+    fprintf(stderr, "corpus archives hold zstd benchmarks\n");
+    return false;
+  }
+  if (opts->manifest.empty() && (opts->num_shards > 1) && (opts->shard >= opts->num_shards)) {
+    fprintf(stderr, "shard %u out of range for %u shards\n", opts->shard, opts->num_shards);
+    return false;
+  }
+  if (opts->accel_ghz <= 0) {
+    fprintf(stderr, "bad clock %f GHz\n", opts->accel_ghz);
+    return false;
+  }
+  if (opts->accel_width <= 0) {
+    fprintf(stderr, "bad speculation width %d\n", opts->accel_width);
+    return false;
+  }
+  return true;
+}
+
+bool Selected(const Options& opts, const Codec& codec) {
+  if (codec.Format() != opts.format) {
+    return false;
+  }
+  if (opts.codecs.empty()) {
+    return true;
+  }
+  for (const std::string& name : opts.codecs) {
+    if ((name == codec.Name()) || (codec.Modeled() && (name == "accel"))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Times fn() the lzbench way: repeated for at least min_time_ms, fastest
+// repetition in seconds.
+template <typename Fn>
+double FastestCall(double min_time_ms, Fn fn) {
+  using clock = std::chrono::steady_clock;
+  double fastest = 0.0;
+  clock::time_point start = clock::now();
+  for (uint64_t rep = 0;; rep++) {
+    clock::time_point t1 = clock::now();
+    fn();
+    clock::time_point t2 = clock::now();
+    double took = std::chrono::duration<double>(t2 - t1).count();
+    if ((rep == 0) || (took < fastest)) {
+      fastest = took;
+    }
+    if (std::chrono::duration<double, std::milli>(t2 - start).count() >= min_time_ms) {
+      return fastest;
+    }
+  }
+}
+
+bool SameBytes(const uint8_t* got, size_t got_len, const std::vector<uint8_t>& want) {
+  return (got_len == want.size()) && (memcmp(got, want.data(), got_len) == 0);
+}
+
+// A checker for compress calls: a zstd codec's output must decode with the
+// reference decoder, a snappy codec's with the codec itself.
+bool CheckCompressed(Codec* codec, Codec* reference, const uint8_t* comp,
+                     size_t comp_len, const Benchmark& bench,
+                     std::vector<uint8_t>* scratch) {
+  Codec* checker = (codec->Format() == BenchFormat::kZstd) ? reference : codec;
+  scratch->resize(bench.raw.size() + 1);
+  size_t got = checker->Decompress(comp, comp_len, scratch->data(), scratch->size());
+  return SameBytes(scratch->data(), got, bench.raw);
+}
+
+bool RunCompress(const Options& opts, Codec* codec, Codec* reference,
+                 const std::vector<Benchmark>& benchmarks, Totals* totals,
+                 BucketTotals* buckets) {
+  std::vector<uint8_t> dst, scratch;
+  for (const Benchmark& bench : benchmarks) {
+    // snappy's MaxCompressedLength and zstd's bound are both under this
+    dst.resize(bench.raw.size() + bench.raw.size() / 6 + (64 << 10));
+    size_t comp_len = codec->Compress(bench.raw.data(), bench.raw.size(), bench.level,
+                                      dst.data(), dst.size());
+    if ((comp_len == 0) || !CheckCompressed(codec, reference, dst.data(), comp_len,
+                                            bench, &scratch)) {
+      fprintf(stderr, "FAIL: %s compress %s\n", codec->Name(), bench.name.c_str());
+      return false;
+    }
+    double seconds = FastestCall(opts.min_time_ms, [&]() {
+      codec->Compress(bench.raw.data(), bench.raw.size(), bench.level, dst.data(), dst.size());
+    });
+    AddCall(bench, comp_len, seconds, totals, buckets);
+  }
+  return true;
+}
+
+bool RunDecompress(const Options& opts, Codec* codec,
+                   const std::vector<Benchmark>& benchmarks, Totals* totals,
+                   BucketTotals* buckets) {
+  std::vector<uint8_t> dst;
+  for (const Benchmark& bench : benchmarks) {
+    dst.resize(bench.raw.size() + 1);
+    size_t got = codec->Decompress(bench.comp.data(), bench.comp.size(), dst.data(), dst.size());
+    if (!SameBytes(dst.data(), got, bench.raw)) {
+      fprintf(stderr, "FAIL: %s decompress %s\n", codec->Name(), bench.name.c_str());
+      return false;
+    }
+    double seconds;
+    if (codec->Modeled()) {
+      seconds = codec->ModeledDecompressSeconds(bench.comp.size(), bench.raw.size());
+    } else {
+      seconds = FastestCall(opts.min_time_ms, [&]() {
+        codec->Decompress(bench.comp.data(), bench.comp.size(), dst.data(), dst.size());
+      });
+    }
+    AddCall(bench, bench.comp.size(), seconds, totals, buckets);
+  }
+  return true;
+}
+
+std::string ResultPath(const Options& opts, const Codec& codec, const char* kind) {
+  std::string name = codec.Name();
+  for (char& c : name) {
+    c = (c == '-') ? '_' : toupper(static_cast<unsigned char>(c));
+  }
+  return opts.out_dir + "/HOST_" + name + "_" + kind + ".csv";
+}
+
+// The xeon-postprocess*.py schema, so draw-plot takes it as --xeon-csv.
+bool WriteResult(const std::string& path, const Codec& codec,
+                 const Totals* comp, const Totals* decomp) {
+  FILE* f = fopen(path.c_str(), "w");
+  if (f == nullptr) {
+    fprintf(stderr, "could not write %s\n", path.c_str());
+    return false;
+  }
+  fprintf(f, "OPERATION,uncomp_data_size,comp_data_size,time_s\n");
+  if (comp != nullptr) {
+    fprintf(f, "COMPRESS,%llu,%llu,%.9g\n", (unsigned long long)comp->uncomp_bytes,
+            (unsigned long long)comp->comp_bytes, comp->seconds);
+  }
+  if (decomp != nullptr) {
+    fprintf(f, "DECOMPRESS,%llu,%llu,%.9g\n", (unsigned long long)decomp->uncomp_bytes,
+            (unsigned long long)decomp->comp_bytes, decomp->seconds);
+  }
+  return fclose(f) == 0;
+}
+
+// The same per size bucket, with the bucket after OPERATION.
+bool WriteBuckets(const std::string& path, const BucketTotals* comp,
+                  const BucketTotals* decomp) {
+  FILE* f = fopen(path.c_str(), "w");
+  if (f == nullptr) {
+    fprintf(stderr, "could not write %s\n", path.c_str());
+    return false;
+  }
+  fprintf(f, "OPERATION,bucket,calls,uncomp_data_size,comp_data_size,time_s\n");
+  const BucketTotals* ops[] = {comp, decomp};
+  const char* names[] = {"COMPRESS", "DECOMPRESS"};
+  for (int op = 0; op < 2; op++) {
+    if (ops[op] == nullptr) {
+      continue;
+    }
+    for (const auto& bucket : *ops[op]) {
+      const Totals& t = bucket.second;
+      fprintf(f, "%s,%u,%u,%llu,%llu,%.9g\n", names[op], bucket.first, t.calls,
+              (unsigned long long)t.uncomp_bytes, (unsigned long long)t.comp_bytes, t.seconds);
+    }
+  }
+  return fclose(f) == 0;
+}
+
+void PrintSummary(const Codec& codec, const char* op, const Totals& totals) {
+  double mbps = (totals.seconds > 0) ? totals.uncomp_bytes / totals.seconds / 1e6 : 0.0;
+  double ratio = (totals.comp_bytes > 0) ? (double)totals.uncomp_bytes / totals.comp_bytes : 0.0;
+  printf("%-24s %-10s %6u calls %12llu -> %12llu bytes (ratio %.3f) %12.6f s %10.2f MB/s%s\n",
+         codec.Name(), op, totals.calls, (unsigned long long)totals.uncomp_bytes,
+         (unsigned long long)totals.comp_bytes, ratio, totals.seconds, mbps,
+         codec.Modeled() ? " (modeled)" : "");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opts;
+  if (!ParseOptions(argc, argv, &opts)) {
+    Usage(argv[0]);
+    return 2;
+  }
+
+  std::vector<Benchmark> benchmarks;
+  bool loaded = opts.corpus.empty()
+                    ? LoadBenchmarkDir(opts.dir, opts.format, opts.manifest, opts.shard,
+                                       opts.num_shards, &benchmarks)
+                    : LoadBenchmarkCorpus(opts.corpus, opts.manifest, opts.shard,
+                                          opts.num_shards, &benchmarks);
+  if (!loaded) {
+    return 1;
+  }
+  if (opts.manifest.empty()) {
+    printf("%zu benchmarks, shard %u of %u\n", benchmarks.size(), opts.shard, opts.num_shards);
+  } else {
+    printf("%zu benchmarks, shard %u of manifest %s\n", benchmarks.size(), opts.shard,
+           opts.manifest.c_str());
+  }
+
+  std::vector<std::unique_ptr<Codec>> codecs = MakeHostCodecs();
+  Codec* reference = codecs[0].get();
+  if (!opts.accel_csv.empty()) {
+    std::unique_ptr<Codec> model = MakeAccelThroughputModel(
+        opts.accel_csv, opts.accel_placement, opts.accel_hist, opts.accel_ghz);
+    if (!model) {
+      return 1;
+    }
+    codecs.push_back(std::move(model));
+  }
+  if (opts.accel_model) {
+    ZstdModelConfig config;
+    config.huf_speculation = opts.accel_width;
+    config.hist_sram_bytes = opts.accel_hist;
+    if (!SetZstdModelPlacement(opts.accel_placement, &config)) {
+      fprintf(stderr, "unknown placement %s\n", opts.accel_placement.c_str());
+      return 1;
+    }
+    if (!opts.accel_calibration.empty() &&
+        !LoadZstdModelCalibration(opts.accel_calibration, &config)) {
+      return 1;
+    }
+    codecs.push_back(MakeAccelPerformanceModel(opts.accel_placement, config, opts.accel_ghz));
+  }
+
+  int ran = 0;
+  for (std::unique_ptr<Codec>& codec : codecs) {
+    if (!Selected(opts, *codec)) {
+      continue;
+    }
+    Totals comp, decomp;
+    BucketTotals comp_buckets, decomp_buckets;
+    bool do_comp = opts.compress && codec->CanCompress();
+    bool do_decomp = opts.decompress && codec->CanDecompress();
+    if (!do_comp && !do_decomp) {
+      continue;
+    }
+    if (do_comp) {
+      if (!RunCompress(opts, codec.get(), reference, benchmarks, &comp, &comp_buckets)) {
+        return 1;
+      }
+      PrintSummary(*codec, "compress", comp);
+    }
+    if (do_decomp) {
+      if (!RunDecompress(opts, codec.get(), benchmarks, &decomp, &decomp_buckets)) {
+        return 1;
+      }
+      PrintSummary(*codec, "decompress", decomp);
+    }
+    if (!WriteResult(ResultPath(opts, *codec, "RESULT"), *codec, do_comp ? &comp : nullptr,
+                     do_decomp ? &decomp : nullptr)) {
+      return 1;
+    }
+    if (opts.buckets &&
+        !WriteBuckets(ResultPath(opts, *codec, "BUCKETS"), do_comp ? &comp_buckets : nullptr,
+                      do_decomp ? &decomp_buckets : nullptr)) {
+      return 1;
+    }
+    ran++;
+  }
+
+  if (ran == 0) {
+    fprintf(stderr, "no selected codec can run the requested operations\n");
+    return 1;
+  }
+  return 0;
+}
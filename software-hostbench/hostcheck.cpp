@@ -0,0 +1,365 @@
+// Host-side checker for accelerator compression outputs, across every shard
+// at once: streams each simulation log, rebuilds the compressed stream of
+// every call in it, decompresses it with the reference decoder and compares
+// against the benchmark input. Replaces get-compressed.py + check.x86, which
+// needed a recompile per log. Output dumps written by the harness
+// (benchdump.h, *.dump) are checked the same way, without the log.
+//
+// Logs are checked in parallel, one per worker thread. Zstd streams are
+// screened with libzstd first when it is built in, so a corrupt stream is
+// reported instead of being fed to the reference decoder, which does not
+// stop on errors. Snappy streams need snappy built in.
+
+#include <sys/stat.h>
+#include <dirent.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "accelout.h"
+#include "benchset.h"
+#include "codecs.h"
+
+namespace {
+
+struct Options {
+  BenchFormat format = BenchFormat::kZstd;
+  std::vector<std::string> input_dirs;
+  std::string corpus;
+  unsigned int threads = 0;  // 0: one per core
+  std::vector<std::string> paths;
+};
+
+struct CallResult {
+  std::string name;
+  bool pass = false;
+  std::string reason;
+  size_t comp_bytes = 0;
+  size_t uncomp_bytes = 0;
+};
+
+struct LogResult {
+  std::string path;
+  bool read_ok = false;
+  std::vector<CallResult> calls;
+};
+
+void Usage(const char* argv0) {
+  fprintf(stderr,
+          "usage: %s [options] <log | dump | results dir> ...\n"
+          "  --format zstd|snappy   stream format (default zstd)\n"
+          "  --inputs DIR           benchmark inputs, <name> or <name>.raw\n"
+          "                         (repeatable)\n"
+          "  --corpus F             or a corpus archive holding them\n"
+          "  --threads N            worker threads (default: one per core)\n"
+          "Results directories are searched for uartlog, *.out and *.dump\n"
+          "files; where a directory has *.dump files, its logs are skipped.\n"
+          "*.dump files are output dumps (benchdump.h), named by their\n"
+          "records. A log's calls are named by its \"Starting benchmark num\"\n"
+          "lines, or by the log's file name without extension.\n",
+          argv0);
+}
+
+bool ParseOptions(int argc, char** argv, Options* opts) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg.compare(0, 2, "--") != 0) {
+      opts->paths.push_back(arg);
+      continue;
+    }
+    if (i + 1 >= argc) {
+      fprintf(stderr, "%s needs a value\n", arg.c_str());
+      return false;
+    }
+    std::string value = argv[++i];
+    if (arg == "--format") {
+      if (value == "zstd") {
+        opts->format = BenchFormat::kZstd;
+      } else if (value == "snappy") {
+        opts->format = BenchFormat::kSnappy;
+      } else {
+        fprintf(stderr, "unknown format %s\n", value.c_str());
+        return false;
+      }
+    } else if (arg == "--inputs") {
+      opts->input_dirs.push_back(value);
+    } else if (arg == "--corpus") {
+      opts->corpus = value;
+    } else if (arg == "--threads") {
+      opts->threads = strtoul(value.c_str(), nullptr, 0);
+    } else {
+      fprintf(stderr, "unknown option %s\n", arg.c_str());
+      return false;
+    }
+  }
+  if (opts->paths.empty()) {
+    fprintf(stderr, "no logs given\n");
+    return false;
+  }
+  if (opts->input_dirs.empty() && opts->corpus.empty()) {
+    fprintf(stderr, "give --inputs or --corpus for the expected outputs\n");
+    return false;
+  }
+  return true;
+}
+
+bool IsDir(const std::string& path) {
+  struct stat st;
+  return (stat(path.c_str(), &st) == 0) && S_ISDIR(st.st_mode);
+}
+
+bool EndsWith(const std::string& s, const std::string& suffix) {
+  return (s.size() >= suffix.size()) &&
+         (s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0);
+}
+
+void FindLogs(const std::string& path, std::vector<std::string>* logs) {
+  DIR* dir = opendir(path.c_str());
+  if (dir == nullptr) {
+    return;
+  }
+  std::vector<std::string> entries;
+  while (struct dirent* entry = readdir(dir)) {
+    std::string name = entry->d_name;
+    if ((name != ".") && (name != "..")) {
+      entries.push_back(name);
+    }
+  }
+  closedir(dir);
+  std::sort(entries.begin(), entries.end());
+  // a run that dumped its outputs has no WRITE_BYTE lines in its log, so the
+  // dumps stand in for the logs next to them
+  bool has_dump = false;
+  for (const std::string& name : entries) {
+    has_dump = has_dump || EndsWith(name, ".dump");
+  }
+  for (const std::string& name : entries) {
+    std::string child = path + "/" + name;
+    if (IsDir(child)) {
+      FindLogs(child, logs);
+    } else if (EndsWith(name, ".dump") ||
+               (!has_dump && ((name == "uartlog") || EndsWith(name, ".out")))) {
+      logs->push_back(child);
+    }
+  }
+}
+
+// The log's file name without directory and extension.
+std::string LogName(const std::string& path) {
+  std::string name = path.substr(path.rfind('/') + 1);
+  size_t dot = name.rfind('.');
+  return (dot == std::string::npos) ? name : name.substr(0, dot);
+}
+
+// Expected outputs by benchmark name, shared by the workers.
+class Inputs {
+ public:
+  bool Load(const Options& opts) {
+    if (!opts.corpus.empty()) {
+      std::vector<Benchmark> benchmarks;
+      if (!LoadBenchmarkCorpus(opts.corpus, "", 0, 1, &benchmarks)) {
+        return false;
+      }
+      for (Benchmark& bench : benchmarks) {
+        raw_[bench.name] = std::move(bench.raw);
+      }
+    }
+    dirs_ = opts.input_dirs;
+    return true;
+  }
+
+  // nullptr if there is no such benchmark. Directory inputs are read on
+  // first use.
+  const std::vector<uint8_t>* Find(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = raw_.find(name);
+    if (found != raw_.end()) {
+      return &found->second;
+    }
+    for (const std::string& dir : dirs_) {
+      for (const char* suffix : {"", ".raw"}) {
+        FILE* f = fopen((dir + "/" + name + suffix).c_str(), "rb");
+        if (f == nullptr) {
+          continue;
+        }
+        std::vector<uint8_t>& raw = raw_[name];
+        uint8_t buf[1 << 16];
+        size_t got;
+        while ((got = fread(buf, 1, sizeof(buf), f)) > 0) {
+          raw.insert(raw.end(), buf, buf + got);
+        }
+        fclose(f);
+        return &raw;
+      }
+    }
+    return nullptr;
+  }
+
+ private:
+  std::vector<std::string> dirs_;
+  std::mutex mutex_;
+  std::map<std::string, std::vector<uint8_t>> raw_;  // node based: stable
+};
+
+Codec* FindCodec(const std::vector<std::unique_ptr<Codec>>& codecs, const char* name) {
+  for (const std::unique_ptr<Codec>& codec : codecs) {
+    if (strcmp(codec->Name(), name) == 0) {
+      return codec.get();
+    }
+  }
+  return nullptr;
+}
+
+void CheckCall(const Options& opts, const std::vector<std::unique_ptr<Codec>>& codecs,
+               Inputs* inputs, const AccelOutput& out, CallResult* result) {
+  result->name = out.name.empty() ? LogName(out.source) : out.name;
+  result->comp_bytes = out.data.size();
+  if (!out.error.empty()) {
+    result->reason = out.error;
+    return;
+  }
+  const std::vector<uint8_t>* raw = inputs->Find(result->name);
+  if (raw == nullptr) {
+    result->reason = "no input named " + result->name;
+    return;
+  }
+  result->uncomp_bytes = raw->size();
+
+  std::vector<uint8_t> dst(raw->size() + 1);
+  Codec* checker;
+  if (opts.format == BenchFormat::kZstd) {
+    Codec* screen = FindCodec(codecs, "zstd");
+    if ((screen != nullptr) &&
+        (screen->Decompress(out.data.data(), out.data.size(), dst.data(), dst.size()) != raw->size())) {
+      result->reason = "not a valid zstd frame of the input's size";
+      return;
+    }
+    checker = FindCodec(codecs, "reference");
+  } else {
+    checker = FindCodec(codecs, "snappy");
+    if (checker == nullptr) {
+      result->reason = "built without snappy";
+      return;
+    }
+  }
+
+  std::fill(dst.begin(), dst.end(), 0);
+  size_t got = checker->Decompress(out.data.data(), out.data.size(), dst.data(), dst.size());
+  if (got != raw->size()) {
+    result->reason = "decompressed to " + std::to_string(got) + " bytes, expected " +
+                     std::to_string(raw->size());
+    return;
+  }
+  auto mismatch = std::mismatch(raw->begin(), raw->end(), dst.begin());
+  if (mismatch.first != raw->end()) {
+    result->reason = "differs at byte " + std::to_string(mismatch.first - raw->begin());
+    return;
+  }
+  result->pass = true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opts;
+  if (!ParseOptions(argc, argv, &opts)) {
+    Usage(argv[0]);
+    return 2;
+  }
+
+  std::vector<std::string> logs;
+  for (const std::string& path : opts.paths) {
+    if (IsDir(path)) {
+      FindLogs(path, &logs);
+    } else {
+      logs.push_back(path);
+    }
+  }
+  if (logs.empty()) {
+    fprintf(stderr, "no logs found\n");
+    return 1;
+  }
+
+  Inputs inputs;
+  if (!inputs.Load(opts)) {
+    return 1;
+  }
+
+  unsigned int num_threads = opts.threads;
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  num_threads = std::min<size_t>(num_threads, logs.size());
+
+  std::vector<LogResult> results(logs.size());
+  std::atomic<size_t> next_log(0);
+  std::vector<std::thread> workers;
+  for (unsigned int t = 0; t < num_threads; t++) {
+    workers.emplace_back([&]() {
+      // codecs keep per-instance contexts, so each worker has its own
+      std::vector<std::unique_ptr<Codec>> codecs = MakeHostCodecs();
+      for (size_t i = next_log++; i < logs.size(); i = next_log++) {
+        LogResult& result = results[i];
+        result.path = logs[i];
+        std::vector<AccelOutput> outputs;
+        if (EndsWith(logs[i], ".dump")) {
+          result.read_ok = ReadOutputDump(logs[i], &outputs);
+        } else {
+          result.read_ok = ReadWriteByteLog(logs[i], opts.format, &outputs);
+        }
+        result.calls.resize(outputs.size());
+        for (size_t c = 0; c < outputs.size(); c++) {
+          CheckCall(opts, codecs, &inputs, outputs[c], &result.calls[c]);
+        }
+      }
+    });
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+
+  // the matrix: one row per log, one column per call, then the failures
+  size_t passed = 0, failed = 0;
+  size_t width = 0;
+  for (const LogResult& result : results) {
+    width = std::max(width, result.path.size());
+  }
+  for (const LogResult& result : results) {
+    printf("%-*s ", (int)width, result.path.c_str());
+    if (!result.read_ok) {
+      printf("unreadable\n");
+      failed++;
+      continue;
+    }
+    if (result.calls.empty()) {
+      printf("no accelerator outputs\n");
+      failed++;
+      continue;
+    }
+    for (const CallResult& call : result.calls) {
+      putchar(call.pass ? '.' : 'F');
+      (call.pass ? passed : failed)++;
+    }
+    putchar('\n');
+  }
+  for (const LogResult& result : results) {
+    for (size_t c = 0; c < result.calls.size(); c++) {
+      const CallResult& call = result.calls[c];
+      if (!call.pass) {
+        printf("FAIL %s call %zu (%s, %zu compressed bytes): %s\n", result.path.c_str(), c,
+               call.name.c_str(), call.comp_bytes, call.reason.c_str());
+      }
+    }
+  }
+  printf("%zu logs, %zu calls passed, %zu failed\n", results.size(), passed, failed);
+  return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,308 @@
+#include "lz77model.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr uint64_t kHashMagic = 0x1e35a7bd;
+constexpr uint32_t kMaxSkipAmt = 16 * 32;
+constexpr uint64_t kChunkBytes = 32;  // memloader / history buffer width
+constexpr uint64_t kSnappyLiteralFlush = 1024;
+constexpr uint64_t kSnappyMaxCopy = 64;
+constexpr uint64_t kPositionMask = (1ull << 48) - 1;
+
+// The low 4 bytes of the memloader output at p.
+uint32_t KeyAt(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Leading bytes of cur that equal those at cur - offset, up to len (<= 32), as
+// the history buffer comparison counts them. The history buffer is written
+// ahead of the reads, so overlapping copies compare like LZ77 expands them.
+uint64_t MatchLength(const uint8_t* prev, const uint8_t* cur, uint64_t len) {
+  uint64_t n = 0;
+  while (n + 8 <= len) {
+    uint64_t a, b;
+    memcpy(&a, prev + n, 8);
+    memcpy(&b, cur + n, 8);
+    if (a != b) {
+      return n + (__builtin_ctzll(a ^ b) >> 3);
+    }
+    n += 8;
+  }
+  while ((n < len) && (prev[n] == cur[n])) {
+    n++;
+  }
+  return n;
+}
+
+uint64_t VarintBytes(uint64_t value) {
+  uint64_t bytes = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    bytes++;
+  }
+  return bytes;
+}
+
+// A Snappy literal element: tag (with 0 to 4 length bytes) and the data.
+uint64_t SnappyLiteralBytes(uint64_t len) {
+  uint64_t tag = (len <= 60) ? 1 : (len <= 256) ? 2 : (len <= 65536) ? 3 : (len <= (1 << 24)) ? 4 : 5;
+  return tag + len;
+}
+
+// A copy of at most 64 bytes as SnappyCompressCopyExpander encodes it.
+uint64_t SnappyCopyBytes(uint64_t offset, uint64_t len) {
+  if ((len >= 4) && (len <= 11) && (offset <= 2047)) {
+    return 2;
+  }
+  return (offset <= 65535) ? 3 : 5;
+}
+
+}  // namespace
+
+Lz77HashMatcherModel::Lz77HashMatcherModel(const Lz77ModelConfig& config) {
+  Configure(config);
+  Reset();
+}
+
+void Lz77HashMatcherModel::Configure(const Lz77ModelConfig& config) {
+  if (config.ht_entries_log2 != config_.ht_entries_log2) {
+    // a RUNTIME_HT_NUM_ENTRIES_LOG2 write: the router forgets the dictionary
+    table_dict_valid_ = false;
+  }
+  config_ = config;
+  hash_shift_ = 32 - config.ht_hw_entries_log2;
+  // the index is masked to the runtime size, then truncated to the SRAM's
+  uint64_t runtime_mask = (1ull << config.ht_entries_log2) - 1;
+  uint64_t hw_mask = (1ull << config.ht_hw_entries_log2) - 1;
+  hash_mask_ = (uint32_t)(runtime_mask & hw_mask);
+  table_.resize((size_t)1 << config.ht_hw_entries_log2, Entry{0, 0});
+}
+
+void Lz77HashMatcherModel::Reset() {
+  std::fill(table_.begin(), table_.end(), Entry{0, 0});
+  write_pending_ = false;
+  request_id_ = 1;
+  skip_amt_ = 32;
+  dict_end_ = 0;
+  input_base_ = 0;
+  next_input_base_ = 0;
+  dict_visible_ = false;
+  table_dict_valid_ = false;
+  table_dict_addr_ = nullptr;
+  table_dict_size_ = 0;
+}
+
+uint32_t Lz77HashMatcherModel::Bucket(uint32_t key) const {
+  return (uint32_t)((kHashMagic * key) >> hash_shift_) & hash_mask_;
+}
+
+Lz77HashMatcherModel::Entry Lz77HashMatcherModel::Cycle(bool lookup, uint32_t key,
+                                                        uint64_t addr) {
+  Entry seen = {0, 0};
+  uint32_t bucket = 0;
+  bool conflict = false;
+  if (lookup) {
+    bucket = Bucket(key);
+    conflict = write_pending_ && (write_bucket_ == bucket);
+    stats_.lookups++;
+    stats_.conflicts += conflict;
+    seen = (conflict && (config_.conflict == Lz77Conflict::kReadNew)) ? write_entry_
+                                                                      : table_[bucket];
+  }
+  if (write_pending_ && !(conflict && (config_.conflict == Lz77Conflict::kDropWrite))) {
+    table_[write_bucket_] = write_entry_;
+  }
+  // every lookup also writes its position
+  write_pending_ = lookup;
+  write_bucket_ = bucket;
+  write_entry_ = Entry{addr, key};
+  stats_.cycles++;
+  return seen;
+}
+
+void Lz77HashMatcherModel::EmitLiterals(uint64_t len, bool end_of_message) {
+  stats_.literal_bytes += len;
+  pending_literals_ += len;
+
+  uint64_t total = snappy_literals_ + len;
+  if ((total >= kSnappyLiteralFlush) || end_of_message) {
+    stats_.snappy_bytes += SnappyLiteralBytes(total);
+    snappy_literals_ = 0;
+  } else {
+    snappy_literals_ = total;
+  }
+
+  if (end_of_message && (pending_literals_ > 0)) {
+    sequences_->push_back(Lz77ModelSequence{(uint32_t)pending_literals_, 0, 0});
+    pending_literals_ = 0;
+  }
+}
+
+void Lz77HashMatcherModel::EmitCopy(uint64_t offset, uint64_t len) {
+  stats_.copies++;
+  stats_.copy_bytes += len;
+  sequences_->push_back(Lz77ModelSequence{(uint32_t)pending_literals_, (uint32_t)len, offset});
+  pending_literals_ = 0;
+
+  if (snappy_literals_ > 0) {
+    stats_.snappy_bytes += SnappyLiteralBytes(snappy_literals_);
+    snappy_literals_ = 0;
+  }
+  for (; len > kSnappyMaxCopy; len -= kSnappyMaxCopy) {
+    stats_.snappy_bytes += SnappyCopyBytes(offset, kSnappyMaxCopy);
+  }
+  stats_.snappy_bytes += SnappyCopyBytes(offset, len);
+}
+
+void Lz77HashMatcherModel::Compress(const uint8_t* dict, size_t dict_size, const uint8_t* src,
+                                    size_t input_len, std::vector<Lz77ModelSequence>* sequences) {
+  sequences_ = sequences;
+  pending_literals_ = 0;
+  snappy_literals_ = 0;
+  stats_.calls++;
+  stats_.input_bytes += input_len;
+  stats_.snappy_bytes += VarintBytes(input_len);
+
+  // the memloader streams the dictionary, then the input
+  const uint8_t* data = src;
+  if (dict_size > 0) {
+    stream_.assign(dict, dict + dict_size);
+    stream_.insert(stream_.end(), src, src + input_len);
+    data = stream_.data();
+  }
+  const uint64_t len = dict_size + input_len;
+
+  // ZstdMatchFinderCommandRouter: the table still holds this dictionary
+  bool resident = table_dict_valid_ &&
+                  ((dict_size == 0) || ((dict == table_dict_addr_) && (dict_size == table_dict_size_)));
+  if (dict_size != 0) {
+    table_dict_valid_ = true;
+    table_dict_addr_ = dict;
+    table_dict_size_ = dict_size;
+  }
+
+  // sWriteUncompressedSizeVarint
+  dict_visible_ = (dict_size != 0);
+  if (resident) {
+    input_base_ = next_input_base_;
+  } else {
+    // new request id: nothing in the table matches any more
+    request_id_++;
+    dict_end_ = dict_size & kPositionMask;
+    input_base_ = dict_size & kPositionMask;
+  }
+  Cycle(false, 0, 0);
+
+  const uint64_t request = (uint64_t)request_id_ << 48;
+  const uint64_t max_offset = config_.max_offset_allowed;
+  auto address = [&](uint64_t pos) {
+    uint64_t position = (pos < dict_size) ? pos : pos - dict_size + input_base_;
+    return request | (position & kPositionMask);
+  };
+  // HashTableBasic's read_resp: has_match, and the offset it reports
+  auto match = [&](const Entry& seen, uint32_t key, uint64_t addr, uint64_t* offset) {
+    uint64_t seen_position = seen.addr & kPositionMask;
+    bool in_dict = seen_position < dict_end_;
+    bool stale = in_dict ? !dict_visible_ : (seen_position < input_base_);
+    *offset = (addr - seen.addr) - (in_dict ? input_base_ - dict_end_ : 0);
+    return (seen.key == key) && ((seen.addr >> 48) == (addr >> 48)) && (seen.addr != addr) &&
+           !stale && (*offset <= max_offset);
+  };
+
+  uint64_t pos = 0;
+  if (resident) {
+    // priming with the dictionary indexed: only the history buffer takes it,
+    // up to 32B per cycle
+    while (pos < dict_size) {
+      Cycle(false, 0, 0);
+      pos += std::min<uint64_t>(kChunkBytes, dict_size - pos);
+    }
+  } else {
+    // priming: the dictionary is inserted a byte per cycle, without lookups
+    for (; pos < dict_size; pos++) {
+      Cycle(false, 0, 0);
+      if (len - pos >= 4) {
+        write_pending_ = true;
+        write_bucket_ = Bucket(KeyAt(data + pos));
+        write_entry_ = Entry{address(pos), KeyAt(data + pos)};
+      }
+    }
+  }
+
+  while (true) {
+    // sClockInHTRead
+    if (len - pos < 4) {
+      EmitLiterals(len - pos, true);
+      Cycle(false, 0, 0);
+      break;
+    }
+    uint32_t key = KeyAt(data + pos);
+    uint64_t addr = address(pos);
+    Entry seen = Cycle(true, key, addr);
+
+    // sHTResultAvailable: a miss emits skip_bytes literals and looks up there
+    uint64_t offset = 0;
+    while (true) {
+      uint64_t match_offset;
+      if (match(seen, key, addr, &match_offset)) {
+        skip_amt_ = 32;
+        offset = match_offset;
+        Cycle(false, 0, 0);
+        break;
+      }
+      uint32_t skip_bytes = skip_amt_ >> 5;
+      uint64_t available = std::min<uint64_t>(kChunkBytes, len - pos);
+      if (skip_bytes + 4 > available) {
+        // only the last chunk is this short
+        EmitLiterals(len - pos, true);
+        Cycle(false, 0, 0);
+        pos = len;
+        break;
+      }
+      EmitLiterals(skip_bytes, false);
+      if (skip_amt_ + skip_bytes <= kMaxSkipAmt) {
+        skip_amt_ += skip_bytes;
+      }
+      pos += skip_bytes;
+      key = KeyAt(data + pos);
+      addr = address(pos);
+      seen = Cycle(true, key, addr);
+    }
+    if (offset == 0) {
+      break;
+    }
+
+    // sHistoryResultAvailable: 32B compared per cycle
+    uint64_t copy_len = 0;
+    bool end_of_message = false;
+    while (true) {
+      uint64_t remaining = len - pos;
+      uint64_t available = std::min<uint64_t>(kChunkBytes, remaining);
+      uint64_t matched = MatchLength(data + pos - offset, data + pos, available);
+      // no table traffic: the last write landed in the cycle of the match
+      stats_.cycles++;
+      if (matched < available) {
+        EmitCopy(offset, copy_len + matched);
+        pos += matched;
+        break;
+      }
+      copy_len += available;
+      pos += available;
+      if (remaining <= kChunkBytes) {
+        EmitCopy(offset, copy_len);
+        end_of_message = true;
+        break;
+      }
+    }
+    if (end_of_message) {
+      break;
+    }
+  }
+
+  // end of buffer
+  next_input_base_ = (input_base_ + input_len) & kPositionMask;
+  sequences_ = nullptr;
+}
@@ -0,0 +1,141 @@
+#ifndef __HOSTBENCH_LZ77MODEL_H
+#define __HOSTBENCH_LZ77MODEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bit-exact model of LZ77HashMatcher and its HashTableBasic, the match finder
+// of the Snappy compressor and of ZstdMatchFinder / the Zstd compressor, so
+// ratio sweeps over hash table sizes and MAX_OFFSET_ALLOWED can run on the
+// host. Given the same calls in the same order it emits the same literals and
+// copies as the RTL:
+//   - one table entry per bucket, Cat(address, key), indexed by
+//     ((0x1e35a7bd * key) >> (32 - hw log2)) & (2^RUNTIME_HT_NUM_ENTRIES_LOG2
+//     - 1), truncated to the hw size; a read matches when key and request id
+//     agree, the entry is not stale (below) and 0 < offset <=
+//     MAX_OFFSET_ALLOWED
+//   - addresses are Cat(16-bit request id, position). The id is 1 after reset
+//     and goes up when a call's header is written, so the first call uses 2;
+//     table contents, request id and skip_amt carry over from call to call as
+//     they do in hardware
+//   - a dictionary is resident when ZstdMatchFinderCommandRouter finds it
+//     so: one was indexed since the last table size write, and the call has
+//     none or the same one (address and size). A resident call keeps the
+//     request id and skips indexing. The dictionary sits at [0, dict_end)
+//     and each input follows the previous one's from input_base; an entry
+//     below input_base is stale unless it is in the dictionary and this call
+//     gave one, and a dictionary entry's offset skips the gap between the two
+//   - a lookup at a position also inserts it; on a miss the matcher emits
+//     skip_amt >> 5 literals and looks up there (skip_amt grows by that much
+//     up to 512 and drops back to 32 on a match); a copy is extended 32B at a
+//     time and the positions it covers are not inserted
+//   - writes land a cycle after their lookup (the RegNext on write_req), so
+//     a lookup can meet the previous cycle's write to the same bucket; what
+//     it then sees is Lz77Conflict
+// Timing is taken as ideal: the memloader always has min(32, remaining)
+// bytes and the writer never stalls. That only matters through the conflict
+// above, which a stall between two lookups hides (the write has landed by
+// then, as with kReadNew). Copies are extended against the input itself, so
+// MAX_OFFSET_ALLOWED is taken to be within the history buffer, as the drivers
+// set it.
+
+struct Lz77ModelSequence {
+  uint32_t literal_length;
+  uint32_t match_length;  // 0 for the literals left at the end of the call
+  uint64_t offset;
+};
+
+// What a lookup sees when the previous cycle's write goes to its bucket.
+enum class Lz77Conflict {
+  kReadNew,    // the write (SRAMs as SFC emits them: registered read address)
+  kReadOld,    // the entry before the write, which still lands
+  kDropWrite,  // the entry before the write, which is lost (CIRCT, per the RTL)
+};
+
+struct Lz77ModelConfig {
+  int ht_entries_log2 = 14;     // RUNTIME_HT_NUM_ENTRIES_LOG2
+  int ht_hw_entries_log2 = 14;  // HashTableBasic numEntriesLog2HW
+  uint64_t max_offset_allowed = (64 << 10) - 64;
+  Lz77Conflict conflict = Lz77Conflict::kReadNew;
+};
+
+struct Lz77ModelStats {
+  uint64_t calls = 0;
+  uint64_t input_bytes = 0;  // dictionaries excluded
+  uint64_t literal_bytes = 0;
+  uint64_t copies = 0;
+  uint64_t copy_bytes = 0;
+  uint64_t lookups = 0;
+  uint64_t conflicts = 0;  // lookups that met a write to their bucket
+  uint64_t cycles = 0;     // matcher FSM cycles at ideal timing
+  // the stream the Snappy compressor writes from these decisions: varint
+  // length header, literals flushed at 1024B or before a copy, copies split
+  // into 64B pieces (SnappyCompressCopyExpander / LitLenInjector)
+  uint64_t snappy_bytes = 0;
+};
+
+class Lz77HashMatcherModel {
+ public:
+  explicit Lz77HashMatcherModel(const Lz77ModelConfig& config = Lz77ModelConfig());
+
+  // Changes the settings as the RoCC writes do: the table is kept, but a
+  // changed table size drops the resident dictionary.
+  void Configure(const Lz77ModelConfig& config);
+  // Back to the state after reset: empty table, request id 1, skip_amt 32,
+  // no resident dictionary.
+  void Reset();
+
+  // One SRC_INFO of len bytes at src, after a DICT_INFO of dict_size bytes at
+  // dict (dict_size 0: none) that is only indexed. Appends the call's
+  // sequences. Whether the dictionary is resident goes by its address, so
+  // pass the same buffer for the same dictionary.
+  void Compress(const uint8_t* dict, size_t dict_size, const uint8_t* src, size_t len,
+                std::vector<Lz77ModelSequence>* sequences);
+
+  // the id the last call used
+  uint16_t request_id() const { return request_id_; }
+  const Lz77ModelStats& stats() const { return stats_; }
+  void ClearStats() { stats_ = Lz77ModelStats(); }
+
+ private:
+  struct Entry {
+    uint64_t addr;
+    uint32_t key;
+  };
+
+  uint32_t Bucket(uint32_t key) const;
+  // One cycle of the table: the lookup of key at addr (if any) is issued and
+  // the previous cycle's write lands. Returns what the lookup reads.
+  Entry Cycle(bool lookup, uint32_t key, uint64_t addr);
+  void EmitLiterals(uint64_t len, bool end_of_message);
+  void EmitCopy(uint64_t offset, uint64_t len);
+
+  Lz77ModelConfig config_;
+  uint32_t hash_mask_ = 0;
+  int hash_shift_ = 0;
+  std::vector<Entry> table_;
+  bool write_pending_ = false;
+  uint32_t write_bucket_ = 0;
+  Entry write_entry_ = {0, 0};
+  uint16_t request_id_ = 1;
+  uint32_t skip_amt_ = 32;
+  // LZ77HashMatcher's dictionary registers (48-bit positions)
+  uint64_t dict_end_ = 0;
+  uint64_t input_base_ = 0;
+  uint64_t next_input_base_ = 0;
+  bool dict_visible_ = false;
+  // the command router's record of the dictionary in the table
+  bool table_dict_valid_ = false;
+  const uint8_t* table_dict_addr_ = nullptr;
+  size_t table_dict_size_ = 0;
+
+  // the call being compressed
+  std::vector<Lz77ModelSequence>* sequences_ = nullptr;
+  std::vector<uint8_t> stream_;  // dictionary and input, as the memloader has them
+  uint64_t pending_literals_ = 0;
+  uint64_t snappy_literals_ = 0;  // LitLenInjector's lit_len_so_far
+  Lz77ModelStats stats_;
+};
+
+#endif  // __HOSTBENCH_LZ77MODEL_H
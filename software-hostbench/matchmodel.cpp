@@ -0,0 +1,452 @@
+// Ratio sweep of the compressors' LZ77 hash matcher on the host with its
+// bit-exact model (lz77model.h): every benchmark of a HyperCompressBench shard
+// is run through the matcher for each hash table size and MAX_OFFSET_ALLOWED,
+// as the accelerator gets it (--format snappy: one call per benchmark; zstd:
+// one call per block, sized as ZstdCompressBlockSize does). Writes one row
+// per design point with the matcher's literal and copy totals and the size
+// of the Snappy stream the compressor would write (for zstd, as if each block
+// were a Snappy call).
+//
+// --dict-bytes lays the calls out as test-dict.c does instead: the first N
+// bytes of each benchmark are a dictionary and the rest is cut into
+// --call-bytes calls (at most 64), each made once without and once with the
+// dictionary, which stays resident from its second use on.
+//
+// --diff-log compares the copies of a single design point with those a
+// simulation of the same calls logged ("Write header for rqid" starts a call,
+// "Emitting copy and ..." are its copies), call by call, and reports the
+// first difference of each call that differs, and any call whose request id
+// differs. The log must come from one matcher, and from reset: table, request
+// id, skip state and the resident dictionary carry over between calls.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchset.h"
+#include "lz77model.h"
+
+namespace {
+
+struct Options {
+  std::string dir;
+  std::string corpus;
+  std::string manifest;
+  BenchFormat format = BenchFormat::kSnappy;
+  uint32_t shard = 0;
+  uint32_t num_shards = 1;
+  std::vector<int> ht_log2s = {14, 13, 12, 11, 10, 9};
+  std::vector<uint64_t> max_offsets = {(64 << 10) - 64};
+  Lz77Conflict conflict = Lz77Conflict::kReadNew;
+  uint32_t reps = 1;
+  size_t dict_bytes = 0;
+  size_t call_bytes = 1024;
+  std::string diff_log;
+  std::string out;
+  unsigned int threads = 0;  // 0: one per core
+};
+
+void Usage(const char* argv0) {
+  fprintf(stderr,
+          "usage: %s (--dir <benchmark dir> | --corpus <corpus file>) [options]\n"
+          "  --format snappy|zstd      how inputs are cut into calls (default snappy)\n"
+          "  --shard N --shards M      run shard N of M (default: everything)\n"
+          "  --manifest F              or shard N of this shardplan.py manifest\n"
+          "  --ht-log2s a,b,...        RUNTIME_HT_NUM_ENTRIES_LOG2 values (default 14\n"
+          "                            down to 9; the table is 2^14 entries)\n"
+          "  --max-offsets a,b,...     MAX_OFFSET_ALLOWED values (default 65472)\n"
+          "  --conflict new|old|drop   what a lookup sees of a write to its bucket\n"
+          "                            the cycle before (default new)\n"
+          "  --reps N                  calls per benchmark, back to back (default 1)\n"
+          "  --dict-bytes N            test-dict.c calls: an N byte dictionary (at most\n"
+          "                            32768) from the front of each benchmark\n"
+          "  --call-bytes N            with --dict-bytes, the call size (default 1024)\n"
+          "  --diff-log F              compare copies with this simulation log\n"
+          "  --out F                   the sweep CSV (default stdout)\n"
+          "  --threads N               design points in parallel (default: one per\n"
+          "                            core)\n",
+          argv0);
+}
+
+template <typename T, typename Parse>
+std::vector<T> SplitList(const std::string& list, Parse parse) {
+  std::vector<T> items;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (!item.empty()) {
+      items.push_back(parse(item));
+    }
+  }
+  return items;
+}
+
+const char* ConflictName(Lz77Conflict conflict) {
+  switch (conflict) {
+    case Lz77Conflict::kReadNew:
+      return "new";
+    case Lz77Conflict::kReadOld:
+      return "old";
+    case Lz77Conflict::kDropWrite:
+      return "drop";
+  }
+  return "?";
+}
+
+bool ParseOptions(int argc, char** argv, Options* opts) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      fprintf(stderr, "%s needs a value\n", arg.c_str());
+      return false;
+    }
+    std::string value = argv[++i];
+    if (arg == "--dir") {
+      opts->dir = value;
+    } else if (arg == "--corpus") {
+      opts->corpus = value;
+    } else if (arg == "--manifest") {
+      opts->manifest = value;
+    } else if (arg == "--format") {
+      if (value == "zstd") {
+        opts->format = BenchFormat::kZstd;
+      } else if (value == "snappy") {
+        opts->format = BenchFormat::kSnappy;
+      } else {
+        fprintf(stderr, "unknown format %s\n", value.c_str());
+        return false;
+      }
+    } else if (arg == "--shard") {
+      opts->shard = strtoul(value.c_str(), nullptr, 0);
+    } else if (arg == "--shards") {
+      opts->num_shards = strtoul(value.c_str(), nullptr, 0);
+    } else if (arg == "--ht-log2s") {
+      opts->ht_log2s = SplitList<int>(
+          value, [](const std::string& s) { return (int)strtol(s.c_str(), nullptr, 0); });
+    } else if (arg == "--max-offsets") {
+      opts->max_offsets = SplitList<uint64_t>(
+          value, [](const std::string& s) { return strtoull(s.c_str(), nullptr, 0); });
+    } else if (arg == "--conflict") {
+      if (value == "new") {
+        opts->conflict = Lz77Conflict::kReadNew;
+      } else if (value == "old") {
+        opts->conflict = Lz77Conflict::kReadOld;
+      } else if (value == "drop") {
+        opts->conflict = Lz77Conflict::kDropWrite;
+      } else {
+        fprintf(stderr, "unknown conflict behavior %s\n", value.c_str());
+        return false;
+      }
+    } else if (arg == "--reps") {
+      opts->reps = strtoul(value.c_str(), nullptr, 0);
+    } else if (arg == "--dict-bytes") {
+      opts->dict_bytes = strtoull(value.c_str(), nullptr, 0);
+    } else if (arg == "--call-bytes") {
+      opts->call_bytes = strtoull(value.c_str(), nullptr, 0);
+    } else if (arg == "--diff-log") {
+      opts->diff_log = value;
+    } else if (arg == "--out") {
+      opts->out = value;
+    } else if (arg == "--threads") {
+      opts->threads = strtoul(value.c_str(), nullptr, 0);
+    } else {
+      fprintf(stderr, "unknown option %s\n", arg.c_str());
+      return false;
+    }
+  }
+
+  if (opts->dir.empty() == opts->corpus.empty()) {
+    fprintf(stderr, "give exactly one of --dir and --corpus\n");
+    return false;
+  }
+  if (opts->ht_log2s.empty() || opts->max_offsets.empty()) {
+    fprintf(stderr, "nothing to sweep\n");
+    return false;
+  }
+  for (int log2 : opts->ht_log2s) {
+    // RUNTIME_HT_NUM_ENTRIES_LOG2 is 5 bits
+    if ((log2 < 0) || (log2 > 31)) {
+      fprintf(stderr, "bad hash table log2 %d\n", log2);
+      return false;
+    }
+  }
+  if (opts->reps == 0) {
+    fprintf(stderr, "--reps must be at least 1\n");
+    return false;
+  }
+  // the split compressor primes at most ZSTD_SPLIT_DICT_MAX_PRIME_BYTES and
+  // gives the match finder one call per 128 KB block
+  if ((opts->dict_bytes > (32 << 10)) || (opts->call_bytes == 0) ||
+      (opts->call_bytes > (128 << 10))) {
+    fprintf(stderr, "--dict-bytes must be at most 32768, --call-bytes 1 to 131072\n");
+    return false;
+  }
+  if (!opts->diff_log.empty() && ((opts->ht_log2s.size() != 1) || (opts->max_offsets.size() != 1))) {
+    fprintf(stderr, "--diff-log needs a single --ht-log2s and --max-offsets\n");
+    return false;
+  }
+  return true;
+}
+
+// The block size the Zstd compressor cuts a source into, as
+// ZstdCompressBlockSize (software-zstd/compress/accellib.c) sets it: the
+// window of the level (ZstdCompressorFrameHeaderBuilder), at most 128 KB.
+size_t ZstdBlockSize(size_t src_size, int level) {
+  static const uint8_t kWindowLog2[] = {16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+                                        16, 17, 18, 19, 20, 21, 21, 21, 21, 21, 21};
+  int index = std::max(0, std::min<int>(level, sizeof(kWindowLog2) - 1));
+  size_t block_size = std::min<size_t>((size_t)1 << kWindowLog2[index], src_size);
+  return std::min<size_t>(std::max<size_t>(block_size, 1), 128 << 10);
+}
+
+// One call's copies, from the model or as the simulation logged them.
+struct CallCopies {
+  unsigned long request_id;
+  std::vector<Lz77ModelSequence> copies;  // literal_length unused
+};
+
+// test-dict.c's MAX_CALLS
+constexpr size_t kDictMaxCalls = 64;
+
+// Every benchmark through one model, in order; with copies, each call's
+// copies are kept for the log diff.
+void RunCalls(const Options& opts, const std::vector<Benchmark>& benchmarks,
+              Lz77HashMatcherModel* model, std::vector<CallCopies>* copies) {
+  std::vector<Lz77ModelSequence> sequences;
+  auto call = [&](const uint8_t* dict, size_t dict_size, const uint8_t* src, size_t len) {
+    sequences.clear();
+    model->Compress(dict, dict_size, src, len, &sequences);
+    if (copies != nullptr) {
+      copies->push_back(CallCopies{model->request_id(), {}});
+      for (const Lz77ModelSequence& seq : sequences) {
+        if (seq.match_length > 0) {
+          copies->back().copies.push_back(seq);
+        }
+      }
+    }
+  };
+  for (const Benchmark& bench : benchmarks) {
+    for (uint32_t rep = 0; rep < opts.reps; rep++) {
+      if (opts.dict_bytes > 0) {
+        const uint8_t* data = bench.raw.data();
+        size_t calls = 0;
+        for (size_t start = opts.dict_bytes; (start < bench.raw.size()) && (calls < kDictMaxCalls);
+             start += opts.call_bytes, calls++) {
+          size_t len = std::min(opts.call_bytes, bench.raw.size() - start);
+          call(nullptr, 0, data + start, len);
+          call(data, opts.dict_bytes, data + start, len);
+        }
+        continue;
+      }
+      if (opts.format == BenchFormat::kSnappy) {
+        call(nullptr, 0, bench.raw.data(), bench.raw.size());
+        continue;
+      }
+      size_t block_size = ZstdBlockSize(bench.raw.size(), bench.level);
+      size_t start = 0;
+      do {
+        size_t block_len = std::min(block_size, bench.raw.size() - start);
+        call(nullptr, 0, bench.raw.data() + start, block_len);
+        start += block_len;
+      } while (start < bench.raw.size());
+    }
+  }
+}
+
+bool ReadMatcherLog(const std::string& path, std::vector<CallCopies>* calls) {
+  FILE* f = fopen(path.c_str(), "r");
+  if (f == nullptr) {
+    fprintf(stderr, "could not open %s\n", path.c_str());
+    return false;
+  }
+  static const char kHeader[] = "Write header for rqid: ";
+  static const char kCopy[] = "Emitting copy and ";
+  char* line = nullptr;
+  size_t line_capacity = 0;
+  while (getline(&line, &line_capacity, f) >= 0) {
+    const char* p = strstr(line, kHeader);
+    if (p != nullptr) {
+      calls->push_back(CallCopies{strtoul(p + strlen(kHeader), nullptr, 10), {}});
+      continue;
+    }
+    p = strstr(line, kCopy);
+    if (p == nullptr) {
+      continue;
+    }
+    const char* offset = strstr(p, "offset: ");
+    const char* length = strstr(p, "length: ");
+    if ((offset == nullptr) || (length == nullptr) || calls->empty()) {
+      continue;
+    }
+    Lz77ModelSequence copy = {0, (uint32_t)strtoull(length + strlen("length: "), nullptr, 10),
+                              strtoull(offset + strlen("offset: "), nullptr, 10)};
+    calls->back().copies.push_back(copy);
+  }
+  free(line);
+  bool ok = !ferror(f);
+  fclose(f);
+  if (!ok) {
+    fprintf(stderr, "error reading %s\n", path.c_str());
+  }
+  return ok;
+}
+
+// Returns the number of calls that differ.
+size_t DiffCalls(const std::vector<CallCopies>& model, const std::vector<CallCopies>& logged) {
+  size_t differ = 0;
+  size_t calls = std::min(model.size(), logged.size());
+  for (size_t i = 0; i < calls; i++) {
+    const std::vector<Lz77ModelSequence>& want = model[i].copies;
+    const std::vector<Lz77ModelSequence>& got = logged[i].copies;
+    size_t k = 0;
+    while ((k < want.size()) && (k < got.size()) &&
+           (want[k].match_length == got[k].match_length) && (want[k].offset == got[k].offset)) {
+      k++;
+    }
+    bool same_id = (logged[i].request_id == model[i].request_id);
+    if (!same_id) {
+      fprintf(stderr, "call %zu: log has rqid %lu, model %lu\n", i, logged[i].request_id,
+              model[i].request_id);
+    }
+    if ((k == want.size()) && (k == got.size())) {
+      differ += !same_id;
+      continue;
+    }
+    differ++;
+    fprintf(stderr, "call %zu: copy %zu of %zu/%zu differs: model ", i, k, want.size(), got.size());
+    if (k < want.size()) {
+      fprintf(stderr, "offset %llu length %u", (unsigned long long)want[k].offset,
+              want[k].match_length);
+    } else {
+      fprintf(stderr, "none");
+    }
+    fprintf(stderr, ", log ");
+    if (k < got.size()) {
+      fprintf(stderr, "offset %llu length %u\n", (unsigned long long)got[k].offset,
+              got[k].match_length);
+    } else {
+      fprintf(stderr, "none\n");
+    }
+  }
+  if (model.size() != logged.size()) {
+    fprintf(stderr, "model made %zu calls, log has %zu\n", model.size(), logged.size());
+    differ += std::max(model.size(), logged.size()) - calls;
+  }
+  return differ;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opts;
+  if (!ParseOptions(argc, argv, &opts)) {
+    Usage(argv[0]);
+    return 2;
+  }
+
+  std::vector<Benchmark> benchmarks;
+  bool loaded = opts.corpus.empty()
+                    ? LoadBenchmarkDir(opts.dir, opts.format, opts.manifest, opts.shard,
+                                       opts.num_shards, &benchmarks)
+                    : LoadBenchmarkCorpus(opts.corpus, opts.manifest, opts.shard,
+                                          opts.num_shards, &benchmarks);
+  if (!loaded) {
+    return 1;
+  }
+  if (benchmarks.empty()) {
+    fprintf(stderr, "no benchmarks\n");
+    return 1;
+  }
+
+  if (!opts.diff_log.empty()) {
+    std::vector<CallCopies> logged;
+    if (!ReadMatcherLog(opts.diff_log, &logged)) {
+      return 1;
+    }
+    Lz77ModelConfig config;
+    config.ht_entries_log2 = opts.ht_log2s[0];
+    config.max_offset_allowed = opts.max_offsets[0];
+    config.conflict = opts.conflict;
+    Lz77HashMatcherModel model(config);
+    std::vector<CallCopies> copies;
+    RunCalls(opts, benchmarks, &model, &copies);
+    size_t differ = DiffCalls(copies, logged);
+    fprintf(stderr, "%zu of %zu calls differ (conflict %s, %llu lookups met a write)\n", differ,
+            std::max(copies.size(), logged.size()), ConflictName(opts.conflict),
+            (unsigned long long)model.stats().conflicts);
+    return (differ == 0) ? 0 : 1;
+  }
+
+  struct Point {
+    Lz77ModelConfig config;
+    Lz77ModelStats stats;
+  };
+  std::vector<Point> points;
+  for (uint64_t max_offset : opts.max_offsets) {
+    for (int log2 : opts.ht_log2s) {
+      Point point;
+      point.config.ht_entries_log2 = log2;
+      point.config.max_offset_allowed = max_offset;
+      point.config.conflict = opts.conflict;
+      points.push_back(point);
+    }
+  }
+
+  unsigned int num_threads = opts.threads;
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  num_threads = std::max<size_t>(1, std::min<size_t>(num_threads, points.size()));
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (unsigned int t = 0; t < num_threads; t++) {
+    workers.emplace_back([&, t]() {
+      for (size_t i = t; i < points.size(); i += num_threads) {
+        Lz77HashMatcherModel model(points[i].config);
+        RunCalls(opts, benchmarks, &model, nullptr);
+        points[i].stats = model.stats();
+      }
+    });
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  double took = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  FILE* out = stdout;
+  if (!opts.out.empty()) {
+    out = fopen(opts.out.c_str(), "w");
+    if (out == nullptr) {
+      fprintf(stderr, "could not write %s\n", opts.out.c_str());
+      return 1;
+    }
+  }
+  fprintf(out,
+          "ht_entries_log2,max_offset,conflict,uncomp_data_size,literal_bytes,copies,copy_bytes,"
+          "lookups,conflicts,cycles,snappy_size,snappy_ratio\n");
+  uint64_t modeled_bytes = 0;
+  for (const Point& point : points) {
+    const Lz77ModelStats& s = point.stats;
+    fprintf(out, "%d,%llu,%s,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%.4f\n",
+            point.config.ht_entries_log2, (unsigned long long)point.config.max_offset_allowed,
+            ConflictName(point.config.conflict), (unsigned long long)s.input_bytes,
+            (unsigned long long)s.literal_bytes, (unsigned long long)s.copies,
+            (unsigned long long)s.copy_bytes, (unsigned long long)s.lookups,
+            (unsigned long long)s.conflicts, (unsigned long long)s.cycles,
+            (unsigned long long)s.snappy_bytes, (double)s.input_bytes / s.snappy_bytes);
+    modeled_bytes += s.input_bytes;
+  }
+  fprintf(stderr, "%zu benchmarks, %zu design points in %.2f s (%.0f MB/s modeled)\n",
+          benchmarks.size(), points.size(), took, modeled_bytes / took / 1e6);
+  if ((out != stdout) && (fclose(out) != 0)) {
+    fprintf(stderr, "could not write %s\n", opts.out.c_str());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,31 @@
+// The in-tree reference decoder (software-zstd/compress/zstd_decompress.c),
+// built for the host bench: its ZSTD_decompress is renamed so libzstd can be
+// linked next to it, its trace printfs are compiled out, and its trace hooks
+// feed the performance model (zstdmodel.cpp). The timed "reference" codec
+// uses the untraced copy in reference_decoder_untraced.c.
+
+#include <stddef.h>
+#include <stdio.h>
+
+void ZstdModelTraceBlock(int block_type, size_t block_len);
+void ZstdModelTraceLiterals(int block_type, size_t regenerated_size, size_t compressed_size,
+                            int num_streams);
+void ZstdModelTraceHufTable(size_t header_bytes, int num_symbs, int max_bits);
+void ZstdModelTraceHufStream(size_t len);
+void ZstdModelTraceHufSymbol(int num_bits);
+void ZstdModelTraceSequences(size_t num_sequences, size_t section_len);
+void ZstdModelTraceSeqTable(int type, int mode, int accuracy_log);
+void ZstdModelTraceSequence(size_t literal_length, size_t match_length, size_t offset);
+
+#define ZDEC_NO_PRINT
+#define ZSTD_decompress RefZstdDecompress
+#define ZSTD_TRACE_BLOCK ZstdModelTraceBlock
+#define ZSTD_TRACE_LITERALS ZstdModelTraceLiterals
+#define ZSTD_TRACE_HUF_TABLE ZstdModelTraceHufTable
+#define ZSTD_TRACE_HUF_STREAM ZstdModelTraceHufStream
+#define ZSTD_TRACE_HUF_SYMBOL ZstdModelTraceHufSymbol
+#define ZSTD_TRACE_SEQUENCES ZstdModelTraceSequences
+#define ZSTD_TRACE_SEQ_TABLE ZstdModelTraceSeqTable
+#define ZSTD_TRACE_SEQUENCE ZstdModelTraceSequence
+
+#include "../software-zstd/compress/zstd_decompress.c"
@@ -0,0 +1,13 @@
+// The reference decoder again, without the trace hooks, for the timed
+// "reference" codec (codecs.cpp): the hooks in reference_decoder.c are calls
+// out per Huffman symbol and per sequence, which would be timed with the
+// decode. Its ZSTD_decompress is renamed RefZstdDecompressUntraced; the
+// Makefile localizes every other symbol so the two copies link together.
+
+#include <stddef.h>
+#include <stdio.h>
+
+#define ZDEC_NO_PRINT
+#define ZSTD_decompress RefZstdDecompressUntraced
+
+#include "../software-zstd/compress/zstd_decompress.c"
@@ -0,0 +1,358 @@
+#include "zstdmodel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+extern "C" size_t RefZstdDecompress(void* const dst, const size_t dst_len,
+                                    const void* const src, const size_t src_len);
+
+namespace {
+
+const double kBeatBytes = 32;         // helper data width
+const double kOutstanding = 32;       // L2MemHelperLatencyInjection numOutstandingReqs
+const double kHeaderOutstanding = 4;  // the block and section header readers
+const double kFarReadsInFlight = 10;  // ZstdOffchipHistoryLookup intermediate queue
+const double kHufIterationCycles = 3; // LOOKUP, SELECT_VALID, SHIFT
+const double kHufStreamSetupCycles = 2;  // REMOVE_PADDING, STREAM_DONE
+
+// The call being traced on this thread, if any.
+thread_local ZstdCallTrace* tracing = nullptr;
+
+struct MemPath {
+  double latency;         // cycles from request to response
+  double cycles_per_beat; // when streaming, bounded by the outstanding requests
+};
+
+MemPath MakeMemPath(const ZstdModelConfig& config, bool behind_cache, double outstanding) {
+  double latency = config.mem_latency;
+  if (!(behind_cache && config.has_intermediate_cache)) {
+    latency += config.latency_inject_cycles;
+  }
+  return {latency, std::max(1.0, latency / outstanding)};
+}
+
+double Beats(uint64_t bytes) {
+  return std::ceil(bytes / kBeatBytes);
+}
+
+// Reading or writing bytes back to back, until the last response.
+double Stream(const MemPath& path, uint64_t bytes) {
+  return path.latency + Beats(bytes) * path.cycles_per_beat;
+}
+
+// Iterations of the literal expander for every Huffman stream of the call,
+// in order: each iteration emits the symbols that chain from the current bit
+// position and start within the first width bits.
+const std::vector<uint32_t>& HufIterations(ZstdCallTrace* trace, int width) {
+  auto found = trace->huf_iterations.find(width);
+  if (found != trace->huf_iterations.end()) {
+    return found->second;
+  }
+  std::vector<uint32_t>& iterations = trace->huf_iterations[width];
+  for (const ZstdTraceBlock& block : trace->blocks) {
+    for (size_t s = 0; s < block.huf_stream_first.size(); s++) {
+      size_t end = (s + 1 < block.huf_stream_first.size()) ? block.huf_stream_first[s + 1]
+                                                           : block.huf_symbols_end;
+      uint32_t count = 0;
+      int pos = width;
+      for (size_t i = block.huf_stream_first[s]; i < end; i++) {
+        if (pos >= width) {
+          count++;
+          pos = 0;
+        }
+        pos += trace->huf_num_bits[i];
+      }
+      iterations.push_back(count);
+    }
+  }
+  return iterations;
+}
+
+double LiteralsCycles(const ZstdTraceBlock& block, const MemPath& header, const MemPath& data,
+                      const MemPath& buffer, const std::vector<uint32_t>& iterations,
+                      size_t* stream) {
+  double cycles = header.latency;
+  switch (block.literals_type) {
+  case 0:
+    cycles += Stream(data, block.literals_size);
+    break;
+  case 1:
+    cycles += Beats(block.literals_size);
+    break;
+  default:
+    if (block.huf_table) {
+      // weights come FSE coded or 4 bits each; the dictionary is filled per entry
+      cycles += Stream(header, block.huf_table_bytes) + 2.0 * block.huf_num_symbs +
+                (1 << block.huf_max_bits);
+    }
+    for (uint32_t len : block.huf_stream_len) {
+      double decode = kHufIterationCycles * iterations[(*stream)++];
+      cycles += data.latency + kHufStreamSetupCycles +
+                std::max(decode, Beats(len) * data.cycles_per_beat);
+    }
+    break;
+  }
+  // the last literals land in the literal buffer before sequences start
+  return cycles + buffer.latency;
+}
+
+// Execution of every block of the call, in order, with matches farther than
+// hist_sram_bytes going off-chip.
+const std::vector<ZstdTraceExec>& Execution(ZstdCallTrace* trace, uint64_t hist_sram_bytes) {
+  auto found = trace->exec.find(hist_sram_bytes);
+  if (found != trace->exec.end()) {
+    return found->second;
+  }
+  std::vector<ZstdTraceExec>& exec = trace->exec[hist_sram_bytes];
+  for (const ZstdTraceBlock& block : trace->blocks) {
+    ZstdTraceExec e;
+    for (size_t i = block.first_sequence; i < block.end_sequence; i++) {
+      const ZstdTraceSequence& seq = trace->sequences[i];
+      e.literal_beats += Beats(seq.literal_length);
+      e.literal_bytes += seq.literal_length;
+      if (seq.match_length > 0) {
+        if (seq.offset <= hist_sram_bytes) {
+          double chunk = std::min<double>(kBeatBytes, seq.offset);
+          e.onchip_cycles += std::ceil(seq.match_length / chunk);
+        } else {
+          e.far_chunks += Beats(seq.match_length);
+        }
+      }
+      e.out_bytes += seq.literal_length + seq.match_length;
+    }
+    exec.push_back(e);
+  }
+  return exec;
+}
+
+double SequencesCycles(const ZstdTraceBlock& block, const ZstdTraceExec& e,
+                       const MemPath& header, const MemPath& data, const MemPath& buffer) {
+  double cycles = header.latency;
+  for (int t = 0; t < 3; t++) {
+    // 2: FSE coded, built by ZstdDTBuilder; predefined tables are a ROM
+    if (block.seq_table_mode[t] == 2) {
+      cycles += 1 << block.seq_table_accuracy[t];
+    } else if (block.seq_table_mode[t] == 1) {
+      cycles += 1;
+    }
+  }
+
+  double decode = data.latency + std::max<double>(block.num_sequences,
+                                                  Beats(block.sequences_len) * data.cycles_per_beat);
+  double exec = e.literal_beats * buffer.cycles_per_beat + e.onchip_cycles;
+  if (e.literal_bytes > 0) {
+    exec += buffer.latency;
+  }
+  if (e.far_chunks > 0) {
+    exec += buffer.latency + e.far_chunks * std::max(1.0, buffer.latency / kFarReadsInFlight);
+  }
+  double writes = Beats(e.out_bytes) * data.cycles_per_beat;
+  return cycles + std::max(decode, std::max(exec, writes)) + data.latency;
+}
+
+}  // namespace
+
+// Trace hooks, compiled into the reference decoder (reference_decoder.c).
+extern "C" {
+
+void ZstdModelTraceBlock(int block_type, size_t block_len) {
+  if (tracing == nullptr) {
+    return;
+  }
+  ZstdTraceBlock block;
+  block.type = block_type;
+  block.len = block_len;
+  block.first_sequence = block.end_sequence = tracing->sequences.size();
+  block.huf_symbols_end = tracing->huf_num_bits.size();
+  tracing->blocks.push_back(block);
+}
+
+void ZstdModelTraceLiterals(int block_type, size_t regenerated_size, size_t compressed_size,
+                            int num_streams) {
+  if ((tracing == nullptr) || tracing->blocks.empty()) {
+    return;
+  }
+  ZstdTraceBlock& block = tracing->blocks.back();
+  block.literals_type = block_type;
+  block.literals_size = regenerated_size;
+}
+
+void ZstdModelTraceHufTable(size_t header_bytes, int num_symbs, int max_bits) {
+  if ((tracing == nullptr) || tracing->blocks.empty()) {
+    return;
+  }
+  ZstdTraceBlock& block = tracing->blocks.back();
+  block.huf_table = true;
+  block.huf_table_bytes = header_bytes + 1;
+  block.huf_num_symbs = num_symbs;
+  block.huf_max_bits = max_bits;
+}
+
+void ZstdModelTraceHufStream(size_t len) {
+  if ((tracing == nullptr) || tracing->blocks.empty()) {
+    return;
+  }
+  ZstdTraceBlock& block = tracing->blocks.back();
+  block.huf_stream_len.push_back(len);
+  block.huf_stream_first.push_back(tracing->huf_num_bits.size());
+}
+
+void ZstdModelTraceHufSymbol(int num_bits) {
+  if ((tracing == nullptr) || tracing->blocks.empty()) {
+    return;
+  }
+  tracing->huf_num_bits.push_back(num_bits);
+  tracing->blocks.back().huf_symbols_end = tracing->huf_num_bits.size();
+}
+
+void ZstdModelTraceSequences(size_t num_sequences, size_t section_len) {
+  if ((tracing == nullptr) || tracing->blocks.empty()) {
+    return;
+  }
+  ZstdTraceBlock& block = tracing->blocks.back();
+  block.num_sequences = num_sequences;
+  block.sequences_len = section_len;
+}
+
+void ZstdModelTraceSeqTable(int type, int mode, int accuracy_log) {
+  if ((tracing == nullptr) || tracing->blocks.empty() || (type < 0) || (type > 2)) {
+    return;
+  }
+  ZstdTraceBlock& block = tracing->blocks.back();
+  block.seq_table_mode[type] = mode;
+  block.seq_table_accuracy[type] = accuracy_log;
+}
+
+void ZstdModelTraceSequence(size_t literal_length, size_t match_length, size_t offset) {
+  if ((tracing == nullptr) || tracing->blocks.empty()) {
+    return;
+  }
+  tracing->sequences.push_back({(uint32_t)literal_length, (uint32_t)match_length,
+                                (uint32_t)offset});
+  tracing->blocks.back().end_sequence = tracing->sequences.size();
+}
+
+}  // extern "C"
+
+size_t TraceZstdCall(const uint8_t* src, size_t src_len, uint8_t* dst, size_t dst_capacity,
+                     ZstdCallTrace* trace) {
+  *trace = ZstdCallTrace();
+  trace->comp_len = src_len;
+  tracing = trace;
+  size_t got = RefZstdDecompress(dst, dst_capacity, src, src_len);
+  tracing = nullptr;
+  // the reference decoder reports errors as (size_t)-1 or its ERROR_CODE
+  if (got > dst_capacity) {
+    return 0;
+  }
+  trace->uncomp_len = got;
+  return got;
+}
+
+bool SetZstdModelPlacement(const std::string& placement, ZstdModelConfig* config) {
+  // as the decompress sweep configs set up latency injection
+  static const struct {
+    const char* name;
+    uint64_t latency_inject_cycles;
+    bool has_intermediate_cache;
+  } kPlacements[] = {
+      {"RoCC", 0, false},
+      {"Chiplet", 50, false},
+      {"PCIeLocalCache", 400, true},
+      {"PCIeNoCache", 400, false},
+  };
+  for (const auto& p : kPlacements) {
+    if (placement == p.name) {
+      config->latency_inject_cycles = p.latency_inject_cycles;
+      config->has_intermediate_cache = p.has_intermediate_cache;
+      return true;
+    }
+  }
+  if (placement.compare(0, 4, "Spec") == 0) {
+    char* end;
+    long width = strtol(placement.c_str() + 4, &end, 10);
+    if ((*end == '\0') && (width > 0)) {
+      config->huf_speculation = width;
+      config->latency_inject_cycles = 0;
+      config->has_intermediate_cache = false;
+      return true;
+    }
+  }
+  return false;
+}
+
+double ZstdModelRawCycles(ZstdCallTrace* trace, const ZstdModelConfig& config) {
+  MemPath header = MakeMemPath(config, false, kHeaderOutstanding);
+  MemPath data = MakeMemPath(config, false, kOutstanding);
+  // the literal buffer and history reads, behind the intermediate cache
+  MemPath buffer = MakeMemPath(config, true, kOutstanding);
+  const std::vector<uint32_t>& iterations = HufIterations(trace, config.huf_speculation);
+  const std::vector<ZstdTraceExec>& exec = Execution(trace, config.hist_sram_bytes);
+
+  size_t stream = 0;
+  double cycles = header.latency;  // frame header
+  for (size_t b = 0; b < trace->blocks.size(); b++) {
+    const ZstdTraceBlock& block = trace->blocks[b];
+    cycles += header.latency;
+    switch (block.type) {
+    case 0:
+      cycles += Stream(data, block.len) + data.latency;
+      break;
+    case 1:
+      cycles += Beats(block.len) * data.cycles_per_beat + data.latency;
+      break;
+    case 2:
+      cycles += LiteralsCycles(block, header, data, buffer, iterations, &stream);
+      cycles += SequencesCycles(block, exec[b], header, data, buffer);
+      break;
+    default:
+      break;
+    }
+  }
+  return cycles + data.latency;  // completion write
+}
+
+double ZstdModelCycles(ZstdCallTrace* trace, const ZstdModelConfig& config) {
+  return config.scale * ZstdModelRawCycles(trace, config) + config.call_overhead;
+}
+
+bool LoadZstdModelCalibration(const std::string& path, ZstdModelConfig* config) {
+  FILE* f = fopen(path.c_str(), "r");
+  if (f == nullptr) {
+    fprintf(stderr, "could not open calibration %s\n", path.c_str());
+    return false;
+  }
+  char key[64];
+  double value;
+  char line[256];
+  while (fgets(line, sizeof(line), f) != nullptr) {
+    if ((line[0] == '#') || (sscanf(line, "%63s %lf", key, &value) != 2)) {
+      continue;
+    }
+    if (strcmp(key, "mem_latency") == 0) {
+      config->mem_latency = value;
+    } else if (strcmp(key, "call_overhead") == 0) {
+      config->call_overhead = value;
+    } else if (strcmp(key, "scale") == 0) {
+      config->scale = value;
+    }
+  }
+  fclose(f);
+  return true;
+}
+
+bool SaveZstdModelCalibration(const std::string& path, const ZstdModelConfig& config) {
+  FILE* f = fopen(path.c_str(), "w");
+  if (f == nullptr) {
+    fprintf(stderr, "could not write calibration %s\n", path.c_str());
+    return false;
+  }
+  fprintf(f, "# decompmodel calibration\n");
+  fprintf(f, "mem_latency %.9g\n", config.mem_latency);
+  fprintf(f, "call_overhead %.9g\n", config.call_overhead);
+  fprintf(f, "scale %.9g\n", config.scale);
+  return fclose(f) == 0;
+}
@@ -0,0 +1,127 @@
+#ifndef __HOSTBENCH_ZSTDMODEL_H
+#define __HOSTBENCH_ZSTDMODEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Cycle-approximate model of the Zstd decompressor (ZstdFrameDecompressor /
+// ZstdBlockDecompressor), so history SRAM sizes, Huffman widths
+// (WithZstdDecompressorN) and placements can be swept on the host instead of
+// in FireSim. A call is decoded once with the reference decoder, which
+// records what the hardware would see (blocks, literal sections, Huffman
+// symbol lengths, sequence tables and every sequence); each design point is
+// then costed from that trace without decoding again.
+//
+// Costs follow the RTL at block granularity, with memory as in
+// L2MemHelperLatencyInjection: every request waits the base memory latency
+// plus the injected cycles (none on the paths through the intermediate cache
+// when the placement has one), and a helper streams at most one 32B beat per
+// cycle and one beat per outstanding request per latency.
+//   - the frame and each block, literal and sequence section header is one
+//     read by the header readers
+//   - raw and RLE blocks stream through at 32B per cycle
+//   - Huffman literals: a new table costs its header read, the FSE weight
+//     decode and the dictionary build (2^max_bits entries); each of the 1 or
+//     4 streams is decoded in turn at 3 cycles per LOOKUP / SELECT_VALID /
+//     SHIFT iteration, which emits the chained symbols starting in the first
+//     N bits (N = HufDecompressDecompAtOnce)
+//   - sequences: FSE tables are built at one cell per cycle (predefined
+//     tables are a ROM, repeat is free), the DT reader produces a sequence
+//     per cycle and ZstdSeqExec runs alongside it: literal chunks of up to
+//     32B, on-chip match chunks of min(32, offset) bytes, and matches farther
+//     than the history SRAM as 32B reads through ZstdOffchipHistoryLookup,
+//     ten in flight
+// The result is scaled and offset by per-call constants calibrated against
+// FireSim TOTAL: results (see decompmodel).
+
+// What the accelerator sees of one call, recorded by TraceZstdCall.
+struct ZstdTraceSequence {
+  uint32_t literal_length;
+  uint32_t match_length;
+  uint32_t offset;  // 0 for the literals left after the last sequence
+};
+
+struct ZstdTraceBlock {
+  int type = 0;  // 0 raw, 1 RLE, 2 compressed
+  uint32_t len = 0;
+
+  // compressed blocks only
+  int literals_type = 0;  // 0 raw, 1 RLE, 2 Huffman, 3 Huffman with the previous table
+  uint32_t literals_size = 0;
+  bool huf_table = false;
+  uint32_t huf_table_bytes = 0;
+  uint32_t huf_num_symbs = 0;
+  int huf_max_bits = 0;
+  std::vector<uint32_t> huf_stream_len;
+  std::vector<size_t> huf_stream_first;  // first symbol of each stream in huf_num_bits
+  size_t huf_symbols_end = 0;
+
+  uint32_t num_sequences = 0;
+  uint32_t sequences_len = 0;
+  int seq_table_mode[3] = {3, 3, 3};  // literal length, offset, match length
+  int seq_table_accuracy[3] = {0, 0, 0};
+  size_t first_sequence = 0;  // in sequences; execution includes leftover literals
+  size_t end_sequence = 0;
+};
+
+// A block's sequence execution for one history SRAM size.
+struct ZstdTraceExec {
+  double literal_beats = 0;  // 32B literal chunks
+  double onchip_cycles = 0;  // match chunks served from the history SRAM
+  double far_chunks = 0;     // 32B reads for matches farther than the SRAM
+  uint64_t literal_bytes = 0;
+  uint64_t out_bytes = 0;
+};
+
+struct ZstdCallTrace {
+  size_t comp_len = 0;
+  size_t uncomp_len = 0;
+  std::vector<ZstdTraceBlock> blocks;
+  std::vector<uint8_t> huf_num_bits;  // bits of every Huffman symbol, in decode order
+  std::vector<ZstdTraceSequence> sequences;
+
+  // filled on first use, so a sweep walks the symbols and sequences once per
+  // width and history size: Huffman iterations per stream by speculation
+  // width, and per block execution by history SRAM size
+  std::map<int, std::vector<uint32_t>> huf_iterations;
+  std::map<uint64_t, std::vector<ZstdTraceExec>> exec;
+};
+
+// Decodes src with the reference decoder into dst and records the call.
+// Returns the decompressed size, 0 on failure.
+size_t TraceZstdCall(const uint8_t* src, size_t src_len, uint8_t* dst, size_t dst_capacity,
+                     ZstdCallTrace* trace);
+
+struct ZstdModelConfig {
+  int huf_speculation = 4;  // HufDecompressDecompAtOnce
+  uint64_t hist_sram_bytes = 65536;
+  uint64_t latency_inject_cycles = 0;
+  bool has_intermediate_cache = false;
+
+  // calibrated
+  double mem_latency = 40;    // round trip to the L2 before any injected latency
+  double call_overhead = 0;   // cycles per call outside the model (commands, fences)
+  double scale = 1.0;
+};
+
+// Sets up a placement as process-resultdir-decompress.py names them: the
+// latency injection of RoCC, Chiplet, PCIeLocalCache and PCIeNoCache, or
+// SpecN for RoCC with N-wide Huffman speculation (the width is left alone
+// otherwise). Returns false if the name is unknown.
+bool SetZstdModelPlacement(const std::string& placement, ZstdModelConfig* config);
+
+// Cycles the call takes without the calibration: ZstdModelCycles is
+// config.scale * this + config.call_overhead.
+double ZstdModelRawCycles(ZstdCallTrace* trace, const ZstdModelConfig& config);
+double ZstdModelCycles(ZstdCallTrace* trace, const ZstdModelConfig& config);
+
+// Calibration files: "key value" lines for mem_latency, call_overhead and
+// scale; other keys and # comments are ignored. Returns false (after printing
+// why) if the file can't be read or written.
+bool LoadZstdModelCalibration(const std::string& path, ZstdModelConfig* config);
+bool SaveZstdModelCalibration(const std::string& path, const ZstdModelConfig& config);
+
+#endif  // __HOSTBENCH_ZSTDMODEL_H
@@ -4,15 +4,53 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <inttypes.h>
+#include <string.h>
+#include "encoding.h"
 
 #define PAGESIZE_BYTES 4096
 
+// Last value written to each runtime parameter register of the two
+// accelerators, so switching contexts only re-issues what differs. The
+// compressor and decompressor have fixed opcodes, so one record per hart
+// covers both.
+typedef struct {
+    bool hist_valid;
+    uint64_t hist_sram_size_limit_bytes;
+    bool ht_valid;
+    uint64_t hash_table_entries_log2;
+    bool decomp_hist_valid;
+    uint64_t decomp_sram_size_limit_bytes;
+    uint64_t param_writes;
+} snappy_programmed_t;
+
+static snappy_programmed_t snappy_programmed[SNAPPY_CTX_MAX_HARTS];
+
+// The calling hart's record.
+static snappy_programmed_t* SnappyProgrammed() {
+    uint32_t hart = (uint32_t)read_csr(mhartid);
+    assert(hart < SNAPPY_CTX_MAX_HARTS);
+    return &snappy_programmed[hart];
+}
+
+// Same worst case as snappy::MaxCompressedLength
+size_t SnappyMaxCompressedLength(size_t source_bytes) {
+    return 32 + source_bytes + (source_bytes / 6);
+}
+
 void SnappyCompressSetDynamicHashTableSizeLog2(uint64_t hash_table_entries_log2) {
     ROCC_INSTRUCTION_S(SNAPPY_COMPRESS_OPCODE, hash_table_entries_log2, SNAPPY_COMPRESS_RUNTIME_HT_NUM_ENTRIES_LOG2);
+    snappy_programmed_t* programmed = SnappyProgrammed();
+    programmed->ht_valid = true;
+    programmed->hash_table_entries_log2 = hash_table_entries_log2;
+    programmed->param_writes++;
 }
 
 void SnappyCompressSetDynamicHistSize(uint64_t hist_sram_size_limit_bytes) {
     ROCC_INSTRUCTION_S(SNAPPY_COMPRESS_OPCODE, hist_sram_size_limit_bytes, SNAPPY_COMPRESS_MAX_OFFSET_ALLOWED);
+    snappy_programmed_t* programmed = SnappyProgrammed();
+    programmed->hist_valid = true;
+    programmed->hist_sram_size_limit_bytes = hist_sram_size_limit_bytes;
+    programmed->param_writes++;
 }
 
 
@@ -67,10 +105,169 @@ uint64_t SnappyAccelRawCompress(const unsigned char* uncompressed, size_t uncomp
     return BlockOnCompressCompletion(&compressed_size);
 }
 
+uint64_t SnappyAccelCompressCodec(const unsigned char* src, size_t src_len, unsigned char* dst, size_t dst_capacity, void* ctx) {
+    return SnappyAccelRawCompress(src, src_len, dst);
+}
+
+size_t AccelIovecTotalLength(const accel_iovec_t* iov, int iovcnt) {
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        total += iov[i].len;
+    }
+    return total;
+}
+
+// Leading segments go out as SRC_SEGMENT, the last one as SRC_INFO, which
+// is what the completion count tracks. Empty segments are skipped.
+void SnappyAccelGatherCompressNonblocking(const accel_iovec_t* iov, int iovcnt, unsigned char* compressed, uint64_t* compressed_size) {
+    assert((iovcnt >= 1) && (iovcnt <= SNAPPY_GATHER_MAX_SEGMENTS));
+
+    int last = iovcnt - 1;
+    while ((last > 0) && (iov[last].len == 0)) {
+        last--;
+    }
+
+#ifndef NOACCEL_DEBUG
+    for (int i = 0; i < last; i++) {
+        if (iov[i].len == 0) {
+            continue;
+        }
+        ROCC_INSTRUCTION_SS(SNAPPY_COMPRESS_OPCODE, (uint64_t)iov[i].base, (uint64_t)iov[i].len, SNAPPY_COMPRESS_FUNCT_SRC_SEGMENT);
+    }
+    ROCC_INSTRUCTION_SS(SNAPPY_COMPRESS_OPCODE, (uint64_t)iov[last].base, (uint64_t)iov[last].len, SNAPPY_COMPRESS_FUNCT_SRC_INFO);
+    ROCC_INSTRUCTION_SS(SNAPPY_COMPRESS_OPCODE, (uint64_t)compressed, (uint64_t)compressed_size, SNAPPY_COMPRESS_FUNCT_DEST_INFO_AND_START);
+#endif
+}
+
+uint64_t SnappyAccelGatherCompress(const accel_iovec_t* iov, int iovcnt, unsigned char* compressed) {
+    uint64_t compressed_size = 0;
+    SnappyAccelGatherCompressNonblocking(iov, iovcnt, compressed, &compressed_size);
+    return BlockOnCompressCompletion(&compressed_size);
+}
+
+// Leading output segments go out as DEST_SEGMENT and the last non-empty one
+// as the DEST_INFO area, when together they hold the worst case; otherwise
+// the output goes to staging (SnappyMaxCompressedLength of the input) and is
+// scattered from there. Returns the compressed size, or 0 if the output
+// segments are too small.
+uint64_t SnappyAccelCompressV(const accel_iovec_t* iov, int iovcnt, const accel_out_iovec_t* out_iov, int out_iovcnt, unsigned char* staging) {
+    size_t max_compressed = SnappyMaxCompressedLength(AccelIovecTotalLength(iov, iovcnt));
+    size_t out_capacity = 0;
+    for (int i = 0; i < out_iovcnt; i++) {
+        out_capacity += out_iov[i].len;
+    }
+
+    if ((out_iovcnt > 0) && (out_iovcnt <= SNAPPY_SCATTER_MAX_SEGMENTS) && (out_capacity >= max_compressed)) {
+        int last = out_iovcnt - 1;
+        while ((last > 0) && (out_iov[last].len == 0)) {
+            last--;
+        }
+
+#ifndef NOACCEL_DEBUG
+        for (int i = 0; i < last; i++) {
+            if (out_iov[i].len == 0) {
+                continue;
+            }
+            ROCC_INSTRUCTION_SS(SNAPPY_COMPRESS_OPCODE, (uint64_t)out_iov[i].base, (uint64_t)out_iov[i].len, SNAPPY_COMPRESS_FUNCT_DEST_SEGMENT);
+        }
+#endif
+        uint64_t compressed_size = 0;
+        SnappyAccelGatherCompressNonblocking(iov, iovcnt, out_iov[last].base, &compressed_size);
+        return BlockOnCompressCompletion(&compressed_size);
+    }
+
+    uint64_t compressed_size = SnappyAccelGatherCompress(iov, iovcnt, staging);
+
+    uint64_t pos = 0;
+    for (int i = 0; (i < out_iovcnt) && (pos < compressed_size); i++) {
+        uint64_t take = compressed_size - pos;
+        if (take > out_iov[i].len) {
+            take = out_iov[i].len;
+        }
+        memcpy(out_iov[i].base, staging + pos, take);
+        pos += take;
+    }
+    return (pos == compressed_size) ? compressed_size : 0;
+}
+
+// Compresses the input as independent raw Snappy blocks of chunk_size bytes,
+// keeping up to num_inflight of them queued on the accelerator so that
+// on_chunk_done can write out / checksum chunk N on the host while chunk N+1
+// compresses. Each in-flight chunk gets its own slot of
+// SnappyMaxCompressedLength(chunk_size) bytes in staging; a slot is reused once
+// its callback returns. Returns the total compressed bytes over all chunks.
+uint64_t SnappyAccelChunkedCompress(const unsigned char* uncompressed, size_t uncompressed_length, unsigned char* staging, size_t chunk_size, unsigned int num_inflight, accel_chunk_done_fn on_chunk_done, void* user_ctx) {
+    volatile uint64_t chunk_sizes[ACCEL_CHUNK_MAX_INFLIGHT];
+    size_t chunk_src_off[ACCEL_CHUNK_MAX_INFLIGHT];
+    size_t chunk_src_len[ACCEL_CHUNK_MAX_INFLIGHT];
+
+    if (num_inflight < 1) {
+        num_inflight = 1;
+    }
+    if (num_inflight > ACCEL_CHUNK_MAX_INFLIGHT) {
+        num_inflight = ACCEL_CHUNK_MAX_INFLIGHT;
+    }
+    if (chunk_size == 0) {
+        chunk_size = SNAPPY_CHUNK_DEFAULT_BYTES;
+    }
+    size_t slot_bytes = SnappyMaxCompressedLength(chunk_size);
+
+    size_t src_pos = 0;
+    size_t submitted = 0;
+    size_t retired = 0;
+    uint64_t total_compressed_size = 0;
+
+    while ((src_pos < uncompressed_length) || (retired < submitted)) {
+        while ((src_pos < uncompressed_length) && (submitted - retired < num_inflight)) {
+            size_t src_len = uncompressed_length - src_pos;
+            if (src_len > chunk_size) {
+                src_len = chunk_size;
+            }
+
+            unsigned int slot = submitted % num_inflight;
+            chunk_sizes[slot] = 0;
+            chunk_src_off[slot] = src_pos;
+            chunk_src_len[slot] = src_len;
+
+            SnappyAccelRawCompressNonblocking(uncompressed + src_pos, src_len, staging + (slot * slot_bytes), (uint64_t*)&chunk_sizes[slot]);
+            src_pos += src_len;
+            submitted++;
+        }
+
+        unsigned int slot = retired % num_inflight;
+        asm volatile ("fence");
+#ifndef NOACCEL_DEBUG
+        while (! chunk_sizes[slot]) {
+            asm volatile ("fence");
+        }
+#endif
+        total_compressed_size += chunk_sizes[slot];
+        if (on_chunk_done) {
+            on_chunk_done(user_ctx, retired, uncompressed + chunk_src_off[slot], chunk_src_len[slot], staging + (slot * slot_bytes), chunk_sizes[slot]);
+        }
+        retired++;
+    }
+
+    // every job is retired, so this only resyncs the command router
+    uint64_t retval;
+#ifndef NOACCEL_DEBUG
+    if (submitted > 0) {
+        ROCC_INSTRUCTION_D(SNAPPY_COMPRESS_OPCODE, retval, SNAPPY_COMPRESS_FUNCT_CHECK_COMPLETION);
+    }
+#endif
+    asm volatile ("fence");
+
+    return total_compressed_size;
+}
+
 
 
 void SnappyDecompressSetDynamicHistSize(uint64_t sram_size_limit_bytes) {
     ROCC_INSTRUCTION_S(SNAPPY_DECOMPRESS_OPCODE, sram_size_limit_bytes, SNAPPY_DECOMPRESS_FUNCT_SET_ONCHIP_HIST);
+    snappy_programmed_t* programmed = SnappyProgrammed();
+    programmed->decomp_hist_valid = true;
+    programmed->decomp_sram_size_limit_bytes = sram_size_limit_bytes;
+    programmed->param_writes++;
 }
 
 
@@ -125,3 +322,127 @@ bool SnappyAccelRawUncompress(const unsigned char* compressed, size_t compressed
     return BlockOnUncompressCompletion(&completion_flag);
 }
 
+uint64_t SnappyAccelUncompressCodec(const unsigned char* src, size_t src_len, unsigned char* dst, size_t dst_capacity, void* ctx) {
+    return SnappyAccelRawUncompress(src, src_len, dst) ? 1 : 0;
+}
+
+
+// Only one job is ever in flight on each accelerator, so the per-job
+// CHECK_COMPLETION of the blocking helpers is safe on both sides. Returns the
+// number of jobs that failed verification.
+size_t SnappyAccelCompressVerified(snappy_verify_job_t* jobs, size_t num_jobs, unsigned char* scratch) {
+    size_t num_failed = 0;
+    if (num_jobs == 0) {
+        return 0;
+    }
+
+    jobs[0].compressed_size = 0;
+    SnappyAccelRawCompressNonblocking(jobs[0].src, jobs[0].src_len, jobs[0].dst, &jobs[0].compressed_size);
+
+    for (size_t i = 0; i < num_jobs; i++) {
+        snappy_verify_job_t * job = &jobs[i];
+        BlockOnCompressCompletion((volatile uint64_t *)&job->compressed_size);
+
+        if (i + 1 < num_jobs) {
+            snappy_verify_job_t * next = &jobs[i + 1];
+            next->compressed_size = 0;
+            SnappyAccelRawCompressNonblocking(next->src, next->src_len, next->dst, &next->compressed_size);
+        }
+
+        bool uncompress_success = false;
+        SnappyAccelRawUncompressNonblocking(job->dst, job->compressed_size, scratch, &uncompress_success);
+        uncompress_success = BlockOnUncompressCompletion(&uncompress_success);
+
+        job->verified = uncompress_success && (memcmp(scratch, job->src, job->src_len) == 0);
+        if (!job->verified) {
+            num_failed++;
+        }
+    }
+    return num_failed;
+}
+
+
+// Accelerator contexts
+
+void SnappyCtxInit(snappy_ctx_t* ctx) {
+    ctx->hist_sram_size_limit_bytes = SNAPPY_CTX_DEFAULT_HIST_SIZE;
+    ctx->hash_table_entries_log2 = SNAPPY_CTX_DEFAULT_HT_LOG2;
+    ctx->decomp_sram_size_limit_bytes = SNAPPY_CTX_DEFAULT_DECOMP_HIST_SIZE;
+}
+
+void SnappyCtxActivateCompress(const snappy_ctx_t* ctx) {
+    const snappy_programmed_t* programmed = SnappyProgrammed();
+    if (!programmed->hist_valid || (programmed->hist_sram_size_limit_bytes != ctx->hist_sram_size_limit_bytes)) {
+        SnappyCompressSetDynamicHistSize(ctx->hist_sram_size_limit_bytes);
+    }
+    if (!programmed->ht_valid || (programmed->hash_table_entries_log2 != ctx->hash_table_entries_log2)) {
+        SnappyCompressSetDynamicHashTableSizeLog2(ctx->hash_table_entries_log2);
+    }
+}
+
+void SnappyCtxActivateDecompress(const snappy_ctx_t* ctx) {
+    const snappy_programmed_t* programmed = SnappyProgrammed();
+    if (!programmed->decomp_hist_valid || (programmed->decomp_sram_size_limit_bytes != ctx->decomp_sram_size_limit_bytes)) {
+        SnappyDecompressSetDynamicHistSize(ctx->decomp_sram_size_limit_bytes);
+    }
+}
+
+void SnappyCtxInvalidate() {
+    snappy_programmed_t* programmed = SnappyProgrammed();
+    programmed->hist_valid = false;
+    programmed->ht_valid = false;
+    programmed->decomp_hist_valid = false;
+}
+
+uint64_t SnappyCtxParamWrites() {
+    return SnappyProgrammed()->param_writes;
+}
+
+uint64_t SnappyCtxCompress(const snappy_ctx_t* ctx, const unsigned char* uncompressed, size_t uncompressed_length, unsigned char* compressed) {
+    SnappyCtxActivateCompress(ctx);
+    return SnappyAccelRawCompress(uncompressed, uncompressed_length, compressed);
+}
+
+bool SnappyCtxUncompress(const snappy_ctx_t* ctx, const unsigned char* compressed, size_t compressed_length, unsigned char* uncompressed) {
+    SnappyCtxActivateDecompress(ctx);
+    return SnappyAccelRawUncompress(compressed, compressed_length, uncompressed);
+}
+
+
+// Performance counters
+
+uint64_t SnappyDecompressReadPerfCounter(uint32_t idx) {
+    uint64_t value = 0;
+#ifndef NOACCEL_DEBUG
+    ROCC_INSTRUCTION_DS(SNAPPY_DECOMPRESS_OPCODE, value, (uint64_t)idx, SNAPPY_DECOMPRESS_FUNCT_READ_PERF_COUNTER);
+#endif
+    return value;
+}
+
+void SnappyDecompressPerfSnapshot(snappy_decompress_perf_t * snap) {
+    for (uint32_t i = 0; i < SNAPPY_DECOMP_PERF_NUM_COUNTERS; i++) {
+        snap->v[i] = SnappyDecompressReadPerfCounter(i);
+    }
+}
+
+void SnappyDecompressPerfDiff(const snappy_decompress_perf_t * before,
+                              const snappy_decompress_perf_t * after,
+                              snappy_decompress_perf_t * delta) {
+    for (uint32_t i = 0; i < SNAPPY_DECOMP_PERF_NUM_COUNTERS; i++) {
+        delta->v[i] = after->v[i] - before->v[i];
+    }
+}
+
+void SnappyDecompressPerfPrint(const char * tag, const snappy_decompress_perf_t * delta) {
+    const uint64_t * v = delta->v;
+    uint64_t copies = v[SNAPPY_DECOMP_PERF_HIST_ONCHIP_HITS] + v[SNAPPY_DECOMP_PERF_HIST_OFFCHIP_MISSES];
+    uint64_t l2_latency = (v[SNAPPY_DECOMP_PERF_L2_ACKS] == 0) ? 0 : (v[SNAPPY_DECOMP_PERF_L2_INFLIGHT_CYCLES] / v[SNAPPY_DECOMP_PERF_L2_ACKS]);
+    uint64_t hist_latency = (v[SNAPPY_DECOMP_PERF_HIST_L2_ACKS] == 0) ? 0 : (v[SNAPPY_DECOMP_PERF_HIST_L2_INFLIGHT_CYCLES] / v[SNAPPY_DECOMP_PERF_HIST_L2_ACKS]);
+    printf("PERF %s: history copies %" PRIu64 " on-chip %" PRIu64 " off-chip %" PRIu64 " (hit rate %" PRIu64 " permille)\n",
+           tag, copies, v[SNAPPY_DECOMP_PERF_HIST_ONCHIP_HITS], v[SNAPPY_DECOMP_PERF_HIST_OFFCHIP_MISSES],
+           (copies == 0) ? 0 : (v[SNAPPY_DECOMP_PERF_HIST_ONCHIP_HITS] * 1000 / copies));
+    printf("PERF %s: l2 reqs %" PRIu64 " acks %" PRIu64 " avg latency %" PRIu64 " cycles\n",
+           tag, v[SNAPPY_DECOMP_PERF_L2_REQS], v[SNAPPY_DECOMP_PERF_L2_ACKS], l2_latency);
+    printf("PERF %s: history l2 reads %" PRIu64 " avg latency %" PRIu64 " cycles\n",
+           tag, v[SNAPPY_DECOMP_PERF_HIST_L2_ACKS], hist_latency);
+}
@@ -10,6 +10,8 @@
 #define SNAPPY_COMPRESS_FUNCT_CHECK_COMPLETION 3
 #define SNAPPY_COMPRESS_MAX_OFFSET_ALLOWED 4
 #define SNAPPY_COMPRESS_RUNTIME_HT_NUM_ENTRIES_LOG2 5
+#define SNAPPY_COMPRESS_FUNCT_SRC_SEGMENT 6
+#define SNAPPY_COMPRESS_FUNCT_DEST_SEGMENT 7
 
 #define SNAPPY_DECOMPRESS_OPCODE 0
 #define SNAPPY_DECOMPRESS_FUNCT_SFENCE 0
@@ -17,7 +19,22 @@
 #define SNAPPY_DECOMPRESS_FUNCT_DEST_INFO_AND_START 2
 #define SNAPPY_DECOMPRESS_FUNCT_CHECK_COMPLETION 3
 #define SNAPPY_DECOMPRESS_FUNCT_SET_ONCHIP_HIST 4
+#define SNAPPY_DECOMPRESS_FUNCT_READ_PERF_COUNTER 5
 
+#define ACCEL_CHUNK_MAX_INFLIGHT 4
+#define SNAPPY_CHUNK_DEFAULT_BYTES (64 << 10)
+
+// Called on the host as each chunk retires, while the accelerator keeps
+// working on the chunks still in flight.
+typedef void (*accel_chunk_done_fn)(void * user_ctx,
+                                    size_t chunk_no,
+                                    const unsigned char * src,
+                                    size_t src_len,
+                                    const unsigned char * dst,
+                                    uint64_t dst_len);
+
+
+size_t SnappyMaxCompressedLength(size_t source_bytes);
 
 void SnappyCompressSetDynamicHashTableSizeLog2(uint64_t hash_table_entries_log2);
 
@@ -31,6 +48,46 @@ uint64_t SnappyAccelRawCompress(const unsigned char* uncompressed, size_t uncomp
 
 volatile uint64_t BlockOnCompressCompletion(volatile uint64_t * compressed_size);
 
+// accel_codec_fn adapters for accelrouter.h
+uint64_t SnappyAccelCompressCodec(const unsigned char* src, size_t src_len, unsigned char* dst, size_t dst_capacity, void* ctx);
+
+// Scatter-gather
+//
+// The compressor's input loader walks the segments of a gathered input back
+// to back, so fragmented records compress as one buffer with continuous
+// history and no gather copy. Likewise the memwriter fills the leading output
+// segments (DEST_SEGMENT) in order before the DEST_INFO area, so
+// SnappyAccelCompressV scatters without a copy when the output segments can
+// hold the worst case; when they cannot it compresses into staging and copies
+// out what fits.
+//
+// A call's segments are queued whole in the command router, so both counts
+// are bounded by its queue depth (GATHER_MAX_SEGMENTS in
+// SnappyCompressorCommandRouter.scala).
+
+#define SNAPPY_GATHER_MAX_SEGMENTS 16
+#define SNAPPY_SCATTER_MAX_SEGMENTS 16
+
+typedef struct {
+  const unsigned char * base;
+  size_t len;
+} accel_iovec_t;
+
+typedef struct {
+  unsigned char * base;
+  size_t len;
+} accel_out_iovec_t;
+
+size_t AccelIovecTotalLength(const accel_iovec_t* iov, int iovcnt);
+
+void SnappyAccelGatherCompressNonblocking(const accel_iovec_t* iov, int iovcnt, unsigned char* compressed, uint64_t* compressed_size);
+
+uint64_t SnappyAccelGatherCompress(const accel_iovec_t* iov, int iovcnt, unsigned char* compressed);
+
+uint64_t SnappyAccelCompressV(const accel_iovec_t* iov, int iovcnt, const accel_out_iovec_t* out_iov, int out_iovcnt, unsigned char* staging);
+
+uint64_t SnappyAccelChunkedCompress(const unsigned char* uncompressed, size_t uncompressed_length, unsigned char* staging, size_t chunk_size, unsigned int num_inflight, accel_chunk_done_fn on_chunk_done, void* user_ctx);
+
 
 void SnappyDecompressSetDynamicHistSize(uint64_t sram_size_limit_bytes);
 
@@ -41,3 +98,118 @@ void SnappyAccelRawUncompressNonblocking(const unsigned char* compressed, size_t
 bool SnappyAccelRawUncompress(const unsigned char* compressed, size_t compressed_length, unsigned char* uncompressed);
 
 volatile bool BlockOnUncompressCompletion(volatile bool * completion_flag);
+
+uint64_t SnappyAccelUncompressCodec(const unsigned char* src, size_t src_len, unsigned char* dst, size_t dst_capacity, void* ctx);
+
+// Verify-on-write
+//
+// Compresses a list of jobs and round-trips each one through the decompressor
+// before it is reported good. The two accelerators are independent, so job N
+// is decompressed and compared while job N+1 compresses; a verified stream
+// costs roughly the compress time plus one decompression. scratch must hold the
+// largest src_len.
+
+typedef struct {
+  const unsigned char * src;
+  size_t src_len;
+  unsigned char * dst; // SnappyMaxCompressedLength(src_len) bytes
+  uint64_t compressed_size;
+  bool verified;
+} snappy_verify_job_t;
+
+size_t SnappyAccelCompressVerified(snappy_verify_job_t* jobs, size_t num_jobs, unsigned char* scratch);
+
+
+// Accelerator contexts
+//
+// The history limits and hash table size are registers shared by every caller
+// of the accelerators. A context carries one tenant's settings; the Ctx
+// compress/uncompress calls re-issue only the registers whose last written
+// value differs. The plain Set* functions keep the same record; call
+// SnappyCtxInvalidate if an accelerator is reset behind the library's back.
+// Every core has its own pair of accelerators, so the record is kept per
+// hart, and the Ctx functions act on the calling hart's.
+
+// hart ids the record covers
+#ifndef SNAPPY_CTX_MAX_HARTS
+#define SNAPPY_CTX_MAX_HARTS 8
+#endif
+
+// Router reset values
+#define SNAPPY_CTX_DEFAULT_HIST_SIZE ((64 << 10) - 64)
+#define SNAPPY_CTX_DEFAULT_HT_LOG2 14
+#define SNAPPY_CTX_DEFAULT_DECOMP_HIST_SIZE (64 << 10)
+
+typedef struct {
+  uint64_t hist_sram_size_limit_bytes;
+  uint64_t hash_table_entries_log2;
+  uint64_t decomp_sram_size_limit_bytes;
+} snappy_ctx_t;
+
+void SnappyCtxInit(snappy_ctx_t* ctx);
+
+void SnappyCtxActivateCompress(const snappy_ctx_t* ctx);
+
+void SnappyCtxActivateDecompress(const snappy_ctx_t* ctx);
+
+void SnappyCtxInvalidate();
+
+uint64_t SnappyCtxParamWrites();
+
+uint64_t SnappyCtxCompress(const snappy_ctx_t* ctx, const unsigned char* uncompressed, size_t uncompressed_length, unsigned char* compressed);
+
+bool SnappyCtxUncompress(const snappy_ctx_t* ctx, const unsigned char* compressed, size_t compressed_length, unsigned char* uncompressed);
+
+#ifdef __cplusplus
+class SnappyContext {
+ public:
+  SnappyContext() { SnappyCtxInit(&ctx_); }
+
+  void set_hist_size(uint64_t bytes) { ctx_.hist_sram_size_limit_bytes = bytes; }
+  void set_hash_table_size_log2(uint64_t log2) { ctx_.hash_table_entries_log2 = log2; }
+  void set_decompress_hist_size(uint64_t bytes) { ctx_.decomp_sram_size_limit_bytes = bytes; }
+
+  uint64_t compress(const unsigned char* uncompressed, size_t uncompressed_length, unsigned char* compressed) const {
+    return SnappyCtxCompress(&ctx_, uncompressed, uncompressed_length, compressed);
+  }
+
+  bool uncompress(const unsigned char* compressed, size_t compressed_length, unsigned char* uncompressed) const {
+    return SnappyCtxUncompress(&ctx_, compressed, compressed_length, uncompressed);
+  }
+
+  const snappy_ctx_t* get() const { return &ctx_; }
+
+ private:
+  snappy_ctx_t ctx_;
+};
+#endif
+
+// Performance counters
+//
+// Decompressor counters, read one at a time with
+// SNAPPY_DECOMPRESS_FUNCT_READ_PERF_COUNTER (rs1 = index, same layout as
+// DecompressorPerfCounters in PerfCounters.scala). Never cleared: snapshot and
+// diff. inflight_cycles / acks is the average memory latency.
+
+#define SNAPPY_DECOMP_PERF_HIST_ONCHIP_HITS 0
+#define SNAPPY_DECOMP_PERF_HIST_OFFCHIP_MISSES 1
+#define SNAPPY_DECOMP_PERF_L2_REQS 2
+#define SNAPPY_DECOMP_PERF_L2_ACKS 3
+#define SNAPPY_DECOMP_PERF_L2_INFLIGHT_CYCLES 4
+#define SNAPPY_DECOMP_PERF_HIST_L2_ACKS 5
+#define SNAPPY_DECOMP_PERF_HIST_L2_INFLIGHT_CYCLES 6
+#define SNAPPY_DECOMP_PERF_NUM_COUNTERS 7
+
+typedef struct {
+  uint64_t v[SNAPPY_DECOMP_PERF_NUM_COUNTERS];
+} snappy_decompress_perf_t;
+
+uint64_t SnappyDecompressReadPerfCounter(uint32_t idx);
+
+void SnappyDecompressPerfSnapshot(snappy_decompress_perf_t * snap);
+
+void SnappyDecompressPerfDiff(const snappy_decompress_perf_t * before,
+                              const snappy_decompress_perf_t * after,
+                              snappy_decompress_perf_t * delta);
+
+void SnappyDecompressPerfPrint(const char * tag, const snappy_decompress_perf_t * delta);
@@ -4,10 +4,18 @@ set -ex
 
 BASEDIR=$(pwd)
 
+# sources shared with the Zstd harnesses
+COMMONDIR="$BASEDIR/../software-common"
+
 NUMCHUNKS=16
 
 COMP_OR_DECOMP=complete
 
+# extra compile flags for the harness, e.g. BENCH_FLAGS=-DBENCH_ROUTER to route
+# calls between the core and the accelerators (see test-complete.c), or
+# -DBENCH_REPS=N to time each configuration N times (see benchreport.h)
+BENCH_FLAGS=${BENCH_FLAGS:-}
+
 function buildbench() {
 
     INPUTDIR="$BASEDIR/../software/benchmarks/$2/"
@@ -25,18 +33,26 @@ function buildbench() {
     cp $BASEDIR/*.c .
     cp $BASEDIR/*.h .
 
-    python3 splitter.py $INPUTDIR $OUTPUTDIR $NUMCHUNKS $3
+    PYTHONPATH=$COMMONDIR python3 splitter.py $INPUTDIR $OUTPUTDIR $NUMCHUNKS $3 $MANIFEST
 
     TEST_FILE_NAME="test-$COMP_OR_DECOMP.c"
     TEST_FILE_O="test-$COMP_OR_DECOMP.o"
 
-    riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c $TEST_FILE_NAME
+    riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -I$COMMONDIR $BENCH_FLAGS -c $TEST_FILE_NAME
     riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c accellib.c
-    riscv64-unknown-elf-gcc -static -specs=htif_nano.specs $TEST_FILE_O accellib.o -o $FINAL_OUTPUT_DIR/$3.riscv
+    riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -I. -c $COMMONDIR/accelrouter.c
+    riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c snappycpu.c
+    riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c $COMMONDIR/benchreport.c
+    riscv64-unknown-elf-gcc -static -specs=htif_nano.specs $TEST_FILE_O accellib.o accelrouter.o snappycpu.o benchreport.o -o $FINAL_OUTPUT_DIR/$3.riscv
 
 
 }
 
+# balance shards by predicted simulation time, see shardplan.py
+MANIFEST="$BASEDIR/snappy-$COMP_OR_DECOMP-external-baremetal/shards.manifest"
+mkdir -p $(dirname $MANIFEST)
+python3 $COMMONDIR/shardplan.py "$BASEDIR/../software/benchmarks/HyperCompressBench/extracted_benchmarks/Snappy-COMPRESS" $NUMCHUNKS snappy complete $MANIFEST
+
 for i in {0..15}
 do
     buildbench external "HyperCompressBench/extracted_benchmarks/Snappy-COMPRESS" $i &
@@ -0,0 +1,21 @@
+#!/usr/bin/env bash
+
+# Builds test-framing.riscv, the framing format check (see test-framing.c). It
+# generates its own input, so no benchmark files are needed.
+
+set -ex
+
+BASEDIR=$(pwd)
+OUTPUTDIR="$BASEDIR/snappy-framing-test-baremetal/"
+
+mkdir -p $OUTPUTDIR
+
+cd $OUTPUTDIR
+
+cp $BASEDIR/*.c .
+cp $BASEDIR/*.h .
+
+riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c test-framing.c
+riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c accellib.c
+riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c snappyframing.c
+riscv64-unknown-elf-gcc -static -specs=htif_nano.specs test-framing.o accellib.o snappyframing.o -o test-framing.riscv
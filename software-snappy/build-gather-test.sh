@@ -0,0 +1,21 @@
+#!/usr/bin/env bash
+
+# Builds test-gather.riscv, the scatter-gather check (see test-gather.c). It
+# generates its own input, so no benchmark files are needed.
+
+set -ex
+
+BASEDIR=$(pwd)
+OUTPUTDIR="$BASEDIR/snappy-gather-test-baremetal/"
+
+mkdir -p $OUTPUTDIR
+
+cd $OUTPUTDIR
+
+cp $BASEDIR/*.c .
+cp $BASEDIR/*.h .
+
+riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c test-gather.c
+riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c accellib.c
+riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c snappycpu.c
+riscv64-unknown-elf-gcc -static -specs=htif_nano.specs test-gather.o accellib.o snappycpu.o -o test-gather.riscv
@@ -0,0 +1,216 @@
+#include "snappycpu.h"
+#include "accellib.h"
+#include <stdint.h>
+#include <string.h>
+
+#define SNAPPY_TAG_LITERAL 0
+#define SNAPPY_TAG_COPY_1 1
+#define SNAPPY_TAG_COPY_2 2
+#define SNAPPY_TAG_COPY_4 3
+
+static uint32_t Load32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t HashBytes(uint32_t bytes) {
+    return (bytes * 0x1e35a7bd) >> (32 - SNAPPY_CPU_HASH_LOG);
+}
+
+static unsigned char* EmitLiteral(unsigned char* op, const unsigned char* literal, size_t len) {
+    size_t n = len - 1;
+    if (n < 60) {
+        *op++ = (unsigned char)((n << 2) | SNAPPY_TAG_LITERAL);
+    } else {
+        unsigned char* tag = op++;
+        int count = 0;
+        while (n > 0) {
+            *op++ = (unsigned char)(n & 0xff);
+            n >>= 8;
+            count++;
+        }
+        *tag = (unsigned char)(((59 + count) << 2) | SNAPPY_TAG_LITERAL);
+    }
+    memcpy(op, literal, len);
+    return op + len;
+}
+
+// offset < 64KB, 4 <= len <= 64
+static unsigned char* EmitCopyAtMost64(unsigned char* op, size_t offset, size_t len) {
+    if ((len < 12) && (offset < 2048)) {
+        *op++ = (unsigned char)(SNAPPY_TAG_COPY_1 | ((len - 4) << 2) | ((offset >> 8) << 5));
+        *op++ = (unsigned char)(offset & 0xff);
+    } else {
+        *op++ = (unsigned char)(SNAPPY_TAG_COPY_2 | ((len - 1) << 2));
+        *op++ = (unsigned char)(offset & 0xff);
+        *op++ = (unsigned char)((offset >> 8) & 0xff);
+    }
+    return op;
+}
+
+static unsigned char* EmitCopy(unsigned char* op, size_t offset, size_t len) {
+    // keep the last piece at 4 bytes or more
+    while (len >= 68) {
+        op = EmitCopyAtMost64(op, offset, 64);
+        len -= 64;
+    }
+    if (len > 64) {
+        op = EmitCopyAtMost64(op, offset, 60);
+        len -= 60;
+    }
+    return EmitCopyAtMost64(op, offset, len);
+}
+
+static unsigned char* CompressBlock(const unsigned char* in, size_t len, unsigned char* op) {
+    static uint16_t table[1 << SNAPPY_CPU_HASH_LOG];
+    memset(table, 0, sizeof(table));
+
+    size_t next_emit = 0;
+    size_t ip = 1;
+    uint32_t skip = 32;
+    while (ip + 4 <= len) {
+        uint32_t bytes = Load32(in + ip);
+        uint32_t h = HashBytes(bytes);
+        size_t candidate = table[h];
+        table[h] = (uint16_t)ip;
+
+        if ((candidate >= ip) || (Load32(in + candidate) != bytes)) {
+            // the longer nothing matches, the further each miss jumps
+            ip += skip++ >> 5;
+            continue;
+        }
+
+        if (ip > next_emit) {
+            op = EmitLiteral(op, in + next_emit, ip - next_emit);
+        }
+        size_t matched = 4;
+        while ((ip + matched < len) && (in[candidate + matched] == in[ip + matched])) {
+            matched++;
+        }
+        op = EmitCopy(op, ip - candidate, matched);
+        ip += matched;
+        next_emit = ip;
+        skip = 32;
+        if (ip + 4 <= len) {
+            table[HashBytes(Load32(in + ip - 1))] = (uint16_t)(ip - 1);
+        }
+    }
+
+    if (next_emit < len) {
+        op = EmitLiteral(op, in + next_emit, len - next_emit);
+    }
+    return op;
+}
+
+uint64_t SnappyCpuRawCompress(const unsigned char* uncompressed, size_t uncompressed_length, unsigned char* compressed) {
+    unsigned char* op = compressed;
+
+    uint64_t n = uncompressed_length;
+    while (n >= 0x80) {
+        *op++ = (unsigned char)((n & 0x7f) | 0x80);
+        n >>= 7;
+    }
+    *op++ = (unsigned char)n;
+
+    for (size_t pos = 0; pos < uncompressed_length; pos += SNAPPY_CPU_BLOCK_BYTES) {
+        size_t block_len = uncompressed_length - pos;
+        if (block_len > SNAPPY_CPU_BLOCK_BYTES) {
+            block_len = SNAPPY_CPU_BLOCK_BYTES;
+        }
+        op = CompressBlock(uncompressed + pos, block_len, op);
+    }
+    return (uint64_t)(op - compressed);
+}
+
+bool SnappyCpuRawUncompress(const unsigned char* compressed, size_t compressed_length, unsigned char* uncompressed, size_t uncompressed_capacity) {
+    const unsigned char* ip = compressed;
+    const unsigned char* ip_end = compressed + compressed_length;
+
+    uint64_t expected = 0;
+    for (int shift = 0; ; shift += 7) {
+        if ((ip == ip_end) || (shift > 28)) {
+            return false;
+        }
+        unsigned char c = *ip++;
+        expected |= (uint64_t)(c & 0x7f) << shift;
+        if (!(c & 0x80)) {
+            break;
+        }
+    }
+    if (expected > uncompressed_capacity) {
+        return false;
+    }
+
+    size_t op = 0;
+    while (ip < ip_end) {
+        unsigned char tag = *ip++;
+        size_t len;
+        size_t offset;
+        switch (tag & 3) {
+        case SNAPPY_TAG_LITERAL:
+            len = (tag >> 2) + 1;
+            if (len > 60) {
+                size_t nbytes = len - 60;
+                if ((size_t)(ip_end - ip) < nbytes) {
+                    return false;
+                }
+                len = 0;
+                for (size_t i = 0; i < nbytes; i++) {
+                    len |= (size_t)ip[i] << (8 * i);
+                }
+                len++;
+                ip += nbytes;
+            }
+            if (((size_t)(ip_end - ip) < len) || (expected - op < len)) {
+                return false;
+            }
+            memcpy(uncompressed + op, ip, len);
+            ip += len;
+            op += len;
+            continue;
+        case SNAPPY_TAG_COPY_1:
+            if (ip_end - ip < 1) {
+                return false;
+            }
+            len = ((tag >> 2) & 7) + 4;
+            offset = ((size_t)(tag >> 5) << 8) | ip[0];
+            ip += 1;
+            break;
+        case SNAPPY_TAG_COPY_2:
+            if (ip_end - ip < 2) {
+                return false;
+            }
+            len = (tag >> 2) + 1;
+            offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+            ip += 2;
+            break;
+        default:
+            if (ip_end - ip < 4) {
+                return false;
+            }
+            len = (tag >> 2) + 1;
+            offset = Load32(ip);
+            ip += 4;
+            break;
+        }
+        if ((offset == 0) || (offset > op) || (expected - op < len)) {
+            return false;
+        }
+        // byte at a time: the copy may overlap its own output
+        for (size_t i = 0; i < len; i++) {
+            uncompressed[op + i] = uncompressed[op - offset + i];
+        }
+        op += len;
+    }
+    return op == expected;
+}
+
+uint64_t SnappyCpuCompressCodec(const unsigned char* src, size_t src_len, unsigned char* dst, size_t dst_capacity, void* ctx) {
+    if (dst_capacity < SnappyMaxCompressedLength(src_len)) {
+        return 0;
+    }
+    return SnappyCpuRawCompress(src, src_len, dst);
+}
+
+uint64_t SnappyCpuUncompressCodec(const unsigned char* src, size_t src_len, unsigned char* dst, size_t dst_capacity, void* ctx) {
+    return SnappyCpuRawUncompress(src, src_len, dst, dst_capacity) ? 1 : 0;
+}
@@ -0,0 +1,31 @@
+#ifndef __SNAPPY_CPU_H
+#define __SNAPPY_CPU_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Software raw Snappy on the core, the CPU side of the accelerator router.
+//
+// The compressor follows snappy::Compress: the input is cut into 64KB blocks,
+// each matched with its own hash table (greedy, 4 byte hashes, skipping
+// faster through incompressible data), so every copy fits the 2 byte offset
+// form. The output is a standard raw Snappy stream, interchangeable with the
+// accelerator's in both directions.
+
+#define SNAPPY_CPU_BLOCK_BYTES (64 << 10)
+#define SNAPPY_CPU_HASH_LOG 14
+
+// dst must hold SnappyMaxCompressedLength(uncompressed_length) bytes.
+// Returns the compressed size.
+uint64_t SnappyCpuRawCompress(const unsigned char* uncompressed, size_t uncompressed_length, unsigned char* compressed);
+
+// Returns false if the stream is malformed or does not fit uncompressed_capacity.
+bool SnappyCpuRawUncompress(const unsigned char* compressed, size_t compressed_length, unsigned char* uncompressed, size_t uncompressed_capacity);
+
+// accel_codec_fn adapters for accelrouter.h
+uint64_t SnappyCpuCompressCodec(const unsigned char* src, size_t src_len, unsigned char* dst, size_t dst_capacity, void* ctx);
+
+uint64_t SnappyCpuUncompressCodec(const unsigned char* src, size_t src_len, unsigned char* dst, size_t dst_capacity, void* ctx);
+
+#endif //__SNAPPY_CPU_H
@@ -0,0 +1,339 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include "accellib.h"
+#include "snappyframing.h"
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+#define SNAPPY_CRC32C_POLY 0x82f63b78U
+#define SNAPPY_CRC_MASK_DELTA 0xa282ead8U
+
+static const unsigned char snappy_stream_id[SNAPPY_FRAME_STREAM_ID_BYTES] = {
+    SNAPPY_FRAME_CHUNK_STREAM_ID, 0x06, 0x00, 0x00, 's', 'N', 'a', 'P', 'p', 'Y'
+};
+
+#if defined(__SSE4_2__)
+
+uint32_t SnappyCrc32c(uint32_t crc, const unsigned char * data, size_t len) {
+    uint64_t c = ~crc;
+    while (len >= 8) {
+        uint64_t word;
+        memcpy(&word, data, 8);
+        c = _mm_crc32_u64(c, word);
+        data += 8;
+        len -= 8;
+    }
+    uint32_t c32 = (uint32_t)c;
+    while (len > 0) {
+        c32 = _mm_crc32_u8(c32, *data++);
+        len--;
+    }
+    return ~c32;
+}
+
+#else
+
+// Slicing-by-8: eight bytes per step through eight 256-entry tables,
+// built on first use.
+static uint32_t crc32c_table[8][256];
+static bool crc32c_table_ready = false;
+
+static void SnappyCrc32cInitTable() {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? ((c >> 1) ^ SNAPPY_CRC32C_POLY) : (c >> 1);
+        }
+        crc32c_table[0][i] = c;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = crc32c_table[0][i];
+        for (int t = 1; t < 8; t++) {
+            c = crc32c_table[0][c & 0xff] ^ (c >> 8);
+            crc32c_table[t][i] = c;
+        }
+    }
+    crc32c_table_ready = true;
+}
+
+uint32_t SnappyCrc32c(uint32_t crc, const unsigned char * data, size_t len) {
+    if (!crc32c_table_ready) {
+        SnappyCrc32cInitTable();
+    }
+
+    uint32_t c = ~crc;
+    while (len >= 8) {
+        uint32_t lo = c ^ ((uint32_t)data[0] | ((uint32_t)data[1] << 8) |
+                           ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24));
+        uint32_t hi = (uint32_t)data[4] | ((uint32_t)data[5] << 8) |
+                      ((uint32_t)data[6] << 16) | ((uint32_t)data[7] << 24);
+        c = crc32c_table[7][lo & 0xff] ^
+            crc32c_table[6][(lo >> 8) & 0xff] ^
+            crc32c_table[5][(lo >> 16) & 0xff] ^
+            crc32c_table[4][lo >> 24] ^
+            crc32c_table[3][hi & 0xff] ^
+            crc32c_table[2][(hi >> 8) & 0xff] ^
+            crc32c_table[1][(hi >> 16) & 0xff] ^
+            crc32c_table[0][hi >> 24];
+        data += 8;
+        len -= 8;
+    }
+    while (len > 0) {
+        c = crc32c_table[0][(c ^ *data++) & 0xff] ^ (c >> 8);
+        len--;
+    }
+    return ~c;
+}
+
+#endif
+
+uint32_t SnappyFrameMaskedCrc(const unsigned char * data, size_t len) {
+    uint32_t crc = SnappyCrc32c(0, data, len);
+    return ((crc >> 15) | (crc << 17)) + SNAPPY_CRC_MASK_DELTA;
+}
+
+static void SnappyFrameWrite24(unsigned char * p, uint32_t v) {
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+}
+
+static void SnappyFrameWrite32(unsigned char * p, uint32_t v) {
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = (v >> 24) & 0xff;
+}
+
+static uint32_t SnappyFrameRead24(const unsigned char * p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+}
+
+static uint32_t SnappyFrameRead32(const unsigned char * p) {
+    return SnappyFrameRead24(p) | ((uint32_t)p[3] << 24);
+}
+
+// Chunks that don't compress are stored, so no chunk grows by more than its
+// header and CRC.
+size_t SnappyFramedMaxCompressedLength(size_t source_bytes) {
+    size_t num_chunks = (source_bytes + SNAPPY_FRAME_CHUNK_BYTES - 1) / SNAPPY_FRAME_CHUNK_BYTES;
+    return SNAPPY_FRAME_STREAM_ID_BYTES
+           + num_chunks * (SNAPPY_FRAME_CHUNK_HEADER_BYTES + SNAPPY_FRAME_CRC_BYTES)
+           + source_bytes;
+}
+
+size_t SnappyFramedStagingBytes(unsigned int num_inflight) {
+    if (num_inflight < 1) {
+        num_inflight = 1;
+    }
+    if (num_inflight > ACCEL_CHUNK_MAX_INFLIGHT) {
+        num_inflight = ACCEL_CHUNK_MAX_INFLIGHT;
+    }
+    return num_inflight * SnappyMaxCompressedLength(SNAPPY_FRAME_CHUNK_BYTES);
+}
+
+typedef struct {
+    unsigned char * out;
+    uint64_t out_pos;
+} snappy_frame_writer_t;
+
+// Runs as each chunk retires: CRC the source and append the chunk, stored
+// uncompressed if it saved less than 1/8 (same rule as snappy's framer).
+static void SnappyFrameAppendChunk(void * user_ctx,
+                                   size_t chunk_no,
+                                   const unsigned char * src,
+                                   size_t src_len,
+                                   const unsigned char * dst,
+                                   uint64_t dst_len) {
+    snappy_frame_writer_t * w = (snappy_frame_writer_t *)user_ctx;
+    unsigned char * p = w->out + w->out_pos;
+
+    bool store_raw = dst_len >= (src_len - (src_len / 8));
+    const unsigned char * payload = store_raw ? src : dst;
+    size_t payload_len = store_raw ? src_len : (size_t)dst_len;
+
+    p[0] = store_raw ? SNAPPY_FRAME_CHUNK_UNCOMPRESSED : SNAPPY_FRAME_CHUNK_COMPRESSED;
+    SnappyFrameWrite24(p + 1, (uint32_t)(payload_len + SNAPPY_FRAME_CRC_BYTES));
+    SnappyFrameWrite32(p + SNAPPY_FRAME_CHUNK_HEADER_BYTES, SnappyFrameMaskedCrc(src, src_len));
+    memcpy(p + SNAPPY_FRAME_CHUNK_HEADER_BYTES + SNAPPY_FRAME_CRC_BYTES, payload, payload_len);
+
+    w->out_pos += SNAPPY_FRAME_CHUNK_HEADER_BYTES + SNAPPY_FRAME_CRC_BYTES + payload_len;
+}
+
+// framed must hold SnappyFramedMaxCompressedLength(uncompressed_length) bytes
+// and staging SnappyFramedStagingBytes(num_inflight). Returns the framed length.
+uint64_t SnappyAccelFramedCompress(const unsigned char * uncompressed,
+                                   size_t uncompressed_length,
+                                   unsigned char * framed,
+                                   unsigned char * staging,
+                                   unsigned int num_inflight) {
+    snappy_frame_writer_t w;
+    w.out = framed;
+    memcpy(framed, snappy_stream_id, SNAPPY_FRAME_STREAM_ID_BYTES);
+    w.out_pos = SNAPPY_FRAME_STREAM_ID_BYTES;
+
+    SnappyAccelChunkedCompress(uncompressed,
+                               uncompressed_length,
+                               staging,
+                               SNAPPY_FRAME_CHUNK_BYTES,
+                               num_inflight,
+                               SnappyFrameAppendChunk,
+                               &w);
+    return w.out_pos;
+}
+
+// Length preamble of a raw Snappy block. Returns bytes consumed, 0 if malformed.
+static size_t SnappyFrameReadVarint(const unsigned char * p, size_t len, uint32_t * value) {
+    uint32_t v = 0;
+    for (size_t i = 0; (i < len) && (i < 5); i++) {
+        v |= (uint32_t)(p[i] & 0x7f) << (7 * i);
+        if (!(p[i] & 0x80)) {
+            *value = v;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+typedef struct {
+    volatile bool done;
+    unsigned char * dst;
+    uint32_t dst_len;
+    uint32_t masked_crc;
+} snappy_frame_job_t;
+
+static bool SnappyFrameRetireJob(snappy_frame_job_t * job) {
+    asm volatile ("fence");
+#ifndef NOACCEL_DEBUG
+    while (! job->done) {
+        asm volatile ("fence");
+    }
+#endif
+    return SnappyFrameMaskedCrc(job->dst, job->dst_len) == job->masked_crc;
+}
+
+// Compressed chunks are decoded on the accelerator, up to num_inflight at a
+// time, and their CRCs checked on the host as they retire. Stops at the first
+// malformed chunk or CRC mismatch (after draining jobs already issued) and
+// returns false.
+bool SnappyAccelFramedUncompress(const unsigned char * framed,
+                                 size_t framed_length,
+                                 unsigned char * uncompressed,
+                                 size_t uncompressed_capacity,
+                                 uint64_t * uncompressed_length,
+                                 unsigned int num_inflight) {
+    snappy_frame_job_t jobs[ACCEL_CHUNK_MAX_INFLIGHT];
+
+    if (num_inflight < 1) {
+        num_inflight = 1;
+    }
+    if (num_inflight > ACCEL_CHUNK_MAX_INFLIGHT) {
+        num_inflight = ACCEL_CHUNK_MAX_INFLIGHT;
+    }
+
+    bool ok = true;
+    bool seen_stream_id = false;
+    size_t in_pos = 0;
+    uint64_t out_pos = 0;
+    size_t submitted = 0;
+    size_t retired = 0;
+
+    while (ok && (in_pos < framed_length)) {
+        if (framed_length - in_pos < SNAPPY_FRAME_CHUNK_HEADER_BYTES) {
+            ok = false;
+            break;
+        }
+        unsigned char chunk_type = framed[in_pos];
+        size_t chunk_len = SnappyFrameRead24(framed + in_pos + 1);
+        const unsigned char * body = framed + in_pos + SNAPPY_FRAME_CHUNK_HEADER_BYTES;
+        in_pos += SNAPPY_FRAME_CHUNK_HEADER_BYTES;
+        if (framed_length - in_pos < chunk_len) {
+            ok = false;
+            break;
+        }
+        in_pos += chunk_len;
+
+        if (chunk_type == SNAPPY_FRAME_CHUNK_STREAM_ID) {
+            ok = (chunk_len == SNAPPY_FRAME_STREAM_ID_BYTES - SNAPPY_FRAME_CHUNK_HEADER_BYTES) &&
+                 (memcmp(body, snappy_stream_id + SNAPPY_FRAME_CHUNK_HEADER_BYTES, chunk_len) == 0);
+            seen_stream_id = true;
+            continue;
+        }
+        if (!seen_stream_id) {
+            ok = false;
+            break;
+        }
+        if (chunk_type >= 0x80) {
+            // padding and skippable chunks
+            continue;
+        }
+        if (((chunk_type != SNAPPY_FRAME_CHUNK_COMPRESSED) && (chunk_type != SNAPPY_FRAME_CHUNK_UNCOMPRESSED)) ||
+            (chunk_len < SNAPPY_FRAME_CRC_BYTES)) {
+            ok = false;
+            break;
+        }
+
+        uint32_t masked_crc = SnappyFrameRead32(body);
+        const unsigned char * payload = body + SNAPPY_FRAME_CRC_BYTES;
+        size_t payload_len = chunk_len - SNAPPY_FRAME_CRC_BYTES;
+
+        if (chunk_type == SNAPPY_FRAME_CHUNK_UNCOMPRESSED) {
+            if ((payload_len > SNAPPY_FRAME_CHUNK_BYTES) || (uncompressed_capacity - out_pos < payload_len)) {
+                ok = false;
+                break;
+            }
+            memcpy(uncompressed + out_pos, payload, payload_len);
+            ok = SnappyFrameMaskedCrc(uncompressed + out_pos, payload_len) == masked_crc;
+            out_pos += payload_len;
+            continue;
+        }
+
+        uint32_t chunk_uncompressed_len;
+        if ((SnappyFrameReadVarint(payload, payload_len, &chunk_uncompressed_len) == 0) ||
+            (chunk_uncompressed_len > SNAPPY_FRAME_CHUNK_BYTES) ||
+            (uncompressed_capacity - out_pos < chunk_uncompressed_len)) {
+            ok = false;
+            break;
+        }
+
+        if (submitted - retired == num_inflight) {
+            ok = SnappyFrameRetireJob(&jobs[retired % num_inflight]);
+            retired++;
+            if (!ok) {
+                break;
+            }
+        }
+
+        snappy_frame_job_t * job = &jobs[submitted % num_inflight];
+        job->done = false;
+        job->dst = uncompressed + out_pos;
+        job->dst_len = chunk_uncompressed_len;
+        job->masked_crc = masked_crc;
+        SnappyAccelRawUncompressNonblocking(payload, payload_len, job->dst, (bool*)&job->done);
+        submitted++;
+        out_pos += chunk_uncompressed_len;
+    }
+
+    while (retired < submitted) {
+        bool crc_ok = SnappyFrameRetireJob(&jobs[retired % num_inflight]);
+        ok = ok && crc_ok;
+        retired++;
+    }
+
+    // every job is retired, so this only resyncs the command router
+    uint64_t retval;
+#ifndef NOACCEL_DEBUG
+    if (submitted > 0) {
+        ROCC_INSTRUCTION_D(SNAPPY_DECOMPRESS_OPCODE, retval, SNAPPY_DECOMPRESS_FUNCT_CHECK_COMPLETION);
+    }
+#endif
+    asm volatile ("fence");
+
+    *uncompressed_length = out_pos;
+    return ok && seen_stream_id;
+}
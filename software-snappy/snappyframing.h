@@ -0,0 +1,47 @@
+#ifndef __SNAPPY_FRAMING_H
+#define __SNAPPY_FRAMING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Snappy framing format (framing_format.txt in the snappy sources) on top of
+// the accelerator.
+//
+// The input is cut into 64KB chunks that go to the accelerator as independent
+// raw Snappy jobs, up to num_inflight at a time. The masked CRC32C of each
+// chunk is computed on the host as the chunk retires, while the following
+// chunks are still being (de)compressed.
+
+#define SNAPPY_FRAME_CHUNK_BYTES (64 << 10)
+#define SNAPPY_FRAME_STREAM_ID_BYTES 10
+#define SNAPPY_FRAME_CHUNK_HEADER_BYTES 4
+#define SNAPPY_FRAME_CRC_BYTES 4
+
+#define SNAPPY_FRAME_CHUNK_COMPRESSED 0x00
+#define SNAPPY_FRAME_CHUNK_UNCOMPRESSED 0x01
+#define SNAPPY_FRAME_CHUNK_PADDING 0xfe
+#define SNAPPY_FRAME_CHUNK_STREAM_ID 0xff
+
+uint32_t SnappyCrc32c(uint32_t crc, const unsigned char * data, size_t len);
+
+uint32_t SnappyFrameMaskedCrc(const unsigned char * data, size_t len);
+
+size_t SnappyFramedMaxCompressedLength(size_t source_bytes);
+
+size_t SnappyFramedStagingBytes(unsigned int num_inflight);
+
+uint64_t SnappyAccelFramedCompress(const unsigned char * uncompressed,
+                                   size_t uncompressed_length,
+                                   unsigned char * framed,
+                                   unsigned char * staging,
+                                   unsigned int num_inflight);
+
+bool SnappyAccelFramedUncompress(const unsigned char * framed,
+                                 size_t framed_length,
+                                 unsigned char * uncompressed,
+                                 size_t uncompressed_capacity,
+                                 uint64_t * uncompressed_length,
+                                 unsigned int num_inflight);
+
+#endif //__SNAPPY_FRAMING_H
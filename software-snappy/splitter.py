@@ -6,6 +6,7 @@
 # abs path to output/build dir (usually current dir)
 # number of chunks
 # this chunkno (zero indexed)
+# optional: shard manifest from shardplan.py, replacing the round-robin deal
 #
 # assume current working
 #
@@ -14,16 +15,18 @@
 
 import sys
 
-assert len(sys.argv) == 5
+assert len(sys.argv) in (5, 6)
 
 input_path = sys.argv[1]
 output_path = sys.argv[2]
 num_chunks = int(sys.argv[3])
 this_chunk = int(sys.argv[4])
+manifest_file = sys.argv[5] if len(sys.argv) == 6 else None
 
 
 
 import os
+from benchhash import bench_hash64_file
 
 all_benchmarks = os.listdir(input_path)
 
@@ -48,6 +51,23 @@ chunks_list = [ [] for chunk in range(num_chunks) ]
 for index, filename_size_pair in enumerate(filenames_with_size):
     chunks_list[index % len(chunks_list)].append(filename_size_pair)
 
+
+# with a shard manifest from shardplan.py, the chunks are its shards
+if manifest_file is not None:
+    files_by_name = {}
+    for filename_size_pair in filenames_with_size:
+        files_by_name[filename_size_pair[0].replace(".raw", '')] = filename_size_pair
+
+    chunks_list = [ [] for chunk in range(num_chunks) ]
+    with open(manifest_file, 'r', encoding='utf-8') as f:
+        for line in f:
+            if line.startswith("# hcb-shard-manifest/1"):
+                assert f" shards={num_chunks} " in line, f"{manifest_file} is not a plan for {num_chunks} chunks"
+            if line.startswith("#") or not line.strip():
+                continue
+            shard, name = line.rstrip("\n").split(" ", 1)
+            chunks_list[int(shard)].append(files_by_name[name])
+
 import subprocess
 
 my_chunk = chunks_list[this_chunk]
@@ -58,6 +78,7 @@ num_benchmarks = 0
 benchmark_names = []
 uncompressed_arrays = []
 uncompressed_lens_array = []
+uncompressed_hashes = []
 compressed_arrays = []
 compressed_lens_array = []
 
@@ -95,6 +116,7 @@ for benchno, fileinfo in enumerate(my_chunk):
     uncompressed_lens_array.append(f"&{uncompressed_varname}_len")
     compressed_arrays.append(f"(char*)(&{compressed_varname})")
     compressed_lens_array.append(f"&{compressed_varname}_len")
+    uncompressed_hashes.append(f"0x{bench_hash64_file(input_file_raw):016x}ULL")
 
 
 overall_header = f"{output_path}/benchmark_data_helper.h"
@@ -125,3 +147,8 @@ with open(overall_header, 'w', encoding='utf-8') as f:
     f.write(",\n".join(compressed_lens_array))
     f.write("};\n\n")
 
+    # BenchHash64 of each uncompressed input, see benchverify.h
+    f.write("uint64_t benchmark_uncompressed_hash_array[] = {\n")
+    f.write(",\n".join(uncompressed_hashes))
+    f.write("};\n\n")
+
@@ -6,16 +6,42 @@
 #include <inttypes.h>
 #include <stdlib.h>
 #include "encoding.h"
+#include "benchreport.h"
 
 
 //#define DO_PRINT
 
+// unreported passes before each hash table size's sweep, at its first hist
+// SRAM size; reps and records are set in benchreport.h
+#ifndef BENCH_WARMUPS
+#define BENCH_WARMUPS 2
+#endif
+
+// Build with -DBENCH_ROUTER (BENCH_FLAGS=-DBENCH_ROUTER ./build-compress.sh) to
+// send every call through accelrouter.h instead of straight to the
+// accelerators: calls below the calibrated crossover run on the core
+// (snappycpu.c). Crossovers are read from ROUTER_PROFILE_PATH if it exists,
+// otherwise measured at startup on the largest benchmark of the shard and
+// written there.
+#ifdef BENCH_ROUTER
+#include "accelrouter.h"
+#include "snappycpu.h"
+
+#define ROUTER_PROFILE_PATH "snappy-router.profile"
+// bounds the startup calibration, the crossovers are far below this
+#define ROUTER_SAMPLE_MAX_BYTES (64 << 10)
+
+static int compress_route;
+static int uncompress_route;
+#endif
+
 
 
 bool run_benchmark(char * benchmark_compressed_data, size_t benchmark_compressed_data_len,
         char * write_region, char * benchmark_uncompressed_data, size_t benchmark_uncompressed_data_len,
         char * bench_name, unsigned int benchno, uint64_t hist_size, char * write_region_decomp, uint64_t hash_table_entries_log2,
-        size_t * total_data_uncompressed_processed, size_t * total_data_compressed_processed, uint64_t * total_cycles_taken, size_t * num_bench_pass, uint64_t * benchmark_sum_overall
+        size_t * total_data_uncompressed_processed, size_t * total_data_compressed_processed, uint64_t * total_cycles_taken, size_t * num_bench_pass, uint64_t * benchmark_sum_overall,
+        uint64_t * call_cycles, uint64_t * compressed_size_out
         ) {
 
 #ifdef DO_PRINT
@@ -51,7 +77,12 @@ bool run_benchmark(char * benchmark_compressed_data, size_t benchmark_compressed
 #endif
 
     uint64_t t1 = rdcycle();
+#ifdef BENCH_ROUTER
+    uint64_t compressed_size = AccelRouterRun(compress_route, (const unsigned char *)benchmark_uncompressed_data, benchmark_uncompressed_data_len,
+                                              (unsigned char *)write_region, SnappyMaxCompressedLength(benchmark_uncompressed_data_len));
+#else
     uint64_t compressed_size = SnappyAccelRawCompress(benchmark_uncompressed_data, benchmark_uncompressed_data_len, write_region);
+#endif
     uint64_t t2 = rdcycle();
 
     //printf("Start cycle: %" PRIu64 "\n", t1);
@@ -62,7 +93,12 @@ bool run_benchmark(char * benchmark_compressed_data, size_t benchmark_compressed
 #endif
 
     uint64_t t3 = rdcycle();
+#ifdef BENCH_ROUTER
+    bool uncompress_success = AccelRouterRun(uncompress_route, (const unsigned char *)write_region, compressed_size,
+                                             (unsigned char *)write_region_decomp, benchmark_uncompressed_data_len) != 0;
+#else
     bool uncompress_success = SnappyAccelRawUncompress(write_region, compressed_size, write_region_decomp);
+#endif
     uint64_t t4 = rdcycle();
 
     //printf("Start cycle: %" PRIu64 "\n", t1);
@@ -126,6 +162,8 @@ bool run_benchmark(char * benchmark_compressed_data, size_t benchmark_compressed
         }
     }
 
+    *call_cycles = fail ? BENCH_REPORT_NO_SAMPLE : (t2 - t1);
+    *compressed_size_out = compressed_size;
     if (!fail) {
         *total_data_uncompressed_processed += benchmark_uncompressed_data_len;
         *total_data_compressed_processed += compressed_size;
@@ -148,17 +186,12 @@ int main() {
     // ensure at least one page
     total_benchmarks_uncompressed_size += 4096;
 
-    unsigned int num_hist_sizes = 8;
+    unsigned int num_hist_sizes = 6;
     uint64_t hist_sizes[] = {
 //        2048 << 10,
 //        1024 << 10,
 //        512 << 10,
 //        256 << 10,
-
-
-        64 << 10, // warmup
-        64 << 10, // warmup
-
 //        128 << 10,
         64 << 10,
         32 << 10,
@@ -169,21 +202,6 @@ int main() {
     };
 
 
-    bool is_warmup[] = {
-
-        true, // warmup
-        true, // warmup
-
-        false,
-        false,
-        false,
-        false,
-        false,
-        false,
-        false
-    };
-
-
 
 
     unsigned int num_hash_table_sizes = 2;
@@ -205,8 +223,46 @@ int main() {
     unsigned char * result_area_decomp = SnappyDecompressAccelSetup(total_benchmarks_uncompressed_size * 2, hist_sizes[0]);
 
 
+#ifdef BENCH_ROUTER
+    compress_route = AccelRouterAddRoute("snappy-compress",
+                                         SnappyAccelCompressCodec, NULL,
+                                         SnappyCpuCompressCodec, NULL,
+                                         NULL, NULL);
+    // calibrated on streams compressed on the core, which decode the same
+    uncompress_route = AccelRouterAddRoute("snappy-uncompress",
+                                           SnappyAccelUncompressCodec, NULL,
+                                           SnappyCpuUncompressCodec, NULL,
+                                           SnappyCpuCompressCodec, NULL);
+
+    unsigned int sample_bench = 0;
+    for (unsigned int i = 1; i < num_benchmarks; i++) {
+        if (*(benchmark_uncompressed_data_len_array[i]) > *(benchmark_uncompressed_data_len_array[sample_bench])) {
+            sample_bench = i;
+        }
+    }
+    size_t sample_len = *(benchmark_uncompressed_data_len_array[sample_bench]);
+    if (sample_len > ROUTER_SAMPLE_MAX_BYTES) {
+        sample_len = ROUTER_SAMPLE_MAX_BYTES;
+    }
+
+    SnappyCompressSetDynamicHashTableSizeLog2(hash_table_sizes_log2[0]);
+    SnappyCompressSetDynamicHistSize(hist_sizes[0]);
+    SnappyDecompressSetDynamicHistSize(hist_sizes[0]);
+    // the result area is free until the first benchmark runs
+    AccelRouterCalibrateOrLoad(ROUTER_PROFILE_PATH,
+                               (const unsigned char *)benchmark_uncompressed_data_arrays[sample_bench], sample_len,
+                               result_area, total_benchmarks_uncompressed_size * 2);
+#endif
+
+    bench_report_run_t run;
+    if (!BenchReportRunInit(&run, "snappy/test-complete", num_benchmarks, BENCH_REPS)) {
+        printf("FAIL: could not allocate cycle samples\n");
+        exit(1);
+    }
+
     bool fail = false;
     uint64_t benchmark_sum_overall = 0;
+    unsigned int pass = 0;
 
 
     for (unsigned int k = 0; k < num_hash_table_sizes; k++) {
@@ -219,54 +275,67 @@ int main() {
 
 
 
-    for (unsigned int j = 0; j < num_hist_sizes; j++) {
+    for (unsigned int j = 0; j < BENCH_WARMUPS + num_hist_sizes; j++) {
+        bool is_warmup = j < BENCH_WARMUPS;
+        uint64_t hist_size = is_warmup ? hist_sizes[0] : hist_sizes[j - BENCH_WARMUPS];
 
-        SnappyCompressSetDynamicHistSize(hist_sizes[j]);
-        SnappyDecompressSetDynamicHistSize(hist_sizes[j]);
+        SnappyCompressSetDynamicHistSize(hist_size);
+        SnappyDecompressSetDynamicHistSize(hist_size);
 
 #ifdef DO_PRINT
-        printf("Using HISTSRAM size: %" PRIu64 "\n", hist_sizes[j]);
+        printf("Using HISTSRAM size: %" PRIu64 "\n", hist_size);
 #endif
 
-        size_t total_data_uncompressed_processed = 0;
-        size_t total_data_compressed_processed = 0;
-        uint64_t total_cycles_taken = 0;
-        size_t num_bench_passed = 0;
-
-
-
-
-
-        // offset write region on each iter to make sure first iter's correct
-        // results don't count for later iters
-        unsigned char * result_area2 = result_area + (j * 32);
-        unsigned char * result_area_decomp2 = result_area_decomp + (j * 32);
-        for (unsigned int i = 0; i < num_benchmarks; i++) {
-
-
-            if(run_benchmark((benchmark_compressed_data_arrays[i]), *(benchmark_compressed_data_len_array[i]),
-                result_area2, (benchmark_uncompressed_data_arrays[i]), *(benchmark_uncompressed_data_len_array[i]),
-                *(benchmark_names[i]), i, hist_sizes[j], result_area_decomp2, hash_table_sizes_log2[k], &total_data_uncompressed_processed, &total_data_compressed_processed, &total_cycles_taken, &num_bench_passed,
-                &benchmark_sum_overall)) {
-                fail = true;
+        BenchReportRunReset(&run);
+        unsigned int num_reps = is_warmup ? 1 : BENCH_REPS;
+        for (unsigned int rep = 0; rep < num_reps; rep++, pass++) {
+            size_t total_data_uncompressed_processed = 0;
+            size_t total_data_compressed_processed = 0;
+            uint64_t total_cycles_taken = 0;
+            size_t num_bench_passed = 0;
+
+            // offset write region on each pass to make sure earlier passes'
+            // correct results don't count for later ones
+            unsigned char * result_area2 = result_area + ((pass % 128) * 32);
+            unsigned char * result_area_decomp2 = result_area_decomp + ((pass % 128) * 32);
+            for (unsigned int i = 0; i < num_benchmarks; i++) {
+                uint64_t call_cycles;
+                uint64_t compressed_size;
+
+                if(run_benchmark((benchmark_compressed_data_arrays[i]), *(benchmark_compressed_data_len_array[i]),
+                    result_area2, (benchmark_uncompressed_data_arrays[i]), *(benchmark_uncompressed_data_len_array[i]),
+                    *(benchmark_names[i]), i, hist_size, result_area_decomp2, hash_table_sizes_log2[k], &total_data_uncompressed_processed, &total_data_compressed_processed, &total_cycles_taken, &num_bench_passed,
+                    &benchmark_sum_overall, &call_cycles, &compressed_size)) {
+                    fail = true;
+                }
+                BenchReportRunSample(&run, rep, i, *(benchmark_names[i]), *(benchmark_uncompressed_data_len_array[i]),
+                                     compressed_size, call_cycles);
+
+                size_t this_bench_size = *(benchmark_uncompressed_data_len_array[i]);
+                this_bench_size = ((this_bench_size / 32) + 1) * 32;
+
+                result_area2 += this_bench_size;
+                result_area_decomp2 += this_bench_size;
             }
 
-            size_t this_bench_size = *(benchmark_uncompressed_data_len_array[i]);
-            this_bench_size = ((this_bench_size / 32) + 1) * 32;
-
-            result_area2 += this_bench_size;
-            result_area_decomp2 += this_bench_size;
+            if (!is_warmup) {
+                printf("TOTAL: Took %" PRIu64 " cycles consumed %" PRIu64 " uncompressed bytes produced compsize %" PRIu64 " bytes SuccessNBenchmarks %d TotalNBenchmarks %d with histsram %" PRIu64 " with log2HTSize %" PRIu64 " rep %u\n", total_cycles_taken, total_data_uncompressed_processed, total_data_compressed_processed, num_bench_passed, num_benchmarks, hist_size, hash_table_sizes_log2[k], rep);
+            }
         }
 
-        if (!is_warmup[j]) {
-            printf("TOTAL: Took %" PRIu64 " cycles consumed %" PRIu64 " uncompressed bytes produced compsize %" PRIu64 " bytes SuccessNBenchmarks %d TotalNBenchmarks %d with histsram %" PRIu64 " with log2HTSize %" PRIu64 "\n", total_cycles_taken, total_data_uncompressed_processed, total_data_compressed_processed, num_bench_passed, num_benchmarks, hist_sizes[j], hash_table_sizes_log2[k]);
+        if (!is_warmup) {
+            char config[64];
+            snprintf(config, sizeof(config), "hist=%" PRIu64 " ht=%" PRIu64, hist_size, hash_table_sizes_log2[k]);
+            BenchReportRunPrint(&run, config, BENCH_RECORDS);
         }
-
-
     }
     }
+    BenchReportRunFree(&run);
 
     printf("FINAL: Benchmark sum: %" PRIu64 "\n", benchmark_sum_overall);
+#ifdef BENCH_ROUTER
+    AccelRouterPrintStats();
+#endif
 
 
     if (fail) {
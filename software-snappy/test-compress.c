@@ -6,11 +6,18 @@
 #include <inttypes.h>
 #include <stdlib.h>
 #include "encoding.h"
+#include "benchreport.h"
 
+// unreported passes before the sweep, at its first hist SRAM size; reps and
+// records are set in benchreport.h
+#ifndef BENCH_WARMUPS
+#define BENCH_WARMUPS 0
+#endif
 
 bool run_benchmark(char * benchmark_compressed_data, size_t benchmark_compressed_data_len,
         char * write_region, char * benchmark_uncompressed_data, size_t benchmark_uncompressed_data_len,
-        char * bench_name, unsigned int benchno, uint64_t hist_size) {
+        char * bench_name, unsigned int benchno, uint64_t hist_size,
+        uint64_t * call_cycles, uint64_t * compressed_size_out) {
 
     uint64_t * benchmark_uncompressed_data_by8 = (uint64_t *) benchmark_uncompressed_data;
     size_t bench_uncompressed_num_words = benchmark_uncompressed_data_len / 8;
@@ -33,6 +40,8 @@ bool run_benchmark(char * benchmark_compressed_data, size_t benchmark_compressed
 
     //printf("Start cycle: %" PRIu64 "\n", t1);
     //printf("End cycle: %" PRIu64 "\n", t2);
+    *call_cycles = t2 - t1;
+    *compressed_size_out = compressed_size;
     printf("Took %" PRIu64 " cycles, produced %" PRIu64 " compressed bytes. uncomp size: %" PRIu64 " for benchmark: %s, with histsram: %" PRIu64 "\n", t2 - t1, compressed_size, benchmark_uncompressed_data_len, bench_name, hist_size);
 
     //printf("Got output:\n");
@@ -100,27 +109,51 @@ int main() {
     printf("Setting up...\n");
     unsigned char * result_area = SnappyCompressAccelSetup(total_benchmarks_uncompressed_size, hist_sizes[0]);
 
-    bool fail = false;
+    bench_report_run_t run;
+    if (!BenchReportRunInit(&run, "snappy/test-compress", num_benchmarks, BENCH_REPS)) {
+        printf("FAIL: could not allocate cycle samples\n");
+        exit(1);
+    }
 
-    for (unsigned int j = 0; j < num_hist_sizes; j++) {
-        SnappyCompressSetDynamicHistSize(hist_sizes[j]);
-        printf("Using HISTSRAM size: %" PRIu64 "\n", hist_sizes[j]);
-
-        // offset write region on each iter to make sure first iter's correct
-        // results don't count for later iters
-        unsigned char * result_area2 = result_area + (j * 32);
-        for (unsigned int i = 0; i < num_benchmarks; i++) {
-            if(run_benchmark((benchmark_compressed_data_arrays[i]), *(benchmark_compressed_data_len_array[i]),
-                result_area2, (benchmark_uncompressed_data_arrays[i]), *(benchmark_uncompressed_data_len_array[i]),
-                *(benchmark_names[i]), i, hist_sizes[j])) {
-                fail = true;
+    bool fail = false;
+    unsigned int pass = 0;
+
+    for (unsigned int j = 0; j < BENCH_WARMUPS + num_hist_sizes; j++) {
+        bool is_warmup = j < BENCH_WARMUPS;
+        uint64_t hist_size = is_warmup ? hist_sizes[0] : hist_sizes[j - BENCH_WARMUPS];
+        SnappyCompressSetDynamicHistSize(hist_size);
+        printf("Using HISTSRAM size: %" PRIu64 "\n", hist_size);
+
+        BenchReportRunReset(&run);
+        unsigned int num_reps = is_warmup ? 1 : BENCH_REPS;
+        for (unsigned int rep = 0; rep < num_reps; rep++, pass++) {
+            // offset write region on each pass to make sure earlier passes'
+            // correct results don't count for later ones
+            unsigned char * result_area2 = result_area + ((pass % 128) * 32);
+            for (unsigned int i = 0; i < num_benchmarks; i++) {
+                uint64_t call_cycles;
+                uint64_t compressed_size;
+                if(run_benchmark((benchmark_compressed_data_arrays[i]), *(benchmark_compressed_data_len_array[i]),
+                    result_area2, (benchmark_uncompressed_data_arrays[i]), *(benchmark_uncompressed_data_len_array[i]),
+                    *(benchmark_names[i]), i, hist_size, &call_cycles, &compressed_size)) {
+                    fail = true;
+                }
+                BenchReportRunSample(&run, rep, i, *(benchmark_names[i]), *(benchmark_uncompressed_data_len_array[i]),
+                                     compressed_size, call_cycles);
+                size_t this_bench_size = *(benchmark_uncompressed_data_len_array[i]);
+                this_bench_size = ((this_bench_size / 32) + 1) * 32;
+
+                result_area2 += this_bench_size;
             }
-            size_t this_bench_size = *(benchmark_uncompressed_data_len_array[i]);
-            this_bench_size = ((this_bench_size / 32) + 1) * 32;
+        }
 
-            result_area2 += this_bench_size;
+        if (!is_warmup) {
+            char config[64];
+            snprintf(config, sizeof(config), "hist=%" PRIu64, hist_size);
+            BenchReportRunPrint(&run, config, BENCH_RECORDS);
         }
     }
+    BenchReportRunFree(&run);
 
 /*
     if (fail) {
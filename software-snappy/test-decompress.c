@@ -6,46 +6,32 @@
 #include <inttypes.h>
 #include <stdlib.h>
 #include "encoding.h"
+#include "benchverify.h"
+#include "benchreport.h"
 
 //#define DO_PRINT
 
+// unreported passes before the sweep, at its first SRAM size; reps and
+// records are set in benchreport.h
+#ifndef BENCH_WARMUPS
+#define BENCH_WARMUPS 2
+#endif
+
 
 
 bool run_benchmark(char * benchmark_compressed_data, size_t benchmark_compressed_data_len,
         char * write_region, char * benchmark_uncompressed_data, size_t benchmark_uncompressed_data_len,
+        uint64_t benchmark_uncompressed_hash,
         char * bench_name, unsigned int benchno, uint64_t sram_size,
-        size_t * total_data_uncompressed_processed, size_t * total_data_compressed_processed, uint64_t * total_cycles_taken, size_t * num_bench_pass, uint64_t * benchmark_sum_overall) {
+        size_t * total_data_uncompressed_processed, size_t * total_data_compressed_processed, uint64_t * total_cycles_taken, size_t * num_bench_pass,
+        uint64_t generation, uint64_t * call_cycles) {
 
 #ifdef DO_PRINT
     printf("Starting benchmark num %d: %s\n", benchno, bench_name);
 #endif
 
-    // zero-out parts of write region to ensure past correct results don't count
-    uint64_t * write_region_zero_by8 = (uint64_t *) write_region;
-    size_t bench_expected_write_num_words = benchmark_uncompressed_data_len / 8;
-    size_t bench_expected_tail_start = bench_expected_write_num_words * 8;
-
-    for (size_t i = 0; i < bench_expected_write_num_words; i++) {
-        write_region_zero_by8[i] = 0;
-    }
-    for (size_t i = bench_expected_tail_start; i < benchmark_uncompressed_data_len; i++) {
-        write_region[i] = 0;
-    }
-
-    uint64_t * benchmark_compressed_data_by8 = (uint64_t *) benchmark_compressed_data;
-    size_t bench_compressed_num_words = benchmark_compressed_data_len / 8;
-    size_t compressed_tail_start = bench_compressed_num_words * 8;
-
-    for (size_t i = 0; i < bench_compressed_num_words; i++) {
-        *benchmark_sum_overall += benchmark_compressed_data_by8[i];
-    }
-    for (size_t i = compressed_tail_start; i < benchmark_compressed_data_len; i++) {
-        *benchmark_sum_overall += benchmark_compressed_data[i];
-    }
-
-#ifdef DO_PRINT
-    printf("Benchmark sum: %" PRIu64 "\n", *benchmark_sum_overall);
-#endif
+    // tag the write region so past correct results don't count
+    BenchVerifyStamp((unsigned char *) write_region, benchmark_uncompressed_data_len, generation);
 
     uint64_t t1 = rdcycle();
     SnappyAccelRawUncompress(benchmark_compressed_data, benchmark_compressed_data_len, write_region);
@@ -66,56 +52,15 @@ bool run_benchmark(char * benchmark_compressed_data, size_t benchmark_compressed
     printf("Checking uncompressed output correctness:\n");
 #endif
 
-    uint64_t * benchmark_uncompressed_data_by8 = (uint64_t *) benchmark_uncompressed_data;
-    uint64_t * result_area_by8 = (uint64_t *) write_region;
-    size_t bench_num_words = benchmark_uncompressed_data_len / 8;
-    size_t tail_start = bench_num_words * 8;
-
     bool fail = false;
-    bool first_fail = true;
-
-    for (size_t i = 0; i < bench_num_words; i++) {
-        if (benchmark_uncompressed_data_by8[i] != result_area_by8[i]) {
-            fail = true;
-            if (first_fail) {
-                printf("FAIL ON BENCHMARK! N: %d, name: %s, with histsram: %" PRIu64 "\n", benchno, bench_name, sram_size);
-                first_fail = false;
-                break;
-            }
 
-
-            printf("FAIL: mismatch on word %" PRIu64 ": expected: 0x%016" PRIx64 ", got: 0x%016" PRIx64 "\n", i, (uint64_t)((uint64_t)benchmark_uncompressed_data_by8[i]), (uint64_t)((uint64_t)result_area_by8[i]));
-        }
-        if ((((i*8) % 10000000) == 0) && !fail) {
-#ifdef DO_PRINT
-            printf("Good after %" PRIu64 " bytes\n", i*8);
-#endif
-
-        }
-    }
-
-    for (size_t i = tail_start; i < benchmark_uncompressed_data_len; i++) {
-        if (fail) {
-            break;
-        }
-        if (benchmark_uncompressed_data[i] != write_region[i]) {
-            fail = true;
-            if (first_fail) {
-                printf("FAIL ON BENCHMARK! N: %d, name: %s, with histsram: %" PRIu64 "\n", benchno, bench_name, sram_size);
-                first_fail = false;
-            }
-            printf("FAIL: mismatch on char %" PRIu64 ": expected: 0x%02x, got: 0x%02x\n", i, (uint32_t)((uint8_t)benchmark_uncompressed_data[i]), (uint32_t)((uint8_t)write_region[i]));
-
-
-        }
-        if (((i % 100000) == 0) && !fail) {
-#ifdef DO_PRINT
-            printf("Good after %" PRIu64 " bytes\n", i);
-#endif
-
-        }
+    if (!BenchVerifyOutput((unsigned char *) write_region, (unsigned char *) benchmark_uncompressed_data,
+                           benchmark_uncompressed_data_len, benchmark_uncompressed_hash, bench_name)) {
+        printf("FAIL ON BENCHMARK! N: %d, name: %s, with histsram: %" PRIu64 "\n", benchno, bench_name, sram_size);
+        fail = true;
     }
 
+    *call_cycles = fail ? BENCH_REPORT_NO_SAMPLE : (t2 - t1);
     if (!fail) {
         *total_data_uncompressed_processed += benchmark_uncompressed_data_len;
         *total_data_compressed_processed += benchmark_compressed_data_len;
@@ -138,12 +83,8 @@ int main() {
     // ensure at least one page
     total_benchmarks_uncompressed_size += 4096;
 
-    unsigned int num_sram_sizes = 8;
+    unsigned int num_sram_sizes = 6;
     uint64_t sram_sizes[] = {
-
-        64 << 10, // warmup
-        64 << 10, // warmup
-
         64 << 10,
         32 << 10,
         16 << 10,
@@ -152,20 +93,11 @@ int main() {
         2 << 10
     };
 
-
-    bool is_warmup[] = {
-
-        true, // warmup
-        true, // warmup
-
-        false,
-        false,
-        false,
-        false,
-        false,
-        false
-    };
-
+    bench_report_run_t run;
+    if (!BenchReportRunInit(&run, "snappy/test-decompress", num_benchmarks, BENCH_REPS)) {
+        printf("FAIL: could not allocate cycle samples\n");
+        exit(1);
+    }
 
 
 #ifdef DO_PRINT
@@ -175,43 +107,58 @@ int main() {
     unsigned char * result_area = SnappyDecompressAccelSetup(total_benchmarks_uncompressed_size, sram_sizes[0]);
 
     bool fail = false;
-    uint64_t benchmark_sum_overall = 0;
 
 
-    for (unsigned int j = 0; j < num_sram_sizes; j++) {
-        SnappyDecompressSetDynamicHistSize(sram_sizes[j]);
+    unsigned int pass = 0;
+    for (unsigned int j = 0; j < BENCH_WARMUPS + num_sram_sizes; j++) {
+        bool is_warmup = j < BENCH_WARMUPS;
+        uint64_t sram_size = is_warmup ? sram_sizes[0] : sram_sizes[j - BENCH_WARMUPS];
+        SnappyDecompressSetDynamicHistSize(sram_size);
 #ifdef DO_PRINT
-        printf("Using SRAM size: %" PRIu64 "\n", sram_sizes[j]);
+        printf("Using SRAM size: %" PRIu64 "\n", sram_size);
 #endif
 
-        size_t total_data_uncompressed_processed = 0;
-        size_t total_data_compressed_processed = 0;
-        uint64_t total_cycles_taken = 0;
-        size_t num_bench_passed = 0;
-
-        // offset write region on each iter to make sure first iter's correct
-        // results don't count for later iters
-        unsigned char * result_area2 = result_area + (j * 32);
-        for (unsigned int i = 0; i < num_benchmarks; i++) {
-            if(run_benchmark((benchmark_compressed_data_arrays[i]), *(benchmark_compressed_data_len_array[i]),
-                result_area2, (benchmark_uncompressed_data_arrays[i]), *(benchmark_uncompressed_data_len_array[i]),
-                *(benchmark_names[i]), i, sram_sizes[j], &total_data_uncompressed_processed, &total_data_compressed_processed, &total_cycles_taken, &num_bench_passed,
-                &benchmark_sum_overall)) {
-                fail = true;
+        BenchReportRunReset(&run);
+        unsigned int num_reps = is_warmup ? 1 : BENCH_REPS;
+        for (unsigned int rep = 0; rep < num_reps; rep++, pass++) {
+            size_t total_data_uncompressed_processed = 0;
+            size_t total_data_compressed_processed = 0;
+            uint64_t total_cycles_taken = 0;
+            size_t num_bench_passed = 0;
+
+            // offset write region on each pass to make sure earlier passes'
+            // correct results don't count for later ones (the page of slack
+            // above bounds the offset)
+            unsigned char * result_area2 = result_area + ((pass % 128) * 32);
+            for (unsigned int i = 0; i < num_benchmarks; i++) {
+                uint64_t call_cycles;
+                if(run_benchmark((benchmark_compressed_data_arrays[i]), *(benchmark_compressed_data_len_array[i]),
+                    result_area2, (benchmark_uncompressed_data_arrays[i]), *(benchmark_uncompressed_data_len_array[i]),
+                    benchmark_uncompressed_hash_array[i],
+                    *(benchmark_names[i]), i, sram_size, &total_data_uncompressed_processed, &total_data_compressed_processed, &total_cycles_taken, &num_bench_passed,
+                    pass, &call_cycles)) {
+                    fail = true;
+                }
+                BenchReportRunSample(&run, rep, i, *(benchmark_names[i]), *(benchmark_uncompressed_data_len_array[i]),
+                                     *(benchmark_compressed_data_len_array[i]), call_cycles);
+                size_t this_bench_size = *(benchmark_uncompressed_data_len_array[i]);
+                this_bench_size = ((this_bench_size / 32) + 1) * 32;
+
+                result_area2 += this_bench_size;
             }
-            size_t this_bench_size = *(benchmark_uncompressed_data_len_array[i]);
-            this_bench_size = ((this_bench_size / 32) + 1) * 32;
 
-            result_area2 += this_bench_size;
+            if (!is_warmup) {
+                printf("TOTAL: Took %" PRIu64 " cycles produced %" PRIu64 " uncompressed bytes comp size %" PRIu64 " bytes SuccessNBenchmarks %d TotalNBenchmarks %d with histsram %" PRIu64 " rep %u\n", total_cycles_taken, total_data_uncompressed_processed, total_data_compressed_processed, num_bench_passed, num_benchmarks, sram_size, rep);
+            }
         }
 
-        if (!is_warmup[j]) {
-            printf("TOTAL: Took %" PRIu64 " cycles produced %" PRIu64 " uncompressed bytes comp size %" PRIu64 " bytes SuccessNBenchmarks %d TotalNBenchmarks %d with histsram %" PRIu64 "\n", total_cycles_taken, total_data_uncompressed_processed, total_data_compressed_processed, num_bench_passed, num_benchmarks, sram_sizes[j]);
+        if (!is_warmup) {
+            char config[64];
+            snprintf(config, sizeof(config), "hist=%" PRIu64, sram_size);
+            BenchReportRunPrint(&run, config, BENCH_RECORDS);
         }
-
     }
-
-    printf("FINAL: Benchmark sum: %" PRIu64 "\n", benchmark_sum_overall);
+    BenchReportRunFree(&run);
 
     if (fail) {
         printf("TEST FAILED!\n");
@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "accellib.h"
+#include "snappyframing.h"
+#include "encoding.h"
+
+// Framing format checks for SnappyAccelFramedCompress /
+// SnappyAccelFramedUncompress, on generated input so no benchmark file is
+// needed. Needs a config with both the Snappy compressor and decompressor.
+//
+// The input is three chunks and a short tail of text, with the second chunk
+// replaced by random bytes: that one must be stored uncompressed, the others
+// compressed, and the whole stream must decode to the input. An empty input
+// must frame to the stream identifier alone and decode to nothing. A CRC
+// flipped in a compressed chunk (checked as the accelerator job retires) and
+// in the stored one (checked on the host) must each fail the decode.
+
+#define INPUT_BYTES (3 * SNAPPY_FRAME_CHUNK_BYTES + 1000)
+#define RANDOM_CHUNK 1
+#define NUM_INFLIGHT 2
+
+static const char * words[] = {
+    "accelerator ", "snappy ", "framing ", "chunk ", "stream ", "crc32c ",
+    "masked ", "stored ", "history ", "hash ", "0123456789", "\n",
+};
+
+static void GenerateInput(unsigned char * buf, size_t len) {
+    uint32_t state = 12345;
+    size_t pos = 0;
+    while (pos < len) {
+        state = state * 1103515245 + 12345;
+        const char * word = words[(state >> 16) % (sizeof(words) / sizeof(words[0]))];
+        size_t word_len = strlen(word);
+        if (word_len > len - pos) {
+            word_len = len - pos;
+        }
+        memcpy(buf + pos, word, word_len);
+        pos += word_len;
+    }
+
+    unsigned char * random_chunk = buf + RANDOM_CHUNK * SNAPPY_FRAME_CHUNK_BYTES;
+    for (size_t i = 0; i < SNAPPY_FRAME_CHUNK_BYTES; i++) {
+        state = state * 1103515245 + 12345;
+        random_chunk[i] = (unsigned char)(state >> 24);
+    }
+}
+
+// Offset of the CRC of data chunk chunk_no in the framed stream, or 0 if the
+// stream does not have that many. Stores the chunk's type in chunk_type.
+static size_t FindChunkCrc(const unsigned char * framed, uint64_t framed_size, int chunk_no, unsigned char * chunk_type) {
+    size_t pos = SNAPPY_FRAME_STREAM_ID_BYTES;
+    for (int i = 0; pos + SNAPPY_FRAME_CHUNK_HEADER_BYTES <= framed_size; i++) {
+        size_t chunk_len = framed[pos + 1] | (framed[pos + 2] << 8) | (framed[pos + 3] << 16);
+        if (i == chunk_no) {
+            *chunk_type = framed[pos];
+            return pos + SNAPPY_FRAME_CHUNK_HEADER_BYTES;
+        }
+        pos += SNAPPY_FRAME_CHUNK_HEADER_BYTES + chunk_len;
+    }
+    return 0;
+}
+
+static bool CheckDecode(const char * name, const unsigned char * framed, uint64_t framed_size,
+        const unsigned char * expected, size_t expected_size, unsigned char * decomp, size_t decomp_capacity) {
+    uint64_t decomp_size = ~0ULL;
+    memset(decomp, 0, decomp_capacity);
+    if (!SnappyAccelFramedUncompress(framed, framed_size, decomp, decomp_capacity, &decomp_size, NUM_INFLIGHT)) {
+        printf("TEST FAILED: %s: decode failed\n", name);
+        return false;
+    }
+    if ((decomp_size != expected_size) || (memcmp(decomp, expected, expected_size) != 0)) {
+        printf("TEST FAILED: %s: decoded %" PRIu64 " bytes, expected %" PRIu64 "\n", name, decomp_size, (uint64_t)expected_size);
+        return false;
+    }
+    printf("%s: ok, %" PRIu64 " -> %" PRIu64 " bytes\n", name, (uint64_t)expected_size, framed_size);
+    return true;
+}
+
+static bool CheckCorruptCrc(const char * name, unsigned char * framed, uint64_t framed_size, int chunk_no,
+        unsigned char want_type, unsigned char * decomp, size_t decomp_capacity) {
+    unsigned char chunk_type;
+    size_t crc_pos = FindChunkCrc(framed, framed_size, chunk_no, &chunk_type);
+    if ((crc_pos == 0) || (chunk_type != want_type)) {
+        printf("TEST FAILED: %s: chunk %d missing or of type 0x%02x\n", name, chunk_no, crc_pos ? chunk_type : 0);
+        return false;
+    }
+
+    framed[crc_pos] ^= 0x01;
+    uint64_t decomp_size = 0;
+    bool decoded = SnappyAccelFramedUncompress(framed, framed_size, decomp, decomp_capacity, &decomp_size, NUM_INFLIGHT);
+    framed[crc_pos] ^= 0x01;
+
+    if (decoded) {
+        printf("TEST FAILED: %s: decode did not catch the bad CRC\n", name);
+        return false;
+    }
+    printf("%s: ok, rejected\n", name);
+    return true;
+}
+
+int main() {
+    size_t framed_capacity = SnappyFramedMaxCompressedLength(INPUT_BYTES);
+    size_t staging_bytes = SnappyFramedStagingBytes(NUM_INFLIGHT);
+
+    unsigned char * region = SnappyCompressAccelSetup(INPUT_BYTES + framed_capacity + staging_bytes, 64 << 10);
+    unsigned char * decomp = SnappyDecompressAccelSetup(INPUT_BYTES, 64 << 10);
+    SnappyCompressSetDynamicHashTableSizeLog2(14);
+
+    unsigned char * input = region;
+    unsigned char * framed = input + INPUT_BYTES;
+    unsigned char * staging = framed + framed_capacity;
+
+    GenerateInput(input, INPUT_BYTES);
+
+    bool pass = true;
+
+    uint64_t framed_size = SnappyAccelFramedCompress(input, INPUT_BYTES, framed, staging, NUM_INFLIGHT);
+    if (framed_size > framed_capacity) {
+        printf("TEST FAILED: framed %" PRIu64 " bytes, bound %" PRIu64 "\n", framed_size, (uint64_t)framed_capacity);
+        return 1;
+    }
+    int num_chunks = (INPUT_BYTES + SNAPPY_FRAME_CHUNK_BYTES - 1) / SNAPPY_FRAME_CHUNK_BYTES;
+    for (int i = 0; i < num_chunks; i++) {
+        unsigned char chunk_type;
+        unsigned char want_type = (i == RANDOM_CHUNK) ? SNAPPY_FRAME_CHUNK_UNCOMPRESSED : SNAPPY_FRAME_CHUNK_COMPRESSED;
+        if ((FindChunkCrc(framed, framed_size, i, &chunk_type) == 0) || (chunk_type != want_type)) {
+            printf("TEST FAILED: chunk %d is not of type 0x%02x\n", i, want_type);
+            pass = false;
+        }
+    }
+    pass &= CheckDecode("round trip", framed, framed_size, input, INPUT_BYTES, decomp, INPUT_BYTES);
+
+    pass &= CheckCorruptCrc("bad crc, compressed chunk", framed, framed_size, 0, SNAPPY_FRAME_CHUNK_COMPRESSED, decomp, INPUT_BYTES);
+    pass &= CheckCorruptCrc("bad crc, stored chunk", framed, framed_size, RANDOM_CHUNK, SNAPPY_FRAME_CHUNK_UNCOMPRESSED, decomp, INPUT_BYTES);
+    // the flips are undone, so the stream must decode again
+    pass &= CheckDecode("round trip after bad crc", framed, framed_size, input, INPUT_BYTES, decomp, INPUT_BYTES);
+
+    uint64_t empty_size = SnappyAccelFramedCompress(input, 0, framed, staging, NUM_INFLIGHT);
+    if (empty_size != SNAPPY_FRAME_STREAM_ID_BYTES) {
+        printf("TEST FAILED: empty input framed to %" PRIu64 " bytes\n", empty_size);
+        pass = false;
+    }
+    pass &= CheckDecode("empty", framed, empty_size, input, 0, decomp, INPUT_BYTES);
+
+    if (!pass) {
+        return 1;
+    }
+    printf("TEST PASSED\n");
+    return 0;
+}
@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "accellib.h"
+#include "snappycpu.h"
+#include "encoding.h"
+
+// Scatter-gather checks for the Snappy compressor, on generated input so no
+// benchmark file is needed.
+//
+// A gathered input must compress to the same bytes as the contiguous one.
+// The leading segments add up to more than 4KB, so the memloader has to start
+// streaming before the last segment is loaded. Each output is also
+// decompressed on the core. SnappyAccelCompressV is checked once with output
+// segments that hold the worst case (filled by the memwriter) and once with
+// segments that only hold the actual output (staging copy), with guard bytes
+// between segments.
+
+#define INPUT_BYTES (20 << 10)
+#define GUARD_BYTES 64
+#define GUARD_VALUE 0xa5
+#define NUM_GATHER_CALLS 2
+
+static const char * words[] = {
+    "accelerator ", "snappy ", "history ", "segment ", "gather ", "scatter ",
+    "memloader ", "memwriter ", "hash ", "table ", "0123456789", "\n",
+};
+
+static void GenerateInput(unsigned char * buf, size_t len) {
+    uint32_t state = 12345;
+    size_t pos = 0;
+    while (pos < len) {
+        state = state * 1103515245 + 12345;
+        const char * word = words[(state >> 16) % (sizeof(words) / sizeof(words[0]))];
+        size_t word_len = strlen(word);
+        if (word_len > len - pos) {
+            word_len = len - pos;
+        }
+        memcpy(buf + pos, word, word_len);
+        pos += word_len;
+    }
+}
+
+static bool CheckOutput(const char * name, const unsigned char * output, uint64_t output_size,
+        const unsigned char * expected, uint64_t expected_size,
+        const unsigned char * input, unsigned char * decomp) {
+    if ((output_size != expected_size) || (memcmp(output, expected, expected_size) != 0)) {
+        printf("TEST FAILED: %s: %" PRIu64 " bytes, expected %" PRIu64 "\n", name, output_size, expected_size);
+        return false;
+    }
+    memset(decomp, 0, INPUT_BYTES);
+    if (!SnappyCpuRawUncompress(output, output_size, decomp, INPUT_BYTES) || (memcmp(decomp, input, INPUT_BYTES) != 0)) {
+        printf("TEST FAILED: %s: does not decompress to the input\n", name);
+        return false;
+    }
+    printf("%s: ok, %" PRIu64 " bytes\n", name, output_size);
+    return true;
+}
+
+// Lays out the output segments in region with guard bytes around each one,
+// and collects them back in order for CheckOutput.
+static void PlaceOutSegments(unsigned char * region, const size_t * lens, int count, accel_out_iovec_t * out_iov) {
+    unsigned char * pos = region;
+    memset(pos, GUARD_VALUE, GUARD_BYTES);
+    pos += GUARD_BYTES;
+    for (int i = 0; i < count; i++) {
+        out_iov[i].base = pos;
+        out_iov[i].len = lens[i];
+        memset(pos, 0, lens[i]);
+        pos += lens[i];
+        memset(pos, GUARD_VALUE, GUARD_BYTES);
+        pos += GUARD_BYTES;
+    }
+}
+
+static bool CollectOutSegments(const accel_out_iovec_t * out_iov, int count, uint64_t size, unsigned char * collected) {
+    uint64_t pos = 0;
+    for (int i = 0; i < count; i++) {
+        for (size_t j = 0; j < GUARD_BYTES; j++) {
+            if (out_iov[i].base[out_iov[i].len + j] != GUARD_VALUE) {
+                printf("TEST FAILED: write past output segment %d\n", i);
+                return false;
+            }
+        }
+        uint64_t take = size - pos;
+        if (take > out_iov[i].len) {
+            take = out_iov[i].len;
+        }
+        memcpy(collected + pos, out_iov[i].base, take);
+        pos += take;
+    }
+    return true;
+}
+
+int main() {
+    size_t max_compressed = SnappyMaxCompressedLength(INPUT_BYTES);
+    size_t out_region_bytes = max_compressed + (SNAPPY_SCATTER_MAX_SEGMENTS + 1) * GUARD_BYTES;
+    size_t region_bytes = INPUT_BYTES * 2 + max_compressed * (NUM_GATHER_CALLS + 3) + out_region_bytes;
+
+    unsigned char * region = SnappyCompressAccelSetup(region_bytes, 64 << 10);
+    SnappyCompressSetDynamicHashTableSizeLog2(14);
+
+    unsigned char * input = region;
+    unsigned char * decomp = input + INPUT_BYTES;
+    unsigned char * expected = decomp + INPUT_BYTES;
+    unsigned char * staging = expected + max_compressed;
+    unsigned char * collected = staging + max_compressed;
+    unsigned char * gathered = collected + max_compressed;
+    unsigned char * out_region = gathered + max_compressed * NUM_GATHER_CALLS;
+
+    GenerateInput(input, INPUT_BYTES);
+
+    bool pass = true;
+
+    uint64_t expected_size = SnappyAccelRawCompress(input, INPUT_BYTES, expected);
+    pass &= CheckOutput("contiguous", expected, expected_size, expected, expected_size, input, decomp);
+
+    // 5000 + 3000 + 1 + 7000 leading bytes, with an empty segment skipped
+    size_t seg_lens[] = {5000, 3000, 1, 0, 7000};
+    int seg_count = sizeof(seg_lens) / sizeof(seg_lens[0]);
+    accel_iovec_t iov[SNAPPY_GATHER_MAX_SEGMENTS];
+    size_t seg_pos = 0;
+    for (int i = 0; i < seg_count; i++) {
+        iov[i].base = input + seg_pos;
+        iov[i].len = seg_lens[i];
+        seg_pos += seg_lens[i];
+    }
+    iov[seg_count].base = input + seg_pos;
+    iov[seg_count].len = INPUT_BYTES - seg_pos;
+    int iovcnt = seg_count + 1;
+
+    // back to back, so the second call's segments queue behind the first's
+    volatile uint64_t gathered_sizes[NUM_GATHER_CALLS];
+    for (int i = 0; i < NUM_GATHER_CALLS; i++) {
+        gathered_sizes[i] = 0;
+        SnappyAccelGatherCompressNonblocking(iov, iovcnt, gathered + i * max_compressed, (uint64_t*)&gathered_sizes[i]);
+    }
+    for (int i = 0; i < NUM_GATHER_CALLS; i++) {
+        BlockOnCompressCompletion(&gathered_sizes[i]);
+        pass &= CheckOutput("gather", gathered + i * max_compressed, gathered_sizes[i], expected, expected_size, input, decomp);
+    }
+
+    // the last segment only needs what is left of the worst case
+    size_t scatter_lens[] = {100, 1, 1000, 0, 37, 0};
+    int scatter_count = sizeof(scatter_lens) / sizeof(scatter_lens[0]);
+    accel_out_iovec_t out_iov[SNAPPY_SCATTER_MAX_SEGMENTS];
+    size_t scatter_leading = 0;
+    for (int i = 0; i < scatter_count - 1; i++) {
+        scatter_leading += scatter_lens[i];
+    }
+    scatter_lens[scatter_count - 1] = max_compressed - scatter_leading;
+    PlaceOutSegments(out_region, scatter_lens, scatter_count, out_iov);
+    uint64_t scattered_size = SnappyAccelCompressV(iov, iovcnt, out_iov, scatter_count, staging);
+    pass &= CollectOutSegments(out_iov, scatter_count, scattered_size, collected);
+    pass &= CheckOutput("scatter", collected, scattered_size, expected, expected_size, input, decomp);
+
+    // only the actual output size: goes through staging
+    scatter_lens[scatter_count - 1] = expected_size - scatter_leading;
+    PlaceOutSegments(out_region, scatter_lens, scatter_count, out_iov);
+    uint64_t staged_size = SnappyAccelCompressV(iov, iovcnt, out_iov, scatter_count, staging);
+    pass &= CollectOutSegments(out_iov, scatter_count, staged_size, collected);
+    pass &= CheckOutput("scatter via staging", collected, staged_size, expected, expected_size, input, decomp);
+
+    if (!pass) {
+        return 1;
+    }
+    printf("TEST PASSED\n");
+    return 0;
+}
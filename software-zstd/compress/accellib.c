@@ -1,14 +1,66 @@
 #include <assert.h>
 #include <malloc.h>
+#include <stdlib.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <inttypes.h>
+#include <string.h>
 #include "accellib.h"
 #include "rocc.h"
+#include "encoding.h"
+#include "zstdtune_model.h"
 
 #define PAGESIZE_BYTES 4096
 
+// Last value written to each runtime parameter register, so switching
+// contexts only re-issues what differs. Each hart reaches its own
+// accelerators, one per custom opcode.
+typedef struct {
+    bool hist_valid;
+    uint64_t hist_sram_size_limit_bytes;
+    bool ht_valid;
+    uint64_t hash_table_size_log2;
+    bool latency_valid;
+    uint64_t latency_inject_cycles;
+    bool has_intermediate_cache;
+    uint64_t param_writes;
+} zstd_compress_programmed_t;
+
+static zstd_compress_programmed_t zstd_compress_programmed[ZSTD_CTX_MAX_HARTS][4];
+
+static uint32_t ZstdCompressHartId() {
+    return (uint32_t)read_csr(mhartid);
+}
+
+static zstd_compress_programmed_t * ZstdCompressProgrammed(uint32_t hart, uint32_t opcode) {
+    assert(hart < ZSTD_CTX_MAX_HARTS);
+    assert(opcode < 4);
+    return &zstd_compress_programmed[hart][opcode];
+}
+
+static void ZstdCompressRecordHistSize(uint32_t opcode, uint64_t hist_sram_size_limit_bytes) {
+    zstd_compress_programmed_t * programmed = ZstdCompressProgrammed(ZstdCompressHartId(), opcode);
+    programmed->hist_valid = true;
+    programmed->hist_sram_size_limit_bytes = hist_sram_size_limit_bytes;
+    programmed->param_writes++;
+}
+
+static void ZstdCompressRecordHashTableSizeLog2(uint32_t opcode, uint64_t hash_table_size_log2) {
+    zstd_compress_programmed_t * programmed = ZstdCompressProgrammed(ZstdCompressHartId(), opcode);
+    programmed->ht_valid = true;
+    programmed->hash_table_size_log2 = hash_table_size_log2;
+    programmed->param_writes++;
+}
+
+static void ZstdCompressRecordLatencyInjectionInfo(uint32_t opcode, uint64_t latency_inject_cycles, bool has_intermediate_cache) {
+    zstd_compress_programmed_t * programmed = ZstdCompressProgrammed(ZstdCompressHartId(), opcode);
+    programmed->latency_valid = true;
+    programmed->latency_inject_cycles = latency_inject_cycles;
+    programmed->has_intermediate_cache = has_intermediate_cache;
+    programmed->param_writes++;
+}
+
 
 void ZstdCompressSetDynamicHistSize(uint64_t hist_sram_size_limit_bytes) {
 #ifndef NOACCEL_DEBUG
@@ -16,6 +68,7 @@ void ZstdCompressSetDynamicHistSize(uint64_t hist_sram_size_limit_bytes) {
                      hist_sram_size_limit_bytes,
                      FUNCT_SNPY_MAX_OFFSET_ALLOWED);
 #endif
+    ZstdCompressRecordHistSize(COMPRESS_OPCODE, hist_sram_size_limit_bytes);
 }
 
 void ZstdCompressSetDynamicHashTableSizeLog2(uint64_t hash_table_size_log2) {
@@ -24,6 +77,7 @@ void ZstdCompressSetDynamicHashTableSizeLog2(uint64_t hash_table_size_log2) {
                        hash_table_size_log2,
                        FUNCT_SNPY_RUNTIME_HT_NUM_ENTRIES_LOG2);
 #endif
+    ZstdCompressRecordHashTableSizeLog2(COMPRESS_OPCODE, hash_table_size_log2);
 }
 
 void ZstdCompressSetLatencyInjectionInfo(uint64_t latency_inject_cycles, bool has_intermediate_cache) {
@@ -33,6 +87,7 @@ void ZstdCompressSetLatencyInjectionInfo(uint64_t latency_inject_cycles, bool ha
                         (uint64_t)has_intermediate_cache,
                         FUNCT_LATENCY_INJECTION_INFO);
 #endif
+    ZstdCompressRecordLatencyInjectionInfo(COMPRESS_OPCODE, latency_inject_cycles, has_intermediate_cache);
 }
 
 unsigned char * ZstdCompressAccelSetup(size_t write_region_size) {
@@ -152,3 +207,1140 @@ int ZstdAccelCompress(const unsigned char * src,
                                  &completion_flag);
     return ZstdBlockOnCompressCompletion(&completion_flag);
 }
+
+// Workspace sizing
+
+// windowLog2 per compression level, as in ZstdCompressorFrameHeaderBuilder
+static const uint8_t zstd_window_log2[ZSTD_MAX_COMPRESSION_LEVEL] = {
+    16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+    17, 18, 19, 20, 21, 21, 21, 21, 21, 21
+};
+
+size_t ZstdCompressBlockSize(const size_t srcSize, const int clevel) {
+    assert((clevel >= 0) && (clevel < ZSTD_MAX_COMPRESSION_LEVEL));
+
+    size_t window_size = (size_t)1 << zstd_window_log2[clevel];
+    size_t block_size = (window_size < srcSize) ? window_size : srcSize;
+    if (block_size < 1) {
+        block_size = 1;
+    }
+    if (block_size > ZSTD_COMPRESS_BLOCKSIZE_MAX) {
+        block_size = ZSTD_COMPRESS_BLOCKSIZE_MAX;
+    }
+    return block_size;
+}
+
+// No point reserving chunks for more blocks than the input has.
+static size_t ZstdCompressWorkspaceChunks(const size_t srcSize, const size_t block_size, size_t num_chunks) {
+    size_t num_blocks = (srcSize + block_size - 1) / block_size;
+    if (num_chunks > num_blocks) {
+        num_chunks = num_blocks;
+    }
+    if (num_chunks > ZSTD_COMPRESS_WKSP_MAX_CHUNKS) {
+        num_chunks = ZSTD_COMPRESS_WKSP_MAX_CHUNKS;
+    }
+    if (num_chunks < 1) {
+        num_chunks = 1;
+    }
+    return num_chunks;
+}
+
+size_t ZstdCompressLitBuffBound(const size_t srcSize, const int clevel, size_t num_chunks) {
+    size_t block_size = ZstdCompressBlockSize(srcSize, clevel);
+    size_t chunk_bytes = block_size + 8;
+    return chunk_bytes * ZstdCompressWorkspaceChunks(srcSize, block_size, num_chunks);
+}
+
+size_t ZstdCompressSeqBuffBound(const size_t srcSize, const int clevel, size_t num_chunks) {
+    size_t block_size = ZstdCompressBlockSize(srcSize, clevel);
+    size_t max_sequences = block_size / ZSTD_COMPRESS_MIN_MATCH_LENGTH;
+    size_t chunk_bytes = max_sequences * ZSTD_COMPRESS_SEQUENCE_COMMAND_BYTES + 8;
+    return chunk_bytes * ZstdCompressWorkspaceChunks(srcSize, block_size, num_chunks);
+}
+
+// Same margin as ZSTD_COMPRESSBOUND (covers raw-block fallback and block
+// headers) plus the largest frame header the accelerator writes.
+size_t ZstdCompressBound(const size_t srcSize) {
+    size_t margin = srcSize >> 8;
+    if (srcSize < ZSTD_COMPRESS_BLOCKSIZE_MAX) {
+        margin += (ZSTD_COMPRESS_BLOCKSIZE_MAX - srcSize) >> 11;
+    }
+    return srcSize + margin + ZSTD_COMPRESS_FRAME_HEADER_MAX_BYTES;
+}
+
+// Per-input tuning
+
+#define ZSTD_TUNE_HASH_MULTIPLIER 0x1e35a7bdU // same as LZ77HashMatcher
+
+// One direct-mapped table per hash table size, packed back to back: the table
+// for log2 k starts at 2^k - 2^ZSTD_TUNE_MIN_HT_LOG2. An entry is the pass's
+// epoch in the upper 16 bits and position + 1 in the lower 16, so tables
+// only need clearing when the epoch wraps, not on every call.
+#define ZSTD_TUNE_TABLE_ENTRIES ((2U << ZSTD_TUNE_MAX_HT_LOG2) - (1U << ZSTD_TUNE_MIN_HT_LOG2))
+
+static uint32_t zstd_tune_tables[ZSTD_TUNE_TABLE_ENTRIES];
+static uint32_t zstd_tune_epoch = 0;
+
+static uint32_t ZstdTuneRead32(const unsigned char * p) {
+    return ((uint32_t)p[0]) |
+           ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+
+// Greedy single-probe matcher approximating HashTableBasic, run with the
+// largest table. Every position it looks up is also inserted into the smaller
+// tables. Like HashTableBasic, every size takes the 14-bit index from the top
+// of the hash and masks it, so a smaller table's bucket is the low bits of the
+// largest one's. A match counts for a smaller table when that table still
+// holds the same candidate. Matched bytes are
+// binned by the smallest history size that still reaches them.
+static void ZstdTuneMatchPass(const unsigned char * src,
+                              size_t len,
+                              uint64_t matched[ZSTD_TUNE_NUM_HT_SIZES][ZSTD_TUNE_NUM_HIST_SIZES]) {
+    if (++zstd_tune_epoch > 0xFFFF) {
+        memset(zstd_tune_tables, 0, sizeof(zstd_tune_tables));
+        zstd_tune_epoch = 1;
+    }
+    uint32_t tag = zstd_tune_epoch << 16;
+    memset(matched, 0, sizeof(uint64_t) * ZSTD_TUNE_NUM_HT_SIZES * ZSTD_TUNE_NUM_HIST_SIZES);
+
+    size_t pos = 0;
+    while (pos + 4 <= len) {
+        uint32_t key = ZstdTuneRead32(src + pos);
+        uint32_t index = (key * ZSTD_TUNE_HASH_MULTIPLIER) >> (32 - ZSTD_TUNE_MAX_HT_LOG2);
+        uint32_t prev[ZSTD_TUNE_NUM_HT_SIZES];
+        for (int t = 0; t < ZSTD_TUNE_NUM_HT_SIZES; t++) {
+            uint32_t log2 = ZSTD_TUNE_MIN_HT_LOG2 + t;
+            uint32_t * entry = &zstd_tune_tables[(1U << log2) - (1U << ZSTD_TUNE_MIN_HT_LOG2) + (index & ((1U << log2) - 1))];
+            prev[t] = *entry;
+            *entry = tag | (uint32_t)(pos + 1);
+        }
+
+        uint32_t cand = prev[ZSTD_TUNE_NUM_HT_SIZES - 1];
+        size_t cand_pos = (size_t)(cand & 0xFFFF) - 1;
+        if (((cand & 0xFFFF0000U) == tag) && (pos - cand_pos <= ZSTD_TUNE_MAX_HIST_SIZE) &&
+            (ZstdTuneRead32(src + cand_pos) == key)) {
+            size_t dist = pos - cand_pos;
+            size_t match_len = 4;
+            while ((pos + match_len < len) && (src[cand_pos + match_len] == src[pos + match_len])) {
+                match_len++;
+            }
+            int bin = 0;
+            while ((bin < ZSTD_TUNE_NUM_HIST_SIZES - 1) && (dist > ((size_t)ZSTD_TUNE_MIN_HIST_SIZE << bin))) {
+                bin++;
+            }
+            for (int t = 0; t < ZSTD_TUNE_NUM_HT_SIZES; t++) {
+                if (prev[t] == cand) {
+                    matched[t][bin] += match_len;
+                }
+            }
+            pos += match_len;
+        } else {
+            pos++;
+        }
+    }
+}
+
+static uint64_t ZstdTuneInputClass(const size_t srcSize, uint64_t sampled_bytes, uint64_t max_matched) {
+    uint64_t size_class = 0;
+    if (srcSize > ZSTD_TUNE_MEDIUM_INPUT_BYTES) {
+        size_class = 2;
+    } else if (srcSize > ZSTD_TUNE_SMALL_INPUT_BYTES) {
+        size_class = 1;
+    }
+    uint64_t match_class = (max_matched * ZSTD_TUNE_NUM_MATCH_CLASSES) / sampled_bytes;
+    if (match_class >= ZSTD_TUNE_NUM_MATCH_CLASSES) {
+        match_class = ZSTD_TUNE_NUM_MATCH_CLASSES - 1;
+    }
+    return size_class * ZSTD_TUNE_NUM_MATCH_CLASSES + match_class;
+}
+
+void ZstdCompressTuneForInput(const unsigned char * src,
+                              const size_t srcSize,
+                              size_t sample_bytes,
+                              uint32_t ratio_target_permille,
+                              zstd_tune_result_t * result) {
+    if ((sample_bytes == 0) || (sample_bytes > (srcSize >> ZSTD_TUNE_SAMPLE_SHIFT))) {
+        sample_bytes = srcSize >> ZSTD_TUNE_SAMPLE_SHIFT;
+    }
+    if (sample_bytes > ZSTD_TUNE_MAX_SAMPLE_BYTES) {
+        sample_bytes = ZSTD_TUNE_MAX_SAMPLE_BYTES;
+    }
+
+    result->hist_size = ZSTD_TUNE_MAX_HIST_SIZE;
+    result->hash_table_size_log2 = ZSTD_TUNE_MAX_HT_LOG2;
+    result->sampled_bytes = 0;
+    result->est_matched_bytes = 0;
+    result->est_max_matched_bytes = 0;
+    result->input_class = 0;
+    result->est_cycles_per_kb = 0;
+    if (sample_bytes < ZSTD_TUNE_MIN_SAMPLE_BYTES) {
+        return;
+    }
+
+    uint64_t matched[ZSTD_TUNE_NUM_HT_SIZES][ZSTD_TUNE_NUM_HIST_SIZES];
+    ZstdTuneMatchPass(src, sample_bytes, matched);
+
+    // est[t][h]: bytes covered with table t and history bin h
+    uint64_t est[ZSTD_TUNE_NUM_HT_SIZES][ZSTD_TUNE_NUM_HIST_SIZES];
+    for (int t = 0; t < ZSTD_TUNE_NUM_HT_SIZES; t++) {
+        uint64_t sum = 0;
+        for (int h = 0; h < ZSTD_TUNE_NUM_HIST_SIZES; h++) {
+            sum += matched[t][h];
+            est[t][h] = sum;
+        }
+    }
+    uint64_t max_matched = est[ZSTD_TUNE_NUM_HT_SIZES - 1][ZSTD_TUNE_NUM_HIST_SIZES - 1];
+    uint64_t target = (max_matched * ratio_target_permille) / 1000;
+    uint64_t input_class = ZstdTuneInputClass(srcSize, sample_bytes, max_matched);
+
+    // the cheapest measured setting that keeps enough of the matches, largest
+    // first so ties keep the larger one
+    int best_t = ZSTD_TUNE_NUM_HT_SIZES - 1;
+    int best_h = ZSTD_TUNE_NUM_HIST_SIZES - 1;
+    uint32_t best_cost = 0;
+    for (int h = ZSTD_TUNE_NUM_HIST_SIZES - 1; h >= 0; h--) {
+        for (int t = ZSTD_TUNE_NUM_HT_SIZES - 1; t >= 0; t--) {
+            uint32_t cost = zstd_tune_cycles_per_kb[input_class][h][t];
+            if ((cost == 0) || (est[t][h] < target)) {
+                continue;
+            }
+            if ((best_cost == 0) || (cost < best_cost)) {
+                best_cost = cost;
+                best_t = t;
+                best_h = h;
+            }
+        }
+    }
+
+    // none measured: the smallest hash table that keeps enough of the
+    // matches, then the smallest history that keeps enough of what it finds
+    if (best_cost == 0) {
+        while ((best_t > 0) && (est[best_t - 1][ZSTD_TUNE_NUM_HIST_SIZES - 1] >= target)) {
+            best_t--;
+        }
+        while ((best_h > 0) && (est[best_t][best_h - 1] >= target)) {
+            best_h--;
+        }
+    }
+
+    result->hist_size = (uint64_t)ZSTD_TUNE_MIN_HIST_SIZE << best_h;
+    result->hash_table_size_log2 = ZSTD_TUNE_MIN_HT_LOG2 + best_t;
+    result->sampled_bytes = sample_bytes;
+    result->est_matched_bytes = est[best_t][best_h];
+    result->est_max_matched_bytes = max_matched;
+    result->input_class = input_class;
+    result->est_cycles_per_kb = best_cost;
+}
+
+void ZstdCompressApplyTuning(const zstd_tune_result_t * result) {
+    ZstdCompressSetDynamicHistSize(result->hist_size);
+    ZstdCompressSetDynamicHashTableSizeLog2(result->hash_table_size_log2);
+}
+
+int ZstdAccelCompressAutoTuned(const unsigned char * src,
+                               const size_t srcSize,
+                               unsigned char * litBuff,
+                               const size_t litBuffSize,
+                               unsigned char * seqBuff,
+                               const size_t seqBuffSize,
+                               unsigned char * dst,
+                               const int clevel,
+                               zstd_tune_result_t * result) {
+    ZstdCompressTuneForInput(src,
+                             srcSize,
+                             ZSTD_TUNE_DEFAULT_SAMPLE_BYTES,
+                             ZSTD_TUNE_DEFAULT_RATIO_TARGET_PERMILLE,
+                             result);
+    ZstdCompressApplyTuning(result);
+    return ZstdAccelCompress(src,
+                             srcSize,
+                             litBuff,
+                             litBuffSize,
+                             seqBuff,
+                             seqBuffSize,
+                             dst,
+                             clevel);
+}
+
+
+uint64_t ZstdAccelCompressCodec(const unsigned char * src,
+                                size_t src_len,
+                                unsigned char * dst,
+                                size_t dst_capacity,
+                                void * ctx) {
+    zstd_compress_codec_ctx_t * c = (zstd_compress_codec_ctx_t *)ctx;
+    return (uint64_t)ZstdAccelCompress(src,
+                                       src_len,
+                                       c->litBuff,
+                                       c->litBuffSize,
+                                       c->seqBuff,
+                                       c->seqBuffSize,
+                                       dst,
+                                       c->clevel);
+}
+
+
+// Multi-instance dispatch
+
+// The opcode is part of the instruction encoding, so reaching an instance
+// picked at runtime takes a switch over the four custom opcodes.
+#define ROCC_INSTRUCTION_ON_OPCODE(opcode, INSN, ...) \
+    do {                                              \
+        switch (opcode) {                             \
+            case 0: INSN(0, __VA_ARGS__); break;      \
+            case 1: INSN(1, __VA_ARGS__); break;      \
+            case 2: INSN(2, __VA_ARGS__); break;      \
+            default: INSN(3, __VA_ARGS__); break;     \
+        }                                             \
+    } while (0)
+
+static zstd_accel_instance_t zstd_instances[ZSTD_DISPATCH_MAX_INSTANCES];
+static volatile uint32_t zstd_num_instances = 0;
+static volatile int zstd_dispatch_init_state = 0; // 0: empty, 1: filling, 2: ready
+static volatile int zstd_dispatch_add_lock = 0;
+
+// Readers only look at entries below this count, so it must be loaded with
+// acquire ordering to see them fully filled in.
+static uint32_t ZstdDispatchNumInstances() {
+    return __atomic_load_n(&zstd_num_instances, __ATOMIC_ACQUIRE);
+}
+
+// Adders are serialized, and each entry is filled in before the count that
+// makes it visible is published.
+int ZstdDispatchAddInstance(uint32_t hart, uint32_t opcode) {
+    while (__atomic_exchange_n(&zstd_dispatch_add_lock, 1, __ATOMIC_ACQUIRE)) {
+        asm volatile ("fence");
+    }
+    uint32_t idx = __atomic_load_n(&zstd_num_instances, __ATOMIC_RELAXED);
+    assert(idx < ZSTD_DISPATCH_MAX_INSTANCES);
+    assert(opcode < 4);
+
+    zstd_accel_instance_t * inst = &zstd_instances[idx];
+    inst->hart = hart;
+    inst->opcode = opcode;
+    inst->outstanding_bytes = 0;
+    inst->outstanding_jobs = 0;
+    inst->completed_jobs = 0;
+    inst->src_bytes = 0;
+    inst->dst_bytes = 0;
+    inst->busy_cycles = 0;
+    inst->busy_since = 0;
+
+    __atomic_store_n(&zstd_num_instances, idx + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&zstd_dispatch_add_lock, 0, __ATOMIC_RELEASE);
+    return (int)idx;
+}
+
+// Every hart calls this once before dispatching: the first caller fills in the
+// instance table from ZSTD_DISPATCH_INSTANCES, and each caller sfences the
+// instances on its core.
+void ZstdDispatchInit() {
+    int expected = 0;
+    if (__atomic_compare_exchange_n(&zstd_dispatch_init_state, &expected, 1, false,
+                                    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+        const uint32_t instances[][2] = ZSTD_DISPATCH_INSTANCES;
+        const uint32_t num_listed = sizeof(instances) / sizeof(instances[0]);
+        for (uint32_t i = 0; i < num_listed; i++) {
+            ZstdDispatchAddInstance(instances[i][0], instances[i][1]);
+        }
+        __atomic_store_n(&zstd_dispatch_init_state, 2, __ATOMIC_SEQ_CST);
+    }
+    while (__atomic_load_n(&zstd_dispatch_init_state, __ATOMIC_SEQ_CST) != 2) {
+        asm volatile ("fence");
+    }
+
+#ifndef NOACCEL_DEBUG
+    uint32_t hart = ZstdCompressHartId();
+    uint32_t num_instances = ZstdDispatchNumInstances();
+    for (uint32_t i = 0; i < num_instances; i++) {
+        if (zstd_instances[i].hart == hart) {
+            ROCC_INSTRUCTION_ON_OPCODE(zstd_instances[i].opcode, ROCC_INSTRUCTION, COMPRESS_SFENCE);
+        }
+    }
+#endif
+}
+
+void ZstdDispatchSetDynamicHistSize(uint64_t hist_sram_size_limit_bytes) {
+    uint32_t hart = ZstdCompressHartId();
+    uint32_t num_instances = ZstdDispatchNumInstances();
+    for (uint32_t i = 0; i < num_instances; i++) {
+        if (zstd_instances[i].hart == hart) {
+#ifndef NOACCEL_DEBUG
+            ROCC_INSTRUCTION_ON_OPCODE(zstd_instances[i].opcode, ROCC_INSTRUCTION_S,
+                                       hist_sram_size_limit_bytes,
+                                       FUNCT_SNPY_MAX_OFFSET_ALLOWED);
+#endif
+            ZstdCompressRecordHistSize(zstd_instances[i].opcode, hist_sram_size_limit_bytes);
+        }
+    }
+}
+
+void ZstdDispatchSetDynamicHashTableSizeLog2(uint64_t hash_table_size_log2) {
+    uint32_t hart = ZstdCompressHartId();
+    uint32_t num_instances = ZstdDispatchNumInstances();
+    for (uint32_t i = 0; i < num_instances; i++) {
+        if (zstd_instances[i].hart == hart) {
+#ifndef NOACCEL_DEBUG
+            ROCC_INSTRUCTION_ON_OPCODE(zstd_instances[i].opcode, ROCC_INSTRUCTION_S,
+                                       hash_table_size_log2,
+                                       FUNCT_SNPY_RUNTIME_HT_NUM_ENTRIES_LOG2);
+#endif
+            ZstdCompressRecordHashTableSizeLog2(zstd_instances[i].opcode, hash_table_size_log2);
+        }
+    }
+}
+
+void ZstdDispatchSetLatencyInjectionInfo(uint64_t latency_inject_cycles, bool has_intermediate_cache) {
+    uint32_t hart = ZstdCompressHartId();
+    uint32_t num_instances = ZstdDispatchNumInstances();
+    for (uint32_t i = 0; i < num_instances; i++) {
+        if (zstd_instances[i].hart == hart) {
+#ifndef NOACCEL_DEBUG
+            ROCC_INSTRUCTION_ON_OPCODE(zstd_instances[i].opcode, ROCC_INSTRUCTION_SS,
+                                       latency_inject_cycles,
+                                       (uint64_t)has_intermediate_cache,
+                                       FUNCT_LATENCY_INJECTION_INFO);
+#endif
+            ZstdCompressRecordLatencyInjectionInfo(zstd_instances[i].opcode, latency_inject_cycles, has_intermediate_cache);
+        }
+    }
+}
+
+// Only the owning hart can issue to an instance, so the local instance with
+// the fewest outstanding source bytes wins (ties go to fewer queued jobs).
+static int ZstdDispatchPickInstance() {
+    uint32_t hart = ZstdCompressHartId();
+    int best = -1;
+    uint32_t num_instances = ZstdDispatchNumInstances();
+    for (uint32_t i = 0; i < num_instances; i++) {
+        zstd_accel_instance_t * inst = &zstd_instances[i];
+        if (inst->hart != hart) {
+            continue;
+        }
+        if ((best < 0) ||
+            (inst->outstanding_bytes < zstd_instances[best].outstanding_bytes) ||
+            ((inst->outstanding_bytes == zstd_instances[best].outstanding_bytes) &&
+             (inst->outstanding_jobs < zstd_instances[best].outstanding_jobs))) {
+            best = (int)i;
+        }
+    }
+    return best;
+}
+
+int ZstdDispatchCompressNonblocking(zstd_dispatch_job_t * job,
+                                    const unsigned char * src,
+                                    const size_t srcSize,
+                                    unsigned char * litBuff,
+                                    const size_t litBuffSize,
+                                    unsigned char * seqBuff,
+                                    const size_t seqBuffSize,
+                                    unsigned char * dst,
+                                    const int clevel) {
+    int idx = ZstdDispatchPickInstance();
+    // no instance listed for this hart: ZSTD_DISPATCH_INSTANCES is out of
+    // sync with the SoC config
+    assert(idx >= 0);
+    zstd_accel_instance_t * inst = &zstd_instances[idx];
+
+    job->instance = idx;
+    job->src_size = srcSize;
+    job->completion_flag = 0;
+
+    if (inst->outstanding_jobs == 0) {
+        inst->busy_since = rdcycle();
+    }
+    inst->outstanding_jobs += 1;
+    inst->outstanding_bytes += srcSize;
+
+#ifndef NOACCEL_DEBUG
+    ROCC_INSTRUCTION_ON_OPCODE(inst->opcode, ROCC_INSTRUCTION_SS,
+                               (uint64_t)src, (uint64_t)srcSize, FUNCT_ZSTD_SRC_INFO);
+    ROCC_INSTRUCTION_ON_OPCODE(inst->opcode, ROCC_INSTRUCTION_SS,
+                               (uint64_t)litBuff, (uint64_t)litBuffSize, FUNCT_ZSTD_LIT_BUFF_INFO);
+    ROCC_INSTRUCTION_ON_OPCODE(inst->opcode, ROCC_INSTRUCTION_SS,
+                               (uint64_t)seqBuff, (uint64_t)seqBuffSize, FUNCT_ZSTD_SEQ_BUFF_INFO);
+    ROCC_INSTRUCTION_ON_OPCODE(inst->opcode, ROCC_INSTRUCTION_SS,
+                               (uint64_t)dst, (uint64_t)&job->completion_flag, FUNCT_ZSTD_DST_INFO);
+    ROCC_INSTRUCTION_ON_OPCODE(inst->opcode, ROCC_INSTRUCTION_S,
+                               (uint64_t)clevel, FUNCT_ZSTD_CLEVEL_INFO);
+#endif
+    return idx;
+}
+
+// Returns the compressed size. Jobs retire by polling their own flag; the
+// CHECK_COMPLETION that resyncs the command router is only issued once the
+// instance has drained, since it waits for every queued job.
+int ZstdDispatchBlockOnCompletion(zstd_dispatch_job_t * job) {
+    zstd_accel_instance_t * inst = &zstd_instances[job->instance];
+
+    asm volatile ("fence");
+#ifndef NOACCEL_DEBUG
+    while (! job->completion_flag) {
+        asm volatile ("fence");
+    }
+#endif
+
+    inst->outstanding_bytes -= job->src_size;
+    inst->outstanding_jobs -= 1;
+    inst->completed_jobs += 1;
+    inst->src_bytes += job->src_size;
+    inst->dst_bytes += (uint64_t)job->completion_flag;
+
+    if (inst->outstanding_jobs == 0) {
+        inst->busy_cycles += rdcycle() - inst->busy_since;
+#ifndef NOACCEL_DEBUG
+        uint64_t retval;
+        ROCC_INSTRUCTION_ON_OPCODE(inst->opcode, ROCC_INSTRUCTION_D, retval, FUNCT_CHECK_COMPLETION);
+#endif
+    }
+    return job->completion_flag;
+}
+
+int ZstdDispatchCompress(const unsigned char * src,
+                         const size_t srcSize,
+                         unsigned char * litBuff,
+                         const size_t litBuffSize,
+                         unsigned char * seqBuff,
+                         const size_t seqBuffSize,
+                         unsigned char * dst,
+                         const int clevel) {
+    zstd_dispatch_job_t job;
+    ZstdDispatchCompressNonblocking(&job, src, srcSize, litBuff, litBuffSize,
+                                    seqBuff, seqBuffSize, dst, clevel);
+    return ZstdDispatchBlockOnCompletion(&job);
+}
+
+void ZstdDispatchGetCounters(zstd_dispatch_counters_t * counters) {
+    counters->num_instances = ZstdDispatchNumInstances();
+    counters->completed_jobs = 0;
+    counters->src_bytes = 0;
+    counters->dst_bytes = 0;
+    counters->busy_cycles = 0;
+    counters->max_busy_cycles = 0;
+
+    uint32_t num_instances = ZstdDispatchNumInstances();
+    for (uint32_t i = 0; i < num_instances; i++) {
+        zstd_accel_instance_t * inst = &zstd_instances[i];
+        counters->completed_jobs += inst->completed_jobs;
+        counters->src_bytes += inst->src_bytes;
+        counters->dst_bytes += inst->dst_bytes;
+        counters->busy_cycles += inst->busy_cycles;
+        if (inst->busy_cycles > counters->max_busy_cycles) {
+            counters->max_busy_cycles = inst->busy_cycles;
+        }
+    }
+}
+
+void ZstdDispatchPrintCounters() {
+    uint32_t num_instances = ZstdDispatchNumInstances();
+    for (uint32_t i = 0; i < num_instances; i++) {
+        zstd_accel_instance_t * inst = &zstd_instances[i];
+        if (inst->completed_jobs == 0) {
+            continue;
+        }
+        printf("DISPATCH: instance %" PRIu32 " hart %" PRIu32 " opcode %" PRIu32 " jobs %" PRIu64 " consumed %" PRIu64 " uncompressed bytes produced %" PRIu64 " bytes busy %" PRIu64 " cycles\n",
+               i, inst->hart, inst->opcode, inst->completed_jobs, inst->src_bytes, inst->dst_bytes, inst->busy_cycles);
+    }
+
+    zstd_dispatch_counters_t counters;
+    ZstdDispatchGetCounters(&counters);
+    printf("DISPATCH TOTAL: instances %" PRIu32 " jobs %" PRIu64 " consumed %" PRIu64 " uncompressed bytes produced %" PRIu64 " bytes busy %" PRIu64 " cycles critical-path %" PRIu64 " cycles\n",
+           counters.num_instances, counters.completed_jobs, counters.src_bytes, counters.dst_bytes, counters.busy_cycles, counters.max_busy_cycles);
+}
+
+
+// Streaming compression
+
+#define ZSTD_CSTREAM_MAGIC_NUMBER 0xFD2FB528U
+#define ZSTD_CSTREAM_WINDOWLOG_ABSOLUTEMIN 10
+#define ZSTD_CSTREAM_BLOCK_HEADER_BYTES 3
+#define ZSTD_CSTREAM_BLOCK_TYPE_RAW 0
+#define ZSTD_CSTREAM_BLOCK_TYPE_RLE 1
+
+size_t ZstdCStreamWorkspaceSize(const int clevel) {
+    size_t chunk_size = (size_t)1 << zstd_window_log2[clevel];
+    return chunk_size
+           + ZstdCompressBound(chunk_size)
+           + ZstdCompressLitBuffBound(chunk_size, clevel, ZSTD_COMPRESS_WKSP_DEFAULT_CHUNKS)
+           + ZstdCompressSeqBuffBound(chunk_size, clevel, ZSTD_COMPRESS_WKSP_DEFAULT_CHUNKS);
+}
+
+void ZstdCStreamInit(zstd_cstream_t * zcs, const int clevel) {
+    assert((clevel >= 0) && (clevel < ZSTD_MAX_COMPRESSION_LEVEL));
+
+    zcs->clevel = clevel;
+    zcs->chunk_size = (size_t)1 << zstd_window_log2[clevel];
+    zcs->in_buff = ZstdCompressWorkspaceSetup(zcs->chunk_size);
+    zcs->out_buff_size = ZstdCompressBound(zcs->chunk_size);
+    zcs->out_buff = ZstdCompressAccelSetup(zcs->out_buff_size);
+    zcs->litBuffSize = ZstdCompressLitBuffBound(zcs->chunk_size, clevel, ZSTD_COMPRESS_WKSP_DEFAULT_CHUNKS);
+    zcs->seqBuffSize = ZstdCompressSeqBuffBound(zcs->chunk_size, clevel, ZSTD_COMPRESS_WKSP_DEFAULT_CHUNKS);
+    zcs->litBuff = ZstdCompressWorkspaceSetup(zcs->litBuffSize);
+    zcs->seqBuff = ZstdCompressWorkspaceSetup(zcs->seqBuffSize);
+    zcs->sink = NULL;
+    zcs->sink_ctx = NULL;
+}
+
+static void ZstdCStreamEmit(zstd_cstream_t * zcs, const unsigned char * data, size_t len) {
+    zcs->sink(zcs->sink_ctx, data, len);
+    zcs->produced_bytes += len;
+}
+
+// Frame header without a content size: magic, descriptor (no single segment,
+// no checksum, no dictionary), window descriptor.
+void ZstdCStreamBegin(zstd_cstream_t * zcs, zstd_cstream_sink_fn sink, void * sink_ctx) {
+    assert(sink != NULL);
+
+    zcs->sink = sink;
+    zcs->sink_ctx = sink_ctx;
+    zcs->in_fill = 0;
+    zcs->consumed_bytes = 0;
+    zcs->produced_bytes = 0;
+    zcs->num_chunks = 0;
+
+    unsigned char hdr[6];
+    hdr[0] = (unsigned char)(ZSTD_CSTREAM_MAGIC_NUMBER & 0xFF);
+    hdr[1] = (unsigned char)((ZSTD_CSTREAM_MAGIC_NUMBER >> 8) & 0xFF);
+    hdr[2] = (unsigned char)((ZSTD_CSTREAM_MAGIC_NUMBER >> 16) & 0xFF);
+    hdr[3] = (unsigned char)((ZSTD_CSTREAM_MAGIC_NUMBER >> 24) & 0xFF);
+    hdr[4] = 0;
+    hdr[5] = (unsigned char)((zstd_window_log2[zcs->clevel] - ZSTD_CSTREAM_WINDOWLOG_ABSOLUTEMIN) << 3);
+    ZstdCStreamEmit(zcs, hdr, sizeof(hdr));
+}
+
+// Length of the frame header the accelerator wrote, from its descriptor byte.
+static size_t ZstdCStreamFrameHeaderBytes(const unsigned char * frame) {
+    unsigned char fhd = frame[4];
+    uint32_t fcs_code = fhd >> 6;
+    bool single_segment = (fhd >> 5) & 0x1;
+    size_t fcs_bytes = (fcs_code == 0) ? (single_segment ? 1 : 0) : ((size_t)1 << fcs_code);
+    return 4 + 1 + (single_segment ? 0 : 1) + fcs_bytes;
+}
+
+// Compresses the staged chunk and forwards its blocks with the last-block
+// bit cleared; the stream's final block comes from ZstdCStreamEnd.
+static void ZstdCStreamCompressChunk(zstd_cstream_t * zcs) {
+    if (zcs->in_fill == 0) {
+        return;
+    }
+
+    int frame_bytes = ZstdAccelCompress(zcs->in_buff,
+                                        zcs->in_fill,
+                                        zcs->litBuff,
+                                        zcs->litBuffSize,
+                                        zcs->seqBuff,
+                                        zcs->seqBuffSize,
+                                        zcs->out_buff,
+                                        zcs->clevel);
+    assert((size_t)frame_bytes <= zcs->out_buff_size);
+
+    size_t pos = ZstdCStreamFrameHeaderBytes(zcs->out_buff);
+    size_t blocks_start = pos;
+    while (pos + ZSTD_CSTREAM_BLOCK_HEADER_BYTES <= (size_t)frame_bytes) {
+        unsigned char * bhdr = zcs->out_buff + pos;
+        uint32_t block_header = (uint32_t)bhdr[0] | ((uint32_t)bhdr[1] << 8) | ((uint32_t)bhdr[2] << 16);
+        uint32_t block_type = (block_header >> 1) & 0x3;
+        uint32_t block_size = block_header >> 3;
+        size_t payload_bytes = (block_type == ZSTD_CSTREAM_BLOCK_TYPE_RLE) ? 1 : block_size;
+
+        bhdr[0] &= ~0x1;
+        pos += ZSTD_CSTREAM_BLOCK_HEADER_BYTES + payload_bytes;
+        if (block_header & 0x1) {
+            break;
+        }
+    }
+    assert(pos <= (size_t)frame_bytes);
+
+    ZstdCStreamEmit(zcs, zcs->out_buff + blocks_start, pos - blocks_start);
+    zcs->consumed_bytes += zcs->in_fill;
+    zcs->num_chunks++;
+    zcs->in_fill = 0;
+}
+
+void ZstdCStreamPush(zstd_cstream_t * zcs, const unsigned char * src, size_t len) {
+    while (len > 0) {
+        size_t take = zcs->chunk_size - zcs->in_fill;
+        if (take > len) {
+            take = len;
+        }
+        memcpy(zcs->in_buff + zcs->in_fill, src, take);
+        zcs->in_fill += take;
+        src += take;
+        len -= take;
+
+        if (zcs->in_fill == zcs->chunk_size) {
+            ZstdCStreamCompressChunk(zcs);
+        }
+    }
+}
+
+// Compresses whatever is staged now, so everything pushed so far can be
+// decoded from the output; flushing often costs ratio.
+void ZstdCStreamFlush(zstd_cstream_t * zcs) {
+    ZstdCStreamCompressChunk(zcs);
+}
+
+// Flushes and closes the frame with an empty last raw block. Returns the
+// total compressed size of the stream.
+uint64_t ZstdCStreamEnd(zstd_cstream_t * zcs) {
+    ZstdCStreamCompressChunk(zcs);
+
+    unsigned char last_block[ZSTD_CSTREAM_BLOCK_HEADER_BYTES];
+    uint32_t block_header = 0x1 | (ZSTD_CSTREAM_BLOCK_TYPE_RAW << 1);
+    last_block[0] = (unsigned char)(block_header & 0xFF);
+    last_block[1] = 0;
+    last_block[2] = 0;
+    ZstdCStreamEmit(zcs, last_block, sizeof(last_block));
+
+    return zcs->produced_bytes;
+}
+
+
+// Verify-on-write
+
+static void ZstdVerifyJobIssue(zstd_verify_job_t * job,
+                               unsigned char * litBuff,
+                               const size_t litBuffSize,
+                               unsigned char * seqBuff,
+                               const size_t seqBuffSize,
+                               const int clevel) {
+    job->compressed_size = 0;
+    job->verified = false;
+    ZstdAccelCompressNonblocking(job->src,
+                                 job->src_len,
+                                 litBuff,
+                                 litBuffSize,
+                                 seqBuff,
+                                 seqBuffSize,
+                                 job->dst,
+                                 clevel,
+                                 (int *)&job->compressed_size);
+}
+
+// Returns the number of jobs that failed verification.
+size_t ZstdAccelCompressVerified(zstd_verify_job_t * jobs,
+                                 size_t num_jobs,
+                                 unsigned char * litBuff,
+                                 const size_t litBuffSize,
+                                 unsigned char * seqBuff,
+                                 const size_t seqBuffSize,
+                                 const int clevel,
+                                 zstd_verify_fn verify_fn,
+                                 void * verify_ctx,
+                                 unsigned char * scratch,
+                                 size_t scratch_len) {
+    size_t num_failed = 0;
+    if (num_jobs == 0) {
+        return 0;
+    }
+
+    ZstdVerifyJobIssue(&jobs[0], litBuff, litBuffSize, seqBuff, seqBuffSize, clevel);
+
+    for (size_t i = 0; i < num_jobs; i++) {
+        zstd_verify_job_t * job = &jobs[i];
+        ZstdBlockOnCompressCompletion(&job->compressed_size);
+
+        if (i + 1 < num_jobs) {
+            ZstdVerifyJobIssue(&jobs[i + 1], litBuff, litBuffSize, seqBuff, seqBuffSize, clevel);
+        }
+
+        // an empty source decodes to nothing, which verify_fn reports like
+        // a failure, so there is nothing to check
+        if (job->src_len == 0) {
+            job->verified = true;
+            continue;
+        }
+        uint64_t decompressed_size = 0;
+        if (job->src_len <= scratch_len) {
+            decompressed_size = verify_fn(job->dst, (size_t)job->compressed_size, scratch, scratch_len, verify_ctx);
+        }
+        job->verified = (decompressed_size == job->src_len) &&
+                        (memcmp(scratch, job->src, job->src_len) == 0);
+        if (!job->verified) {
+            num_failed++;
+        }
+    }
+    return num_failed;
+}
+
+
+// Accelerator contexts
+
+void ZstdCompressCtxInit(zstd_compress_ctx_t * ctx, const int algorithm, const int clevel) {
+    assert((algorithm == ZSTD_COMPRESS_ALGORITHM_ZSTD) || (algorithm == ZSTD_COMPRESS_ALGORITHM_SNAPPY));
+    assert((clevel >= 0) && (clevel < ZSTD_MAX_COMPRESSION_LEVEL));
+
+    memset(ctx, 0, sizeof(zstd_compress_ctx_t));
+    ctx->algorithm = algorithm;
+    ctx->clevel = clevel;
+    ctx->hist_sram_size_limit_bytes = ZSTD_CTX_DEFAULT_HIST_SIZE;
+    ctx->hash_table_size_log2 = ZSTD_CTX_DEFAULT_HT_LOG2;
+    ctx->latency_inject_cycles = 0;
+    ctx->has_intermediate_cache = false;
+}
+
+void ZstdCompressCtxSetBuffers(zstd_compress_ctx_t * ctx,
+                               unsigned char * litBuff,
+                               const size_t litBuffSize,
+                               unsigned char * seqBuff,
+                               const size_t seqBuffSize) {
+    ctx->litBuff = litBuff;
+    ctx->litBuffSize = litBuffSize;
+    ctx->seqBuff = seqBuff;
+    ctx->seqBuffSize = seqBuffSize;
+    ctx->owns_buffers = false;
+}
+
+void ZstdCompressCtxAllocBuffers(zstd_compress_ctx_t * ctx, const size_t max_src_size) {
+    ZstdCompressCtxFreeBuffers(ctx);
+    if (ctx->algorithm != ZSTD_COMPRESS_ALGORITHM_ZSTD) {
+        return;
+    }
+    ctx->litBuffSize = ZstdCompressLitBuffBound(max_src_size, ctx->clevel, ZSTD_COMPRESS_WKSP_DEFAULT_CHUNKS);
+    ctx->seqBuffSize = ZstdCompressSeqBuffBound(max_src_size, ctx->clevel, ZSTD_COMPRESS_WKSP_DEFAULT_CHUNKS);
+    ctx->litBuff = ZstdCompressWorkspaceSetup(ctx->litBuffSize);
+    ctx->seqBuff = ZstdCompressWorkspaceSetup(ctx->seqBuffSize);
+    ctx->owns_buffers = true;
+}
+
+void ZstdCompressCtxFreeBuffers(zstd_compress_ctx_t * ctx) {
+    if (ctx->owns_buffers) {
+        free(ctx->litBuff);
+        free(ctx->seqBuff);
+    }
+    ctx->litBuff = NULL;
+    ctx->litBuffSize = 0;
+    ctx->seqBuff = NULL;
+    ctx->seqBuffSize = 0;
+    ctx->owns_buffers = false;
+}
+
+// The hash table size and history limit only exist for the match finder, so
+// they are programmed for both algorithms; clevel and buffers travel with
+// every job and never need re-issuing.
+void ZstdCompressCtxActivate(const zstd_compress_ctx_t * ctx) {
+    const zstd_compress_programmed_t * programmed = ZstdCompressProgrammed(ZstdCompressHartId(), COMPRESS_OPCODE);
+    if (!programmed->hist_valid ||
+        (programmed->hist_sram_size_limit_bytes != ctx->hist_sram_size_limit_bytes)) {
+        ZstdCompressSetDynamicHistSize(ctx->hist_sram_size_limit_bytes);
+    }
+    if (!programmed->ht_valid ||
+        (programmed->hash_table_size_log2 != ctx->hash_table_size_log2)) {
+        ZstdCompressSetDynamicHashTableSizeLog2(ctx->hash_table_size_log2);
+    }
+    if (!programmed->latency_valid ||
+        (programmed->latency_inject_cycles != ctx->latency_inject_cycles) ||
+        (programmed->has_intermediate_cache != ctx->has_intermediate_cache)) {
+        ZstdCompressSetLatencyInjectionInfo(ctx->latency_inject_cycles, ctx->has_intermediate_cache);
+    }
+}
+
+void ZstdCompressCtxInvalidate() {
+    uint32_t hart = ZstdCompressHartId();
+    for (uint32_t opcode = 0; opcode < 4; opcode++) {
+        zstd_compress_programmed_t * programmed = ZstdCompressProgrammed(hart, opcode);
+        programmed->hist_valid = false;
+        programmed->ht_valid = false;
+        programmed->latency_valid = false;
+    }
+}
+
+uint64_t ZstdCompressCtxParamWrites() {
+    uint32_t hart = ZstdCompressHartId();
+    uint64_t param_writes = 0;
+    for (uint32_t opcode = 0; opcode < 4; opcode++) {
+        param_writes += ZstdCompressProgrammed(hart, opcode)->param_writes;
+    }
+    return param_writes;
+}
+
+// The merged compressor reports Snappy output size through the same
+// cmpflag/CHECK_COMPLETION pair as Zstd, as a 64-bit byte count.
+static uint64_t ZstdCompressCtxSnappyCompress(const unsigned char * src,
+                                              const size_t srcSize,
+                                              unsigned char * dst) {
+    volatile uint64_t compressed_size = 0;
+#ifndef NOACCEL_DEBUG
+    ROCC_INSTRUCTION_SS(COMPRESS_OPCODE,
+                        (uint64_t)src,
+                        (uint64_t)srcSize,
+                        FUNCT_SNPY_SRC_INFO);
+    ROCC_INSTRUCTION_SS(COMPRESS_OPCODE,
+                        (uint64_t)dst,
+                        (uint64_t)&compressed_size,
+                        FUNCT_SNPY_DST_INFO);
+
+    uint64_t retval;
+    ROCC_INSTRUCTION_D(COMPRESS_OPCODE, retval, FUNCT_CHECK_COMPLETION);
+#endif
+    asm volatile ("fence");
+
+#ifndef NOACCEL_DEBUG
+    while (! compressed_size) {
+        asm volatile ("fence");
+    }
+#endif
+    return compressed_size;
+}
+
+uint64_t ZstdCompressCtxCompress(const zstd_compress_ctx_t * ctx,
+                                 const unsigned char * src,
+                                 const size_t srcSize,
+                                 unsigned char * dst) {
+    ZstdCompressCtxActivate(ctx);
+    if (ctx->algorithm == ZSTD_COMPRESS_ALGORITHM_SNAPPY) {
+        return ZstdCompressCtxSnappyCompress(src, srcSize, dst);
+    }
+    assert(ctx->litBuff && ctx->seqBuff);
+    return (uint64_t)ZstdAccelCompress(src,
+                                       srcSize,
+                                       ctx->litBuff,
+                                       ctx->litBuffSize,
+                                       ctx->seqBuff,
+                                       ctx->seqBuffSize,
+                                       dst,
+                                       ctx->clevel);
+}
+
+
+// Standalone entropy compressors
+
+void EntropyCompressAccelSetup() {
+#ifndef NOACCEL_DEBUG
+    // HUF_COMPRESS_FUNCT_SFENCE == FSE_COMPRESS_FUNCT_SFENCE
+    ROCC_INSTRUCTION(ENTROPY_COMPRESS_OPCODE, HUF_COMPRESS_FUNCT_SFENCE);
+#endif
+}
+
+volatile int HufBlockOnCompressCompletion(volatile int * completion_flag) {
+    uint64_t retval;
+#ifndef NOACCEL_DEBUG
+    ROCC_INSTRUCTION_D(ENTROPY_COMPRESS_OPCODE, retval, HUF_COMPRESS_FUNCT_CHECK_COMPLETION);
+#endif
+    asm volatile ("fence");
+
+#ifndef NOACCEL_DEBUG
+    while (! *(completion_flag)) {
+        asm volatile ("fence");
+    }
+#endif
+
+    return *completion_flag;
+}
+
+volatile int FSEBlockOnCompressCompletion(volatile int * completion_flag) {
+    uint64_t retval;
+#ifndef NOACCEL_DEBUG
+    ROCC_INSTRUCTION_D(ENTROPY_COMPRESS_OPCODE, retval, FSE_COMPRESS_FUNCT_CHECK_COMPLETION);
+#endif
+    asm volatile ("fence");
+
+#ifndef NOACCEL_DEBUG
+    while (! *(completion_flag)) {
+        asm volatile ("fence");
+    }
+#endif
+
+    return *completion_flag;
+}
+
+void HufAccelCompressNonblocking(const unsigned char * src,
+                                 const size_t srcSize,
+                                 unsigned char * dst,
+                                 int * completion_flag) {
+    *completion_flag = 0;
+    asm volatile ("fence");
+#ifndef NOACCEL_DEBUG
+    ROCC_INSTRUCTION_SS(ENTROPY_COMPRESS_OPCODE,
+                        (uint64_t)src,
+                        (uint64_t)srcSize,
+                        HUF_COMPRESS_FUNCT_SRC_INFO);
+    ROCC_INSTRUCTION_SS(ENTROPY_COMPRESS_OPCODE,
+                        (uint64_t)dst,
+                        (uint64_t)completion_flag,
+                        HUF_COMPRESS_FUNCT_DST_INFO);
+#endif
+}
+
+int HufAccelCompress(const unsigned char * src,
+                     const size_t srcSize,
+                     unsigned char * dst) {
+    int completion_flag;
+    HufAccelCompressNonblocking(src, srcSize, dst, &completion_flag);
+    return HufBlockOnCompressCompletion(&completion_flag);
+}
+
+// The FSE blocks read their input back to front (zstd encodes in reverse),
+// which the router sets up from the same SRC_INFO.
+static void FSEAccelCompressIssue(const unsigned char * src,
+                                  const size_t srcSize,
+                                  const size_t nbSeq,
+                                  unsigned char * dst,
+                                  int * completion_flag) {
+    *completion_flag = 0;
+    asm volatile ("fence");
+#ifndef NOACCEL_DEBUG
+    ROCC_INSTRUCTION_SS(ENTROPY_COMPRESS_OPCODE,
+                        (uint64_t)src,
+                        (uint64_t)srcSize,
+                        FSE_COMPRESS_FUNCT_SRC_INFO);
+    ROCC_INSTRUCTION_SS(ENTROPY_COMPRESS_OPCODE,
+                        (uint64_t)dst,
+                        (uint64_t)completion_flag,
+                        FSE_COMPRESS_FUNCT_DST_INFO);
+    ROCC_INSTRUCTION_S(ENTROPY_COMPRESS_OPCODE,
+                       (uint64_t)nbSeq,
+                       FSE_COMPRESS_FUNCT_NBSEQ_INFO);
+#endif
+}
+
+void FSEAccelCompressNonblocking(const unsigned char * src,
+                                 const size_t nbSymbols,
+                                 unsigned char * dst,
+                                 int * completion_flag) {
+    FSEAccelCompressIssue(src, nbSymbols, nbSymbols, dst, completion_flag);
+}
+
+int FSEAccelCompress(const unsigned char * src,
+                     const size_t nbSymbols,
+                     unsigned char * dst) {
+    int completion_flag;
+    FSEAccelCompressNonblocking(src, nbSymbols, dst, &completion_flag);
+    return FSEBlockOnCompressCompletion(&completion_flag);
+}
+
+void FSESeqAccelCompressNonblocking(const accel_seq_command_t * seqs,
+                                    const size_t nbSeq,
+                                    unsigned char * dst,
+                                    int * completion_flag) {
+    FSEAccelCompressIssue((const unsigned char *)seqs,
+                          nbSeq * sizeof(accel_seq_command_t),
+                          nbSeq,
+                          dst,
+                          completion_flag);
+}
+
+int FSESeqAccelCompress(const accel_seq_command_t * seqs,
+                        const size_t nbSeq,
+                        unsigned char * dst) {
+    int completion_flag;
+    FSESeqAccelCompressNonblocking(seqs, nbSeq, dst, &completion_flag);
+    return FSEBlockOnCompressCompletion(&completion_flag);
+}
+
+
+// Standalone match finder
+
+void ZstdMatchFinderAccelSetup() {
+#ifndef NOACCEL_DEBUG
+    ROCC_INSTRUCTION(MATCHFINDER_OPCODE, MATCHFINDER_FUNCT_SFENCE);
+#endif
+}
+
+void ZstdMatchFinderSetMaxOffset(uint64_t max_offset_allowed) {
+#ifndef NOACCEL_DEBUG
+    ROCC_INSTRUCTION_S(MATCHFINDER_OPCODE,
+                       max_offset_allowed,
+                       MATCHFINDER_FUNCT_MAX_OFFSET_ALLOWED);
+#endif
+}
+
+void ZstdMatchFinderSetHashTableSizeLog2(uint64_t hash_table_size_log2) {
+#ifndef NOACCEL_DEBUG
+    ROCC_INSTRUCTION_S(MATCHFINDER_OPCODE,
+                       hash_table_size_log2,
+                       MATCHFINDER_FUNCT_RUNTIME_HT_NUM_ENTRIES_LOG2);
+#endif
+}
+
+void ZstdMatchFinderSetDictionary(const unsigned char * dict, size_t dictSize) {
+#ifndef NOACCEL_DEBUG
+    ROCC_INSTRUCTION_SS(MATCHFINDER_OPCODE,
+                        (uint64_t)dict,
+                        (uint64_t)dictSize,
+                        MATCHFINDER_FUNCT_DICT_INFO);
+#endif
+}
+
+void ZstdMatchFinderAccelNonblocking(const unsigned char * src,
+                                     const size_t srcSize,
+                                     unsigned char * litDst,
+                                     int * lit_flag,
+                                     accel_seq_command_t * seqDst,
+                                     int * seq_flag) {
+    *lit_flag = ZSTD_MATCHFINDER_FLAG_PENDING;
+    *seq_flag = ZSTD_MATCHFINDER_FLAG_PENDING;
+    asm volatile ("fence");
+#ifndef NOACCEL_DEBUG
+    ROCC_INSTRUCTION_SS(MATCHFINDER_OPCODE,
+                        (uint64_t)src,
+                        (uint64_t)srcSize,
+                        MATCHFINDER_FUNCT_SRC_INFO);
+    ROCC_INSTRUCTION_SS(MATCHFINDER_OPCODE,
+                        (uint64_t)litDst,
+                        (uint64_t)lit_flag,
+                        MATCHFINDER_FUNCT_LIT_DST_INFO);
+    ROCC_INSTRUCTION_SS(MATCHFINDER_OPCODE,
+                        (uint64_t)seqDst,
+                        (uint64_t)seq_flag,
+                        MATCHFINDER_FUNCT_SEQ_DST_INFO);
+#endif
+}
+
+void ZstdMatchFinderBlockOnCompletion(volatile int * lit_flag,
+                                      volatile int * seq_flag) {
+    asm volatile ("fence");
+#ifndef NOACCEL_DEBUG
+    while ((*lit_flag == ZSTD_MATCHFINDER_FLAG_PENDING) ||
+           (*seq_flag == ZSTD_MATCHFINDER_FLAG_PENDING)) {
+        asm volatile ("fence");
+    }
+#endif
+}
+
+
+// Performance counters
+
+uint64_t ZstdCompressReadPerfCounter(uint32_t idx) {
+    uint64_t value = 0;
+#ifndef NOACCEL_DEBUG
+    ROCC_INSTRUCTION_DS(COMPRESS_OPCODE, value, (uint64_t)idx, FUNCT_READ_PERF_COUNTER);
+#endif
+    return value;
+}
+
+void ZstdCompressPerfSnapshot(zstd_compress_perf_t * snap) {
+    for (uint32_t i = 0; i < ZSTD_COMP_PERF_NUM_COUNTERS; i++) {
+        snap->v[i] = ZstdCompressReadPerfCounter(i);
+    }
+}
+
+void ZstdCompressPerfDiff(const zstd_compress_perf_t * before,
+                          const zstd_compress_perf_t * after,
+                          zstd_compress_perf_t * delta) {
+    for (uint32_t i = 0; i < ZSTD_COMP_PERF_NUM_COUNTERS; i++) {
+        delta->v[i] = after->v[i] - before->v[i];
+    }
+}
+
+static uint64_t ZstdCompressPerfRatio(uint64_t num, uint64_t denom) {
+    return (denom == 0) ? 0 : (num / denom);
+}
+
+void ZstdCompressPerfPrint(const char * tag, const zstd_compress_perf_t * delta) {
+    const uint64_t * v = delta->v;
+    printf("PERF %s: matchfinder jobs %" PRIu64 " busy %" PRIu64 " cycles stalled %" PRIu64 " cycles\n",
+           tag, v[ZSTD_COMP_PERF_MF_JOBS], v[ZSTD_COMP_PERF_MF_BUSY_CYCLES], v[ZSTD_COMP_PERF_MF_STALL_CYCLES]);
+    printf("PERF %s: huffman jobs %" PRIu64 " busy %" PRIu64 " cycles stalled %" PRIu64 " cycles\n",
+           tag, v[ZSTD_COMP_PERF_HUF_JOBS], v[ZSTD_COMP_PERF_HUF_BUSY_CYCLES], v[ZSTD_COMP_PERF_HUF_STALL_CYCLES]);
+    printf("PERF %s: fse jobs %" PRIu64 " busy %" PRIu64 " cycles stalled %" PRIu64 " cycles\n",
+           tag, v[ZSTD_COMP_PERF_FSE_JOBS], v[ZSTD_COMP_PERF_FSE_BUSY_CYCLES], v[ZSTD_COMP_PERF_FSE_STALL_CYCLES]);
+    printf("PERF %s: l2 reqs %" PRIu64 " acks %" PRIu64 " avg latency %" PRIu64 " cycles\n",
+           tag, v[ZSTD_COMP_PERF_L2_REQS], v[ZSTD_COMP_PERF_L2_ACKS],
+           ZstdCompressPerfRatio(v[ZSTD_COMP_PERF_L2_INFLIGHT_CYCLES], v[ZSTD_COMP_PERF_L2_ACKS]));
+    printf("PERF %s: matchfinder l2 reads %" PRIu64 " avg latency %" PRIu64 " cycles\n",
+           tag, v[ZSTD_COMP_PERF_MF_L2_READ_REQS],
+           ZstdCompressPerfRatio(v[ZSTD_COMP_PERF_MF_L2_READ_INFLIGHT_CYCLES], v[ZSTD_COMP_PERF_MF_L2_READ_REQS]));
+}
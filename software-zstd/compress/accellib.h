@@ -20,6 +20,7 @@
 #define FUNCT_SNPY_RUNTIME_HT_NUM_ENTRIES_LOG2 9
 #define FUNCT_LATENCY_INJECTION_INFO 10
 #define FUNCT_CHECK_COMPLETION 11
+#define FUNCT_READ_PERF_COUNTER 12
 
 
 typedef struct {
@@ -60,4 +61,554 @@ int ZstdAccelCompress(const unsigned char * src, // src file
 
 volatile int ZstdBlockOnCompressCompletion(volatile int * completion_flag);
 
+
+// Workspace sizing
+//
+// The accelerator carves litBuff and seqBuff into per-block chunks and hands
+// a chunk back as soon as its block has been entropy coded, so the workspace
+// only needs to cover the blocks in flight, not the whole input. These return
+// the exact sizes the frame controller will use for a given source size and
+// compression level; num_chunks is how many blocks may be in flight (more
+// lets the match finder run further ahead of the encoders). The accelerator
+// tracks at most ZSTD_COMPRESS_WKSP_MAX_CHUNKS chunks per buffer.
+
+#define ZSTD_COMPRESS_WKSP_DEFAULT_CHUNKS 4
+#define ZSTD_COMPRESS_WKSP_MAX_CHUNKS 256
+#define ZSTD_COMPRESS_BLOCKSIZE_MAX (128 << 10)
+#define ZSTD_COMPRESS_MIN_MATCH_LENGTH 4
+#define ZSTD_COMPRESS_SEQUENCE_COMMAND_BYTES 12
+#define ZSTD_COMPRESS_FRAME_HEADER_MAX_BYTES 14
+#define ZSTD_MAX_COMPRESSION_LEVEL 22
+
+size_t ZstdCompressBlockSize(const size_t srcSize, const int clevel);
+
+size_t ZstdCompressLitBuffBound(const size_t srcSize, const int clevel, size_t num_chunks);
+
+size_t ZstdCompressSeqBuffBound(const size_t srcSize, const int clevel, size_t num_chunks);
+
+size_t ZstdCompressBound(const size_t srcSize);
+
+
+// Per-input tuning
+//
+// One software pass over a prefix of the input estimates how many bytes the
+// match finder would cover at each hash table size and history size the
+// accelerator supports. The settings that keep ratio_target_permille of what
+// the largest setting covers are then ranked by a cost model: the cycles per
+// KB the zstd-compress sweep measured for each setting, per input class
+// (match density of the sample, call size). The model is zstdtune_model.h,
+// written by fit-tune-model.py from the sweep logs; settings it has no
+// measurement for are not picked, and ties go to the larger setting. When no
+// setting that keeps the target is measured (the checked-in model has no
+// sweep data yet), the tuner takes the smallest hash table that keeps it,
+// then the smallest history.
+//
+// The pass reads at most 1/2^ZSTD_TUNE_SAMPLE_SHIFT of the input (inputs too
+// small to give ZSTD_TUNE_MIN_SAMPLE_BYTES keep the largest setting
+// untested), and updates one table per hash table size at each position.
+
+#define ZSTD_TUNE_DEFAULT_SAMPLE_BYTES (16 << 10)
+#define ZSTD_TUNE_DEFAULT_RATIO_TARGET_PERMILLE 980
+#define ZSTD_TUNE_SAMPLE_SHIFT 3
+#define ZSTD_TUNE_MIN_SAMPLE_BYTES 256
+#define ZSTD_TUNE_MAX_SAMPLE_BYTES ((64 << 10) - 1) // positions are kept in 16 bits
+#define ZSTD_TUNE_MAX_HIST_SIZE (64 << 10)
+#define ZSTD_TUNE_MIN_HIST_SIZE (2 << 10)
+#define ZSTD_TUNE_NUM_HIST_SIZES 6 // 2KB .. 64KB
+#define ZSTD_TUNE_MAX_HT_LOG2 14
+#define ZSTD_TUNE_MIN_HT_LOG2 9
+#define ZSTD_TUNE_NUM_HT_SIZES (ZSTD_TUNE_MAX_HT_LOG2 - ZSTD_TUNE_MIN_HT_LOG2 + 1)
+
+// input classes: ZSTD_TUNE_NUM_MATCH_CLASSES bands of the matched fraction of
+// the sample at the largest setting, times call sizes up to 4KB, up to 32KB,
+// and larger
+#define ZSTD_TUNE_NUM_MATCH_CLASSES 4
+#define ZSTD_TUNE_NUM_SIZE_CLASSES 3
+#define ZSTD_TUNE_SMALL_INPUT_BYTES (4 << 10)
+#define ZSTD_TUNE_MEDIUM_INPUT_BYTES (32 << 10)
+#define ZSTD_TUNE_NUM_CLASSES (ZSTD_TUNE_NUM_MATCH_CLASSES * ZSTD_TUNE_NUM_SIZE_CLASSES)
+
+typedef struct {
+  uint64_t hist_size;
+  uint64_t hash_table_size_log2;
+  uint64_t sampled_bytes;
+  uint64_t est_matched_bytes;     // at the chosen setting
+  uint64_t est_max_matched_bytes; // at the largest setting
+  uint64_t input_class;           // size class * ZSTD_TUNE_NUM_MATCH_CLASSES + match class
+  uint64_t est_cycles_per_kb;     // the model's, 0 if unsampled or unmeasured
+} zstd_tune_result_t;
+
+void ZstdCompressTuneForInput(const unsigned char * src,
+                              const size_t srcSize,
+                              size_t sample_bytes,
+                              uint32_t ratio_target_permille,
+                              zstd_tune_result_t * result);
+
+void ZstdCompressApplyTuning(const zstd_tune_result_t * result);
+
+int ZstdAccelCompressAutoTuned(const unsigned char * src,
+                               const size_t srcSize,
+                               unsigned char * litBuff,
+                               const size_t litBuffSize,
+                               unsigned char * seqBuff,
+                               const size_t seqBuffSize,
+                               unsigned char * dst,
+                               const int clevel,
+                               zstd_tune_result_t * result);
+
+// accel_codec_fn adapter for accelrouter.h
+typedef struct {
+  unsigned char * litBuff;
+  size_t litBuffSize;
+  unsigned char * seqBuff;
+  size_t seqBuffSize;
+  int clevel;
+} zstd_compress_codec_ctx_t;
+
+uint64_t ZstdAccelCompressCodec(const unsigned char * src,
+                                size_t src_len,
+                                unsigned char * dst,
+                                size_t dst_capacity,
+                                void * ctx);
+
+
+// Multi-instance dispatch
+//
+// SoC configs can stack several compressors on different custom opcodes, one
+// set per core. The instances that exist are listed as { hart, opcode } pairs
+// in ZSTD_DISPATCH_INSTANCES, which must match the SoC config (default: the
+// single-tile build, COMPRESS_OPCODE on hart 0); ZstdDispatchAddInstance
+// registers more at runtime, from any hart. Only listed instances are ever
+// issued to.
+// Requests go to the instance on the calling hart with the fewest outstanding
+// source bytes.
+
+#ifndef ZSTD_DISPATCH_INSTANCES
+#define ZSTD_DISPATCH_INSTANCES { { 0, COMPRESS_OPCODE } }
+#endif
+
+#define ZSTD_DISPATCH_MAX_INSTANCES 16
+
+typedef struct {
+  uint32_t hart;
+  uint32_t opcode;
+  volatile uint64_t outstanding_bytes;
+  volatile uint64_t outstanding_jobs;
+  volatile uint64_t completed_jobs;
+  volatile uint64_t src_bytes;
+  volatile uint64_t dst_bytes;
+  volatile uint64_t busy_cycles;
+  uint64_t busy_since;
+} zstd_accel_instance_t;
+
+typedef struct {
+  int instance;
+  uint64_t src_size;
+  volatile int completion_flag;
+} zstd_dispatch_job_t;
+
+typedef struct {
+  uint32_t num_instances;
+  uint64_t completed_jobs;
+  uint64_t src_bytes;
+  uint64_t dst_bytes;
+  uint64_t busy_cycles;     // summed over instances
+  uint64_t max_busy_cycles; // busiest instance, approximates wall time
+} zstd_dispatch_counters_t;
+
+void ZstdDispatchInit();
+
+int ZstdDispatchAddInstance(uint32_t hart, uint32_t opcode);
+
+void ZstdDispatchSetDynamicHistSize(uint64_t hist_sram_size_limit_bytes);
+
+void ZstdDispatchSetDynamicHashTableSizeLog2(uint64_t hash_table_size_log2);
+
+void ZstdDispatchSetLatencyInjectionInfo(uint64_t latency_inject_cycles, bool has_intermediate_cache);
+
+int ZstdDispatchCompressNonblocking(zstd_dispatch_job_t * job,
+                                    const unsigned char * src,
+                                    const size_t srcSize,
+                                    unsigned char * litBuff,
+                                    const size_t litBuffSize,
+                                    unsigned char * seqBuff,
+                                    const size_t seqBuffSize,
+                                    unsigned char * dst,
+                                    const int clevel);
+
+int ZstdDispatchBlockOnCompletion(zstd_dispatch_job_t * job);
+
+int ZstdDispatchCompress(const unsigned char * src,
+                         const size_t srcSize,
+                         unsigned char * litBuff,
+                         const size_t litBuffSize,
+                         unsigned char * seqBuff,
+                         const size_t seqBuffSize,
+                         unsigned char * dst,
+                         const int clevel);
+
+void ZstdDispatchGetCounters(zstd_dispatch_counters_t * counters);
+
+void ZstdDispatchPrintCounters();
+
+
+// Streaming compression
+//
+// Compresses an unbounded stream into a single Zstd frame with memory bounded
+// by the window of the compression level. Input is staged into window-sized
+// chunks; each chunk goes through the accelerator and its blocks are spliced
+// into the stream's frame (whose header leaves the content size out), so a
+// chunk never holds more than one window. Blocks the accelerator emits are
+// self-contained (no repeat offsets or repeat tables), but matches do not
+// reach back into earlier chunks.
+
+// Receives compressed output as it becomes available.
+typedef void (*zstd_cstream_sink_fn)(void * user_ctx,
+                                     const unsigned char * data,
+                                     size_t len);
+
+typedef struct {
+  int clevel;
+  size_t chunk_size;
+  unsigned char * in_buff;
+  size_t in_fill;
+  unsigned char * out_buff;
+  size_t out_buff_size;
+  unsigned char * litBuff;
+  size_t litBuffSize;
+  unsigned char * seqBuff;
+  size_t seqBuffSize;
+  zstd_cstream_sink_fn sink;
+  void * sink_ctx;
+  uint64_t consumed_bytes;
+  uint64_t produced_bytes;
+  uint64_t num_chunks;
+} zstd_cstream_t;
+
+size_t ZstdCStreamWorkspaceSize(const int clevel);
+
+void ZstdCStreamInit(zstd_cstream_t * zcs, const int clevel);
+
+void ZstdCStreamBegin(zstd_cstream_t * zcs, zstd_cstream_sink_fn sink, void * sink_ctx);
+
+void ZstdCStreamPush(zstd_cstream_t * zcs, const unsigned char * src, size_t len);
+
+void ZstdCStreamFlush(zstd_cstream_t * zcs);
+
+uint64_t ZstdCStreamEnd(zstd_cstream_t * zcs);
+
+
+// Verify-on-write
+//
+// Compresses a list of jobs and checks each one by decompressing it with
+// verify_fn (accel_codec_fn shape: nonzero on success, 0 on failure) and
+// comparing against the source. Verification of job N runs on the
+// host while the accelerator compresses job N+1, so it is hidden behind the
+// compression of the following job instead of being added to it. verify_fn is
+// typically a wrapper around ZSTD_decompress from zstd_decompress.c, or a
+// decompressor accelerator's codec adapter. Jobs run one at a time on the
+// compressor, so litBuff/seqBuff are shared; scratch must hold the largest
+// src_len. A job is verified when it decompresses to exactly src_len bytes
+// equal to the source; an empty source counts as verified.
+
+typedef uint64_t (*zstd_verify_fn)(const unsigned char * src,
+                                   size_t src_len,
+                                   unsigned char * dst,
+                                   size_t dst_capacity,
+                                   void * ctx);
+
+typedef struct {
+  const unsigned char * src;
+  size_t src_len;
+  unsigned char * dst; // ZstdCompressBound(src_len) bytes
+  volatile int compressed_size;
+  bool verified;
+} zstd_verify_job_t;
+
+size_t ZstdAccelCompressVerified(zstd_verify_job_t * jobs,
+                                 size_t num_jobs,
+                                 unsigned char * litBuff,
+                                 const size_t litBuffSize,
+                                 unsigned char * seqBuff,
+                                 const size_t seqBuffSize,
+                                 const int clevel,
+                                 zstd_verify_fn verify_fn,
+                                 void * verify_ctx,
+                                 unsigned char * scratch,
+                                 size_t scratch_len);
+
+
+// Accelerator contexts
+//
+// Runtime parameters (history limit, hash table size, latency injection) are
+// registers in the command router shared by every caller of the accelerator.
+// A context carries one tenant's settings; ZstdCompressCtxActivate (implied by
+// ZstdCompressCtxCompress) re-issues only the registers whose last written
+// value differs, so tenants can interleave jobs without leaking settings into
+// each other or paying for writes that change nothing. The plain Set*
+// functions above keep the same record, so mixing them with contexts is safe;
+// call ZstdCompressCtxInvalidate if the accelerator is reset behind the
+// library's back. Every core has its own accelerators, so the record is kept
+// per hart and per custom opcode, and the Ctx functions act on the calling
+// hart's.
+
+// hart ids the record covers
+#ifndef ZSTD_CTX_MAX_HARTS
+#define ZSTD_CTX_MAX_HARTS 8
+#endif
+
+#define ZSTD_COMPRESS_ALGORITHM_ZSTD 0
+#define ZSTD_COMPRESS_ALGORITHM_SNAPPY 1
+
+// Router reset values
+#define ZSTD_CTX_DEFAULT_HIST_SIZE ((64 << 10) - 64)
+#define ZSTD_CTX_DEFAULT_HT_LOG2 14
+
+typedef struct {
+  int algorithm;
+  int clevel;
+  uint64_t hist_sram_size_limit_bytes;
+  uint64_t hash_table_size_log2;
+  uint64_t latency_inject_cycles;
+  bool has_intermediate_cache;
+  unsigned char * litBuff;
+  size_t litBuffSize;
+  unsigned char * seqBuff;
+  size_t seqBuffSize;
+  bool owns_buffers;
+} zstd_compress_ctx_t;
+
+void ZstdCompressCtxInit(zstd_compress_ctx_t * ctx, const int algorithm, const int clevel);
+
+void ZstdCompressCtxSetBuffers(zstd_compress_ctx_t * ctx,
+                               unsigned char * litBuff,
+                               const size_t litBuffSize,
+                               unsigned char * seqBuff,
+                               const size_t seqBuffSize);
+
+void ZstdCompressCtxAllocBuffers(zstd_compress_ctx_t * ctx, const size_t max_src_size);
+
+void ZstdCompressCtxFreeBuffers(zstd_compress_ctx_t * ctx);
+
+void ZstdCompressCtxActivate(const zstd_compress_ctx_t * ctx);
+
+void ZstdCompressCtxInvalidate();
+
+uint64_t ZstdCompressCtxParamWrites();
+
+uint64_t ZstdCompressCtxCompress(const zstd_compress_ctx_t * ctx,
+                                 const unsigned char * src,
+                                 const size_t srcSize,
+                                 unsigned char * dst);
+
+#ifdef __cplusplus
+// Owns a context and, when constructed with a max_src_size, its workspace.
+class ZstdCompressContext {
+ public:
+  ZstdCompressContext(int algorithm, int clevel, size_t max_src_size = 0) {
+    ZstdCompressCtxInit(&ctx_, algorithm, clevel);
+    if (max_src_size > 0) {
+      ZstdCompressCtxAllocBuffers(&ctx_, max_src_size);
+    }
+  }
+
+  ~ZstdCompressContext() {
+    ZstdCompressCtxFreeBuffers(&ctx_);
+  }
+
+  ZstdCompressContext(const ZstdCompressContext &) = delete;
+  ZstdCompressContext & operator=(const ZstdCompressContext &) = delete;
+
+  void set_hist_size(uint64_t bytes) { ctx_.hist_sram_size_limit_bytes = bytes; }
+  void set_hash_table_size_log2(uint64_t log2) { ctx_.hash_table_size_log2 = log2; }
+  void set_latency_injection(uint64_t cycles, bool has_intermediate_cache) {
+    ctx_.latency_inject_cycles = cycles;
+    ctx_.has_intermediate_cache = has_intermediate_cache;
+  }
+  void set_buffers(unsigned char * litBuff, size_t litBuffSize,
+                   unsigned char * seqBuff, size_t seqBuffSize) {
+    ZstdCompressCtxFreeBuffers(&ctx_);
+    ZstdCompressCtxSetBuffers(&ctx_, litBuff, litBuffSize, seqBuff, seqBuffSize);
+  }
+
+  void activate() const { ZstdCompressCtxActivate(&ctx_); }
+
+  uint64_t compress(const unsigned char * src, size_t srcSize, unsigned char * dst) const {
+    return ZstdCompressCtxCompress(&ctx_, src, srcSize, dst);
+  }
+
+  const zstd_compress_ctx_t * get() const { return &ctx_; }
+
+ private:
+  zstd_compress_ctx_t ctx_;
+};
+#endif
+
+
+// Standalone entropy compressors
+//
+// HufCompressor, FSECompressor and FSESequenceCompressor are separate RoCC
+// blocks that run only the entropy stage, so LZ77 can be done elsewhere.
+// Each is built as its own config on custom2 (ENTROPY_COMPRESS_OPCODE) and
+// they are mutually exclusive with each other and with the full compressor.
+// The completion flag receives the number of bytes written to dst.
+//
+// HufCompressor turns a literal stream into a complete literals section
+// (header, Huffman tree description, jump table and streams).
+// FSECompressor FSE-codes a stream of small symbols (e.g. Huffman weights);
+// nbSymbols is the stream length. FSESequenceCompressor turns an array of
+// accel_seq_command_t into a complete sequences section (sequence count,
+// symbol compression modes, tables and bitstream).
+
+#define ENTROPY_COMPRESS_OPCODE 2
+
+#define HUF_COMPRESS_FUNCT_SFENCE 0
+#define HUF_COMPRESS_FUNCT_SRC_INFO 1
+#define HUF_COMPRESS_FUNCT_DST_INFO 2
+#define HUF_COMPRESS_FUNCT_CHECK_COMPLETION 3
+
+#define FSE_COMPRESS_FUNCT_SFENCE 0
+#define FSE_COMPRESS_FUNCT_SRC_INFO 1
+#define FSE_COMPRESS_FUNCT_DST_INFO 2
+#define FSE_COMPRESS_FUNCT_NBSEQ_INFO 3
+#define FSE_COMPRESS_FUNCT_CHECK_COMPLETION 4
+
+// Same layout the match finder writes to seqBuff: match_len_base is the
+// match length - 3 and offset_base is the zstd offset value, offset + 3
+// (repeat offsets are never emitted).
+typedef struct {
+  uint32_t lit_len;
+  uint32_t match_len_base;
+  uint32_t offset_base;
+} accel_seq_command_t;
+
+void EntropyCompressAccelSetup();
+
+volatile int HufBlockOnCompressCompletion(volatile int * completion_flag);
+
+// Shared by FSECompressor and FSESequenceCompressor.
+volatile int FSEBlockOnCompressCompletion(volatile int * completion_flag);
+
+void HufAccelCompressNonblocking(const unsigned char * src,
+                                 const size_t srcSize,
+                                 unsigned char * dst,
+                                 int * completion_flag);
+
+int HufAccelCompress(const unsigned char * src,
+                     const size_t srcSize,
+                     unsigned char * dst);
+
+void FSEAccelCompressNonblocking(const unsigned char * src,
+                                 const size_t nbSymbols,
+                                 unsigned char * dst,
+                                 int * completion_flag);
+
+int FSEAccelCompress(const unsigned char * src,
+                     const size_t nbSymbols,
+                     unsigned char * dst);
+
+void FSESeqAccelCompressNonblocking(const accel_seq_command_t * seqs,
+                                    const size_t nbSeq,
+                                    unsigned char * dst,
+                                    int * completion_flag);
+
+int FSESeqAccelCompress(const accel_seq_command_t * seqs,
+                        const size_t nbSeq,
+                        unsigned char * dst);
+
+
+// Standalone match finder
+//
+// ZstdMatchFinderRoCC (custom3) runs only the LZ77 stage: for each SRC_INFO
+// it writes the block's literals to litDst and its sequences, as
+// accel_seq_command_t, to seqDst. When a block is done the number of bytes
+// written is stored to lit_flag and seq_flag (4 bytes each). Either count can
+// legitimately be 0, so the flags start at ZSTD_MATCHFINDER_FLAG_PENDING.
+// Blocks are independent jobs; up to 4 can be queued.
+//
+// A dictionary set with ZstdMatchFinderSetDictionary is streamed in ahead of
+// every following block, until it is cleared (size 0). The match finder only
+// indexes it, at about one cycle per byte, and matches in the block can then
+// point back into it: offsets count from the end of the dictionary.
+//
+// The index stays in the hash table for later blocks given the same
+// dictionary (address and size), and across blocks with none in between, so
+// those blocks only stream it in at full width. Changing the hash table size
+// or ZstdMatchFinderAccelSetup drops it; call the latter after rewriting a
+// dictionary's bytes in place.
+
+#define MATCHFINDER_OPCODE 3
+
+#define MATCHFINDER_FUNCT_SFENCE 0
+#define MATCHFINDER_FUNCT_SRC_INFO 1
+#define MATCHFINDER_FUNCT_LIT_DST_INFO 2
+#define MATCHFINDER_FUNCT_SEQ_DST_INFO 3
+#define MATCHFINDER_FUNCT_MAX_OFFSET_ALLOWED 4
+#define MATCHFINDER_FUNCT_CHECK_COMPLETION 5
+#define MATCHFINDER_FUNCT_RUNTIME_HT_NUM_ENTRIES_LOG2 6
+#define MATCHFINDER_FUNCT_DICT_INFO 7
+
+#define ZSTD_MATCHFINDER_FLAG_PENDING (-1)
+
+void ZstdMatchFinderAccelSetup();
+
+void ZstdMatchFinderSetMaxOffset(uint64_t max_offset_allowed);
+
+void ZstdMatchFinderSetHashTableSizeLog2(uint64_t hash_table_size_log2);
+
+void ZstdMatchFinderSetDictionary(const unsigned char * dict, size_t dictSize);
+
+void ZstdMatchFinderAccelNonblocking(const unsigned char * src,
+                                     const size_t srcSize,
+                                     unsigned char * litDst,
+                                     int * lit_flag,
+                                     accel_seq_command_t * seqDst,
+                                     int * seq_flag);
+
+// Waits for one block only; FUNCT_CHECK_COMPLETION would wait for every
+// queued block, which defeats keeping the match finder busy.
+void ZstdMatchFinderBlockOnCompletion(volatile int * lit_flag,
+                                      volatile int * seq_flag);
+
+
+// Performance counters
+//
+// Free-running hardware counters, read one at a time with
+// FUNCT_READ_PERF_COUNTER (rs1 = index, see CompressorPerfCounters in
+// PerfCounters.scala). They are never cleared: snapshot before and after a
+// region of interest and diff. Busy cycles count cycles with at least one job
+// in the unit; stall cycles are the busy cycles where one of the unit's memory
+// ports had a request waiting. L2 inflight cycles sum the outstanding requests
+// every cycle, so inflight_cycles / acks is the average memory latency.
+
+#define ZSTD_COMP_PERF_MF_JOBS 0
+#define ZSTD_COMP_PERF_MF_BUSY_CYCLES 1
+#define ZSTD_COMP_PERF_MF_STALL_CYCLES 2
+#define ZSTD_COMP_PERF_HUF_JOBS 3
+#define ZSTD_COMP_PERF_HUF_BUSY_CYCLES 4
+#define ZSTD_COMP_PERF_HUF_STALL_CYCLES 5
+#define ZSTD_COMP_PERF_FSE_JOBS 6
+#define ZSTD_COMP_PERF_FSE_BUSY_CYCLES 7
+#define ZSTD_COMP_PERF_FSE_STALL_CYCLES 8
+#define ZSTD_COMP_PERF_L2_REQS 9
+#define ZSTD_COMP_PERF_L2_ACKS 10
+#define ZSTD_COMP_PERF_L2_INFLIGHT_CYCLES 11
+#define ZSTD_COMP_PERF_MF_L2_READ_REQS 12
+#define ZSTD_COMP_PERF_MF_L2_READ_INFLIGHT_CYCLES 13
+#define ZSTD_COMP_PERF_NUM_COUNTERS 14
+
+typedef struct {
+  uint64_t v[ZSTD_COMP_PERF_NUM_COUNTERS];
+} zstd_compress_perf_t;
+
+uint64_t ZstdCompressReadPerfCounter(uint32_t idx);
+
+void ZstdCompressPerfSnapshot(zstd_compress_perf_t * snap);
+
+void ZstdCompressPerfDiff(const zstd_compress_perf_t * before,
+                          const zstd_compress_perf_t * after,
+                          zstd_compress_perf_t * delta);
+
+void ZstdCompressPerfPrint(const char * tag, const zstd_compress_perf_t * delta);
+
 #endif //__ACCEL_H
@@ -0,0 +1,55 @@
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "benchdump.h"
+
+static int bench_dump_fd = -1;
+
+static int BenchDumpWriteAll(const void * src, uint64_t len) {
+    const unsigned char * p = (const unsigned char *)src;
+    while (len > 0) {
+        ssize_t wrote = write(bench_dump_fd, p, len);
+        if (wrote <= 0) {
+            return -1;
+        }
+        p += wrote;
+        len -= (uint64_t)wrote;
+    }
+    return 0;
+}
+
+int BenchDumpOpen(const char * path) {
+    BenchDumpClose();
+    bench_dump_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (bench_dump_fd < 0) {
+        return -1;
+    }
+    if (BenchDumpWriteAll(BENCH_DUMP_MAGIC, strlen(BENCH_DUMP_MAGIC)) != 0) {
+        BenchDumpClose();
+        return -1;
+    }
+    return 0;
+}
+
+int BenchDumpWrite(const char * name, const unsigned char * data, uint64_t data_len) {
+    if (bench_dump_fd < 0) {
+        return -1;
+    }
+    bench_dump_record_t record;
+    record.name_len = (uint32_t)strlen(name);
+    record.reserved = 0;
+    record.data_len = data_len;
+    if ((BenchDumpWriteAll(&record, sizeof(record)) != 0) ||
+        (BenchDumpWriteAll(name, record.name_len) != 0) ||
+        (BenchDumpWriteAll(data, data_len) != 0)) {
+        return -1;
+    }
+    return 0;
+}
+
+void BenchDumpClose(void) {
+    if (bench_dump_fd >= 0) {
+        close(bench_dump_fd);
+        bench_dump_fd = -1;
+    }
+}
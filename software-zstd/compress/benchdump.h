@@ -0,0 +1,46 @@
+#ifndef __BENCH_DUMP_H
+#define __BENCH_DUMP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Accelerator output dump
+//
+// Writes each call's output buffer to a binary file on the host with one
+// write() per call, proxied by HTIF (fesvr reads the buffer out of target
+// memory in bulk), so correctness can be checked on the host without
+// building the hardware with the L2MemHelper WRITE_BYTE printfs. Those print
+// one log line per byte written, which makes logs gigabytes in size and
+// slows simulation; see WithoutCompressAccelWriteByteLog. hostcheck in
+// software-hostbench reads the file.
+//
+// Layout, all fields little-endian:
+//
+//   magic "HCBDUMP1"
+//   records         one per BenchDumpWrite call, in call order:
+//                   bench_dump_record_t, then name_len bytes of name (not
+//                   NUL terminated), then data_len bytes of output
+
+#define BENCH_DUMP_MAGIC "HCBDUMP1"
+
+// relative to the simulator's working directory
+#ifndef BENCH_DUMP_PATH
+#define BENCH_DUMP_PATH "accel-output.dump"
+#endif
+
+typedef struct {
+  uint32_t name_len;
+  uint32_t reserved;
+  uint64_t data_len;
+} bench_dump_record_t;
+
+// Creates (or truncates) the dump file. Returns 0 on success, -1 on failure.
+int BenchDumpOpen(const char * path);
+
+// Appends one record. Returns 0 on success, -1 on failure or if no dump file
+// is open.
+int BenchDumpWrite(const char * name, const unsigned char * data, uint64_t data_len);
+
+void BenchDumpClose(void);
+
+#endif //__BENCH_DUMP_H
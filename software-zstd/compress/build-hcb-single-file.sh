@@ -4,6 +4,9 @@ set -ex
 
 BASEDIR=$(pwd)
 
+# sources shared with the Snappy harnesses
+COMMONDIR="$BASEDIR/../../software-common"
+
 
 ZSTD_DIR="$BASEDIR/../../software/zstd"
 RUNDIR="$ZSTD_DIR/programs"
@@ -12,7 +15,14 @@ ZSTD_COMPRESSOR="$RUNDIR/zstd"
 
 CYDIR=$BASEDIR/../../../../
 VCSDIR=$CYDIR/sims/vcs
-CONFIG=ZstdCompressorReducedAccuracyHyperscaleRocketConfig
+# The check below reads the output dump, so the WRITE_BYTE printfs only slow
+# the simulation down. Configs in chipyard drop them by starting with the
+# compressacc.WithoutCompressAccelWriteByteLog fragment, e.g.
+#   class ZstdCompressorReducedAccuracyNoByteLogHyperscaleRocketConfig extends Config(
+#     new compressacc.WithoutCompressAccelWriteByteLog ++
+#     new ZstdCompressorReducedAccuracyHyperscaleRocketConfig)
+# Pass such a config as CONFIG=...; the default keeps the byte log.
+CONFIG=${CONFIG:-ZstdCompressorReducedAccuracyHyperscaleRocketConfig}
 ZSTD_BINARY_PATH="$BASEDIR/../../software/zstd/programs/zstd"
 
 function compile_zstd() {
@@ -38,10 +48,14 @@ function buildbench() {
     cd $BASEDIR
     xxd -i -n benchmark_raw_data $INPUTDIR/$1 > benchmark_data.h
 
-    riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c test.c
+    # the output is written to $1.dump in the simulator's working directory,
+    # see benchdump.h
+    riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -DBENCH_DUMP -DBENCH_DUMP_NAME=\"$1\" -DBENCH_DUMP_PATH=\"$1.dump\" -I$COMMONDIR -c test.c
     riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c accellib.c
     riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c zstd_decompress.c
-    riscv64-unknown-elf-gcc -static -specs=htif_nano.specs test.o accellib.o zstd_decompress.o -o $OUTPUTDIR/$1.riscv
+    riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c benchdump.c
+    riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c $COMMONDIR/benchreport.c
+    riscv64-unknown-elf-gcc -static -specs=htif_nano.specs test.o accellib.o zstd_decompress.o benchdump.o benchreport.o -o $OUTPUTDIR/$1.riscv
     cp $OUTPUTDIR/$1.riscv .
 }
 
@@ -55,13 +69,11 @@ function runtest() {
   make -j20 CONFIG=$CONFIG run-binary-hex BINARY=$BASEDIR/$1.riscv
 
   cd $BASEDIR
-  # Python script that will grab all the accelerator written bytes and output a compressed_bytes.h file
-  python get-compressed.py --hwlog $SIMOUTPUTDIR/$1.out --algo zstd --out $BASEDIR/compressed_bytes.h
-
-  # Using the above compressed_bytes.h file from the above, decompress it to check for correctness
+  # Decompress the dumped output on the host to check for correctness
   # Faster than checking for correctness in the target machine
-  make all
-  ./check.x86
+  # (hardware that still prints WRITE_BYTE lines can check $SIMOUTPUTDIR/$1.out)
+  make -C $BASEDIR/../../software-hostbench hostcheck
+  $BASEDIR/../../software-hostbench/hostcheck --inputs $BASEDIR/example-files $VCSDIR/$1.dump
 }
 
 function set_baremetal_max_heap_size() {
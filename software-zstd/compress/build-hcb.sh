@@ -4,6 +4,9 @@ set -ex
 
 BASEDIR=$(pwd)
 
+# sources shared with the Snappy harnesses
+COMMONDIR="$BASEDIR/../../software-common"
+
 # The number of binaries you want to shard the benchmark files across.
 # Should correspond with the # of sims you want to run in parallel.
 #
@@ -23,6 +26,18 @@ BENCH_DATA_DIR="HyperCompressBench/extracted_benchmarks/ZSTD-COMPRESS"
 
 COMP_OR_DECOMP=complete
 
+# extra compile flags for the harness, e.g. BENCH_FLAGS=-DBENCH_ROUTER to route
+# calls between the core and the accelerator, or -DDO_VERIFY_ON_WRITE to add
+# a pass through ZstdAccelCompressVerified (see test-complete.c), or
+# -DBENCH_REPS=N to time each configuration N times (see benchreport.h)
+BENCH_FLAGS=${BENCH_FLAGS:-}
+
+# each shard writes its outputs to <shard>.dump in the simulation's working
+# directory (see benchdump.h), which the hyper-compress-bench-zstd-sweep-*
+# workloads copy back for hostcheck. BENCH_DUMP=0 leaves checking to the
+# WRITE_BYTE log.
+BENCH_DUMP=${BENCH_DUMP:-1}
+
 function buildbench() {
 
   INPUTDIR="$BASEDIR/../../software/benchmarks/$2/"
@@ -40,17 +55,33 @@ function buildbench() {
   cp $BASEDIR/*.c .
   cp $BASEDIR/*.h .
 
-  python3 splitter.py $INPUTDIR $OUTPUTDIR $NUMCHUNKS $3 $ZSTD_BINARY_PATH
+  python3 splitter.py $INPUTDIR $OUTPUTDIR $NUMCHUNKS $3 $ZSTD_BINARY_PATH $MANIFEST
 
   TEST_FILE_NAME="test-$COMP_OR_DECOMP.c"
   TEST_FILE_O="test-$COMP_OR_DECOMP.o"
 
-  riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c $TEST_FILE_NAME
+  DUMP_FLAGS=""
+  if [ "$BENCH_DUMP" != "0" ]
+  then
+    DUMP_FLAGS="-DBENCH_DUMP -DBENCH_DUMP_PATH=\"$3.dump\""
+  fi
+
+  riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -I$COMMONDIR $BENCH_FLAGS $DUMP_FLAGS -c $TEST_FILE_NAME
   riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c accellib.c
-  riscv64-unknown-elf-gcc -static -specs=htif_nano.specs $TEST_FILE_O accellib.o -o $FINAL_OUTPUT_DIR/$3.riscv
+  riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c benchdump.c
+  riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -I. -c $COMMONDIR/accelrouter.c
+  riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c zstdsplit.c
+  riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c zstd_decompress.c
+  riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c $COMMONDIR/benchreport.c
+  riscv64-unknown-elf-gcc -static -specs=htif_nano.specs $TEST_FILE_O accellib.o benchdump.o accelrouter.o zstdsplit.o zstd_decompress.o benchreport.o -o $FINAL_OUTPUT_DIR/$3.riscv
 }
 
 
+# balance shards by predicted simulation time, see shardplan.py
+MANIFEST="$BASEDIR/zstd-$COMP_OR_DECOMP-external-baremetal/shards.manifest"
+mkdir -p $(dirname $MANIFEST)
+python3 $COMMONDIR/shardplan.py "$BASEDIR/../../software/benchmarks/$BENCH_DATA_DIR/" $NUMCHUNKS zstd $COMP_OR_DECOMP $MANIFEST
+
 END_INDEX=$((NUMCHUNKS/PARALLELISM_MAX))
 
 for ((j=0; j < $END_INDEX; j++))
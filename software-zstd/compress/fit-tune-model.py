@@ -0,0 +1,177 @@
+# Fits the cost model ZstdCompressTuneForInput ranks settings by
+# (zstdtune_model.h) to a zstd-compress sweep: test-complete.c built with
+# DO_PRINT, whose per-benchmark lines give the cycles each call took at each
+# histsram / hash table size.
+#
+# required arguments:
+# abs path to benchmark input files (<name> or <name>.raw)
+# output header (zstdtune_model.h)
+# then any number of sweep logs (uartlog, *.out) or results directories,
+# searched for them
+#
+# optional, among the logs: latency=L has_cache=0|1 to fit that latency
+# injection config (default 1 and 0, no injected latency).
+#
+# Each benchmark is put in the input class the tuner would give it, with a
+# port of its sampling pass reading the same ZSTD_TUNE_* settings from
+# accellib.h. An entry is the median cycles per KB over the benchmarks of its
+# class at that setting; settings the sweep did not cover are left 0, which
+# the tuner never picks. Without logs every entry is 0 and the tuner keeps
+# the largest setting.
+
+
+
+import sys
+import os
+import re
+import statistics
+
+assert len(sys.argv) >= 3
+
+input_path = sys.argv[1]
+output_file = sys.argv[2]
+
+latency = 1
+has_cache = 0
+log_paths = []
+for arg in sys.argv[3:]:
+    if arg.startswith("latency="):
+        latency = int(arg.split("=")[1])
+    elif arg.startswith("has_cache="):
+        has_cache = int(arg.split("=")[1])
+    else:
+        log_paths.append(arg)
+
+
+# the ZSTD_TUNE_* settings, so the port below classes inputs as the target does
+tune = {}
+with open(os.path.join(os.path.dirname(os.path.abspath(__file__)), "accellib.h"), encoding='utf-8') as f:
+    for line in f:
+        m = re.match(r"#define (ZSTD_TUNE_\w+) (.*?)\s*(//.*)?$", line)
+        if m:
+            value = re.sub(r"(0x[0-9a-fA-F]+|\d+)U\b", r"\1", m.group(2))
+            value = re.sub(r"ZSTD_TUNE_\w+", lambda name: str(tune[name.group(0)]), value)
+            tune[m.group(1)] = eval(value)
+
+NUM_HT = tune["ZSTD_TUNE_NUM_HT_SIZES"]
+NUM_HIST = tune["ZSTD_TUNE_NUM_HIST_SIZES"]
+NUM_MATCH_CLASSES = tune["ZSTD_TUNE_NUM_MATCH_CLASSES"]
+NUM_CLASSES = tune["ZSTD_TUNE_NUM_CLASSES"]
+HASH_MULTIPLIER = 0x1e35a7bd
+
+
+def read32(data, pos):
+    return int.from_bytes(data[pos:pos + 4], "little")
+
+
+# ZstdTuneMatchPass: returns the bytes matched with the largest table, or
+# None when the input is too small to be sampled
+def max_matched(data):
+    sample = min(len(data) >> tune["ZSTD_TUNE_SAMPLE_SHIFT"], tune["ZSTD_TUNE_DEFAULT_SAMPLE_BYTES"],
+                 tune["ZSTD_TUNE_MAX_SAMPLE_BYTES"])
+    if sample < tune["ZSTD_TUNE_MIN_SAMPLE_BYTES"]:
+        return None, sample
+    log2 = tune["ZSTD_TUNE_MAX_HT_LOG2"]
+    table = [0] * (1 << log2)
+    matched = 0
+    pos = 0
+    while pos + 4 <= sample:
+        key = read32(data, pos)
+        bucket = ((key * HASH_MULTIPLIER) & 0xffffffff) >> (32 - log2)
+        cand = table[bucket]
+        table[bucket] = pos + 1
+        if cand and (pos - (cand - 1) <= tune["ZSTD_TUNE_MAX_HIST_SIZE"]) and (read32(data, cand - 1) == key):
+            match_len = 4
+            while (pos + match_len < sample) and (data[cand - 1 + match_len] == data[pos + match_len]):
+                match_len += 1
+            matched += match_len
+            pos += match_len
+        else:
+            pos += 1
+    return matched, sample
+
+
+# ZstdTuneInputClass
+def input_class(data):
+    matched, sample = max_matched(data)
+    if matched is None:
+        return None
+    size_class = 0
+    if len(data) > tune["ZSTD_TUNE_MEDIUM_INPUT_BYTES"]:
+        size_class = 2
+    elif len(data) > tune["ZSTD_TUNE_SMALL_INPUT_BYTES"]:
+        size_class = 1
+    match_class = min((matched * NUM_MATCH_CLASSES) // sample, NUM_MATCH_CLASSES - 1)
+    return size_class * NUM_MATCH_CLASSES + match_class
+
+
+def find_logs(path, logs):
+    if not os.path.isdir(path):
+        logs.append(path)
+        return
+    for name in sorted(os.listdir(path)):
+        child = os.path.join(path, name)
+        if os.path.isdir(child):
+            find_logs(child, logs)
+        elif (name == "uartlog") or name.endswith(".out"):
+            logs.append(child)
+
+
+logs = []
+for path in log_paths:
+    find_logs(path, logs)
+
+line_re = re.compile(r"Took (\d+) cycles produced \d+ compressed bytes uncompsize (\d+) for benchmark (\S+) "
+                     r"with histsram (\d+) with log2HTEntries: (\d+) with latencyInjection: (\d+) hasCache: (\d+)")
+
+# (benchmark, hist bin, table) -> cycles per KB
+measured = {}
+for log in logs:
+    with open(log, errors='replace') as f:
+        for line in f:
+            m = line_re.search(line)
+            if not m:
+                continue
+            cycles, size, name, hist, ht_log2, lat, cache = m.groups()
+            if (int(lat) != latency) or (int(cache) != has_cache) or (int(size) == 0):
+                continue
+            hist_bin = (int(hist) // tune["ZSTD_TUNE_MIN_HIST_SIZE"]).bit_length() - 1
+            ht = int(ht_log2) - tune["ZSTD_TUNE_MIN_HT_LOG2"]
+            if (0 <= hist_bin < NUM_HIST) and (0 <= ht < NUM_HT):
+                measured[(name, hist_bin, ht)] = int(cycles) * 1024 / int(size)
+
+classes = {}
+samples = [[[[] for ht in range(NUM_HT)] for hist_bin in range(NUM_HIST)] for c in range(NUM_CLASSES)]
+unsampled = 0
+for (name, hist_bin, ht), cycles_per_kb in measured.items():
+    if name not in classes:
+        input_file = os.path.join(input_path, name)
+        if not os.path.exists(input_file):
+            input_file += ".raw"
+        with open(input_file, 'rb') as f:
+            classes[name] = input_class(f.read())
+        unsampled += classes[name] is None
+    if classes[name] is not None:
+        samples[classes[name]][hist_bin][ht].append(cycles_per_kb)
+
+
+with open(output_file, 'w', encoding='utf-8') as f:
+    f.write("#ifndef __ZSTD_TUNE_MODEL_H\n#define __ZSTD_TUNE_MODEL_H\n\n")
+    f.write("// Generated by fit-tune-model.py, see the per-input tuning section of\n")
+    f.write("// accellib.h. Median cycles per KB of input, per input class, history size\n")
+    f.write("// (2KB up) and hash table size (2^ZSTD_TUNE_MIN_HT_LOG2 up); 0 where the\n")
+    f.write("// sweep has no measurement.\n")
+    f.write(f"// {len(classes) - unsampled} benchmarks, {len(logs)} logs, latency {latency} has_cache {has_cache}\n\n")
+    f.write("#include <stdint.h>\n#include \"accellib.h\"\n\n")
+    f.write("static const uint32_t zstd_tune_cycles_per_kb[ZSTD_TUNE_NUM_CLASSES][ZSTD_TUNE_NUM_HIST_SIZES][ZSTD_TUNE_NUM_HT_SIZES] = {\n")
+    for c in range(NUM_CLASSES):
+        f.write("    {\n")
+        for hist_bin in range(NUM_HIST):
+            entries = [round(statistics.median(s)) if s else 0 for s in samples[c][hist_bin]]
+            entries = [max(1, e) if samples[c][hist_bin][ht] else 0 for ht, e in enumerate(entries)]
+            f.write("        {" + ", ".join(str(e) for e in entries) + "},\n")
+        f.write("    },\n")
+    f.write("};\n\n#endif //__ZSTD_TUNE_MODEL_H\n")
+
+print(f"{output_file}: {len(measured)} measurements of {len(classes)} benchmarks "
+      f"({unsampled} too small to sample) from {len(logs)} logs")
@@ -7,6 +7,7 @@
 # number of chunks
 # this chunkno (zero indexed)
 # ZSTD binary path (for generated compressed version of input)
+# optional: shard manifest from shardplan.py, replacing the round-robin deal
 #
 # assume current working
 #
@@ -15,13 +16,14 @@
 
 import sys
 
-assert len(sys.argv) == 6
+assert len(sys.argv) in (6, 7)
 
 input_path = sys.argv[1]
 output_path = sys.argv[2]
 num_chunks = int(sys.argv[3])
 this_chunk = int(sys.argv[4])
 ZSTD_BINARY_PATH = sys.argv[5]
+manifest_file = sys.argv[6] if len(sys.argv) == 7 else None
 
 
 import os
@@ -49,6 +51,23 @@ chunks_list = [ [] for chunk in range(num_chunks) ]
 for index, filename_size_pair in enumerate(filenames_with_size):
     chunks_list[index % len(chunks_list)].append(filename_size_pair)
 
+
+# with a shard manifest from shardplan.py, the chunks are its shards
+if manifest_file is not None:
+    files_by_name = {}
+    for filename_size_pair in filenames_with_size:
+        files_by_name[filename_size_pair[0].replace(".raw", '')] = filename_size_pair
+
+    chunks_list = [ [] for chunk in range(num_chunks) ]
+    with open(manifest_file, 'r', encoding='utf-8') as f:
+        for line in f:
+            if line.startswith("# hcb-shard-manifest/1"):
+                assert f" shards={num_chunks} " in line, f"{manifest_file} is not a plan for {num_chunks} chunks"
+            if line.startswith("#") or not line.strip():
+                continue
+            shard, name = line.rstrip("\n").split(" ", 1)
+            chunks_list[int(shard)].append(files_by_name[name])
+
 import subprocess
 
 my_chunk = chunks_list[this_chunk]
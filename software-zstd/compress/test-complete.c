@@ -7,9 +7,51 @@
 
 #include "encoding.h"
 #include "benchmark_data_helper.h"
+#include "benchdump.h"
+#include "benchreport.h"
+#ifdef DO_VERIFY_ON_WRITE
+#include "zstd_decompress.h"
+#endif
 
 /* #define DO_PRINT */
 /* #define DO_CHECKING */
+/* #define DO_AUTOTUNE */
+/* #define DO_VERIFY_ON_WRITE */
+/* #define BENCH_DUMP */
+/* #define BENCH_ROUTER */
+
+// unreported passes before each latency config's sweep, at its first hist
+// SRAM size; reps and records are set in benchreport.h
+#ifndef BENCH_WARMUPS
+#define BENCH_WARMUPS 0
+#endif
+
+// BENCH_ROUTER sends every call through accelrouter.h instead of straight to
+// the accelerator: calls below the calibrated crossover compress on the core
+// (ZstdCpuCompress). Each latency injection config has its own crossover;
+// they are read from ROUTER_PROFILE_PATH, or measured on the largest
+// benchmark of the shard and written there.
+#ifdef BENCH_ROUTER
+#include "accelrouter.h"
+#include "zstdsplit.h"
+
+#define ROUTER_PROFILE_PATH "zstd-compress-router.profile"
+// bounds the startup calibration, the crossovers are far below this
+#define ROUTER_SAMPLE_MAX_BYTES (128 << 10)
+
+static int compress_route = -1;
+#endif
+
+// DO_VERIFY_ON_WRITE adds a pass per latency config that compresses the
+// shard through ZstdAccelCompressVerified: every output is decompressed on
+// the core while the accelerator compresses the next benchmark.
+#ifdef DO_VERIFY_ON_WRITE
+static uint64_t VerifyDecompress(const unsigned char * src, size_t src_len,
+                                 unsigned char * dst, size_t dst_capacity, void * ctx) {
+  (void)ctx;
+  return ZSTD_decompress(dst, dst_capacity, src, src_len);
+}
+#endif
 
 
 
@@ -17,6 +59,7 @@ bool run_benchmark(char * benchmark_compressed_data, size_t benchmark_compressed
     char * write_region, char * benchmark_uncompressed_data, size_t benchmark_uncompressed_data_len,
     char * bench_name, unsigned int benchno, uint64_t hist_size, char * write_region_decomp, uint64_t hash_table_entries_log2, latency_info_t latency_info,
     size_t * total_data_uncompressed_processed, size_t * total_data_compressed_processed, uint64_t * total_cycles_taken, size_t * num_bench_pass, uint64_t * benchmark_sum_overall,
+    uint64_t * call_cycles, uint64_t * compressed_size_out,
 
     unsigned char * lit_buf,
     size_t lit_buf_size,
@@ -58,6 +101,13 @@ bool run_benchmark(char * benchmark_compressed_data, size_t benchmark_compressed
 #endif
 
   uint64_t t1 = rdcycle();
+#ifdef BENCH_ROUTER
+  uint64_t compressed_size = AccelRouterRun(compress_route,
+      (const unsigned char *)benchmark_uncompressed_data,
+      benchmark_uncompressed_data_len,
+      (unsigned char *)write_region,
+      ZstdSplitCompressBound(benchmark_uncompressed_data_len));
+#else
   uint64_t compressed_size = ZstdAccelCompress(
       benchmark_uncompressed_data,
       benchmark_uncompressed_data_len,
@@ -68,10 +118,18 @@ bool run_benchmark(char * benchmark_compressed_data, size_t benchmark_compressed
       write_region,
       clevel
       );
+#endif
 
 
   uint64_t t2 = rdcycle();
 
+#ifdef BENCH_DUMP
+  // outside the timed region; checked on the host by hostcheck
+  if (BenchDumpWrite(bench_name, (unsigned char *)write_region, compressed_size) != 0) {
+    printf("FAILED TO DUMP OUTPUT OF BENCHMARK %s\n", bench_name);
+  }
+#endif
+
   //printf("Start cycle: %" PRIu64 "\n", t1);
   //printf("End cycle: %" PRIu64 "\n", t2);
 
@@ -156,6 +214,8 @@ bool run_benchmark(char * benchmark_compressed_data, size_t benchmark_compressed
   }
 #endif
 
+  *call_cycles = fail ? BENCH_REPORT_NO_SAMPLE : (t2 - t1);
+  *compressed_size_out = compressed_size;
   if (!fail) {
     *total_data_uncompressed_processed += benchmark_uncompressed_data_len;
     *total_data_compressed_processed += compressed_size;
@@ -170,8 +230,12 @@ bool run_benchmark(char * benchmark_compressed_data, size_t benchmark_compressed
 int main() {
 
   size_t total_benchmarks_uncompressed_size = 0;
+  size_t max_benchmark_uncompressed_size = 0;
   for (unsigned int i = 0; i < num_benchmarks; i++) {
     size_t this_bench_size = *(benchmark_uncompressed_data_len_array[i]);
+    if (this_bench_size > max_benchmark_uncompressed_size) {
+      max_benchmark_uncompressed_size = this_bench_size;
+    }
     this_bench_size = ((this_bench_size / 32) + 1) * 32;
     total_benchmarks_uncompressed_size += this_bench_size;
   }
@@ -192,18 +256,6 @@ int main() {
   };
 
 
-  bool is_warmup[] = {
-    false,
-    false,
-    false,
-    false,
-    false,
-    false
-  };
-
-
-
-
   unsigned int num_hash_table_sizes = 1;
   uint64_t hash_table_sizes_log2[] = {
     14
@@ -223,17 +275,63 @@ int main() {
   printf("Setting up...\n");
 #endif
 
-  unsigned char * result_area = ZstdCompressAccelSetup(total_benchmarks_uncompressed_size, hist_sizes[0]);
-  unsigned char * lit_buf = ZstdCompressWorkspaceSetup(total_benchmarks_uncompressed_size);
-  unsigned char * seq_buf = ZstdCompressWorkspaceSetup(total_benchmarks_uncompressed_size);
+#ifdef BENCH_DUMP
+  if (BenchDumpOpen(BENCH_DUMP_PATH) != 0) {
+    printf("FAILED TO OPEN DUMP FILE %s\n", BENCH_DUMP_PATH);
+  }
+#endif
+
+  unsigned char * result_area = ZstdCompressAccelSetup(total_benchmarks_uncompressed_size);
   unsigned char * result_area_decomp = ZstdCompressWorkspaceSetup(total_benchmarks_uncompressed_size);
 
+  const int clevel = 3;
 
+  // lit/seq chunks are recycled per block, so size them for the largest
+  // input rather than the whole shard
+  size_t lit_buf_size = ZstdCompressLitBuffBound(max_benchmark_uncompressed_size, clevel, ZSTD_COMPRESS_WKSP_DEFAULT_CHUNKS);
+  size_t seq_buf_size = ZstdCompressSeqBuffBound(max_benchmark_uncompressed_size, clevel, ZSTD_COMPRESS_WKSP_DEFAULT_CHUNKS);
+  unsigned char * lit_buf = ZstdCompressWorkspaceSetup(lit_buf_size);
+  unsigned char * seq_buf = ZstdCompressWorkspaceSetup(seq_buf_size);
 
-  const int clevel = 3;
+#ifdef BENCH_ROUTER
+  zstd_compress_codec_ctx_t accel_codec_ctx = { lit_buf, lit_buf_size, seq_buf, seq_buf_size, clevel };
+  unsigned char * cpu_workspace = ZstdCompressWorkspaceSetup(ZstdSplitWorkspaceBytes());
+
+  int latency_routes[ACCEL_ROUTER_MAX_ROUTES];
+  for (unsigned int m = 0; m < num_latency_injection_configs; m++) {
+    char route_name[ACCEL_ROUTER_NAME_LEN];
+    snprintf(route_name, sizeof(route_name), "zstd-compress-lat%" PRIu64 "%s",
+             latency_injection_configs[m].cycles, latency_injection_configs[m].has_cache ? "-cache" : "");
+    latency_routes[m] = AccelRouterAddRoute(route_name,
+                                            ZstdAccelCompressCodec, &accel_codec_ctx,
+                                            ZstdCpuCompressCodec, cpu_workspace,
+                                            NULL, NULL);
+  }
+  AccelRouterLoadProfile(ROUTER_PROFILE_PATH);
+
+  unsigned int sample_bench = 0;
+  for (unsigned int i = 1; i < num_benchmarks; i++) {
+    if (*(benchmark_uncompressed_data_len_array[i]) > *(benchmark_uncompressed_data_len_array[sample_bench])) {
+      sample_bench = i;
+    }
+  }
+  size_t sample_len = *(benchmark_uncompressed_data_len_array[sample_bench]);
+  if (sample_len > ROUTER_SAMPLE_MAX_BYTES) {
+    sample_len = ROUTER_SAMPLE_MAX_BYTES;
+  }
+  size_t router_scratch_size = 2 * ZstdSplitCompressBound(sample_len);
+  unsigned char * router_scratch = ZstdCompressWorkspaceSetup(router_scratch_size);
+#endif
+
+  bench_report_run_t run;
+  if (!BenchReportRunInit(&run, "zstd/test-complete", num_benchmarks, BENCH_REPS)) {
+    printf("FAIL: could not allocate cycle samples\n");
+    exit(1);
+  }
 
   bool fail = false;
   uint64_t benchmark_sum_overall = 0;
+  unsigned int pass = 0;
 
 
   for (unsigned int m = 0; m < num_latency_injection_configs; m++) {
@@ -242,6 +340,17 @@ int main() {
     printf("Using Latency Cycles: %" PRIu64 " Cache Enabled: %d\n", latency_injection_configs[m].cycles, latency_injection_configs[m].has_cache);
 #endif
 
+#ifdef BENCH_ROUTER
+    compress_route = latency_routes[m];
+    if (!AccelRouterGetRoute(compress_route)->calibrated) {
+      ZstdCompressSetDynamicHashTableSizeLog2(hash_table_sizes_log2[0]);
+      ZstdCompressSetDynamicHistSize(hist_sizes[0]);
+      AccelRouterCalibrate(compress_route, (const unsigned char *)benchmark_uncompressed_data_arrays[sample_bench], sample_len,
+                           router_scratch, router_scratch_size);
+      AccelRouterSaveProfile(ROUTER_PROFILE_PATH);
+    }
+#endif
+
   for (unsigned int k = 0; k < num_hash_table_sizes; k++) {
 
     ZstdCompressSetDynamicHashTableSizeLog2(hash_table_sizes_log2[k]);
@@ -249,51 +358,174 @@ int main() {
     printf("Using Hash Entries Log2: %" PRIu64 "\n", hash_table_sizes_log2[k]);
 #endif
 
-      for (unsigned int j = 0; j < num_hist_sizes; j++) {
-        ZstdCompressSetDynamicHistSize(hist_sizes[j]);
+      for (unsigned int j = 0; j < BENCH_WARMUPS + num_hist_sizes; j++) {
+        bool is_warmup = j < BENCH_WARMUPS;
+        uint64_t hist_size = is_warmup ? hist_sizes[0] : hist_sizes[j - BENCH_WARMUPS];
+        ZstdCompressSetDynamicHistSize(hist_size);
 
 #ifdef DO_PRINT
-        printf("Using HISTSRAM size: %" PRIu64 "\n", hist_sizes[j]);
+        printf("Using HISTSRAM size: %" PRIu64 "\n", hist_size);
 #endif
 
-        size_t total_data_uncompressed_processed = 0;
-        size_t total_data_compressed_processed = 0;
-        uint64_t total_cycles_taken = 0;
-        size_t num_bench_passed = 0;
-
-
-        // offset write region on each iter to make sure first iter's correct
-        // results don't count for later iters
-        unsigned char * result_area2 = result_area + (j * 32);
-        unsigned char * result_area_decomp2 = result_area_decomp + (j * 32);
-        for (unsigned int i = 0; i < num_benchmarks; i++) {
-          if(run_benchmark((benchmark_compressed_data_arrays[i]), *(benchmark_compressed_data_len_array[i]),
-                result_area2, (benchmark_uncompressed_data_arrays[i]), *(benchmark_uncompressed_data_len_array[i]),
-                *(benchmark_names[i]), i, hist_sizes[j], result_area_decomp2, hash_table_sizes_log2[k], latency_injection_configs[m],
-                &total_data_uncompressed_processed, &total_data_compressed_processed, &total_cycles_taken, &num_bench_passed, &benchmark_sum_overall,
-                lit_buf,
-                total_benchmarks_uncompressed_size,
-                seq_buf,
-                total_benchmarks_uncompressed_size,
-                clevel
-                )) {
-            fail = true;
+        BenchReportRunReset(&run);
+        unsigned int num_reps = is_warmup ? 1 : BENCH_REPS;
+        for (unsigned int rep = 0; rep < num_reps; rep++, pass++) {
+          size_t total_data_uncompressed_processed = 0;
+          size_t total_data_compressed_processed = 0;
+          uint64_t total_cycles_taken = 0;
+          size_t num_bench_passed = 0;
+
+
+          // offset write region on each pass to make sure earlier passes'
+          // correct results don't count for later ones (the page of slack
+          // above bounds the offset)
+          unsigned char * result_area2 = result_area + ((pass % 128) * 32);
+          unsigned char * result_area_decomp2 = result_area_decomp + ((pass % 128) * 32);
+          for (unsigned int i = 0; i < num_benchmarks; i++) {
+            uint64_t call_cycles;
+            uint64_t compressed_size;
+            if(run_benchmark((benchmark_compressed_data_arrays[i]), *(benchmark_compressed_data_len_array[i]),
+                  result_area2, (benchmark_uncompressed_data_arrays[i]), *(benchmark_uncompressed_data_len_array[i]),
+                  *(benchmark_names[i]), i, hist_size, result_area_decomp2, hash_table_sizes_log2[k], latency_injection_configs[m],
+                  &total_data_uncompressed_processed, &total_data_compressed_processed, &total_cycles_taken, &num_bench_passed, &benchmark_sum_overall,
+                  &call_cycles, &compressed_size,
+                  lit_buf,
+                  lit_buf_size,
+                  seq_buf,
+                  seq_buf_size,
+                  clevel
+                  )) {
+              fail = true;
+            }
+            BenchReportRunSample(&run, rep, i, *(benchmark_names[i]), *(benchmark_uncompressed_data_len_array[i]),
+                                 compressed_size, call_cycles);
+
+            size_t this_bench_size = *(benchmark_uncompressed_data_len_array[i]);
+            this_bench_size = ((this_bench_size / 32) + 1) * 32;
+
+            result_area2 += this_bench_size;
+            result_area_decomp2 += this_bench_size;
           }
 
-          size_t this_bench_size = *(benchmark_uncompressed_data_len_array[i]);
-          this_bench_size = ((this_bench_size / 32) + 1) * 32;
-
-          result_area2 += this_bench_size;
-          result_area_decomp2 += this_bench_size;
+          if (!is_warmup) {
+            printf("TOTAL: Took %" PRIu64 " cycles consumed %" PRIu64 " uncompressed bytes produced compsize %" PRIu64 " bytes SuccessNBenchmarks %d TotalNBenchmarks %d with histsram %" PRIu64 " with log2HTSize %" PRIu64 " latency %" PRIu64 " hasCache %d rep %u\n",
+                total_cycles_taken, total_data_uncompressed_processed, total_data_compressed_processed, num_bench_passed, num_benchmarks, hist_size, hash_table_sizes_log2[k], latency_injection_configs[m].cycles, latency_injection_configs[m].has_cache, rep);
+          }
         }
 
-        if (!is_warmup[j]) {
-          printf("TOTAL: Took %" PRIu64 " cycles consumed %" PRIu64 " uncompressed bytes produced compsize %" PRIu64 " bytes SuccessNBenchmarks %d TotalNBenchmarks %d with histsram %" PRIu64 " with log2HTSize %" PRIu64 " latency %" PRIu64 " hasCache %d\n",
-              total_cycles_taken, total_data_uncompressed_processed, total_data_compressed_processed, num_bench_passed, num_benchmarks, hist_sizes[j], hash_table_sizes_log2[k], latency_injection_configs[m].cycles, latency_injection_configs[m].has_cache);
+        if (!is_warmup) {
+          char config[96];
+          snprintf(config, sizeof(config), "hist=%" PRIu64 " ht=%" PRIu64 " latency=%" PRIu64 " cache=%d",
+                   hist_size, hash_table_sizes_log2[k], latency_injection_configs[m].cycles, latency_injection_configs[m].has_cache);
+          BenchReportRunPrint(&run, config, BENCH_RECORDS);
         }
       }
     }
   }
+  BenchReportRunFree(&run);
+
+#ifdef DO_AUTOTUNE
+  // one more pass where each input picks its own histsram/HT size; tuning
+  // time is included in the cycle count
+  for (unsigned int m = 0; m < num_latency_injection_configs; m++) {
+    ZstdCompressSetLatencyInjectionInfo((uint64_t) latency_injection_configs[m].cycles, (bool)latency_injection_configs[m].has_cache);
+
+    size_t total_data_uncompressed_processed = 0;
+    size_t total_data_compressed_processed = 0;
+    uint64_t total_cycles_taken = 0;
+
+    unsigned char * result_area2 = result_area;
+    for (unsigned int i = 0; i < num_benchmarks; i++) {
+      zstd_tune_result_t tune_result;
+      size_t this_bench_size = *(benchmark_uncompressed_data_len_array[i]);
+
+      uint64_t t1 = rdcycle();
+      uint64_t compressed_size = ZstdAccelCompressAutoTuned(
+          benchmark_uncompressed_data_arrays[i],
+          this_bench_size,
+          lit_buf,
+          lit_buf_size,
+          seq_buf,
+          seq_buf_size,
+          result_area2,
+          clevel,
+          &tune_result);
+      uint64_t t2 = rdcycle();
+
+#ifdef DO_PRINT
+      printf("AUTOTUNE: benchmark %s histsram %" PRIu64 " log2HTSize %" PRIu64 " est matched %" PRIu64 " of %" PRIu64 " class %" PRIu64 " est cycles/KB %" PRIu64 "\n",
+          *(benchmark_names[i]), tune_result.hist_size, tune_result.hash_table_size_log2, tune_result.est_matched_bytes, tune_result.est_max_matched_bytes,
+          tune_result.input_class, tune_result.est_cycles_per_kb);
+#endif
+
+      total_data_uncompressed_processed += this_bench_size;
+      total_data_compressed_processed += compressed_size;
+      total_cycles_taken += (t2 - t1);
+
+      this_bench_size = ((this_bench_size / 32) + 1) * 32;
+      result_area2 += this_bench_size;
+    }
+
+    printf("AUTOTUNE TOTAL: Took %" PRIu64 " cycles consumed %" PRIu64 " uncompressed bytes produced compsize %" PRIu64 " bytes TotalNBenchmarks %d latency %" PRIu64 " hasCache %d\n",
+        total_cycles_taken, total_data_uncompressed_processed, total_data_compressed_processed, num_benchmarks, latency_injection_configs[m].cycles, latency_injection_configs[m].has_cache);
+  }
+#endif
+
+#ifdef DO_VERIFY_ON_WRITE
+  size_t verify_dst_size = 0;
+  for (unsigned int i = 0; i < num_benchmarks; i++) {
+    verify_dst_size += ZstdCompressBound(*(benchmark_uncompressed_data_len_array[i]));
+  }
+  unsigned char * verify_dst = ZstdCompressWorkspaceSetup(verify_dst_size);
+  zstd_verify_job_t * verify_jobs = (zstd_verify_job_t *)malloc(num_benchmarks * sizeof(zstd_verify_job_t));
+
+  ZstdCompressSetDynamicHashTableSizeLog2(hash_table_sizes_log2[0]);
+  ZstdCompressSetDynamicHistSize(hist_sizes[0]);
+  for (unsigned int m = 0; m < num_latency_injection_configs; m++) {
+    ZstdCompressSetLatencyInjectionInfo((uint64_t) latency_injection_configs[m].cycles, (bool)latency_injection_configs[m].has_cache);
+
+    size_t total_data_uncompressed_processed = 0;
+    unsigned char * dst = verify_dst;
+    for (unsigned int i = 0; i < num_benchmarks; i++) {
+      verify_jobs[i].src = (const unsigned char *)benchmark_uncompressed_data_arrays[i];
+      verify_jobs[i].src_len = *(benchmark_uncompressed_data_len_array[i]);
+      verify_jobs[i].dst = dst;
+      dst += ZstdCompressBound(verify_jobs[i].src_len);
+      total_data_uncompressed_processed += verify_jobs[i].src_len;
+    }
+
+    uint64_t t1 = rdcycle();
+    size_t num_failed = ZstdAccelCompressVerified(verify_jobs, num_benchmarks,
+        lit_buf, lit_buf_size, seq_buf, seq_buf_size, clevel,
+        VerifyDecompress, NULL,
+        result_area_decomp, max_benchmark_uncompressed_size);
+    uint64_t t2 = rdcycle();
+
+    size_t total_data_compressed_processed = 0;
+    for (unsigned int i = 0; i < num_benchmarks; i++) {
+      total_data_compressed_processed += verify_jobs[i].compressed_size;
+      if (!verify_jobs[i].verified) {
+        printf("VERIFY FAILED ON BENCHMARK! N: %d, name: %s, latency %" PRIu64 " hasCache %d\n",
+            i, *(benchmark_names[i]), latency_injection_configs[m].cycles, latency_injection_configs[m].has_cache);
+      }
+    }
+    if (num_failed != 0) {
+      fail = true;
+    }
+
+    printf("VERIFIED TOTAL: Took %" PRIu64 " cycles consumed %" PRIu64 " uncompressed bytes produced compsize %" PRIu64 " bytes FailedNBenchmarks %" PRIu64 " TotalNBenchmarks %d latency %" PRIu64 " hasCache %d\n",
+        t2 - t1, total_data_uncompressed_processed, total_data_compressed_processed, (uint64_t)num_failed, num_benchmarks, latency_injection_configs[m].cycles, latency_injection_configs[m].has_cache);
+  }
+  free(verify_jobs);
+#endif
+
+#ifdef BENCH_DUMP
+  BenchDumpClose();
+#endif
+
+#ifdef BENCH_ROUTER
+  AccelRouterPrintStats();
+#endif
 
   printf("FINAL: Benchmark sum: %" PRIu64 "\n", benchmark_sum_overall);
 
@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "accellib.h"
+#include "zstdsplit.h"
+#include "encoding.h"
+#include "benchmark_data.h"
+#include "zstd_decompress.h"
+
+// Dictionary-primed small calls: needs a config with WithZstdMatchFinder.
+//
+// The first DICT_CONTENT_BYTES of the benchmark input become a dictionary,
+// the rest is compressed in CALL_BYTES calls, each its own frame, once
+// without and once with the dictionary.
+
+#define DO_CHECKING
+
+#define DICT_CONTENT_BYTES (16 << 10)
+#define DICT_ID 0x5a5a0001U
+#define CALL_BYTES 1024
+#define MAX_CALLS 64
+
+int main() {
+    if (benchmark_raw_data_len <= DICT_CONTENT_BYTES) {
+        printf("benchmark input too small for a %d byte dictionary\n", DICT_CONTENT_BYTES);
+        return 1;
+    }
+
+    unsigned char * workspace = ZstdCompressWorkspaceSetup(ZstdSplitWorkspaceBytes());
+    size_t dstCapacity = ZstdSplitCompressBound(CALL_BYTES);
+    unsigned char * result_area = ZstdCompressWorkspaceSetup(dstCapacity);
+
+    size_t dictCapacity = DICT_CONTENT_BYTES + 1024;
+    unsigned char * dict_buf = ZstdCompressWorkspaceSetup(dictCapacity);
+    size_t dict_size = ZstdSplitBuildDictionary(dict_buf, dictCapacity,
+                                                benchmark_raw_data, DICT_CONTENT_BYTES,
+                                                DICT_ID);
+    zstd_split_dict_t dict;
+    if ((dict_size == 0) || (ZstdSplitLoadDictionary(&dict, dict_buf, dict_size) != 0)) {
+        printf("TEST FAILED: could not build the dictionary\n");
+        return 1;
+    }
+    printf("dictionary: %" PRIu64 " bytes, id 0x%08x\n", (uint64_t)dict_size, dict.dict_id);
+
+#ifdef DO_CHECKING
+    dictionary_t * parsed_dict = create_dictionary();
+    parse_dictionary(parsed_dict, dict_buf, dict_size);
+    unsigned char * result_area_decomp = ZstdCompressWorkspaceSetup(CALL_BYTES + 4096);
+#endif
+
+    ZstdMatchFinderAccelSetup();
+    ZstdMatchFinderSetHashTableSizeLog2(14);
+    ZstdMatchFinderSetMaxOffset((64L << 10) - 64);
+
+    printf("Starting benchmark.\n");
+
+    uint64_t plain_bytes = 0, plain_cycles = 0;
+    uint64_t dict_bytes = 0, dict_cycles = 0;
+    uint64_t calls = 0;
+    for (size_t start = DICT_CONTENT_BYTES;
+         (start < benchmark_raw_data_len) && (calls < MAX_CALLS);
+         start += CALL_BYTES, calls++) {
+        size_t size = benchmark_raw_data_len - start;
+        if (size > CALL_BYTES) {
+            size = CALL_BYTES;
+        }
+
+        uint64_t t1 = rdcycle();
+        uint64_t plain_size = ZstdAccelSplitCompress(benchmark_raw_data + start, size,
+                                                     result_area, dstCapacity,
+                                                     workspace, NULL);
+        uint64_t t2 = rdcycle();
+        plain_bytes += plain_size;
+        plain_cycles += t2 - t1;
+
+        t1 = rdcycle();
+        uint64_t compressed_size = ZstdAccelSplitCompressUsingDict(benchmark_raw_data + start, size,
+                                                                   result_area, dstCapacity,
+                                                                   workspace, &dict, NULL);
+        t2 = rdcycle();
+        dict_bytes += compressed_size;
+        dict_cycles += t2 - t1;
+
+        if ((plain_size == 0) || (compressed_size == 0)) {
+            printf("TEST FAILED: call %" PRIu64 " did not fit\n", calls);
+            return 1;
+        }
+
+#ifdef DO_CHECKING
+        size_t decomp_size = ZSTD_decompress_with_dict(result_area_decomp,
+                                                       CALL_BYTES + 4096,
+                                                       result_area,
+                                                       compressed_size,
+                                                       parsed_dict);
+        if ((decomp_size != size) ||
+            (memcmp(result_area_decomp, benchmark_raw_data + start, size) != 0)) {
+            printf("TEST FAILED: call %" PRIu64 "\n", calls);
+            return 1;
+        }
+#endif
+    }
+
+    printf("%" PRIu64 " calls of %d bytes\n", calls, CALL_BYTES);
+    printf("no dictionary: compressed %" PRIu64 " bytes, took %" PRIu64 " cycles\n",
+        plain_bytes, plain_cycles);
+    printf("dictionary:    compressed %" PRIu64 " bytes, took %" PRIu64 " cycles\n",
+        dict_bytes, dict_cycles);
+
+#ifdef DO_CHECKING
+    free_dictionary(parsed_dict);
+    printf("TEST SUCCESS\n");
+#endif
+
+    return 0;
+}
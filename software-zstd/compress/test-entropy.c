@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "accellib.h"
+#include "zstdsplit.h"
+#include "encoding.h"
+#include "benchmark_data.h"
+#include "zstd_decompress.h"
+
+// Software LZ77 + hardware entropy coding.
+//
+// A greedy hash matcher on the core (ZstdSplitCpuMatchBlock) produces the
+// literals and sequences of each block, then only the entropy stage is
+// offloaded:
+//
+//  ENTROPY_HUF      HufCompressor builds the literals section, sequences are
+//                   stored as raw 12 byte commands (the format
+//                   accel_zstd_test_lz77_huf expects).
+//  ENTROPY_FSE_SEQ  FSESequenceCompressor builds the sequences section,
+//                   literals are stored raw. The output is a regular zstd
+//                   frame and is checked with ZSTD_decompress.
+//
+// Only one of the standalone blocks can be in a config, so pick the mode that
+// matches the simulated design.
+
+#define ENTROPY_HUF
+/* #define ENTROPY_FSE_SEQ */
+
+#define ZSTD_MAGIC 0xFD2FB528U
+#define ZSTD_BLOCK_TYPE_RAW 0
+#define ZSTD_BLOCK_TYPE_COMPRESSED 2
+
+// Below this many literals a Huffman table costs more than it saves, store
+// them raw like the software encoder does.
+#define HUF_MIN_LITERALS 64
+
+static void write32(unsigned char * p, uint32_t v) {
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = (v >> 24) & 0xff;
+}
+
+// Single segment frame header with a 4 byte content size.
+static size_t write_frame_header(unsigned char * dst, size_t content_size) {
+    write32(dst, ZSTD_MAGIC);
+    dst[4] = (2 << 6) | (1 << 5);
+    write32(dst + 5, (uint32_t)content_size);
+    return 9;
+}
+
+static void write_block_header(unsigned char * dst, bool last, int type, size_t size) {
+    uint32_t hdr = (uint32_t)last | ((uint32_t)type << 1) | ((uint32_t)size << 3);
+    dst[0] = hdr & 0xff;
+    dst[1] = (hdr >> 8) & 0xff;
+    dst[2] = (hdr >> 16) & 0xff;
+}
+
+static size_t write_raw_literals_header(unsigned char * dst, size_t nbLits) {
+    if (nbLits < 32) {
+        dst[0] = (unsigned char)(nbLits << 3);
+        return 1;
+    } else if (nbLits < 4096) {
+        uint32_t hdr = (1 << 2) | ((uint32_t)nbLits << 4);
+        dst[0] = hdr & 0xff;
+        dst[1] = (hdr >> 8) & 0xff;
+        return 2;
+    } else {
+        uint32_t hdr = (3 << 2) | ((uint32_t)nbLits << 4);
+        dst[0] = hdr & 0xff;
+        dst[1] = (hdr >> 8) & 0xff;
+        dst[2] = (hdr >> 16) & 0xff;
+        return 3;
+    }
+}
+
+int main() {
+    const size_t src_len = benchmark_raw_data_len;
+    const unsigned char * src = benchmark_raw_data;
+
+    size_t max_block_seqs = ZSTD_COMPRESS_BLOCKSIZE_MAX / ZSTD_COMPRESS_MIN_MATCH_LENGTH + 1;
+    unsigned char * lits = ZstdCompressWorkspaceSetup(ZSTD_COMPRESS_BLOCKSIZE_MAX);
+    accel_seq_command_t * seqs = (accel_seq_command_t *)ZstdCompressWorkspaceSetup(
+        max_block_seqs * sizeof(accel_seq_command_t));
+    unsigned char * entropy_out = ZstdCompressWorkspaceSetup(2 * ZSTD_COMPRESS_BLOCKSIZE_MAX + 4096);
+
+    size_t frame_capacity = 4 * src_len + 4096;
+    unsigned char * frame = ZstdCompressWorkspaceSetup(frame_capacity);
+    unsigned char * decomp = ZstdCompressWorkspaceSetup(src_len + 4096);
+
+    EntropyCompressAccelSetup();
+    ZstdSplitCpuMatchReset();
+
+    printf("Starting benchmark.\n");
+
+    uint64_t lz77_cycles = 0;
+    uint64_t entropy_cycles = 0;
+    uint64_t t_start = rdcycle();
+
+    size_t pos = write_frame_header(frame, src_len);
+    for (size_t block_start = 0; block_start < src_len; block_start += ZSTD_COMPRESS_BLOCKSIZE_MAX) {
+        size_t block_end = block_start + ZSTD_COMPRESS_BLOCKSIZE_MAX;
+        if (block_end > src_len) {
+            block_end = src_len;
+        }
+        bool last = (block_end == src_len);
+
+        size_t nbLits, nbSeq;
+        uint64_t t1 = rdcycle();
+        ZstdSplitCpuMatchBlock(src, block_start, block_end, lits, &nbLits, seqs, &nbSeq);
+        uint64_t t2 = rdcycle();
+        lz77_cycles += t2 - t1;
+
+        unsigned char * block_hdr = frame + pos;
+        unsigned char * body = block_hdr + 3;
+        size_t body_len = 0;
+
+#ifdef ENTROPY_HUF
+        if (nbLits >= HUF_MIN_LITERALS) {
+            t1 = rdcycle();
+            size_t lit_section = (size_t)HufAccelCompress(lits, nbLits, entropy_out);
+            t2 = rdcycle();
+            entropy_cycles += t2 - t1;
+
+            memcpy(body, entropy_out, lit_section);
+            body_len += lit_section;
+        } else {
+            body_len = write_raw_literals_header(body, nbLits);
+            memcpy(body + body_len, lits, nbLits);
+            body_len += nbLits;
+        }
+        for (size_t i = 0; i < nbSeq; i++) {
+            write32(body + body_len, seqs[i].lit_len);
+            write32(body + body_len + 4, seqs[i].match_len_base + 3);
+            write32(body + body_len + 8, seqs[i].offset_base);
+            body_len += ZSTD_COMPRESS_SEQUENCE_COMMAND_BYTES;
+        }
+        write_block_header(block_hdr, last, ZSTD_BLOCK_TYPE_COMPRESSED, body_len);
+#endif
+
+#ifdef ENTROPY_FSE_SEQ
+        size_t seq_section = 0;
+        if (nbSeq > 0) {
+            t1 = rdcycle();
+            seq_section = (size_t)FSESeqAccelCompress(seqs, nbSeq, entropy_out);
+            t2 = rdcycle();
+            entropy_cycles += t2 - t1;
+        } else {
+            entropy_out[0] = 0;
+            seq_section = 1;
+        }
+
+        body_len = write_raw_literals_header(body, nbLits);
+        memcpy(body + body_len, lits, nbLits);
+        body_len += nbLits;
+        memcpy(body + body_len, entropy_out, seq_section);
+        body_len += seq_section;
+
+        // a compressed block may not be larger than the data it holds
+        if (body_len >= block_end - block_start) {
+            body_len = block_end - block_start;
+            memcpy(body, src + block_start, body_len);
+            write_block_header(block_hdr, last, ZSTD_BLOCK_TYPE_RAW, body_len);
+        } else {
+            write_block_header(block_hdr, last, ZSTD_BLOCK_TYPE_COMPRESSED, body_len);
+        }
+#endif
+        pos += 3 + body_len;
+    }
+
+    uint64_t t_end = rdcycle();
+    printf("SW LZ77 cycles: %" PRIu64 ", HW entropy cycles: %" PRIu64 ", total cycles: %" PRIu64 "\n",
+           lz77_cycles, entropy_cycles, t_end - t_start);
+    printf("uncompressed %" PRIu64 " bytes, compressed %" PRIu64 " bytes\n",
+           (uint64_t)src_len, (uint64_t)pos);
+
+#ifdef ENTROPY_HUF
+    accel_zstd_test_lz77_huf(decomp, src_len + 4096, frame, pos);
+#endif
+#ifdef ENTROPY_FSE_SEQ
+    size_t decomp_len = ZSTD_decompress(decomp, src_len + 4096, frame, pos);
+    if (decomp_len != src_len) {
+        printf("TEST FAILED: decompressed %" PRIu64 " bytes, expected %" PRIu64 "\n",
+               (uint64_t)decomp_len, (uint64_t)src_len);
+        return 1;
+    }
+#endif
+
+    if (memcmp(decomp, src, src_len) != 0) {
+        printf("TEST FAILED\n");
+        return 1;
+    }
+    printf("TEST SUCCESS\n");
+    return 0;
+}
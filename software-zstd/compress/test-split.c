@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "accellib.h"
+#include "zstdsplit.h"
+#include "encoding.h"
+#include "benchmark_data.h"
+#include "zstd_decompress.h"
+
+// Split pipeline benchmark: needs a config with WithZstdMatchFinder.
+
+/* #define DO_CHECKING */
+
+int main() {
+    unsigned char * workspace = ZstdCompressWorkspaceSetup(ZstdSplitWorkspaceBytes());
+
+    size_t dstCapacity = ZstdSplitCompressBound(benchmark_raw_data_len);
+    unsigned char * result_area = ZstdCompressWorkspaceSetup(dstCapacity);
+
+    printf("src start addr: 0x%016" PRIx64 "\n", (uint64_t)benchmark_raw_data);
+    printf("Starting benchmark.\n");
+
+    ZstdMatchFinderAccelSetup();
+    ZstdMatchFinderSetHashTableSizeLog2(14);
+    ZstdMatchFinderSetMaxOffset((64L << 10) - 64);
+
+    zstd_split_stats_t stats;
+    memset(&stats, 0, sizeof(stats));
+
+    uint64_t t1 = rdcycle();
+    uint64_t compressed_size = ZstdAccelSplitCompress(benchmark_raw_data,
+                                                      benchmark_raw_data_len,
+                                                      result_area,
+                                                      dstCapacity,
+                                                      workspace,
+                                                      &stats);
+    uint64_t t2 = rdcycle();
+    printf("Start cycle: %" PRIu64 ", End cycle: %" PRIu64 ", Took: %" PRIu64 "\n",
+        t1, t2, t2 - t1);
+    printf("uncompressed %" PRIu64 " bytes, compressed %" PRIu64 " bytes\n",
+        (uint64_t)benchmark_raw_data_len, compressed_size);
+    printf("blocks %" PRIu64 " (raw %" PRIu64 "), host waited %" PRIu64 " cycles, entropy coded %" PRIu64 " cycles\n",
+        stats.blocks, stats.raw_blocks, stats.wait_cycles, stats.entropy_cycles);
+
+#ifdef DO_CHECKING
+    unsigned char * result_area_decomp = ZstdCompressWorkspaceSetup(benchmark_raw_data_len + 4096);
+    size_t decomp_size = ZSTD_decompress(result_area_decomp,
+                                         benchmark_raw_data_len + 4096,
+                                         result_area,
+                                         compressed_size);
+    if ((decomp_size != benchmark_raw_data_len) ||
+        (memcmp(result_area_decomp, benchmark_raw_data, benchmark_raw_data_len) != 0)) {
+        printf("TEST FAILED\n");
+        return 1;
+    }
+    printf("TEST SUCCESS\n");
+#endif
+
+    return 0;
+}
@@ -8,24 +8,35 @@
 #include "encoding.h"
 #include "benchmark_data.h"
 #include "zstd_decompress.h"
-
-#define ACCEL_RESULT_AREA_BYTES_LOG 14
-#define BUFF_AREA_BYTES_LOG 14
+#include "benchdump.h"
+#include "benchreport.h"
 
 
 
 /* #define FIRESIM */
+/* #define BENCH_DUMP */
+
+// name of the dumped output, hostcheck looks for an input by this name
+#ifndef BENCH_DUMP_NAME
+#define BENCH_DUMP_NAME "benchmark"
+#endif
+
+// unreported calls before the timed ones; reps and records are set in
+// benchreport.h
+#ifndef BENCH_WARMUPS
+#define BENCH_WARMUPS 0
+#endif
 
 int main() {
-    size_t litBuffSize = 1 << BUFF_AREA_BYTES_LOG;
-    size_t seqBuffSize = 1 << BUFF_AREA_BYTES_LOG;
+    const int clevel = 3;
+
+    size_t litBuffSize = ZstdCompressLitBuffBound(benchmark_raw_data_len, clevel, ZSTD_COMPRESS_WKSP_DEFAULT_CHUNKS);
+    size_t seqBuffSize = ZstdCompressSeqBuffBound(benchmark_raw_data_len, clevel, ZSTD_COMPRESS_WKSP_DEFAULT_CHUNKS);
     unsigned char* litBuff = ZstdCompressWorkspaceSetup(litBuffSize);
     unsigned char* seqBuff = ZstdCompressWorkspaceSetup(seqBuffSize);
 
-    size_t accelResultBuffSize = (1 << ACCEL_RESULT_AREA_BYTES_LOG) + 4096;
-    unsigned char* result_area = ZstdCompressAccelSetup(accelResultBuffSize); // FIXME : Jack this up later
-
-    const int clevel = 3;
+    size_t accelResultBuffSize = ZstdCompressBound(benchmark_raw_data_len) + 4096;
+    unsigned char* result_area = ZstdCompressAccelSetup(accelResultBuffSize);
 
     printf("src start addr: 0x%016" PRIx64 "\n", (uint64_t)benchmark_raw_data);
     printf("Starting benchmark.\n");
@@ -34,18 +45,42 @@ int main() {
     ZstdCompressSetDynamicHistSize(64L << 10);
     ZstdCompressSetLatencyInjectionInfo(0L, false);
 
-    uint64_t t1 = rdcycle();
-    uint64_t compressed_size = ZstdAccelCompress(benchmark_raw_data,
-                                                 benchmark_raw_data_len,
-                                                 litBuff,
-                                                 litBuffSize,
-                                                 seqBuff,
-                                                 seqBuffSize,
-                                                 result_area,
-                                                 clevel);
-    uint64_t t2 = rdcycle();
-    printf("Start cycle: %" PRIu64 ", End cycle: %" PRIu64 ", Took: %" PRIu64 "\n", 
-        t1, t2, t2 - t1);
+    bench_report_run_t run;
+    if (!BenchReportRunInit(&run, "zstd/test", 1, BENCH_REPS)) {
+        printf("FAIL: could not allocate cycle samples\n");
+        return 1;
+    }
+
+    uint64_t compressed_size = 0;
+    for (unsigned int rep = 0; rep < BENCH_WARMUPS + BENCH_REPS; rep++) {
+        uint64_t t1 = rdcycle();
+        compressed_size = ZstdAccelCompress(benchmark_raw_data,
+                                            benchmark_raw_data_len,
+                                            litBuff,
+                                            litBuffSize,
+                                            seqBuff,
+                                            seqBuffSize,
+                                            result_area,
+                                            clevel);
+        uint64_t t2 = rdcycle();
+        if (rep < BENCH_WARMUPS) {
+            continue;
+        }
+        printf("Start cycle: %" PRIu64 ", End cycle: %" PRIu64 ", Took: %" PRIu64 "\n",
+            t1, t2, t2 - t1);
+        BenchReportRunSample(&run, rep - BENCH_WARMUPS, 0, BENCH_DUMP_NAME, benchmark_raw_data_len,
+                             compressed_size, t2 - t1);
+    }
+    BenchReportRunPrint(&run, "hist=65536 ht=14 latency=0 cache=0", BENCH_RECORDS);
+    BenchReportRunFree(&run);
+
+#ifdef BENCH_DUMP
+  if ((BenchDumpOpen(BENCH_DUMP_PATH) != 0) ||
+      (BenchDumpWrite(BENCH_DUMP_NAME, result_area, compressed_size) != 0)) {
+    printf("FAILED TO DUMP OUTPUT TO %s\n", BENCH_DUMP_PATH);
+  }
+  BenchDumpClose();
+#endif
   
 #ifdef FIRESIM
   unsigned char * result_area_decomp  = ZstdCompressWorkspaceSetup(accelResultBuffSize);
@@ -17,7 +17,13 @@
 #include <string.h>   // memset, memcpy
 #include "zstd_decompress.h"
 
-/* #define printf(fmt, ...) (0) */
+// Debug output. Define ZDEC_NO_PRINT to compile it out when the decoder is
+// built into a harness (zstdcpu.c, the host bench).
+#if defined(ZDEC_NO_PRINT)
+#define ZDEC_PRINT(...) ((void)0)
+#else
+#define ZDEC_PRINT(...) printf(__VA_ARGS__)
+#endif
 
 
 /******* IMPORTANT CONSTANTS *********************************************/
@@ -59,6 +65,34 @@
 #define BAD_ALLOC() ERROR("Memory allocation error")
 #define IMPOSSIBLE() ERROR("An impossibility has occurred")
 
+/// Trace hooks, called with what the decoder finds in the stream. They do
+/// nothing unless the includer defines them; the host performance model in
+/// software-hostbench (zstdmodel.h) uses them to record each call.
+#ifndef ZSTD_TRACE_BLOCK
+#define ZSTD_TRACE_BLOCK(block_type, block_len)
+#endif
+#ifndef ZSTD_TRACE_LITERALS
+#define ZSTD_TRACE_LITERALS(block_type, regenerated_size, compressed_size, num_streams)
+#endif
+#ifndef ZSTD_TRACE_HUF_TABLE
+#define ZSTD_TRACE_HUF_TABLE(header_bytes, num_symbs, max_bits)
+#endif
+#ifndef ZSTD_TRACE_HUF_STREAM
+#define ZSTD_TRACE_HUF_STREAM(len)
+#endif
+#ifndef ZSTD_TRACE_HUF_SYMBOL
+#define ZSTD_TRACE_HUF_SYMBOL(num_bits)
+#endif
+#ifndef ZSTD_TRACE_SEQUENCES
+#define ZSTD_TRACE_SEQUENCES(num_sequences, section_len)
+#endif
+#ifndef ZSTD_TRACE_SEQ_TABLE
+#define ZSTD_TRACE_SEQ_TABLE(type, mode, accuracy_log)
+#endif
+#ifndef ZSTD_TRACE_SEQUENCE
+#define ZSTD_TRACE_SEQUENCE(literal_length, match_length, offset)
+#endif
+
 typedef uint8_t  u8;
 typedef uint16_t u16;
 typedef uint32_t u32;
@@ -588,8 +622,8 @@ static void parse_frame_header(frame_header_t *const header,
         header->window_size = header->frame_content_size;
     }
 
-    printf("FrameHeaderDescriptor %x\n", descriptor);
-    printf("single_segment_flag: %d, window_size: %lu, frame_content_size: %lu\n",
+    ZDEC_PRINT("FrameHeaderDescriptor %x\n", descriptor);
+    ZDEC_PRINT("single_segment_flag: %d, window_size: %lu, frame_content_size: %lu\n",
         single_segment_flag, header->window_size, header->frame_content_size);
 }
 
@@ -620,7 +654,8 @@ static size_t decompress_data(frame_context_t *const ctx, ostream_t *const out,
         size_t decompress_block_err = 0;
         compressed_frame_bytes += block_len;
 
-        printf("block_type: %d block_len: %d last_block: %d\n", block_type, block_len, last_block);
+        ZDEC_PRINT("block_type: %d block_len: %d last_block: %d\n", block_type, block_len, last_block);
+        ZSTD_TRACE_BLOCK(block_type, block_len);
 
         switch (block_type) {
         case 0: {
@@ -701,7 +736,7 @@ static size_t decompress_block(frame_context_t *const ctx, ostream_t *const out,
     }
 
 #ifdef RUN_ON_HOST
-    printf("literals_size: %d\n", literals_size);
+    ZDEC_PRINT("literals_size: %d\n", literals_size);
 #endif
 
     // Part 2: decode the sequences block
@@ -762,7 +797,7 @@ static size_t decode_literals(frame_context_t *const ctx, istream_t *const in,
     int size_format = (int)IO_read_bits(in, 2);
 
 #ifdef RUN_ON_HOST
-    printf("decode_literals block_type: %d, size_format: %d\n", block_type, size_format);
+    ZDEC_PRINT("decode_literals block_type: %d, size_format: %d\n", block_type, size_format);
 #endif
 
     if (block_type <= 1) {
@@ -814,6 +849,7 @@ static size_t decode_literals_simple(istream_t *const in, u8 **const literals,
         ERROR("decode_literals_simple malloc failed");
         return ERROR_CODE;
     }
+    ZSTD_TRACE_LITERALS(block_type, size, (block_type == 0) ? size : 1, 0);
 
     switch (block_type) {
     case 0: {
@@ -877,7 +913,7 @@ static size_t decode_literals_compressed(frame_context_t *const ctx,
     }
 
 #ifdef RUN_ON_HOST
-    printf("huf regenerated_size: %d, compressed_size: %d\n", regenerated_size, compressed_size);
+    ZDEC_PRINT("huf regenerated_size: %d, compressed_size: %d\n", regenerated_size, compressed_size);
 #endif
     if (regenerated_size > MAX_LITERALS_SIZE) {
         ERROR("decode_literals_compressed regenerated_size > MAX_LITERALS_SIZE");
@@ -889,6 +925,7 @@ static size_t decode_literals_compressed(frame_context_t *const ctx,
         ERROR("decode_literals_compressed malloc failed");
         return ERROR_CODE;
     }
+    ZSTD_TRACE_LITERALS(block_type, regenerated_size, compressed_size, num_streams);
 
     ostream_t lit_stream = IO_make_ostream(*literals, regenerated_size);
     istream_t huf_stream = IO_make_sub_istream(in, compressed_size);
@@ -940,8 +977,8 @@ static size_t decode_huf_table(HUF_dtable *const dtable, istream_t *const in) {
     int num_symbs;
 
 #ifdef RUN_ON_HOST
-    printf("huf_header_bytes: %d\n", header);
-    printf("in->len: %d\n", in->len);
+    ZDEC_PRINT("huf_header_bytes: %d\n", header);
+    ZDEC_PRINT("in->len: %d\n", in->len);
 #endif
 
     if (header >= 128) {
@@ -956,7 +993,7 @@ static size_t decode_huf_table(HUF_dtable *const dtable, istream_t *const in) {
         const u8 *const weight_src = IO_get_read_ptr(in, bytes);
 
 #ifdef RUN_ON_HOST
-        printf("weight bytes: %d\n", bytes);
+        ZDEC_PRINT("weight bytes: %d\n", bytes);
 #endif
 
         for (int i = 0; i < num_symbs; i++) {
@@ -971,7 +1008,7 @@ static size_t decode_huf_table(HUF_dtable *const dtable, istream_t *const in) {
                 weights[i] = weight_src[i / 2] & 0xf;
             }
 #ifdef RUN_ON_HOST
-            printf("weights[%d]: %d\n", i, weights[i]);
+            ZDEC_PRINT("weights[%d]: %d\n", i, weights[i]);
 #endif
         }
     } else {
@@ -986,7 +1023,10 @@ static size_t decode_huf_table(HUF_dtable *const dtable, istream_t *const in) {
     }
 
     // Construct the table using the decoded weights
-    return HUF_init_dtable_usingweights(dtable, weights, num_symbs);
+    size_t err = HUF_init_dtable_usingweights(dtable, weights, num_symbs);
+    ZSTD_TRACE_HUF_TABLE((header >= 128) ? (num_symbs + 1) / 2 : header, num_symbs,
+                         dtable->max_bits);
+    return err;
 }
 
 static size_t fse_decode_hufweights(ostream_t *weights, istream_t *const in,
@@ -1103,6 +1143,7 @@ static size_t decode_sequences(frame_context_t *const ctx, istream_t *in,
         // "There are no sequences. The sequence section stops there.
         // Regenerated content is defined entirely by literals section."
         *sequences = NULL;
+        ZSTD_TRACE_SEQUENCES(0, IO_istream_len(in));
         return 0;
     } else if (header < 128) {
         // "Number_of_Sequences = byte0 . Uses 1 byte."
@@ -1116,8 +1157,9 @@ static size_t decode_sequences(frame_context_t *const ctx, istream_t *in,
     }
 
 #ifdef RUN_ON_HOST
-    printf("num_sequences: %d\n", num_sequences);
+    ZDEC_PRINT("num_sequences: %d\n", num_sequences);
 #endif
+    ZSTD_TRACE_SEQUENCES(num_sequences, IO_istream_len(in));
 
     *sequences = (sequence_command_t*)malloc(num_sequences * sizeof(sequence_command_t));
     if (!*sequences) {
@@ -1256,7 +1298,7 @@ static sequence_command_t decode_sequence(sequence_states_t *const states,
         STREAM_read_bits(src, SEQ_LITERAL_LENGTH_EXTRA_BITS[ll_code], offset);
 
 #ifdef RUN_ON_HOST
-    printf("ll: %d, ml: %d, of: %d\n", seq.literal_length, seq.match_length, seq.offset);
+    ZDEC_PRINT("ll: %d, ml: %d, of: %d\n", seq.literal_length, seq.match_length, seq.offset);
 #endif
 
     // "If it is not the last sequence in the block, the next operation is to
@@ -1333,6 +1375,7 @@ static size_t decode_seq_table(FSE_dtable *const table, istream_t *const in,
 /* IMPOSSIBLE(); */
         break;
     }
+    ZSTD_TRACE_SEQ_TABLE(type, mode, table->accuracy_log);
     return 0;
 
 }
@@ -1365,6 +1408,7 @@ static size_t execute_sequences(frame_context_t *const ctx, ostream_t *const out
         size_t const offset = compute_offset(seq, offset_hist);
 
         size_t const match_length = seq.match_length;
+        ZSTD_TRACE_SEQUENCE(seq.literal_length, match_length, offset);
 
         size_t emc_err = execute_match_copy(ctx, offset, match_length, total_output, out);
         if (emc_err == ERROR_CODE) {
@@ -1377,6 +1421,7 @@ static size_t execute_sequences(frame_context_t *const ctx, ostream_t *const out
     // Copy any leftover literals
     {
         size_t len = IO_istream_len(&litstream);
+        ZSTD_TRACE_SEQUENCE(len, 0, 0);
         const u32 leftover_literals_size = copy_literals(len, &litstream, out);
         total_output += len;
 
@@ -1394,8 +1439,8 @@ static u32 copy_literals(const size_t literal_length, istream_t *litstream,
     // If the sequence asks for more literals than are left, the
     // sequence must be corrupted
     if (literal_length > IO_istream_len(litstream)) {
-        printf("[*] copy_literals literal_length > IO_istream_len(litstream)\n");
-        printf("literal_length: %lu, litstream_length: %lu\n",
+        ZDEC_PRINT("[*] copy_literals literal_length > IO_istream_len(litstream)\n");
+        ZDEC_PRINT("literal_length: %lu, litstream_length: %lu\n",
             literal_length, IO_istream_len(litstream));
         return ERROR_CODE;
 /* CORRUPTION(); */
@@ -1465,7 +1510,7 @@ static size_t execute_match_copy(frame_context_t *const ctx, size_t offset,
     if (total_output <= ctx->header.window_size) {
         // In this case offset might go back into the dictionary
         if (offset > total_output + ctx->dict_content_len) {
-            printf("[*] execute_match_copy, offset(%d) > total_output(%d) + ctx->dict_content_len(%d)\n",
+            ZDEC_PRINT("[*] execute_match_copy, offset(%d) > total_output(%d) + ctx->dict_content_len(%d)\n",
                     offset, total_output, ctx->dict_content_len);
             // The offset goes beyond even the dictionary
 /* CORRUPTION(); */
@@ -1486,7 +1531,7 @@ static size_t execute_match_copy(frame_context_t *const ctx, size_t offset,
             match_length -= dict_copy;
         }
     } else if (offset > ctx->header.window_size) {
-        printf("[*] execute_match_copy, offset(%d) > ctx->header.window_size(%d)\n",
+        ZDEC_PRINT("[*] execute_match_copy, offset(%d) > ctx->header.window_size(%d)\n",
                 offset, ctx->header.window_size);
         return ERROR_CODE;
 /* CORRUPTION(); */
@@ -1560,10 +1605,10 @@ void standalone_execute_sequences(void *const dst,
     u64 *const offset_hist = ctx->previous_offsets;
     size_t total_output = ctx->current_total_output;
 
-    printf("total sequences: %lu\n", num_sequences);
+    ZDEC_PRINT("total sequences: %lu\n", num_sequences);
     for (size_t i = 0; i < num_sequences; i++) {
         if (i % 100 == 0) {
-          printf("current sequence : %lu\n", i);
+          ZDEC_PRINT("current sequence : %lu\n", i);
         }
 
         const sequence_command_t seq = sequences[i];
@@ -1612,7 +1657,7 @@ size_t zstd_test_execute_sequences(void *const dst, const size_t dst_len,
   if (magic_number == ZSTD_MAGIC_NUMBER) {
     zstd_test_decode_frame(&out, &in);
   } else {
-    printf("ZSTD magic number does not match!!\n");
+    ZDEC_PRINT("ZSTD magic number does not match!!\n");
     exit(2);
   }
 }
@@ -1660,10 +1705,10 @@ static void zstd_test_decompress_data(frame_context_t *const ctx, ostream_t *con
 
     size_t total_output = ctx->current_total_output;
 
-    printf("total sequences: %lu, lit_len: %d seq_len: %d, last_block: %d\n", 
+    ZDEC_PRINT("total sequences: %lu, lit_len: %d seq_len: %d, last_block: %d\n", 
         seq_cnt, lit_len, seq_len, last_block);
     for (size_t i = 0; i < seq_cnt; i++) {
-      if (i % 100 == 0) printf("current sequence : %lu\n", i);
+      if (i % 100 == 0) ZDEC_PRINT("current sequence : %lu\n", i);
 /* printf("current sequence : %lu\n", i); */
 
 /* const sequence_command_t seq = sequences[i]; */
@@ -1675,8 +1720,8 @@ static void zstd_test_decompress_data(frame_context_t *const ctx, ostream_t *con
       {
         const u32 literals_size = copy_literals(seq.literal_length, &litstream, out);
         if (literals_size == INF32) {
-          printf("[*] copy_literals corrupted!!\n");
-          printf("seq number: %lu, ll: %u, ml: %u, of: %u\n", i, raw_literal_length, raw_match_length, raw_offset_length);
+          ZDEC_PRINT("[*] copy_literals corrupted!!\n");
+          ZDEC_PRINT("seq number: %lu, ll: %u, ml: %u, of: %u\n", i, raw_literal_length, raw_match_length, raw_offset_length);
         }
         total_output += literals_size;
       }
@@ -1713,7 +1758,7 @@ static size_t decode_sequences_raw(
   const size_t seq_command_bytes = 12;
   const size_t seq_cnt = seq_len / seq_command_bytes;
 
-  printf("seq_len: %d, seq_cnt: %d\n", seq_len, seq_cnt);
+  ZDEC_PRINT("seq_len: %d, seq_cnt: %d\n", seq_len, seq_cnt);
 
   *sequences = (sequence_command_t*)malloc(seq_cnt * sizeof(sequence_command_t));
   if (!*sequences) {
@@ -1735,11 +1780,11 @@ static void accel_zstd_test_lz77_huf_decompress_block(
   u8 *literals = NULL;
   size_t before_len = in->len;
   const size_t literals_size = decode_literals(ctx, in, &literals);
-  printf("literals_size: %d, consumed_input_stream: %d\n", literals_size, before_len - in->len);
+  ZDEC_PRINT("literals_size: %d, consumed_input_stream: %d\n", literals_size, before_len - in->len);
 
   sequence_command_t *sequences = NULL;
   const size_t num_sequences = decode_sequences_raw(ctx, in, &sequences);
-  printf("num_sequences: %d\n", num_sequences);
+  ZDEC_PRINT("num_sequences: %d\n", num_sequences);
 
   execute_sequences(ctx, out, literals, literals_size, sequences, num_sequences);
 
@@ -1759,10 +1804,10 @@ static void accel_zstd_test_lz77_huf_data(
     const int block_type = (int)IO_read_bits(in, 2);
     const size_t block_len = IO_read_bits(in, 21);
 
-    printf("block_type: %d, block_len: %d, last_block: %d\n", block_type, block_len, last_block);
+    ZDEC_PRINT("block_type: %d, block_len: %d, last_block: %d\n", block_type, block_len, last_block);
 
     if (block_type != 2) {
-      printf("wrong block type : %d\n", block_type);
+      ZDEC_PRINT("wrong block type : %d\n", block_type);
       exit(1);
     }
 
@@ -1797,7 +1842,7 @@ size_t accel_zstd_test_lz77_huf(void *const dst, const size_t dst_len,
   if (magic_number == ZSTD_MAGIC_NUMBER) {
     accel_zstd_test_lz77_huf_decode_frame(&out, &in);
   } else {
-    printf("ZSTD magic number does not match!!\n");
+    ZDEC_PRINT("ZSTD magic number does not match!!\n");
     exit(2);
   }
 }
@@ -2244,7 +2289,8 @@ static size_t HUF_decompress_1stream(const HUF_dtable *const dtable,
 /* INP_SIZE(); */
     }
 
-    printf("HUF_deocmpress_1stream len: %d\n", len);
+    ZDEC_PRINT("HUF_deocmpress_1stream len: %d\n", len);
+    ZSTD_TRACE_HUF_STREAM(len);
 
     const u8 *const src = IO_get_read_ptr(in, len);
 
@@ -2258,7 +2304,7 @@ static size_t HUF_decompress_1stream(const HUF_dtable *const dtable,
     // final-bit-flag itself is not part of the useful bitstream. Hence, the
     // last byte contains between 0 and 7 useful bits."
     const int padding = 8 - highest_set_bit(src[len - 1]);
-    printf("huf padding: %d\n", padding);
+    ZDEC_PRINT("huf padding: %d\n", padding);
 
     // Offset starts at the end because HUF streams are read backwards
     i64 bit_offset = len * 8 - padding;
@@ -2269,6 +2315,7 @@ static size_t HUF_decompress_1stream(const HUF_dtable *const dtable,
     size_t symbols_written = 0;
     while (bit_offset > -dtable->max_bits) {
         // Iterate over the stream, decoding one symbol at a time
+        ZSTD_TRACE_HUF_SYMBOL(dtable->num_bits[state]);
         IO_write_byte(out, HUF_decode_symbol(dtable, &state, src, &bit_offset));
         symbols_written++;
     }
@@ -2283,11 +2330,11 @@ static size_t HUF_decompress_1stream(const HUF_dtable *const dtable,
     // Therefore `offset`, the edge to start reading new bits at, should be
     // dtable->max_bits before the start of the stream
     if (bit_offset != -dtable->max_bits) {
-        printf("bit_offset(%d) != -dtable->max_bits(%d)\n", bit_offset, dtable->max_bits);
+        ZDEC_PRINT("bit_offset(%d) != -dtable->max_bits(%d)\n", bit_offset, dtable->max_bits);
 /* CORRUPTION(); */
     }
 
-    printf("symbols_written: %d\n", symbols_written);
+    ZDEC_PRINT("symbols_written: %d\n", symbols_written);
 
     return symbols_written;
 }
@@ -2418,7 +2465,7 @@ static size_t HUF_init_dtable_usingweights(HUF_dtable *const table,
     const u64 left_over = ((u64)1 << max_bits) - weight_sum;
 
 #ifdef RUN_ON_HOST
-    printf("weight_sum: %d, max_bits: %d, left_over: %lu\n", weight_sum, max_bits, left_over);
+    ZDEC_PRINT("weight_sum: %d, max_bits: %d, left_over: %lu\n", weight_sum, max_bits, left_over);
 #endif
 
     // If the left over isn't a power of 2, the weights are invalid
@@ -2434,7 +2481,7 @@ static size_t HUF_init_dtable_usingweights(HUF_dtable *const table,
         // "Number_of_Bits = Number_of_Bits ? Max_Number_of_Bits + 1 - Weight : 0"
         bits[i] = weights[i] > 0 ? (max_bits + 1 - weights[i]) : 0;
 #ifdef RUN_ON_HOST
-        printf("bits[%d]: %d\n", i, bits[i]);
+        ZDEC_PRINT("bits[%d]: %d\n", i, bits[i]);
 #endif
     }
     bits[num_symbs] =
@@ -2507,7 +2554,7 @@ static size_t FSE_decompress_interleaved2(const FSE_dtable *const dtable,
     // last byte contains between 0 and 7 useful bits."
     const int padding = 8 - highest_set_bit(src[len - 1]);
     i64 offset = len * 8 - padding;
-    printf("fse padding: %d\n", padding);
+    ZDEC_PRINT("fse padding: %d\n", padding);
 
     // "The first state (State1) encodes the even indexed symbols, and the
     // second (State2) encodes the odd indexes. State1 is initialized first, and
@@ -2518,7 +2565,7 @@ static size_t FSE_decompress_interleaved2(const FSE_dtable *const dtable,
     FSE_init_state(dtable, &state2, src, &offset);
 
 #ifdef RUN_ON_HOST
-    printf("[*] fse interleave decoding\n");
+    ZDEC_PRINT("[*] fse interleave decoding\n");
 #endif
     // Decode until we overflow the stream
     // Since we decode in reverse order, overflowing the stream is offset going
@@ -2535,7 +2582,7 @@ static size_t FSE_decompress_interleaved2(const FSE_dtable *const dtable,
         IO_write_byte(out, byte1);
 
 #ifdef RUN_ON_HOST
-        printf("%d: %d\n", symbols_written, byte1);
+        ZDEC_PRINT("%d: %d\n", symbols_written, byte1);
 #endif
         symbols_written++;
 
@@ -2545,7 +2592,7 @@ static size_t FSE_decompress_interleaved2(const FSE_dtable *const dtable,
             IO_write_byte(out, byte2_end);
 
 #ifdef RUN_ON_HOST
-            printf("%d: %d\n", symbols_written, byte2_end);
+            ZDEC_PRINT("%d: %d\n", symbols_written, byte2_end);
 #endif
 
             symbols_written++;
@@ -2555,7 +2602,7 @@ static size_t FSE_decompress_interleaved2(const FSE_dtable *const dtable,
         u8 byte2 = FSE_decode_symbol(dtable, &state2, src, &offset);
         IO_write_byte(out, byte2);
 #ifdef RUN_ON_HOST
-        printf("%d: %d\n", symbols_written, byte2);
+        ZDEC_PRINT("%d: %d\n", symbols_written, byte2);
 #endif
         symbols_written++;
 
@@ -2564,7 +2611,7 @@ static size_t FSE_decompress_interleaved2(const FSE_dtable *const dtable,
             u8 byte1_end = FSE_peek_symbol(dtable, state1);
             IO_write_byte(out, byte1_end);
 #ifdef RUN_ON_HOST
-            printf("%d: %d\n", symbols_written, byte1_end);
+            ZDEC_PRINT("%d: %d\n", symbols_written, byte1_end);
 #endif
             symbols_written++;
             break;
@@ -2587,10 +2634,10 @@ static size_t FSE_init_dtable(FSE_dtable *const dtable,
     }
 
 #ifdef RUN_ON_HOST
-    printf("[*] FSE_init_dtable\n");
-    printf("num_symbs: %d, accuracy_log: %d\n", num_symbs, accuracy_log);
+    ZDEC_PRINT("[*] FSE_init_dtable\n");
+    ZDEC_PRINT("num_symbs: %d, accuracy_log: %d\n", num_symbs, accuracy_log);
     for (int i = 0; i < num_symbs; i++) {
-      printf("norm_freqs: %d\n", norm_freqs[i]);
+      ZDEC_PRINT("norm_freqs: %d\n", norm_freqs[i]);
     }
 #endif
 
@@ -2670,9 +2717,9 @@ static size_t FSE_init_dtable(FSE_dtable *const dtable,
     }
 
 #ifdef RUN_ON_HOST
-    printf("[*] FSE decoding table\n");
+    ZDEC_PRINT("[*] FSE decoding table\n");
     for (int i = 0; i < size; i++) {
-      printf("%d : symbol: %d, numbits: %d, new_state_base: %d\n", i, dtable->symbols[i], dtable->num_bits[i], dtable->new_state_base[i]);
+      ZDEC_PRINT("%d : symbol: %d, numbits: %d, new_state_base: %d\n", i, dtable->symbols[i], dtable->num_bits[i], dtable->new_state_base[i]);
     }
 #endif
 
@@ -2753,7 +2800,7 @@ static size_t FSE_decode_header(FSE_dtable *const dtable, istream_t *const in,
         frequencies[symb] = proba;
         symb++;
 #ifdef RUN_ON_HOST
-        printf("frequencies[%d]: %d\n", symb, proba);
+        ZDEC_PRINT("frequencies[%d]: %d\n", symb, proba);
 #endif
 
         // "When a symbol has a probability of zero, it is followed by a 2-bits
@@ -2762,7 +2809,7 @@ static size_t FSE_decode_header(FSE_dtable *const dtable, istream_t *const in,
         // it is a 3, another 2-bits repeat flag follows, and so on."
         if (proba == 0) {
 #ifdef RUN_ON_HOST
-          printf("[*] found proba == 0 while fse decoding\n");
+          ZDEC_PRINT("[*] found proba == 0 while fse decoding\n");
 #endif
             // Read the next two bits to see how many more 0s
             int repeat = IO_read_bits(in, 2);
@@ -0,0 +1,1501 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include "zstdsplit.h"
+#include "encoding.h"
+
+#define ZSTD_MAGIC_NUMBER 0xFD2FB528U
+
+#define ZSTD_BLOCK_HEADER_BYTES 3
+#define ZSTD_BLOCK_TYPE_RAW 0
+#define ZSTD_BLOCK_TYPE_COMPRESSED 2
+
+#define ZSTD_LITERALS_RAW 0
+#define ZSTD_LITERALS_RLE 1
+#define ZSTD_LITERALS_COMPRESSED 2
+
+#define ZSTD_SEQ_MODE_PREDEFINED 0
+#define ZSTD_SEQ_MODE_RLE 1
+#define ZSTD_SEQ_MODE_FSE 2
+
+#define FSE_MIN_TABLELOG 5
+#define FSE_MAX_TABLELOG 12
+#define FSE_MAX_SYMBOLS 64
+#define HUF_WEIGHTS_MAX_TABLELOG 6
+
+#define LL_MAX_CODE 35
+#define ML_MAX_CODE 52
+#define OF_MAX_CODE 31
+#define OF_PREDEFINED_MAX_CODE 28
+
+// Predefined distributions and code tables from the zstd format spec
+static const int16_t ll_default_norm[LL_MAX_CODE + 1] = {
+    4, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1,  1,  2,  2,
+    2, 2, 2, 2, 2, 2, 2, 3, 2, 1, 1, 1, 1, 1, -1, -1, -1, -1};
+static const int16_t of_default_norm[OF_PREDEFINED_MAX_CODE + 1] = {
+    1, 1, 1, 1, 1, 1, 2, 2, 2, 1,  1,  1,  1,  1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1};
+static const int16_t ml_default_norm[ML_MAX_CODE + 1] = {
+    1, 4, 3, 2, 2, 2, 2, 2, 2, 1, 1,  1,  1,  1,  1,  1,  1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,  1,  1,  1,  1,  1,  1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1, -1, -1};
+#define LL_DEFAULT_NORM_LOG 6
+#define OF_DEFAULT_NORM_LOG 5
+#define ML_DEFAULT_NORM_LOG 6
+
+static const uint32_t ll_base[LL_MAX_CODE + 1] = {
+    0,  1,  2,   3,   4,   5,    6,    7,    8,    9,     10,    11,
+    12, 13, 14,  15,  16,  18,   20,   22,   24,   28,    32,    40,
+    48, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384, 32768, 65536};
+static const uint8_t ll_bits[LL_MAX_CODE + 1] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  0,  0,  0,  0,  1,  1,
+    1, 1, 2, 2, 3, 3, 4, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+static const uint32_t ml_base[ML_MAX_CODE + 1] = {
+    3,  4,  5,  6,  7,  8,  9,  10,  11,  12,   13,   14,   15,   16,
+    17, 18, 19, 20, 21, 22, 23, 24,  25,  26,   27,   28,   29,   30,
+    31, 32, 33, 34, 35, 37, 39, 41,  43,  47,   51,   59,   67,   83,
+    99, 131, 259, 515, 1027, 2051, 4099, 8195, 16387, 32771, 65539};
+static const uint8_t ml_bits[ML_MAX_CODE + 1] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1,
+    2, 2, 3, 3, 4, 4, 5, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+
+static unsigned HighBit(uint64_t v) {
+    unsigned r = 0;
+    while (v >>= 1) {
+        r++;
+    }
+    return r;
+}
+
+
+// Bitstream writer. Bits go in LSB first and the decoder reads the stream
+// back to front, so whatever is written last is decoded first.
+
+typedef struct {
+    uint64_t container;
+    unsigned bits;
+    unsigned char * start;
+    unsigned char * ptr;
+    unsigned char * end;
+    bool overflow;
+} split_bitwriter_t;
+
+static void BitInit(split_bitwriter_t * bw, unsigned char * dst, size_t dstCapacity) {
+    bw->container = 0;
+    bw->bits = 0;
+    bw->start = dst;
+    bw->ptr = dst;
+    bw->end = dst + dstCapacity;
+    bw->overflow = false;
+}
+
+static void BitAdd(split_bitwriter_t * bw, uint64_t value, unsigned nbBits) {
+    assert(nbBits <= 32);
+    bw->container |= (value & ((1ULL << nbBits) - 1)) << bw->bits;
+    bw->bits += nbBits;
+    while (bw->bits >= 8) {
+        if (bw->ptr < bw->end) {
+            *bw->ptr++ = (unsigned char)bw->container;
+        } else {
+            bw->overflow = true;
+        }
+        bw->container >>= 8;
+        bw->bits -= 8;
+    }
+}
+
+// Terminates the stream with the 1 bit end mark. Returns its size, 0 on overflow.
+static size_t BitClose(split_bitwriter_t * bw) {
+    BitAdd(bw, 1, 1);
+    if (bw->bits > 0) {
+        if (bw->ptr < bw->end) {
+            *bw->ptr++ = (unsigned char)bw->container;
+        } else {
+            bw->overflow = true;
+        }
+    }
+    return bw->overflow ? 0 : (size_t)(bw->ptr - bw->start);
+}
+
+
+// FSE
+
+typedef struct {
+    unsigned table_log;
+    uint16_t state_table[1 << FSE_MAX_TABLELOG];
+    int32_t delta_find_state[FSE_MAX_SYMBOLS];
+    uint32_t delta_nb_bits[FSE_MAX_SYMBOLS];
+} split_fse_ctable_t;
+
+typedef struct {
+    int64_t value;
+    const split_fse_ctable_t * ct;
+} split_fse_state_t;
+
+static unsigned FseOptimalTableLog(unsigned max_table_log, size_t srcSize, unsigned max_symbol) {
+    int table_log = (int)max_table_log;
+    int max_bits_src = (int)HighBit(srcSize - 1) - 2;
+    int min_bits_src = (int)HighBit(srcSize) + 1;
+    int min_bits_symbols = (int)HighBit(max_symbol) + 2;
+    int min_bits = (min_bits_src < min_bits_symbols) ? min_bits_src : min_bits_symbols;
+
+    if (max_bits_src < table_log) {
+        table_log = max_bits_src;
+    }
+    if (min_bits > table_log) {
+        table_log = min_bits;
+    }
+    if (table_log < FSE_MIN_TABLELOG) {
+        table_log = FSE_MIN_TABLELOG;
+    }
+    if (table_log > FSE_MAX_TABLELOG) {
+        table_log = FSE_MAX_TABLELOG;
+    }
+    return (unsigned)table_log;
+}
+
+// Scales count to sum to 1 << table_log. Symbols too rare for a full slot get
+// -1 ("less than 1"), which still takes one slot.
+static void FseNormalize(int16_t * norm, unsigned table_log, const uint32_t * count,
+                         size_t total, unsigned max_symbol) {
+    int remaining = 1 << table_log;
+    int largest = -1;
+    int most_frequent = -1;
+
+    for (unsigned s = 0; s <= max_symbol; s++) {
+        if (count[s] == 0) {
+            norm[s] = 0;
+            continue;
+        }
+        if ((most_frequent < 0) || (count[s] > count[most_frequent])) {
+            most_frequent = (int)s;
+        }
+        uint64_t p = (((uint64_t)count[s] << table_log) + (total / 2)) / total;
+        if (p == 0) {
+            norm[s] = -1;
+            remaining -= 1;
+        } else {
+            norm[s] = (int16_t)p;
+            remaining -= (int)p;
+            if ((largest < 0) || (norm[s] > norm[largest])) {
+                largest = (int)s;
+            }
+        }
+    }
+
+    if (largest < 0) {
+        norm[most_frequent] = 1;
+        largest = most_frequent;
+    }
+
+    while (remaining < 0) {
+        int biggest = largest;
+        for (unsigned s = 0; s <= max_symbol; s++) {
+            if (norm[s] > norm[biggest]) {
+                biggest = (int)s;
+            }
+        }
+        assert(norm[biggest] > 1);
+        norm[biggest]--;
+        remaining++;
+    }
+    norm[largest] += (int16_t)remaining;
+}
+
+// FSE table description, as read by the decoder. Returns its size, 0 on
+// overflow.
+static size_t FseWriteNCount(unsigned char * dst, size_t dstCapacity, const int16_t * norm,
+                             unsigned max_symbol, unsigned table_log) {
+    unsigned char * out = dst;
+    unsigned char * end = dst + dstCapacity;
+    const int table_size = 1 << table_log;
+    int remaining = table_size + 1;
+    int threshold = table_size;
+    int nb_bits = (int)table_log + 1;
+    uint32_t bit_stream = 0;
+    int bit_count = 0;
+    unsigned symbol = 0;
+    bool previous_is_0 = false;
+
+    bit_stream += (table_log - FSE_MIN_TABLELOG) << bit_count;
+    bit_count += 4;
+
+    while ((symbol <= max_symbol) && (remaining > 1)) {
+        if (previous_is_0) {
+            unsigned start = symbol;
+            while ((symbol <= max_symbol) && !norm[symbol]) {
+                symbol++;
+            }
+            if (symbol > max_symbol) {
+                break;
+            }
+            while (symbol >= start + 24) {
+                start += 24;
+                bit_stream += 0xFFFFU << bit_count;
+                if (out + 2 > end) {
+                    return 0;
+                }
+                out[0] = (unsigned char)bit_stream;
+                out[1] = (unsigned char)(bit_stream >> 8);
+                out += 2;
+                bit_stream >>= 16;
+            }
+            while (symbol >= start + 3) {
+                start += 3;
+                bit_stream += 3U << bit_count;
+                bit_count += 2;
+            }
+            bit_stream += (symbol - start) << bit_count;
+            bit_count += 2;
+            if (bit_count > 16) {
+                if (out + 2 > end) {
+                    return 0;
+                }
+                out[0] = (unsigned char)bit_stream;
+                out[1] = (unsigned char)(bit_stream >> 8);
+                out += 2;
+                bit_stream >>= 16;
+                bit_count -= 16;
+            }
+        }
+        {
+            int count = norm[symbol++];
+            const int max = (2 * threshold - 1) - remaining;
+            remaining -= (count < 0) ? -count : count;
+            count++;
+            if (count >= threshold) {
+                count += max;
+            }
+            bit_stream += (uint32_t)count << bit_count;
+            bit_count += nb_bits;
+            bit_count -= (count < max);
+            previous_is_0 = (count == 1);
+            assert(remaining >= 1);
+            while (remaining < threshold) {
+                nb_bits--;
+                threshold >>= 1;
+            }
+        }
+        if (bit_count > 16) {
+            if (out + 2 > end) {
+                return 0;
+            }
+            out[0] = (unsigned char)bit_stream;
+            out[1] = (unsigned char)(bit_stream >> 8);
+            out += 2;
+            bit_stream >>= 16;
+            bit_count -= 16;
+        }
+    }
+
+    if (out + 2 > end) {
+        return 0;
+    }
+    out[0] = (unsigned char)bit_stream;
+    out[1] = (unsigned char)(bit_stream >> 8);
+    out += (bit_count + 7) / 8;
+
+    return (size_t)(out - dst);
+}
+
+static void FseBuildCTable(split_fse_ctable_t * ct, const int16_t * norm,
+                           unsigned max_symbol, unsigned table_log) {
+    const unsigned table_size = 1U << table_log;
+    const unsigned table_mask = table_size - 1;
+    const unsigned step = (table_size >> 1) + (table_size >> 3) + 3;
+    uint8_t table_symbol[1 << FSE_MAX_TABLELOG];
+    uint32_t cumul[FSE_MAX_SYMBOLS + 1];
+    unsigned high_threshold = table_size - 1;
+
+    ct->table_log = table_log;
+
+    // low probability symbols go at the top of the table
+    cumul[0] = 0;
+    for (unsigned u = 1; u <= max_symbol + 1; u++) {
+        if (norm[u - 1] == -1) {
+            cumul[u] = cumul[u - 1] + 1;
+            table_symbol[high_threshold--] = (uint8_t)(u - 1);
+        } else {
+            cumul[u] = cumul[u - 1] + (uint32_t)norm[u - 1];
+        }
+    }
+
+    unsigned position = 0;
+    for (unsigned s = 0; s <= max_symbol; s++) {
+        for (int n = 0; n < norm[s]; n++) {
+            table_symbol[position] = (uint8_t)s;
+            position = (position + step) & table_mask;
+            while (position > high_threshold) {
+                position = (position + step) & table_mask;
+            }
+        }
+    }
+    assert(position == 0);
+
+    for (unsigned u = 0; u < table_size; u++) {
+        uint8_t s = table_symbol[u];
+        ct->state_table[cumul[s]++] = (uint16_t)(table_size + u);
+    }
+
+    int total = 0;
+    for (unsigned s = 0; s <= max_symbol; s++) {
+        switch (norm[s]) {
+        case 0:
+            ct->delta_nb_bits[s] = ((table_log + 1) << 16) - table_size;
+            ct->delta_find_state[s] = 0;
+            break;
+        case -1:
+        case 1:
+            ct->delta_nb_bits[s] = (table_log << 16) - table_size;
+            ct->delta_find_state[s] = total - 1;
+            total++;
+            break;
+        default: {
+            unsigned max_bits_out = table_log - HighBit((uint32_t)(norm[s] - 1));
+            uint32_t min_state_plus = (uint32_t)norm[s] << max_bits_out;
+            ct->delta_nb_bits[s] = (max_bits_out << 16) - min_state_plus;
+            ct->delta_find_state[s] = total - norm[s];
+            total += norm[s];
+            break;
+        }
+        }
+    }
+}
+
+// Single symbol table for RLE mode: no state, no bits.
+static void FseBuildCTableRle(split_fse_ctable_t * ct, unsigned symbol) {
+    ct->table_log = 0;
+    ct->state_table[0] = 0;
+    ct->delta_nb_bits[symbol] = 0;
+    ct->delta_find_state[symbol] = 0;
+}
+
+static void FseInitState(split_fse_state_t * st, const split_fse_ctable_t * ct, unsigned symbol) {
+    uint32_t nb_bits_out = (ct->delta_nb_bits[symbol] + (1 << 15)) >> 16;
+    int64_t value = ((int64_t)nb_bits_out << 16) - ct->delta_nb_bits[symbol];
+    st->ct = ct;
+    st->value = ct->state_table[(value >> nb_bits_out) + ct->delta_find_state[symbol]];
+}
+
+static void FseEncodeSymbol(split_bitwriter_t * bw, split_fse_state_t * st, unsigned symbol) {
+    const split_fse_ctable_t * ct = st->ct;
+    uint32_t nb_bits_out = (uint32_t)((st->value + ct->delta_nb_bits[symbol]) >> 16);
+    BitAdd(bw, (uint64_t)st->value, nb_bits_out);
+    st->value = ct->state_table[(st->value >> nb_bits_out) + ct->delta_find_state[symbol]];
+}
+
+static void FseFlushState(split_bitwriter_t * bw, split_fse_state_t * st) {
+    BitAdd(bw, (uint64_t)st->value, st->ct->table_log);
+}
+
+// Approximate cost in 1/256 bits of coding count[] with norm[] at table_log.
+// Returns UINT64_MAX if norm[] can't code one of the symbols.
+static uint64_t FseCost(const uint32_t * count, unsigned max_symbol,
+                        const int16_t * norm, unsigned norm_max_symbol, unsigned table_log) {
+    uint64_t cost = 0;
+    for (unsigned s = 0; s <= max_symbol; s++) {
+        if (count[s] == 0) {
+            continue;
+        }
+        if ((s > norm_max_symbol) || (norm[s] == 0)) {
+            return UINT64_MAX;
+        }
+        uint32_t n = (norm[s] < 0) ? 1 : (uint32_t)norm[s];
+        unsigned hb = HighBit(n);
+        uint32_t log2_q8 = (hb << 8) + (((n << 8) >> hb) - 256);
+        cost += (uint64_t)count[s] * ((table_log << 8) - log2_q8);
+    }
+    return cost;
+}
+
+
+// Huffman
+
+typedef struct {
+    uint16_t code[256];
+    uint8_t nb_bits[256];
+    unsigned max_bits;
+} split_huf_ctable_t;
+
+// Code lengths from a plain Huffman tree. If the tree is deeper than
+// ZSTD_SPLIT_HUF_MAX_BITS the counts are flattened and it is rebuilt, which
+// always converges (all counts 1 gives depth 8) and keeps the code complete,
+// as the format requires.
+static void HufBuildLengths(const uint32_t * count, unsigned max_symbol, split_huf_ctable_t * ht) {
+    uint32_t work[256];
+    uint32_t leaf_weight[256];
+    uint16_t leaf_symbol[256];
+    uint32_t node_weight[512];
+    uint16_t parent[512];
+    uint8_t depth[512];
+
+    for (unsigned s = 0; s <= max_symbol; s++) {
+        work[s] = count[s];
+    }
+
+    while (true) {
+        unsigned n = 0;
+        for (unsigned s = 0; s <= max_symbol; s++) {
+            if (work[s] == 0) {
+                continue;
+            }
+            unsigned i = n++;
+            while ((i > 0) && (leaf_weight[i - 1] > work[s])) {
+                leaf_weight[i] = leaf_weight[i - 1];
+                leaf_symbol[i] = leaf_symbol[i - 1];
+                i--;
+            }
+            leaf_weight[i] = work[s];
+            leaf_symbol[i] = (uint16_t)s;
+        }
+        assert(n >= 2);
+
+        for (unsigned i = 0; i < n; i++) {
+            node_weight[i] = leaf_weight[i];
+        }
+        unsigned next_leaf = 0;
+        unsigned next_internal = n;
+        for (unsigned next = n; next < 2 * n - 1; next++) {
+            unsigned pick[2];
+            for (int k = 0; k < 2; k++) {
+                if ((next_leaf < n) &&
+                    ((next_internal >= next) || (node_weight[next_leaf] <= node_weight[next_internal]))) {
+                    pick[k] = next_leaf++;
+                } else {
+                    pick[k] = next_internal++;
+                }
+            }
+            node_weight[next] = node_weight[pick[0]] + node_weight[pick[1]];
+            parent[pick[0]] = (uint16_t)next;
+            parent[pick[1]] = (uint16_t)next;
+        }
+
+        depth[2 * n - 2] = 0;
+        unsigned max_depth = 0;
+        for (int i = (int)(2 * n) - 3; i >= 0; i--) {
+            depth[i] = depth[parent[i]] + 1;
+            if (depth[i] > max_depth) {
+                max_depth = depth[i];
+            }
+        }
+
+        if (max_depth <= ZSTD_SPLIT_HUF_MAX_BITS) {
+            memset(ht->nb_bits, 0, sizeof(ht->nb_bits));
+            for (unsigned i = 0; i < n; i++) {
+                ht->nb_bits[leaf_symbol[i]] = depth[i];
+            }
+            ht->max_bits = max_depth;
+            return;
+        }
+
+        for (unsigned s = 0; s <= max_symbol; s++) {
+            if (work[s]) {
+                work[s] = (work[s] + 1) / 2;
+            }
+        }
+    }
+}
+
+// Canonical codes in the order the decoder rebuilds them: longest codes
+// first, by symbol value within a length.
+static void HufAssignCodes(split_huf_ctable_t * ht, unsigned max_symbol) {
+    uint16_t nb_per_rank[ZSTD_SPLIT_HUF_MAX_BITS + 2];
+    uint16_t val_per_rank[ZSTD_SPLIT_HUF_MAX_BITS + 2];
+    memset(nb_per_rank, 0, sizeof(nb_per_rank));
+
+    for (unsigned s = 0; s <= max_symbol; s++) {
+        nb_per_rank[ht->nb_bits[s]]++;
+    }
+    uint16_t min = 0;
+    for (int n = (int)ht->max_bits; n > 0; n--) {
+        val_per_rank[n] = min;
+        min += nb_per_rank[n];
+        min >>= 1;
+    }
+    for (unsigned s = 0; s <= max_symbol; s++) {
+        if (ht->nb_bits[s]) {
+            ht->code[s] = val_per_rank[ht->nb_bits[s]]++;
+        }
+    }
+}
+
+// FSE compressed Huffman weights: two interleaved states over a table of at
+// most 64 entries. Returns the size, 0 if not worth it or it doesn't fit.
+static size_t HufCompressWeights(unsigned char * dst, size_t dstCapacity,
+                                 const uint8_t * weights, size_t nb_weights) {
+    uint32_t count[ZSTD_SPLIT_HUF_MAX_BITS + 1];
+    int16_t norm[ZSTD_SPLIT_HUF_MAX_BITS + 1];
+    static split_fse_ctable_t ct;
+
+    if (nb_weights < 3) {
+        return 0;
+    }
+
+    memset(count, 0, sizeof(count));
+    unsigned max_weight = 0;
+    uint32_t max_count = 0;
+    for (size_t i = 0; i < nb_weights; i++) {
+        count[weights[i]]++;
+        if (weights[i] > max_weight) {
+            max_weight = weights[i];
+        }
+    }
+    for (unsigned w = 0; w <= max_weight; w++) {
+        if (count[w] > max_count) {
+            max_count = count[w];
+        }
+    }
+    if ((max_count == nb_weights) || (max_count == 1)) {
+        return 0;
+    }
+
+    unsigned table_log = FseOptimalTableLog(HUF_WEIGHTS_MAX_TABLELOG, nb_weights, max_weight);
+    if (table_log > HUF_WEIGHTS_MAX_TABLELOG) {
+        table_log = HUF_WEIGHTS_MAX_TABLELOG;
+    }
+    FseNormalize(norm, table_log, count, nb_weights, max_weight);
+    size_t header = FseWriteNCount(dst, dstCapacity, norm, max_weight, table_log);
+    if (header == 0) {
+        return 0;
+    }
+    FseBuildCTable(&ct, norm, max_weight, table_log);
+
+    split_bitwriter_t bw;
+    BitInit(&bw, dst + header, dstCapacity - header);
+    split_fse_state_t state1, state2;
+    size_t i = nb_weights;
+    if (nb_weights & 1) {
+        FseInitState(&state1, &ct, weights[--i]);
+        FseInitState(&state2, &ct, weights[--i]);
+        FseEncodeSymbol(&bw, &state1, weights[--i]);
+    } else {
+        FseInitState(&state2, &ct, weights[--i]);
+        FseInitState(&state1, &ct, weights[--i]);
+    }
+    while (i > 0) {
+        FseEncodeSymbol(&bw, &state2, weights[--i]);
+        FseEncodeSymbol(&bw, &state1, weights[--i]);
+    }
+    FseFlushState(&bw, &state2);
+    FseFlushState(&bw, &state1);
+    size_t stream = BitClose(&bw);
+    if (stream == 0) {
+        return 0;
+    }
+    return header + stream;
+}
+
+// Huffman tree description: weights of symbols 0..max_symbol-1, the last one
+// is implied. Returns its size, 0 if it can't be represented.
+static size_t HufWriteTree(unsigned char * dst, size_t dstCapacity,
+                           const split_huf_ctable_t * ht, unsigned max_symbol) {
+    uint8_t weights[256];
+    const size_t nb_weights = max_symbol;
+
+    for (unsigned s = 0; s < max_symbol; s++) {
+        weights[s] = ht->nb_bits[s] ? (uint8_t)(ht->max_bits + 1 - ht->nb_bits[s]) : 0;
+    }
+
+    if (dstCapacity < 1) {
+        return 0;
+    }
+    size_t fse_size = HufCompressWeights(dst + 1, dstCapacity - 1, weights, nb_weights);
+    if ((fse_size > 1) && (fse_size < nb_weights / 2)) {
+        dst[0] = (unsigned char)fse_size;
+        return 1 + fse_size;
+    }
+
+    if (nb_weights > 128) {
+        return 0;
+    }
+    size_t direct_size = 1 + (nb_weights + 1) / 2;
+    if (direct_size > dstCapacity) {
+        return 0;
+    }
+    dst[0] = (unsigned char)(127 + nb_weights);
+    for (size_t i = 0; i < nb_weights; i += 2) {
+        uint8_t hi = weights[i];
+        uint8_t lo = (i + 1 < nb_weights) ? weights[i + 1] : 0;
+        dst[1 + i / 2] = (unsigned char)((hi << 4) | lo);
+    }
+    return direct_size;
+}
+
+static size_t HufEncodeStream(unsigned char * dst, size_t dstCapacity,
+                              const unsigned char * src, size_t srcSize,
+                              const split_huf_ctable_t * ht) {
+    split_bitwriter_t bw;
+    BitInit(&bw, dst, dstCapacity);
+    for (size_t i = srcSize; i > 0; i--) {
+        BitAdd(&bw, ht->code[src[i - 1]], ht->nb_bits[src[i - 1]]);
+    }
+    return BitClose(&bw);
+}
+
+
+// Literals section
+
+static size_t LiteralsHeaderRawRleBytes(size_t size) {
+    return (size < 32) ? 1 : ((size < 4096) ? 2 : 3);
+}
+
+static size_t WriteLiteralsHeaderRawRle(unsigned char * dst, int type, size_t size) {
+    if (size < 32) {
+        dst[0] = (unsigned char)(type | (size << 3));
+        return 1;
+    } else if (size < 4096) {
+        uint32_t hdr = (uint32_t)type | (1 << 2) | ((uint32_t)size << 4);
+        dst[0] = (unsigned char)hdr;
+        dst[1] = (unsigned char)(hdr >> 8);
+        return 2;
+    } else {
+        uint32_t hdr = (uint32_t)type | (3 << 2) | ((uint32_t)size << 4);
+        dst[0] = (unsigned char)hdr;
+        dst[1] = (unsigned char)(hdr >> 8);
+        dst[2] = (unsigned char)(hdr >> 16);
+        return 3;
+    }
+}
+
+static size_t WriteLiteralsRaw(unsigned char * dst, size_t dstCapacity,
+                               const unsigned char * lits, size_t nbLits) {
+    if (dstCapacity < nbLits + 3) {
+        return 0;
+    }
+    size_t hdr = WriteLiteralsHeaderRawRle(dst, ZSTD_LITERALS_RAW, nbLits);
+    memcpy(dst + hdr, lits, nbLits);
+    return hdr + nbLits;
+}
+
+static size_t WriteLiterals(unsigned char * dst, size_t dstCapacity,
+                            const unsigned char * lits, size_t nbLits) {
+    static split_huf_ctable_t ht;
+    uint32_t count[256];
+
+    memset(count, 0, sizeof(count));
+    for (size_t i = 0; i < nbLits; i++) {
+        count[lits[i]]++;
+    }
+    unsigned max_symbol = 0;
+    unsigned distinct = 0;
+    for (unsigned s = 0; s < 256; s++) {
+        if (count[s]) {
+            max_symbol = s;
+            distinct++;
+        }
+    }
+
+    if ((nbLits > 0) && (distinct == 1)) {
+        if (dstCapacity < 4) {
+            return 0;
+        }
+        size_t hdr = WriteLiteralsHeaderRawRle(dst, ZSTD_LITERALS_RLE, nbLits);
+        dst[hdr] = lits[0];
+        return hdr + 1;
+    }
+    if (nbLits < ZSTD_SPLIT_HUF_MIN_LITERALS) {
+        return WriteLiteralsRaw(dst, dstCapacity, lits, nbLits);
+    }
+
+    HufBuildLengths(count, max_symbol, &ht);
+    HufAssignCodes(&ht, max_symbol);
+
+    // body first, behind the largest possible header
+    const size_t max_hdr = 5;
+    if (dstCapacity <= max_hdr) {
+        return 0;
+    }
+    unsigned char * body = dst + max_hdr;
+    unsigned char * body_end = dst + dstCapacity;
+    size_t tree = HufWriteTree(body, (size_t)(body_end - body), &ht, max_symbol);
+    if (tree == 0) {
+        return WriteLiteralsRaw(dst, dstCapacity, lits, nbLits);
+    }
+
+    bool single_stream = nbLits < 256;
+    size_t csize = tree;
+    if (single_stream) {
+        size_t s = HufEncodeStream(body + csize, (size_t)(body_end - body - csize), lits, nbLits, &ht);
+        if (s == 0) {
+            return WriteLiteralsRaw(dst, dstCapacity, lits, nbLits);
+        }
+        csize += s;
+    } else {
+        size_t segment = (nbLits + 3) / 4;
+        unsigned char * jump_table = body + csize;
+        csize += 6;
+        if (body + csize > body_end) {
+            return WriteLiteralsRaw(dst, dstCapacity, lits, nbLits);
+        }
+        for (int k = 0; k < 4; k++) {
+            size_t seg_start = segment * k;
+            size_t seg_len = (k < 3) ? segment : (nbLits - 3 * segment);
+            size_t s = HufEncodeStream(body + csize, (size_t)(body_end - body - csize),
+                                       lits + seg_start, seg_len, &ht);
+            if ((s == 0) || (s > 0xFFFF)) {
+                return WriteLiteralsRaw(dst, dstCapacity, lits, nbLits);
+            }
+            if (k < 3) {
+                jump_table[2 * k] = (unsigned char)s;
+                jump_table[2 * k + 1] = (unsigned char)(s >> 8);
+            }
+            csize += s;
+        }
+    }
+
+    size_t hdr;
+    uint64_t h;
+    if (single_stream && (nbLits < 1024) && (csize < 1024)) {
+        hdr = 3;
+        h = ZSTD_LITERALS_COMPRESSED | (0 << 2) | ((uint64_t)nbLits << 4) | ((uint64_t)csize << 14);
+    } else if (single_stream) {
+        return WriteLiteralsRaw(dst, dstCapacity, lits, nbLits);
+    } else if ((nbLits < 1024) && (csize < 1024)) {
+        hdr = 3;
+        h = ZSTD_LITERALS_COMPRESSED | (1 << 2) | ((uint64_t)nbLits << 4) | ((uint64_t)csize << 14);
+    } else if ((nbLits < 16384) && (csize < 16384)) {
+        hdr = 4;
+        h = ZSTD_LITERALS_COMPRESSED | (2 << 2) | ((uint64_t)nbLits << 4) | ((uint64_t)csize << 18);
+    } else {
+        hdr = 5;
+        h = ZSTD_LITERALS_COMPRESSED | (3 << 2) | ((uint64_t)nbLits << 4) | ((uint64_t)csize << 22);
+    }
+
+    if (hdr + csize >= nbLits + LiteralsHeaderRawRleBytes(nbLits)) {
+        return WriteLiteralsRaw(dst, dstCapacity, lits, nbLits);
+    }
+
+    memmove(dst + hdr, body, csize);
+    for (size_t i = 0; i < hdr; i++) {
+        dst[i] = (unsigned char)(h >> (8 * i));
+    }
+    return hdr + csize;
+}
+
+
+// Sequences section
+
+static uint8_t ll_code_table[ZSTD_SPLIT_MAX_SEQS_PER_BLOCK];
+static uint8_t ml_code_table[ZSTD_SPLIT_MAX_SEQS_PER_BLOCK];
+static uint8_t of_code_table[ZSTD_SPLIT_MAX_SEQS_PER_BLOCK];
+
+static unsigned LitLengthCode(uint32_t ll) {
+    if (ll >= 64) {
+        return HighBit(ll) + 19;
+    }
+    unsigned code = (ll < 16) ? ll : 16;
+    while ((code < LL_MAX_CODE) && (ll_base[code + 1] <= ll)) {
+        code++;
+    }
+    return code;
+}
+
+static unsigned MatchLengthCode(uint32_t ml) {
+    uint32_t ml_base_value = ml - ZSTD_SPLIT_MIN_MATCH_LENGTH;
+    if (ml_base_value >= 128) {
+        return HighBit(ml_base_value) + 36;
+    }
+    unsigned code = (ml_base_value < 32) ? ml_base_value : 32;
+    while ((code < ML_MAX_CODE) && (ml_base[code + 1] <= ml)) {
+        code++;
+    }
+    return code;
+}
+
+typedef struct {
+    int mode;
+    unsigned table_log;
+    unsigned max_symbol;
+    int16_t norm[FSE_MAX_SYMBOLS];
+} split_seq_table_choice_t;
+
+// Picks RLE, predefined or a per-block FSE table for one code stream,
+// whichever is estimated smallest including its table description.
+static void ChooseSeqTable(split_seq_table_choice_t * choice,
+                           const uint32_t * count, unsigned max_symbol, size_t nbSeq,
+                           unsigned max_log, const int16_t * default_norm,
+                           unsigned default_max_symbol, unsigned default_log) {
+    unsigned distinct = 0;
+    unsigned last = 0;
+    for (unsigned s = 0; s <= max_symbol; s++) {
+        if (count[s]) {
+            distinct++;
+            last = s;
+        }
+    }
+    choice->max_symbol = max_symbol;
+
+    if ((distinct == 1) && (nbSeq > 2)) {
+        choice->mode = ZSTD_SEQ_MODE_RLE;
+        choice->table_log = 0;
+        choice->max_symbol = last;
+        return;
+    }
+
+    uint64_t predefined_cost = FseCost(count, max_symbol, default_norm, default_max_symbol, default_log);
+
+    unsigned table_log = FseOptimalTableLog(max_log, nbSeq, max_symbol);
+    if (table_log > max_log) {
+        table_log = max_log;
+    }
+    FseNormalize(choice->norm, table_log, count, nbSeq, max_symbol);
+    unsigned char ncount[512];
+    size_t ncount_size = FseWriteNCount(ncount, sizeof(ncount), choice->norm, max_symbol, table_log);
+    uint64_t fse_cost = FseCost(count, max_symbol, choice->norm, max_symbol, table_log) +
+                        ((uint64_t)ncount_size << 11);
+
+    if ((ncount_size == 0) || (predefined_cost <= fse_cost)) {
+        assert(predefined_cost != UINT64_MAX);
+        choice->mode = ZSTD_SEQ_MODE_PREDEFINED;
+        choice->table_log = default_log;
+        choice->max_symbol = default_max_symbol;
+        memcpy(choice->norm, default_norm, sizeof(int16_t) * (default_max_symbol + 1));
+    } else {
+        choice->mode = ZSTD_SEQ_MODE_FSE;
+        choice->table_log = table_log;
+    }
+}
+
+static size_t WriteSeqTable(unsigned char * dst, size_t dstCapacity,
+                            const split_seq_table_choice_t * choice,
+                            split_fse_ctable_t * ct) {
+    if (choice->mode == ZSTD_SEQ_MODE_RLE) {
+        if (dstCapacity < 1) {
+            return SIZE_MAX;
+        }
+        dst[0] = (unsigned char)choice->max_symbol;
+        FseBuildCTableRle(ct, choice->max_symbol);
+        return 1;
+    }
+    FseBuildCTable(ct, choice->norm, choice->max_symbol, choice->table_log);
+    if (choice->mode == ZSTD_SEQ_MODE_PREDEFINED) {
+        return 0;
+    }
+    size_t n = FseWriteNCount(dst, dstCapacity, choice->norm, choice->max_symbol, choice->table_log);
+    return (n == 0) ? SIZE_MAX : n;
+}
+
+static size_t WriteSequences(unsigned char * dst, size_t dstCapacity,
+                             const accel_seq_command_t * seqs, size_t nbSeq) {
+    static split_fse_ctable_t ll_ct, of_ct, ml_ct;
+    static split_seq_table_choice_t ll_choice, of_choice, ml_choice;
+    uint32_t ll_count[LL_MAX_CODE + 1];
+    uint32_t ml_count[ML_MAX_CODE + 1];
+    uint32_t of_count[OF_MAX_CODE + 1];
+    unsigned char * out = dst;
+    unsigned char * end = dst + dstCapacity;
+
+    if (dstCapacity < 4) {
+        return 0;
+    }
+    if (nbSeq < 128) {
+        *out++ = (unsigned char)nbSeq;
+    } else if (nbSeq < 0x7F00) {
+        *out++ = (unsigned char)((nbSeq >> 8) + 0x80);
+        *out++ = (unsigned char)nbSeq;
+    } else {
+        *out++ = 0xFF;
+        *out++ = (unsigned char)(nbSeq - 0x7F00);
+        *out++ = (unsigned char)((nbSeq - 0x7F00) >> 8);
+    }
+    if (nbSeq == 0) {
+        return (size_t)(out - dst);
+    }
+    assert(nbSeq <= ZSTD_SPLIT_MAX_SEQS_PER_BLOCK);
+
+    memset(ll_count, 0, sizeof(ll_count));
+    memset(ml_count, 0, sizeof(ml_count));
+    memset(of_count, 0, sizeof(of_count));
+    unsigned ll_max = 0, ml_max = 0, of_max = 0;
+    for (size_t i = 0; i < nbSeq; i++) {
+        unsigned llc = LitLengthCode(seqs[i].lit_len);
+        unsigned mlc = MatchLengthCode(seqs[i].match_len_base + ZSTD_SPLIT_MIN_MATCH_LENGTH);
+        unsigned ofc = HighBit(seqs[i].offset_base);
+        ll_code_table[i] = (uint8_t)llc;
+        ml_code_table[i] = (uint8_t)mlc;
+        of_code_table[i] = (uint8_t)ofc;
+        ll_count[llc]++;
+        ml_count[mlc]++;
+        of_count[ofc]++;
+        ll_max = (llc > ll_max) ? llc : ll_max;
+        ml_max = (mlc > ml_max) ? mlc : ml_max;
+        of_max = (ofc > of_max) ? ofc : of_max;
+    }
+
+    ChooseSeqTable(&ll_choice, ll_count, ll_max, nbSeq, ZSTD_SPLIT_LL_MAX_LOG,
+                   ll_default_norm, LL_MAX_CODE, LL_DEFAULT_NORM_LOG);
+    ChooseSeqTable(&of_choice, of_count, of_max, nbSeq, ZSTD_SPLIT_OF_MAX_LOG,
+                   of_default_norm, OF_PREDEFINED_MAX_CODE, OF_DEFAULT_NORM_LOG);
+    ChooseSeqTable(&ml_choice, ml_count, ml_max, nbSeq, ZSTD_SPLIT_ML_MAX_LOG,
+                   ml_default_norm, ML_MAX_CODE, ML_DEFAULT_NORM_LOG);
+
+    if (out >= end) {
+        return 0;
+    }
+    *out++ = (unsigned char)((ll_choice.mode << 6) | (of_choice.mode << 4) | (ml_choice.mode << 2));
+
+    size_t n = WriteSeqTable(out, (size_t)(end - out), &ll_choice, &ll_ct);
+    if (n == SIZE_MAX) {
+        return 0;
+    }
+    out += n;
+    n = WriteSeqTable(out, (size_t)(end - out), &of_choice, &of_ct);
+    if (n == SIZE_MAX) {
+        return 0;
+    }
+    out += n;
+    n = WriteSeqTable(out, (size_t)(end - out), &ml_choice, &ml_ct);
+    if (n == SIZE_MAX) {
+        return 0;
+    }
+    out += n;
+
+    // The decoder walks the sequences front to back, so encode back to front.
+    split_bitwriter_t bw;
+    BitInit(&bw, out, (size_t)(end - out));
+    split_fse_state_t ll_state, of_state, ml_state;
+    size_t last = nbSeq - 1;
+    FseInitState(&ml_state, &ml_ct, ml_code_table[last]);
+    FseInitState(&of_state, &of_ct, of_code_table[last]);
+    FseInitState(&ll_state, &ll_ct, ll_code_table[last]);
+    BitAdd(&bw, seqs[last].lit_len - ll_base[ll_code_table[last]], ll_bits[ll_code_table[last]]);
+    BitAdd(&bw, seqs[last].match_len_base + ZSTD_SPLIT_MIN_MATCH_LENGTH - ml_base[ml_code_table[last]],
+           ml_bits[ml_code_table[last]]);
+    BitAdd(&bw, seqs[last].offset_base, of_code_table[last]);
+
+    for (size_t i = last; i > 0; i--) {
+        const size_t s = i - 1;
+        const unsigned llc = ll_code_table[s];
+        const unsigned mlc = ml_code_table[s];
+        const unsigned ofc = of_code_table[s];
+        FseEncodeSymbol(&bw, &of_state, ofc);
+        FseEncodeSymbol(&bw, &ml_state, mlc);
+        FseEncodeSymbol(&bw, &ll_state, llc);
+        BitAdd(&bw, seqs[s].lit_len - ll_base[llc], ll_bits[llc]);
+        BitAdd(&bw, seqs[s].match_len_base + ZSTD_SPLIT_MIN_MATCH_LENGTH - ml_base[mlc], ml_bits[mlc]);
+        BitAdd(&bw, seqs[s].offset_base, ofc);
+    }
+
+    FseFlushState(&bw, &ml_state);
+    FseFlushState(&bw, &of_state);
+    FseFlushState(&bw, &ll_state);
+    size_t stream = BitClose(&bw);
+    if (stream == 0) {
+        return 0;
+    }
+    out += stream;
+
+    return (size_t)(out - dst);
+}
+
+
+// Frame and blocks
+
+static void WriteBlockHeader(unsigned char * dst, bool last, int type, size_t size) {
+    uint32_t hdr = (uint32_t)last | ((uint32_t)type << 1) | ((uint32_t)size << 3);
+    dst[0] = (unsigned char)hdr;
+    dst[1] = (unsigned char)(hdr >> 8);
+    dst[2] = (unsigned char)(hdr >> 16);
+}
+
+size_t ZstdSplitWriteFrameHeader(unsigned char * dst, uint64_t content_size) {
+    return ZstdSplitWriteFrameHeaderDict(dst, content_size, 0);
+}
+
+size_t ZstdSplitWriteFrameHeaderDict(unsigned char * dst, uint64_t content_size, uint32_t dict_id) {
+    dst[0] = (unsigned char)ZSTD_MAGIC_NUMBER;
+    dst[1] = (unsigned char)(ZSTD_MAGIC_NUMBER >> 8);
+    dst[2] = (unsigned char)(ZSTD_MAGIC_NUMBER >> 16);
+    dst[3] = (unsigned char)(ZSTD_MAGIC_NUMBER >> 24);
+
+    // Dictionary_ID_flag 0..3 selects a 0, 1, 2 or 4 byte field
+    unsigned did_flag = (dict_id == 0) ? 0 : (dict_id < 256) ? 1 : (dict_id < 65536) ? 2 : 3;
+    unsigned did_bytes = (did_flag == 3) ? 4 : did_flag;
+    // single segment: the window is the whole content
+    unsigned fcs_bytes = (content_size >> 32) ? 8 : 4;
+    dst[4] = (unsigned char)((((fcs_bytes == 8) ? 3 : 2) << 6) | (1 << 5) | did_flag);
+    size_t pos = 5;
+    for (unsigned i = 0; i < did_bytes; i++) {
+        dst[pos++] = (unsigned char)(dict_id >> (8 * i));
+    }
+    for (unsigned i = 0; i < fcs_bytes; i++) {
+        dst[pos++] = (unsigned char)(content_size >> (8 * i));
+    }
+    return pos;
+}
+
+size_t ZstdSplitEncodeBlock(const unsigned char * src,
+                            size_t srcSize,
+                            const unsigned char * lits,
+                            size_t nbLits,
+                            const accel_seq_command_t * seqs,
+                            size_t nbSeq,
+                            bool last,
+                            unsigned char * dst,
+                            size_t dstCapacity) {
+    assert(srcSize <= ZSTD_COMPRESS_BLOCKSIZE_MAX);
+    if (dstCapacity < ZSTD_BLOCK_HEADER_BYTES) {
+        return 0;
+    }
+
+    unsigned char * body = dst + ZSTD_BLOCK_HEADER_BYTES;
+    // anything at least srcSize long is stored raw instead
+    size_t body_capacity = dstCapacity - ZSTD_BLOCK_HEADER_BYTES;
+    if (body_capacity > srcSize) {
+        body_capacity = srcSize;
+    }
+
+    size_t lit_size = WriteLiterals(body, body_capacity, lits, nbLits);
+    size_t seq_size = 0;
+    if (lit_size != 0) {
+        seq_size = WriteSequences(body + lit_size, body_capacity - lit_size, seqs, nbSeq);
+    }
+
+    if ((lit_size != 0) && (seq_size != 0) && (lit_size + seq_size < srcSize)) {
+        WriteBlockHeader(dst, last, ZSTD_BLOCK_TYPE_COMPRESSED, lit_size + seq_size);
+        return ZSTD_BLOCK_HEADER_BYTES + lit_size + seq_size;
+    }
+
+    if (dstCapacity < ZSTD_BLOCK_HEADER_BYTES + srcSize) {
+        return 0;
+    }
+    memcpy(body, src, srcSize);
+    WriteBlockHeader(dst, last, ZSTD_BLOCK_TYPE_RAW, srcSize);
+    return ZSTD_BLOCK_HEADER_BYTES + srcSize;
+}
+
+
+// Dictionaries
+
+static void WriteLE32(unsigned char * dst, uint32_t v) {
+    dst[0] = (unsigned char)v;
+    dst[1] = (unsigned char)(v >> 8);
+    dst[2] = (unsigned char)(v >> 16);
+    dst[3] = (unsigned char)(v >> 24);
+}
+
+static uint32_t ReadLE32(const unsigned char * src) {
+    return (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+// Reads forward, little-endian. Bits past srcSize read as 0; the caller checks
+// *bit against srcSize when it is done.
+static uint32_t DictReadBits(const unsigned char * src, size_t srcSize, size_t * bit, unsigned nbBits) {
+    uint32_t v = 0;
+    for (unsigned i = 0; i < nbBits; i++, (*bit)++) {
+        size_t byte = *bit >> 3;
+        if (byte < srcSize) {
+            v |= (uint32_t)((src[byte] >> (*bit & 7)) & 1) << i;
+        }
+    }
+    return v;
+}
+
+// Size of an FSE table description, walked the way the decoder reads it.
+// Returns 0 if it is malformed or runs past srcSize.
+static size_t FseNCountBytes(const unsigned char * src, size_t srcSize,
+                             unsigned max_table_log, unsigned max_symbol) {
+    size_t bit = 0;
+    unsigned table_log = FSE_MIN_TABLELOG + DictReadBits(src, srcSize, &bit, 4);
+    if (table_log > max_table_log) {
+        return 0;
+    }
+
+    int remaining = 1 << table_log;
+    unsigned symbol = 0;
+    while ((remaining > 0) && (symbol <= max_symbol)) {
+        unsigned nb_bits = HighBit((uint64_t)remaining + 1) + 1;
+        uint32_t val = DictReadBits(src, srcSize, &bit, nb_bits);
+        uint32_t lower_mask = (1U << (nb_bits - 1)) - 1;
+        uint32_t threshold = (1U << nb_bits) - 1 - (uint32_t)(remaining + 1);
+        if ((val & lower_mask) < threshold) {
+            // small values take one bit less
+            bit--;
+            val &= lower_mask;
+        } else if (val > lower_mask) {
+            val -= threshold;
+        }
+
+        int proba = (int)val - 1;
+        remaining -= (proba < 0) ? -proba : proba;
+        symbol++;
+        if (proba == 0) {
+            uint32_t repeat;
+            do {
+                repeat = DictReadBits(src, srcSize, &bit, 2);
+                symbol += repeat;
+            } while ((repeat == 3) && (symbol <= max_symbol));
+        }
+    }
+
+    if ((remaining != 0) || (symbol > max_symbol + 1) || (bit > 8 * srcSize)) {
+        return 0;
+    }
+    return (bit + 7) / 8;
+}
+
+int ZstdSplitLoadDictionary(zstd_split_dict_t * dict, const unsigned char * src, size_t srcSize) {
+    // the decoder doesn't take anything shorter either
+    if (srcSize < 8) {
+        return -1;
+    }
+    if (ReadLE32(src) != ZSTD_SPLIT_DICT_MAGIC) {
+        dict->content = src;
+        dict->content_size = srcSize;
+        dict->dict_id = 0;
+        return 0;
+    }
+
+    // magic, Dictionary_ID, then the literals, offsets, match lengths and
+    // literal lengths tables and three repeat offsets, then the content
+    size_t pos = 8;
+    if (pos >= srcSize) {
+        return -1;
+    }
+    unsigned huf_header = src[pos];
+    pos += (huf_header < 128) ? 1 + huf_header : 1 + (huf_header - 127 + 1) / 2;
+
+    static const unsigned max_logs[3] = { ZSTD_SPLIT_OF_MAX_LOG, ZSTD_SPLIT_ML_MAX_LOG, ZSTD_SPLIT_LL_MAX_LOG };
+    static const unsigned max_codes[3] = { OF_MAX_CODE, ML_MAX_CODE, LL_MAX_CODE };
+    for (int t = 0; t < 3; t++) {
+        if (pos >= srcSize) {
+            return -1;
+        }
+        size_t ncount = FseNCountBytes(src + pos, srcSize - pos, max_logs[t], max_codes[t]);
+        if (ncount == 0) {
+            return -1;
+        }
+        pos += ncount;
+    }
+
+    pos += 3 * 4;
+    if (pos > srcSize) {
+        return -1;
+    }
+    dict->content = src + pos;
+    dict->content_size = srcSize - pos;
+    dict->dict_id = ReadLE32(src + 4);
+    return 0;
+}
+
+size_t ZstdSplitBuildDictionary(unsigned char * dst,
+                                size_t dstCapacity,
+                                const unsigned char * content,
+                                size_t contentSize,
+                                uint32_t dict_id) {
+    static const uint32_t rep_offsets[3] = { 1, 4, 8 };
+    static split_huf_ctable_t ht;
+    uint32_t count[256];
+
+    if ((dict_id == 0) || (contentSize <= rep_offsets[2]) || (dstCapacity < 8)) {
+        return 0;
+    }
+
+    memset(count, 0, sizeof(count));
+    for (size_t i = 0; i < contentSize; i++) {
+        count[content[i]]++;
+    }
+    unsigned max_symbol = 0;
+    unsigned nb_symbols = 0;
+    for (unsigned s = 0; s < 256; s++) {
+        if (count[s]) {
+            max_symbol = s;
+            nb_symbols++;
+        }
+    }
+    if (nb_symbols < 2) {
+        return 0;
+    }
+
+    WriteLE32(dst, ZSTD_SPLIT_DICT_MAGIC);
+    WriteLE32(dst + 4, dict_id);
+    size_t pos = 8;
+
+    HufBuildLengths(count, max_symbol, &ht);
+    size_t written = HufWriteTree(dst + pos, dstCapacity - pos, &ht, max_symbol);
+    if (written == 0) {
+        return 0;
+    }
+    pos += written;
+
+    // blocks coded with this encoder never reuse the dictionary's tables, so
+    // the predefined distributions are as good as any
+    written = FseWriteNCount(dst + pos, dstCapacity - pos, of_default_norm,
+                             OF_PREDEFINED_MAX_CODE, OF_DEFAULT_NORM_LOG);
+    if (written == 0) {
+        return 0;
+    }
+    pos += written;
+    written = FseWriteNCount(dst + pos, dstCapacity - pos, ml_default_norm,
+                             ML_MAX_CODE, ML_DEFAULT_NORM_LOG);
+    if (written == 0) {
+        return 0;
+    }
+    pos += written;
+    written = FseWriteNCount(dst + pos, dstCapacity - pos, ll_default_norm,
+                             LL_MAX_CODE, LL_DEFAULT_NORM_LOG);
+    if (written == 0) {
+        return 0;
+    }
+    pos += written;
+
+    if (dstCapacity - pos < 3 * 4 + contentSize) {
+        return 0;
+    }
+    for (int i = 0; i < 3; i++) {
+        WriteLE32(dst + pos, rep_offsets[i]);
+        pos += 4;
+    }
+    memcpy(dst + pos, content, contentSize);
+    return pos + contentSize;
+}
+
+
+// Pipeline
+
+typedef struct {
+    unsigned char * lits;
+    accel_seq_command_t * seqs;
+    volatile int lit_flag;
+    volatile int seq_flag;
+    size_t block_start;
+    size_t block_size;
+} zstd_split_slot_t;
+
+static zstd_split_slot_t split_slots[ZSTD_SPLIT_NUM_SLOTS];
+
+size_t ZstdSplitWorkspaceBytes() {
+    return ZSTD_SPLIT_NUM_SLOTS * (ZSTD_SPLIT_LIT_SLOT_BYTES + ZSTD_SPLIT_SEQ_SLOT_BYTES);
+}
+
+size_t ZstdSplitCompressBound(size_t srcSize) {
+    size_t nblocks = (srcSize + ZSTD_COMPRESS_BLOCKSIZE_MAX - 1) / ZSTD_COMPRESS_BLOCKSIZE_MAX;
+    return ZSTD_SPLIT_FRAME_HEADER_MAX_BYTES + srcSize + ZSTD_BLOCK_HEADER_BYTES * (nblocks + 1);
+}
+
+// prime_size != 0 streams prime in ahead of this block only
+static void ZstdSplitIssue(zstd_split_slot_t * slot, const unsigned char * src,
+                           size_t block_start, size_t block_size,
+                           const unsigned char * prime, size_t prime_size) {
+    slot->block_start = block_start;
+    slot->block_size = block_size;
+    if (prime_size) {
+        ZstdMatchFinderSetDictionary(prime, prime_size);
+    }
+    ZstdMatchFinderAccelNonblocking(src + block_start,
+                                    block_size,
+                                    slot->lits,
+                                    (int *)&slot->lit_flag,
+                                    slot->seqs,
+                                    (int *)&slot->seq_flag);
+    if (prime_size) {
+        ZstdMatchFinderSetDictionary(NULL, 0);
+    }
+}
+
+uint64_t ZstdAccelSplitCompress(const unsigned char * src,
+                                size_t srcSize,
+                                unsigned char * dst,
+                                size_t dstCapacity,
+                                unsigned char * workspace,
+                                zstd_split_stats_t * stats) {
+    return ZstdAccelSplitCompressUsingDict(src, srcSize, dst, dstCapacity, workspace, NULL, stats);
+}
+
+uint64_t ZstdAccelSplitCompressUsingDict(const unsigned char * src,
+                                         size_t srcSize,
+                                         unsigned char * dst,
+                                         size_t dstCapacity,
+                                         unsigned char * workspace,
+                                         const zstd_split_dict_t * dict,
+                                         zstd_split_stats_t * stats) {
+    for (int i = 0; i < ZSTD_SPLIT_NUM_SLOTS; i++) {
+        unsigned char * base = workspace + i * (ZSTD_SPLIT_LIT_SLOT_BYTES + ZSTD_SPLIT_SEQ_SLOT_BYTES);
+        split_slots[i].lits = base;
+        split_slots[i].seqs = (accel_seq_command_t *)(base + ZSTD_SPLIT_LIT_SLOT_BYTES);
+    }
+
+    // only the first block follows the dictionary in the decoded output
+    const unsigned char * prime = NULL;
+    size_t prime_size = 0;
+    uint32_t dict_id = 0;
+    if (dict) {
+        prime_size = dict->content_size;
+        if (prime_size > ZSTD_SPLIT_DICT_MAX_PRIME_BYTES) {
+            prime_size = ZSTD_SPLIT_DICT_MAX_PRIME_BYTES;
+        }
+        prime = dict->content + dict->content_size - prime_size;
+        dict_id = dict->dict_id;
+    }
+
+    if (dstCapacity < ZSTD_SPLIT_FRAME_HEADER_MAX_BYTES + ZSTD_BLOCK_HEADER_BYTES) {
+        return 0;
+    }
+    size_t pos = ZstdSplitWriteFrameHeaderDict(dst, srcSize, dict_id);
+    if (srcSize == 0) {
+        WriteBlockHeader(dst + pos, true, ZSTD_BLOCK_TYPE_RAW, 0);
+        return pos + ZSTD_BLOCK_HEADER_BYTES;
+    }
+
+    size_t nblocks = (srcSize + ZSTD_COMPRESS_BLOCKSIZE_MAX - 1) / ZSTD_COMPRESS_BLOCKSIZE_MAX;
+    size_t next_issue = 0;
+    while ((next_issue < nblocks) && (next_issue < ZSTD_SPLIT_NUM_SLOTS - 1)) {
+        size_t start = next_issue * ZSTD_COMPRESS_BLOCKSIZE_MAX;
+        size_t size = (srcSize - start < ZSTD_COMPRESS_BLOCKSIZE_MAX) ? (srcSize - start) : ZSTD_COMPRESS_BLOCKSIZE_MAX;
+        ZstdSplitIssue(&split_slots[next_issue % ZSTD_SPLIT_NUM_SLOTS], src, start, size,
+                       prime, (next_issue == 0) ? prime_size : 0);
+        next_issue++;
+    }
+
+    for (size_t b = 0; b < nblocks; b++) {
+        // keep the match finder busy while this block is entropy coded
+        if (next_issue < nblocks) {
+            size_t start = next_issue * ZSTD_COMPRESS_BLOCKSIZE_MAX;
+            size_t size = (srcSize - start < ZSTD_COMPRESS_BLOCKSIZE_MAX) ? (srcSize - start) : ZSTD_COMPRESS_BLOCKSIZE_MAX;
+            ZstdSplitIssue(&split_slots[next_issue % ZSTD_SPLIT_NUM_SLOTS], src, start, size, NULL, 0);
+            next_issue++;
+        }
+
+        zstd_split_slot_t * slot = &split_slots[b % ZSTD_SPLIT_NUM_SLOTS];
+        uint64_t t1 = rdcycle();
+        ZstdMatchFinderBlockOnCompletion(&slot->lit_flag, &slot->seq_flag);
+        uint64_t t2 = rdcycle();
+
+        size_t nbLits = (size_t)slot->lit_flag;
+        size_t nbSeq = (size_t)slot->seq_flag / ZSTD_COMPRESS_SEQUENCE_COMMAND_BYTES;
+        bool last = (b == nblocks - 1);
+        size_t written = ZstdSplitEncodeBlock(src + slot->block_start,
+                                              slot->block_size,
+                                              slot->lits,
+                                              nbLits,
+                                              slot->seqs,
+                                              nbSeq,
+                                              last,
+                                              dst + pos,
+                                              dstCapacity - pos);
+        uint64_t t3 = rdcycle();
+        if (written == 0) {
+            return 0;
+        }
+
+        if (stats) {
+            stats->blocks++;
+            stats->raw_blocks += (written == ZSTD_BLOCK_HEADER_BYTES + slot->block_size);
+            stats->wait_cycles += t2 - t1;
+            stats->entropy_cycles += t3 - t2;
+        }
+        pos += written;
+    }
+
+    return pos;
+}
+
+
+// CPU path
+
+static uint32_t cpu_hash_table[1 << ZSTD_SPLIT_CPU_HASH_LOG];
+
+static uint32_t CpuHash(uint32_t v) {
+    return (v * 2654435761U) >> (32 - ZSTD_SPLIT_CPU_HASH_LOG);
+}
+
+void ZstdSplitCpuMatchReset() {
+    memset(cpu_hash_table, 0, sizeof(cpu_hash_table));
+}
+
+void ZstdSplitCpuMatchBlock(const unsigned char * src,
+                            size_t block_start,
+                            size_t block_end,
+                            unsigned char * lits,
+                            size_t * nbLits,
+                            accel_seq_command_t * seqs,
+                            size_t * nbSeq) {
+    size_t ip = block_start;
+    size_t anchor = block_start;
+    size_t nlits = 0;
+    size_t nseq = 0;
+
+    while (ip + ZSTD_COMPRESS_MIN_MATCH_LENGTH <= block_end) {
+        uint32_t cur = ReadLE32(src + ip);
+        uint32_t h = CpuHash(cur);
+        size_t cand = cpu_hash_table[h];
+        cpu_hash_table[h] = (uint32_t)ip;
+
+        if ((cand < ip) && (ip - cand <= ZSTD_SPLIT_CPU_MAX_OFFSET) && (ReadLE32(src + cand) == cur)) {
+            size_t ml = ZSTD_COMPRESS_MIN_MATCH_LENGTH;
+            while ((ip + ml < block_end) && (ml < ZSTD_SPLIT_CPU_MAX_MATCH) && (src[cand + ml] == src[ip + ml])) {
+                ml++;
+            }
+
+            size_t ll = ip - anchor;
+            memcpy(lits + nlits, src + anchor, ll);
+            nlits += ll;
+
+            seqs[nseq].lit_len = (uint32_t)ll;
+            seqs[nseq].match_len_base = (uint32_t)(ml - 3);
+            seqs[nseq].offset_base = (uint32_t)(ip - cand + 3);
+            nseq++;
+
+            ip += ml;
+            anchor = ip;
+        } else {
+            ip++;
+        }
+    }
+
+    memcpy(lits + nlits, src + anchor, block_end - anchor);
+    nlits += block_end - anchor;
+
+    *nbLits = nlits;
+    *nbSeq = nseq;
+}
+
+uint64_t ZstdCpuCompress(const unsigned char * src,
+                         size_t srcSize,
+                         unsigned char * dst,
+                         size_t dstCapacity,
+                         unsigned char * workspace) {
+    unsigned char * lits = workspace;
+    accel_seq_command_t * seqs = (accel_seq_command_t *)(workspace + ZSTD_SPLIT_LIT_SLOT_BYTES);
+
+    if (dstCapacity < ZSTD_SPLIT_FRAME_HEADER_MAX_BYTES + ZSTD_BLOCK_HEADER_BYTES) {
+        return 0;
+    }
+    size_t pos = ZstdSplitWriteFrameHeader(dst, srcSize);
+    if (srcSize == 0) {
+        WriteBlockHeader(dst + pos, true, ZSTD_BLOCK_TYPE_RAW, 0);
+        return pos + ZSTD_BLOCK_HEADER_BYTES;
+    }
+
+    ZstdSplitCpuMatchReset();
+    for (size_t start = 0; start < srcSize; start += ZSTD_COMPRESS_BLOCKSIZE_MAX) {
+        size_t size = (srcSize - start < ZSTD_COMPRESS_BLOCKSIZE_MAX) ? (srcSize - start) : ZSTD_COMPRESS_BLOCKSIZE_MAX;
+        size_t nbLits, nbSeq;
+        ZstdSplitCpuMatchBlock(src, start, start + size, lits, &nbLits, seqs, &nbSeq);
+        size_t written = ZstdSplitEncodeBlock(src + start,
+                                              size,
+                                              lits,
+                                              nbLits,
+                                              seqs,
+                                              nbSeq,
+                                              start + size == srcSize,
+                                              dst + pos,
+                                              dstCapacity - pos);
+        if (written == 0) {
+            return 0;
+        }
+        pos += written;
+    }
+    return pos;
+}
+
+uint64_t ZstdCpuCompressCodec(const unsigned char * src,
+                              size_t src_len,
+                              unsigned char * dst,
+                              size_t dst_capacity,
+                              void * ctx) {
+    return ZstdCpuCompress(src, src_len, dst, dst_capacity, (unsigned char *)ctx);
+}
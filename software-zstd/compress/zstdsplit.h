@@ -0,0 +1,158 @@
+#ifndef __ZSTD_SPLIT_H
+#define __ZSTD_SPLIT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "accellib.h"
+
+// Split pipeline: hardware LZ77, host entropy coding.
+//
+// The standalone match finder (ZstdMatchFinderRoCC) produces the literals and
+// sequences of each 128KB block; the host then builds Huffman and FSE tables
+// for that block at the format's full accuracy (11 bit Huffman codes, FSE
+// table logs up to 9/9/8 for literal lengths/match lengths/offsets, versus
+// the 7/7/6 the on-chip encoders are built with) and emits the block. Two
+// blocks are in flight, so the host entropy codes block N while the match
+// finder works on block N+1.
+//
+// The output is a single zstd frame with the content size in the header.
+// Blocks that don't shrink are stored raw.
+
+#define ZSTD_SPLIT_NUM_SLOTS 2
+#define ZSTD_SPLIT_MIN_MATCH_LENGTH 3
+#define ZSTD_SPLIT_MAX_SEQS_PER_BLOCK (ZSTD_COMPRESS_BLOCKSIZE_MAX / ZSTD_SPLIT_MIN_MATCH_LENGTH + 1)
+// the match finder closes each buffer with a one byte marker
+#define ZSTD_SPLIT_LIT_SLOT_BYTES (ZSTD_COMPRESS_BLOCKSIZE_MAX + 64)
+#define ZSTD_SPLIT_SEQ_SLOT_BYTES (ZSTD_SPLIT_MAX_SEQS_PER_BLOCK * ZSTD_COMPRESS_SEQUENCE_COMMAND_BYTES + 64)
+
+// magic, descriptor, 4 byte Dictionary_ID, 8 byte content size
+#define ZSTD_SPLIT_FRAME_HEADER_MAX_BYTES 17
+
+#define ZSTD_SPLIT_HUF_MAX_BITS 11
+#define ZSTD_SPLIT_LL_MAX_LOG 9
+#define ZSTD_SPLIT_ML_MAX_LOG 9
+#define ZSTD_SPLIT_OF_MAX_LOG 8
+// below this many literals a Huffman table costs more than it saves
+#define ZSTD_SPLIT_HUF_MIN_LITERALS 64
+
+// Dictionaries
+//
+// With a dictionary the first block is matched against the dictionary's
+// content (its last ZSTD_SPLIT_DICT_MAX_PRIME_BYTES, see
+// ZstdMatchFinderSetDictionary) and the frame carries its Dictionary_ID.
+// Later blocks are matched on their own, so this is meant for small calls.
+// Decode with the same dictionary (ZSTD_decompress_with_dict).
+#define ZSTD_SPLIT_DICT_MAGIC 0xEC30A437U
+// priming costs about a cycle per byte on every call
+#define ZSTD_SPLIT_DICT_MAX_PRIME_BYTES (32 << 10)
+
+typedef struct {
+  const unsigned char * content;
+  size_t content_size;
+  uint32_t dict_id; // 0 for raw content dictionaries
+} zstd_split_dict_t;
+
+typedef struct {
+  uint64_t blocks;
+  uint64_t raw_blocks;
+  uint64_t wait_cycles;    // host waiting on the match finder
+  uint64_t entropy_cycles; // host entropy coding
+} zstd_split_stats_t;
+
+size_t ZstdSplitWorkspaceBytes();
+
+size_t ZstdSplitCompressBound(size_t srcSize);
+
+size_t ZstdSplitWriteFrameHeader(unsigned char * dst, uint64_t content_size);
+
+// Same, with a Dictionary_ID field unless dict_id is 0.
+size_t ZstdSplitWriteFrameHeaderDict(unsigned char * dst, uint64_t content_size, uint32_t dict_id);
+
+// Points dict at the content of a zstd dictionary (src is not copied). src is
+// either a formatted dictionary (ZSTD_SPLIT_DICT_MAGIC, its ID and entropy
+// tables, then the content) or raw content. Returns 0, -1 if src is
+// malformed.
+int ZstdSplitLoadDictionary(zstd_split_dict_t * dict, const unsigned char * src, size_t srcSize);
+
+// Writes a formatted dictionary around raw content: a Huffman table from the
+// content's byte counts, the predefined sequence tables and the default
+// repeat offsets. dict_id must be non-zero and the content more than 8 bytes
+// with at least two distinct byte values. Returns the size, 0 on failure.
+size_t ZstdSplitBuildDictionary(unsigned char * dst,
+                                size_t dstCapacity,
+                                const unsigned char * content,
+                                size_t contentSize,
+                                uint32_t dict_id);
+
+// Entropy codes one block from its literals and sequences and writes it,
+// block header included. Falls back to a raw block (from src) when that is
+// smaller. Returns the bytes written, 0 if dstCapacity is too small.
+size_t ZstdSplitEncodeBlock(const unsigned char * src,
+                            size_t srcSize,
+                            const unsigned char * lits,
+                            size_t nbLits,
+                            const accel_seq_command_t * seqs,
+                            size_t nbSeq,
+                            bool last,
+                            unsigned char * dst,
+                            size_t dstCapacity);
+
+// workspace: ZstdSplitWorkspaceBytes() bytes from ZstdCompressWorkspaceSetup.
+// stats may be NULL. Returns the frame size, 0 if dstCapacity is too small.
+uint64_t ZstdAccelSplitCompress(const unsigned char * src,
+                                size_t srcSize,
+                                unsigned char * dst,
+                                size_t dstCapacity,
+                                unsigned char * workspace,
+                                zstd_split_stats_t * stats);
+
+// Same, primed with dict (may be NULL).
+uint64_t ZstdAccelSplitCompressUsingDict(const unsigned char * src,
+                                         size_t srcSize,
+                                         unsigned char * dst,
+                                         size_t dstCapacity,
+                                         unsigned char * workspace,
+                                         const zstd_split_dict_t * dict,
+                                         zstd_split_stats_t * stats);
+
+// CPU path
+//
+// The same frame with LZ77 on the core: a greedy single-probe hash matcher
+// feeds ZstdSplitEncodeBlock. This is the CPU side of the accelerator router
+// (accelrouter.h) and the software match finder of test-entropy.c.
+
+#define ZSTD_SPLIT_CPU_HASH_LOG 14
+#define ZSTD_SPLIT_CPU_MAX_OFFSET ((64 << 10) - 64)
+#define ZSTD_SPLIT_CPU_MAX_MATCH (64 << 10)
+
+// Forgets every position; call at the start of each frame.
+void ZstdSplitCpuMatchReset();
+
+// Matches src[block_start, block_end); matches may reach back into earlier
+// blocks of src. Literals after the last sequence are left for the decoder to
+// copy, so *nbLits can exceed the literal lengths' sum.
+void ZstdSplitCpuMatchBlock(const unsigned char * src,
+                            size_t block_start,
+                            size_t block_end,
+                            unsigned char * lits,
+                            size_t * nbLits,
+                            accel_seq_command_t * seqs,
+                            size_t * nbSeq);
+
+// workspace: ZstdSplitWorkspaceBytes() bytes. Returns the frame size, 0 if
+// dstCapacity is too small.
+uint64_t ZstdCpuCompress(const unsigned char * src,
+                         size_t srcSize,
+                         unsigned char * dst,
+                         size_t dstCapacity,
+                         unsigned char * workspace);
+
+// accel_codec_fn adapter for accelrouter.h, ctx is the workspace
+uint64_t ZstdCpuCompressCodec(const unsigned char * src,
+                              size_t src_len,
+                              unsigned char * dst,
+                              size_t dst_capacity,
+                              void * ctx);
+
+#endif //__ZSTD_SPLIT_H
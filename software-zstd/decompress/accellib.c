@@ -1,22 +1,59 @@
 #include <assert.h>
 #include <malloc.h>
+#include <stdlib.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <inttypes.h>
 #include "accellib.h"
+#include "encoding.h"
 
 #define PAGESIZE_BYTES 4096
 
+// Last value written to each runtime parameter register of
+// DECOMPRESS_OPCODE, so switching contexts only re-issues what differs. Both
+// algorithms' SET_ONCHIP_HIST functs write the same register. One record
+// per hart, since each core reaches its own decompressor.
+typedef struct {
+    bool hist_valid;
+    uint64_t hist_sram_size_limit_bytes;
+    bool latency_valid;
+    uint32_t latency_injection_cycles;
+    bool has_intermediate_cache;
+    uint64_t param_writes;
+} decompress_programmed_t;
+
+static decompress_programmed_t decompress_programmed[DECOMPRESS_CTX_MAX_HARTS];
+
+// The calling hart's record.
+static decompress_programmed_t* DecompressProgrammed() {
+    uint32_t hart = (uint32_t)read_csr(mhartid);
+    assert(hart < DECOMPRESS_CTX_MAX_HARTS);
+    return &decompress_programmed[hart];
+}
+
+static void DecompressRecordHistSize(uint64_t hist_sram_size_limit_bytes) {
+    decompress_programmed_t* programmed = DecompressProgrammed();
+    programmed->hist_valid = true;
+    programmed->hist_sram_size_limit_bytes = hist_sram_size_limit_bytes;
+    programmed->param_writes++;
+}
+
 // Zstd Functions
 
 void ZStdDecompressSetDynamicHistSize(uint64_t hist_sram_size_limit_bytes) {
     ROCC_INSTRUCTION_S(DECOMPRESS_OPCODE, hist_sram_size_limit_bytes, ZSTD_DECOMPRESS_FUNCT_SET_ONCHIP_HIST);
+    DecompressRecordHistSize(hist_sram_size_limit_bytes);
 }
 void DecompressSetLatencyInjection(uint32_t latency_injection_cycles, bool has_intermediate_cache) {
     ROCC_INSTRUCTION_SS(DECOMPRESS_OPCODE,
                         latency_injection_cycles,
                         has_intermediate_cache,
                         DECOMPRESS_FUNCT_LATENCY);
+    decompress_programmed_t* programmed = DecompressProgrammed();
+    programmed->latency_valid = true;
+    programmed->latency_injection_cycles = latency_injection_cycles;
+    programmed->has_intermediate_cache = has_intermediate_cache;
+    programmed->param_writes++;
 }
 
 unsigned char * ZStdDecompressWorkspaceSetup(size_t workspace_size) {
@@ -118,10 +155,221 @@ int ZStdAccelUncompress(const unsigned char* compressed,
     return ZStdAccelBlockOnUncompressCompletion(&completion_flag);
 }
 
+uint64_t ZStdAccelUncompressCodec(const unsigned char* src,
+                                  size_t src_len,
+                                  unsigned char* dst,
+                                  size_t dst_capacity,
+                                  void* ctx) {
+    return (uint64_t)ZStdAccelUncompress(src, src_len, (unsigned char*)ctx, dst);
+}
+
+#define ZSTD_FRAME_MAGIC 0xFD2FB528U
+#define ZSTD_SKIPPABLE_MAGIC_MASK 0xFFFFFFF0U
+#define ZSTD_SKIPPABLE_MAGIC_START 0x184D2A50U
+
+static uint64_t ReadLE(const unsigned char* p, unsigned int nbytes) {
+    uint64_t val = 0;
+    for (unsigned int i = 0; i < nbytes; i++) {
+        val |= ((uint64_t)p[i]) << (8 * i);
+    }
+    return val;
+}
+
+// Walks the frame header and block headers of the frame starting at src.
+// Returns the number of compressed bytes in the frame (0 if malformed) and
+// stores the frame content size, if the header carries one.
+size_t ZStdFrameCompressedSize(const unsigned char* src,
+                               size_t src_len,
+                               uint64_t* content_size) {
+    *content_size = ZSTD_CONTENTSIZE_UNKNOWN;
+    if (src_len < 5) {
+        return 0;
+    }
+
+    uint32_t magic = (uint32_t)ReadLE(src, 4);
+    if ((magic & ZSTD_SKIPPABLE_MAGIC_MASK) == ZSTD_SKIPPABLE_MAGIC_START) {
+        if (src_len < 8) {
+            return 0;
+        }
+        size_t skippable_size = 8 + (size_t)ReadLE(src + 4, 4);
+        *content_size = 0;
+        return (skippable_size <= src_len) ? skippable_size : 0;
+    }
+    if (magic != ZSTD_FRAME_MAGIC) {
+        return 0;
+    }
+
+    const unsigned int did_field_sizes[4] = { 0, 1, 2, 4 };
+    unsigned char fhd = src[4];
+    unsigned int fcs_flag = fhd >> 6;
+    unsigned int single_segment = (fhd >> 5) & 0x1;
+    unsigned int has_checksum = (fhd >> 2) & 0x1;
+    unsigned int fcs_field_size = (fcs_flag == 0) ? single_segment : (1 << fcs_flag);
+
+    size_t pos = 5 + (single_segment ? 0 : 1) + did_field_sizes[fhd & 0x3];
+    if (pos + fcs_field_size > src_len) {
+        return 0;
+    }
+    if (fcs_field_size > 0) {
+        *content_size = ReadLE(src + pos, fcs_field_size) + ((fcs_field_size == 2) ? 256 : 0);
+    }
+    pos += fcs_field_size;
+
+    bool last_block = false;
+    while (!last_block) {
+        if (pos + 3 > src_len) {
+            return 0;
+        }
+        uint32_t block_header = (uint32_t)ReadLE(src + pos, 3);
+        uint32_t block_type = (block_header >> 1) & 0x3;
+        uint32_t block_size = block_header >> 3;
+        last_block = block_header & 0x1;
+        if (block_type == 3) {
+            return 0;
+        }
+        // RLE blocks carry a single byte regardless of their regenerated size
+        pos += 3 + ((block_type == 1) ? 1 : block_size);
+    }
+    pos += has_checksum ? 4 : 0;
+
+    return (pos <= src_len) ? pos : 0;
+}
+
+// Size of the skippable frame starting at src, 0 if it does not start with a
+// complete one.
+static size_t ZStdSkippableFrameSize(const unsigned char* src, size_t src_len) {
+    if ((src_len < 8) || ((ReadLE(src, 4) & ZSTD_SKIPPABLE_MAGIC_MASK) != ZSTD_SKIPPABLE_MAGIC_START)) {
+        return 0;
+    }
+    size_t skippable_size = 8 + (size_t)ReadLE(src + 4, 4);
+    return (skippable_size <= src_len) ? skippable_size : 0;
+}
+
+static void ZStdAccelSpinOnFlag(volatile int * completion_flag) {
+    asm volatile ("fence");
+#ifndef NOACCEL_DEBUG
+    while (! *(completion_flag)) {
+        asm volatile ("fence");
+    }
+#endif
+}
+
+// Splits the input on frame boundaries into chunks of roughly
+// chunk_target_bytes of decompressed output and keeps up to num_inflight of
+// them queued on the accelerator, so on_chunk_done can consume chunk N on the
+// host while chunk N+1 decompresses. Frames without a content size can't be
+// placed in the output ahead of time, so everything from the first such frame
+// onwards goes out as one final chunk. Skippable frames before that are
+// stepped over here and end the chunk they follow, so the accelerator only
+// sees frames with content. All chunks share the workspace, since the
+// decompressor works through its queued jobs one at a time.
+int ZStdAccelChunkedUncompress(const unsigned char* compressed,
+                               size_t compressed_length,
+                               unsigned char* workspace,
+                               unsigned char* uncompressed,
+                               size_t chunk_target_bytes,
+                               unsigned int num_inflight,
+                               accel_chunk_done_fn on_chunk_done,
+                               void* user_ctx) {
+    volatile int chunk_flags[ACCEL_CHUNK_MAX_INFLIGHT];
+    size_t chunk_src_off[ACCEL_CHUNK_MAX_INFLIGHT];
+    size_t chunk_src_len[ACCEL_CHUNK_MAX_INFLIGHT];
+    uint64_t chunk_dst_off[ACCEL_CHUNK_MAX_INFLIGHT];
+    uint64_t chunk_dst_len[ACCEL_CHUNK_MAX_INFLIGHT];
+
+    if (num_inflight < 1) {
+        num_inflight = 1;
+    }
+    if (num_inflight > ACCEL_CHUNK_MAX_INFLIGHT) {
+        num_inflight = ACCEL_CHUNK_MAX_INFLIGHT;
+    }
+
+    size_t src_pos = 0;
+    uint64_t dst_pos = 0;
+    size_t submitted = 0;
+    size_t retired = 0;
+
+    while ((src_pos < compressed_length) || (retired < submitted)) {
+        while ((src_pos < compressed_length) && (submitted - retired < num_inflight)) {
+            size_t skip_len = ZStdSkippableFrameSize(compressed + src_pos, compressed_length - src_pos);
+            if (skip_len != 0) {
+                src_pos += skip_len;
+                continue;
+            }
+
+            size_t src_len = 0;
+            uint64_t dst_len = 0;
+            bool dst_len_known = true;
+
+            while ((src_pos + src_len < compressed_length) &&
+                   ((src_len == 0) || (dst_len < chunk_target_bytes))) {
+                const unsigned char* frame = compressed + src_pos + src_len;
+                size_t frame_avail = compressed_length - src_pos - src_len;
+                if (ZStdSkippableFrameSize(frame, frame_avail) != 0) {
+                    break;
+                }
+                uint64_t frame_content_size;
+                size_t frame_len = ZStdFrameCompressedSize(frame, frame_avail, &frame_content_size);
+                if ((frame_len == 0) || (frame_content_size == ZSTD_CONTENTSIZE_UNKNOWN)) {
+                    src_len = compressed_length - src_pos;
+                    dst_len_known = false;
+                    break;
+                }
+                src_len += frame_len;
+                dst_len += frame_content_size;
+            }
+
+            unsigned int slot = submitted % num_inflight;
+            chunk_flags[slot] = 0;
+            chunk_src_off[slot] = src_pos;
+            chunk_src_len[slot] = src_len;
+            chunk_dst_off[slot] = dst_pos;
+            chunk_dst_len[slot] = dst_len_known ? dst_len : 0;
+
+            ZStdAccelUncompressNonblocking(compressed + src_pos,
+                                           src_len,
+                                           workspace,
+                                           uncompressed + dst_pos,
+                                           (int*)&chunk_flags[slot]);
+            src_pos += src_len;
+            dst_pos += dst_len;
+            submitted++;
+        }
+        if (retired == submitted) {
+            // the rest of the input was skippable frames
+            continue;
+        }
+
+        unsigned int slot = retired % num_inflight;
+        ZStdAccelSpinOnFlag(&chunk_flags[slot]);
+        if (on_chunk_done) {
+            on_chunk_done(user_ctx,
+                          retired,
+                          compressed + chunk_src_off[slot],
+                          chunk_src_len[slot],
+                          uncompressed + chunk_dst_off[slot],
+                          chunk_dst_len[slot]);
+        }
+        retired++;
+    }
+
+    // every job is retired, so this only resyncs the command router
+    uint64_t retval;
+#ifndef NOACCEL_DEBUG
+    if (submitted > 0) {
+        ROCC_INSTRUCTION_D(DECOMPRESS_OPCODE, retval, ZSTD_DECOMPRESS_FUNCT_CHECK_COMPLETION);
+    }
+#endif
+    asm volatile ("fence");
+
+    return 1;
+}
+
 // Snappy Functions
 
 void SnappyDecompressSetDynamicHistSize(uint64_t sram_size_limit_bytes) {
     ROCC_INSTRUCTION_S(DECOMPRESS_OPCODE, sram_size_limit_bytes, SNAPPY_DECOMPRESS_FUNCT_SET_ONCHIP_HIST);
+    DecompressRecordHistSize(sram_size_limit_bytes);
 }
 
 
@@ -175,4 +423,124 @@ bool SnappyAccelRawUncompress(const unsigned char* compressed, size_t compressed
     bool completion_flag = false;
     SnappyAccelRawUncompressNonblocking(compressed, compressed_length, uncompressed, &completion_flag);
     return BlockOnUncompressCompletion(&completion_flag);
-}
\ No newline at end of file
+}
+
+uint64_t SnappyAccelUncompressCodec(const unsigned char* src, size_t src_len, unsigned char* dst, size_t dst_capacity, void* ctx) {
+    return SnappyAccelRawUncompress(src, src_len, dst) ? 1 : 0;
+}
+
+
+// Accelerator contexts
+
+void DecompressCtxInit(decompress_ctx_t * ctx, int algorithm) {
+    assert((algorithm == ZSTD_ALGORITHM) || (algorithm == SNAPPY_ALGORITHM));
+
+    ctx->algorithm = algorithm;
+    ctx->hist_sram_size_limit_bytes = DECOMPRESS_CTX_DEFAULT_HIST_SIZE;
+    ctx->latency_injection_cycles = 0;
+    ctx->has_intermediate_cache = false;
+    ctx->workspace = NULL;
+    ctx->owns_workspace = false;
+}
+
+void DecompressCtxSetWorkspace(decompress_ctx_t * ctx, unsigned char * workspace) {
+    DecompressCtxFreeWorkspace(ctx);
+    ctx->workspace = workspace;
+}
+
+void DecompressCtxAllocWorkspace(decompress_ctx_t * ctx, size_t workspace_size) {
+    DecompressCtxFreeWorkspace(ctx);
+    if (ctx->algorithm != ZSTD_ALGORITHM) {
+        return;
+    }
+    ctx->workspace = ZStdDecompressWorkspaceSetup(workspace_size);
+    ctx->owns_workspace = true;
+}
+
+void DecompressCtxFreeWorkspace(decompress_ctx_t * ctx) {
+    if (ctx->owns_workspace) {
+        free(ctx->workspace);
+    }
+    ctx->workspace = NULL;
+    ctx->owns_workspace = false;
+}
+
+// The algorithm register is rewritten by every job submission, so only the
+// history limit and latency injection are tracked here.
+void DecompressCtxActivate(const decompress_ctx_t * ctx) {
+    const decompress_programmed_t* programmed = DecompressProgrammed();
+    if (!programmed->hist_valid ||
+        (programmed->hist_sram_size_limit_bytes != ctx->hist_sram_size_limit_bytes)) {
+        if (ctx->algorithm == ZSTD_ALGORITHM) {
+            ZStdDecompressSetDynamicHistSize(ctx->hist_sram_size_limit_bytes);
+        } else {
+            SnappyDecompressSetDynamicHistSize(ctx->hist_sram_size_limit_bytes);
+        }
+    }
+    if (!programmed->latency_valid ||
+        (programmed->latency_injection_cycles != ctx->latency_injection_cycles) ||
+        (programmed->has_intermediate_cache != ctx->has_intermediate_cache)) {
+        DecompressSetLatencyInjection(ctx->latency_injection_cycles, ctx->has_intermediate_cache);
+    }
+}
+
+void DecompressCtxInvalidate() {
+    decompress_programmed_t* programmed = DecompressProgrammed();
+    programmed->hist_valid = false;
+    programmed->latency_valid = false;
+}
+
+uint64_t DecompressCtxParamWrites() {
+    return DecompressProgrammed()->param_writes;
+}
+
+bool DecompressCtxUncompress(const decompress_ctx_t * ctx,
+                             const unsigned char* compressed,
+                             size_t compressed_length,
+                             unsigned char* uncompressed) {
+    DecompressCtxActivate(ctx);
+    if (ctx->algorithm == SNAPPY_ALGORITHM) {
+        return SnappyAccelRawUncompress(compressed, compressed_length, uncompressed);
+    }
+    assert(ctx->workspace);
+    return ZStdAccelUncompress(compressed, compressed_length, ctx->workspace, uncompressed) != 0;
+}
+
+
+// Performance counters
+
+uint64_t DecompressReadPerfCounter(uint32_t idx) {
+    uint64_t value = 0;
+#ifndef NOACCEL_DEBUG
+    ROCC_INSTRUCTION_DS(DECOMPRESS_OPCODE, value, (uint64_t)idx, DECOMPRESS_FUNCT_READ_PERF_COUNTER);
+#endif
+    return value;
+}
+
+void DecompressPerfSnapshot(decompress_perf_t * snap) {
+    for (uint32_t i = 0; i < DECOMPRESS_PERF_NUM_COUNTERS; i++) {
+        snap->v[i] = DecompressReadPerfCounter(i);
+    }
+}
+
+void DecompressPerfDiff(const decompress_perf_t * before,
+                        const decompress_perf_t * after,
+                        decompress_perf_t * delta) {
+    for (uint32_t i = 0; i < DECOMPRESS_PERF_NUM_COUNTERS; i++) {
+        delta->v[i] = after->v[i] - before->v[i];
+    }
+}
+
+void DecompressPerfPrint(const char * tag, const decompress_perf_t * delta) {
+    const uint64_t * v = delta->v;
+    uint64_t copies = v[DECOMPRESS_PERF_HIST_ONCHIP_HITS] + v[DECOMPRESS_PERF_HIST_OFFCHIP_MISSES];
+    uint64_t l2_latency = (v[DECOMPRESS_PERF_L2_ACKS] == 0) ? 0 : (v[DECOMPRESS_PERF_L2_INFLIGHT_CYCLES] / v[DECOMPRESS_PERF_L2_ACKS]);
+    uint64_t hist_latency = (v[DECOMPRESS_PERF_HIST_L2_ACKS] == 0) ? 0 : (v[DECOMPRESS_PERF_HIST_L2_INFLIGHT_CYCLES] / v[DECOMPRESS_PERF_HIST_L2_ACKS]);
+    printf("PERF %s: history copies %" PRIu64 " on-chip %" PRIu64 " off-chip %" PRIu64 " (hit rate %" PRIu64 " permille)\n",
+           tag, copies, v[DECOMPRESS_PERF_HIST_ONCHIP_HITS], v[DECOMPRESS_PERF_HIST_OFFCHIP_MISSES],
+           (copies == 0) ? 0 : (v[DECOMPRESS_PERF_HIST_ONCHIP_HITS] * 1000 / copies));
+    printf("PERF %s: l2 reqs %" PRIu64 " acks %" PRIu64 " avg latency %" PRIu64 " cycles\n",
+           tag, v[DECOMPRESS_PERF_L2_REQS], v[DECOMPRESS_PERF_L2_ACKS], l2_latency);
+    printf("PERF %s: history l2 reads %" PRIu64 " avg latency %" PRIu64 " cycles\n",
+           tag, v[DECOMPRESS_PERF_HIST_L2_ACKS], hist_latency);
+}
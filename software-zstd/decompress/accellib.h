@@ -26,6 +26,21 @@
 #define SNAPPY_DECOMPRESS_FUNCT_CHECK_COMPLETION 10
 #define SNAPPY_DECOMPRESS_FUNCT_SET_ONCHIP_HIST 11
 
+#define DECOMPRESS_FUNCT_READ_PERF_COUNTER 12
+
+#define ACCEL_CHUNK_MAX_INFLIGHT 4
+#define ZSTD_CONTENTSIZE_UNKNOWN (~0ULL)
+
+// Called on the host as each chunk retires, while the accelerator keeps
+// working on the chunks still in flight. dst_len is 0 if the frame headers in
+// the chunk did not carry a content size.
+typedef void (*accel_chunk_done_fn)(void * user_ctx,
+                                    size_t chunk_no,
+                                    const unsigned char * src,
+                                    size_t src_len,
+                                    const unsigned char * dst,
+                                    uint64_t dst_len);
+
 // Zstd Functions
 void ZStdDecompressSetDynamicHistSize(uint64_t hist_sram_size_limit_bytes);
 
@@ -48,6 +63,31 @@ int ZStdAccelUncompress(const unsigned char* compressed,
 
 volatile int ZStdAccelBlockOnUncompressCompletion(volatile int * completion_flag);
 
+size_t ZStdFrameCompressedSize(const unsigned char* src,
+                               size_t src_len,
+                               uint64_t* content_size);
+
+// accel_codec_fn adapter for accelrouter.h, ctx is the workspace
+uint64_t ZStdAccelUncompressCodec(const unsigned char* src,
+                                  size_t src_len,
+                                  unsigned char* dst,
+                                  size_t dst_capacity,
+                                  void* ctx);
+
+// Decompresses a run of frames as chunks overlapped with on_chunk_done (see
+// accellib.c). Chunks are cut only at frame boundaries, so a single-frame
+// input is one job and nothing is overlapped. Skippable frames are skipped on
+// the host and never reach the accelerator, except after a frame without a
+// content size, from where the rest of the input is one job.
+int ZStdAccelChunkedUncompress(const unsigned char* compressed,
+                               size_t compressed_length,
+                               unsigned char* workspace,
+                               unsigned char* uncompressed,
+                               size_t chunk_target_bytes,
+                               unsigned int num_inflight,
+                               accel_chunk_done_fn on_chunk_done,
+                               void* user_ctx);
+
 // Snappy Functions
 void SnappyDecompressSetDynamicHistSize(uint64_t sram_size_limit_bytes);
 
@@ -59,4 +99,124 @@ bool SnappyAccelRawUncompress(const unsigned char* compressed, size_t compressed
 
 volatile bool BlockOnUncompressCompletion(volatile bool * completion_flag);
 
+uint64_t SnappyAccelUncompressCodec(const unsigned char* src, size_t src_len, unsigned char* dst, size_t dst_capacity, void* ctx);
+
+// Accelerator contexts
+//
+// The history limit and latency injection are registers in the decompressor's
+// command router, shared by every caller. A context carries one tenant's
+// settings; DecompressCtxActivate (implied by DecompressCtxUncompress)
+// re-issues only the registers whose last written value differs. The plain
+// Set* functions keep the same record; call DecompressCtxInvalidate if the
+// accelerator is reset behind the library's back. Every core has its own
+// decompressor, so the record is kept per hart, and the Ctx functions act on
+// the calling hart's.
+
+// hart ids the record covers
+#ifndef DECOMPRESS_CTX_MAX_HARTS
+#define DECOMPRESS_CTX_MAX_HARTS 8
+#endif
+
+// Router reset value
+#define DECOMPRESS_CTX_DEFAULT_HIST_SIZE (64 << 10)
+
+typedef struct {
+  int algorithm; // ZSTD_ALGORITHM or SNAPPY_ALGORITHM
+  uint64_t hist_sram_size_limit_bytes;
+  uint32_t latency_injection_cycles;
+  bool has_intermediate_cache;
+  unsigned char * workspace; // Zstd only
+  bool owns_workspace;
+} decompress_ctx_t;
+
+void DecompressCtxInit(decompress_ctx_t * ctx, int algorithm);
+
+void DecompressCtxSetWorkspace(decompress_ctx_t * ctx, unsigned char * workspace);
+
+void DecompressCtxAllocWorkspace(decompress_ctx_t * ctx, size_t workspace_size);
+
+void DecompressCtxFreeWorkspace(decompress_ctx_t * ctx);
+
+void DecompressCtxActivate(const decompress_ctx_t * ctx);
+
+void DecompressCtxInvalidate();
+
+uint64_t DecompressCtxParamWrites();
+
+bool DecompressCtxUncompress(const decompress_ctx_t * ctx,
+                             const unsigned char* compressed,
+                             size_t compressed_length,
+                             unsigned char* uncompressed);
+
+#ifdef __cplusplus
+// Owns a context and, when constructed with a workspace_size, its workspace.
+class DecompressContext {
+ public:
+  explicit DecompressContext(int algorithm, size_t workspace_size = 0) {
+    DecompressCtxInit(&ctx_, algorithm);
+    if (workspace_size > 0) {
+      DecompressCtxAllocWorkspace(&ctx_, workspace_size);
+    }
+  }
+
+  ~DecompressContext() {
+    DecompressCtxFreeWorkspace(&ctx_);
+  }
+
+  DecompressContext(const DecompressContext &) = delete;
+  DecompressContext & operator=(const DecompressContext &) = delete;
+
+  void set_hist_size(uint64_t bytes) { ctx_.hist_sram_size_limit_bytes = bytes; }
+  void set_latency_injection(uint32_t cycles, bool has_intermediate_cache) {
+    ctx_.latency_injection_cycles = cycles;
+    ctx_.has_intermediate_cache = has_intermediate_cache;
+  }
+  void set_workspace(unsigned char * workspace) { DecompressCtxSetWorkspace(&ctx_, workspace); }
+
+  void activate() const { DecompressCtxActivate(&ctx_); }
+
+  bool uncompress(const unsigned char * compressed, size_t compressed_length, unsigned char * uncompressed) const {
+    return DecompressCtxUncompress(&ctx_, compressed, compressed_length, uncompressed);
+  }
+
+  const decompress_ctx_t * get() const { return &ctx_; }
+
+ private:
+  decompress_ctx_t ctx_;
+};
+#endif
+
+// Performance counters
+//
+// Free-running hardware counters shared by both algorithms, read one at a
+// time with DECOMPRESS_FUNCT_READ_PERF_COUNTER (rs1 = index, see
+// DecompressorPerfCounters in PerfCounters.scala). They are never cleared:
+// snapshot before and after a region of interest and diff. History hits are
+// copies served from the on-chip history SRAM, misses are copies that had to
+// read the history back from memory. L2 inflight cycles sum the outstanding
+// requests every cycle, so inflight_cycles / acks is the average latency.
+
+#define DECOMPRESS_PERF_HIST_ONCHIP_HITS 0
+#define DECOMPRESS_PERF_HIST_OFFCHIP_MISSES 1
+#define DECOMPRESS_PERF_L2_REQS 2
+#define DECOMPRESS_PERF_L2_ACKS 3
+#define DECOMPRESS_PERF_L2_INFLIGHT_CYCLES 4
+#define DECOMPRESS_PERF_HIST_L2_ACKS 5
+#define DECOMPRESS_PERF_HIST_L2_INFLIGHT_CYCLES 6
+#define DECOMPRESS_PERF_NUM_COUNTERS 7
+
+typedef struct {
+  uint64_t v[DECOMPRESS_PERF_NUM_COUNTERS];
+} decompress_perf_t;
+
+uint64_t DecompressReadPerfCounter(uint32_t idx);
+
+void DecompressPerfSnapshot(decompress_perf_t * snap);
+
+void DecompressPerfDiff(const decompress_perf_t * before,
+                        const decompress_perf_t * after,
+                        decompress_perf_t * delta);
+
+void DecompressPerfPrint(const char * tag, const decompress_perf_t * delta);
+
 #endif //__ACCEL_H
@@ -0,0 +1,371 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef RUN_ON_HOST
+#include <sys/mman.h>
+#endif
+#include "benchcorpus.h"
+
+static int BenchCorpusRead(int fd, void * dst, size_t len, uint64_t offset) {
+    if (lseek(fd, (off_t)offset, SEEK_SET) != (off_t)offset) {
+        return -1;
+    }
+    unsigned char * p = (unsigned char *)dst;
+    while (len > 0) {
+        ssize_t got = read(fd, p, len);
+        if (got <= 0) {
+            return -1;
+        }
+        p += got;
+        len -= (size_t)got;
+    }
+    return 0;
+}
+
+static bool BenchCorpusInShard(uint32_t entry, uint32_t shard, uint32_t num_shards) {
+    return (num_shards <= 1) || ((entry % num_shards) == shard);
+}
+
+static uint64_t BenchCorpusAlignUp(uint64_t v, uint64_t align) {
+    return (v + align - 1) & ~(align - 1);
+}
+
+static bool BenchCorpusHeaderValid(const bench_corpus_header_t * header) {
+    if (memcmp(header->magic, BENCH_CORPUS_MAGIC, sizeof(header->magic)) != 0) {
+        return false;
+    }
+    if ((header->version != BENCH_CORPUS_VERSION) ||
+        (header->align == 0) || (header->align & (header->align - 1))) {
+        return false;
+    }
+    uint64_t index_bytes = (uint64_t)header->num_entries * sizeof(bench_corpus_index_entry_t);
+    return (header->index_offset >= BENCH_CORPUS_HEADER_BYTES) &&
+           (header->index_offset + index_bytes <= header->file_size) &&
+           (header->names_offset + header->names_bytes <= header->file_size);
+}
+
+static bool BenchCorpusEntryValid(const bench_corpus_header_t * header,
+                                  const bench_corpus_index_entry_t * entry,
+                                  const char * names) {
+    return (entry->uncompressed_offset + entry->uncompressed_len <= header->file_size) &&
+           (entry->compressed_offset + entry->compressed_len <= header->file_size) &&
+           ((uint64_t)entry->name_offset + entry->name_len < header->names_bytes) &&
+           (names[entry->name_offset + entry->name_len] == '\0');
+}
+
+// Reads a whole file into a NUL terminated buffer, NULL on failure.
+static char * BenchCorpusReadAll(const char * path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    size_t len = 0;
+    size_t capacity = 4096;
+    char * buf = (char *)malloc(capacity + 1);
+    while (buf != NULL) {
+        ssize_t got = read(fd, buf + len, capacity - len);
+        if (got < 0) {
+            free(buf);
+            buf = NULL;
+            break;
+        }
+        if (got == 0) {
+            buf[len] = '\0';
+            break;
+        }
+        len += (size_t)got;
+        if (len == capacity) {
+            capacity *= 2;
+            char * bigger = (char *)realloc(buf, capacity + 1);
+            if (bigger == NULL) {
+                free(buf);
+            }
+            buf = bigger;
+        }
+    }
+    close(fd);
+    return buf;
+}
+
+// Marks the entries shard `shard` of the manifest lists. -1 if the manifest
+// is malformed, has no such shard, or names a benchmark the corpus lacks.
+static int BenchCorpusSelectManifest(const char * manifest, uint32_t shard,
+                                     const bench_corpus_header_t * header,
+                                     const bench_corpus_index_entry_t * index,
+                                     const char * names, bool * selected) {
+    static const char magic[] = "# " BENCH_CORPUS_MANIFEST_MAGIC " shards=";
+    if (strncmp(manifest, magic, sizeof(magic) - 1) != 0) {
+        return -1;
+    }
+    uint32_t num_shards = (uint32_t)strtoul(manifest + sizeof(magic) - 1, NULL, 10);
+    if (shard >= num_shards) {
+        return -1;
+    }
+
+    for (const char * line = manifest; *line != '\0'; ) {
+        size_t line_len = strcspn(line, "\n");
+        const char * next = line + line_len + (line[line_len] == '\n');
+        if ((line_len == 0) || (line[0] == '#')) {
+            line = next;
+            continue;
+        }
+
+        // <shard> <name>
+        char * end;
+        uint32_t line_shard = (uint32_t)strtoul(line, &end, 10);
+        if ((end == line) || (*end != ' ') || (line_shard >= num_shards)) {
+            return -1;
+        }
+        if (line_shard == shard) {
+            const char * name = end + 1;
+            size_t name_len = line + line_len - name;
+            if ((name_len > 0) && (name[name_len - 1] == '\r')) {
+                name_len--;
+            }
+            uint32_t i;
+            for (i = 0; i < header->num_entries; i++) {
+                if ((index[i].name_len == name_len) &&
+                    (index[i].name_offset + name_len < header->names_bytes) &&
+                    (memcmp(names + index[i].name_offset, name, name_len) == 0)) {
+                    break;
+                }
+            }
+            if (i == header->num_entries) {
+                return -1;
+            }
+            selected[i] = true;
+        }
+        line = next;
+    }
+    return 0;
+}
+
+// Opens the corpus with the entries of a round-robin shard, or of a
+// manifest's shard when manifest_path is given.
+static int BenchCorpusOpenShard(bench_corpus_t * corpus, const char * path, const char * manifest_path,
+                                uint32_t shard, uint32_t num_shards) {
+    memset(corpus, 0, sizeof(*corpus));
+    if ((manifest_path == NULL) && (num_shards > 1) && (shard >= num_shards)) {
+        return -1;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    bench_corpus_header_t header;
+    bench_corpus_index_entry_t * index = NULL;
+    bool * in_shard = NULL;
+    char * manifest = NULL;
+    uint32_t selected = 0;
+    uint64_t shard_bytes = 0;
+#ifdef RUN_ON_HOST
+    unsigned char * base = NULL;
+#else
+    unsigned char * next = NULL;
+#endif
+    int ret = -1;
+
+    if ((BenchCorpusRead(fd, &header, sizeof(header), 0) != 0) || !BenchCorpusHeaderValid(&header)) {
+        goto out;
+    }
+
+    index = (bench_corpus_index_entry_t *)malloc(header.num_entries * sizeof(bench_corpus_index_entry_t) + 1);
+    corpus->names = (char *)malloc(header.names_bytes + 1);
+    if ((index == NULL) || (corpus->names == NULL) ||
+        (BenchCorpusRead(fd, index, header.num_entries * sizeof(bench_corpus_index_entry_t), header.index_offset) != 0) ||
+        (BenchCorpusRead(fd, corpus->names, header.names_bytes, header.names_offset) != 0)) {
+        goto out;
+    }
+
+    in_shard = (bool *)calloc(header.num_entries + 1, sizeof(bool));
+    if (in_shard == NULL) {
+        goto out;
+    }
+    if (manifest_path != NULL) {
+        manifest = BenchCorpusReadAll(manifest_path);
+        if ((manifest == NULL) ||
+            (BenchCorpusSelectManifest(manifest, shard, &header, index, corpus->names, in_shard) != 0)) {
+            goto out;
+        }
+    } else {
+        for (uint32_t i = 0; i < header.num_entries; i++) {
+            in_shard[i] = BenchCorpusInShard(i, shard, num_shards);
+        }
+    }
+
+    for (uint32_t i = 0; i < header.num_entries; i++) {
+        if (!in_shard[i]) {
+            continue;
+        }
+        if (!BenchCorpusEntryValid(&header, &index[i], corpus->names)) {
+            goto out;
+        }
+        selected++;
+        shard_bytes += BenchCorpusAlignUp(index[i].uncompressed_len, header.align) +
+                       BenchCorpusAlignUp(index[i].compressed_len, header.align);
+    }
+
+    corpus->entries = (bench_corpus_entry_t *)malloc(selected * sizeof(bench_corpus_entry_t) + 1);
+    if (corpus->entries == NULL) {
+        goto out;
+    }
+
+#ifdef RUN_ON_HOST
+    // blobs are used in place
+    (void)shard_bytes;
+    corpus->storage_bytes = header.file_size;
+    base = (unsigned char *)mmap(NULL, corpus->storage_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (base == (unsigned char *)MAP_FAILED) {
+        goto out;
+    }
+    corpus->storage = base;
+#else
+    // only this shard's blobs, packed at the corpus alignment
+    corpus->storage_bytes = shard_bytes + header.align;
+    corpus->storage = (unsigned char *)malloc(corpus->storage_bytes);
+    if (corpus->storage == NULL) {
+        goto out;
+    }
+    next = (unsigned char *)BenchCorpusAlignUp((uint64_t)corpus->storage, header.align);
+#endif
+
+    for (uint32_t i = 0; i < header.num_entries; i++) {
+        if (!in_shard[i]) {
+            continue;
+        }
+        bench_corpus_entry_t * entry = &corpus->entries[corpus->num_entries++];
+        entry->name = corpus->names + index[i].name_offset;
+        entry->uncompressed_len = index[i].uncompressed_len;
+        entry->compressed_len = index[i].compressed_len;
+        entry->uncompressed_hash = index[i].uncompressed_hash;
+#ifdef RUN_ON_HOST
+        entry->uncompressed = base + index[i].uncompressed_offset;
+        entry->compressed = base + index[i].compressed_offset;
+#else
+        entry->uncompressed = next;
+        next += BenchCorpusAlignUp(entry->uncompressed_len, header.align);
+        entry->compressed = next;
+        next += BenchCorpusAlignUp(entry->compressed_len, header.align);
+        if ((BenchCorpusRead(fd, entry->uncompressed, entry->uncompressed_len, index[i].uncompressed_offset) != 0) ||
+            (BenchCorpusRead(fd, entry->compressed, entry->compressed_len, index[i].compressed_offset) != 0)) {
+            goto out;
+        }
+#endif
+    }
+    ret = 0;
+
+out:
+    free(index);
+    free(in_shard);
+    free(manifest);
+    close(fd);
+    if (ret != 0) {
+        BenchCorpusClose(corpus);
+    }
+    return ret;
+}
+
+int BenchCorpusOpen(bench_corpus_t * corpus, const char * path, uint32_t shard, uint32_t num_shards) {
+    return BenchCorpusOpenShard(corpus, path, NULL, shard, num_shards);
+}
+
+int BenchCorpusOpenManifest(bench_corpus_t * corpus, const char * path, const char * manifest_path, uint32_t shard) {
+    return BenchCorpusOpenShard(corpus, path, manifest_path, shard, 0);
+}
+
+void BenchCorpusClose(bench_corpus_t * corpus) {
+    if (corpus->storage) {
+#ifdef RUN_ON_HOST
+        munmap(corpus->storage, corpus->storage_bytes);
+#else
+        free(corpus->storage);
+#endif
+    }
+    free(corpus->entries);
+    free(corpus->names);
+    memset(corpus, 0, sizeof(*corpus));
+}
+
+
+// benchmark_data_helper.h drop-in
+
+static bench_corpus_t bench_corpus;
+
+unsigned int num_benchmarks = 0;
+char *** benchmark_names = NULL;
+unsigned char ** benchmark_uncompressed_data_arrays = NULL;
+unsigned int ** benchmark_uncompressed_data_len_array = NULL;
+unsigned char ** benchmark_compressed_data_arrays = NULL;
+unsigned int ** benchmark_compressed_data_len_array = NULL;
+uint64_t * benchmark_uncompressed_hash_array = NULL;
+
+static char ** bench_corpus_names = NULL;
+static unsigned int * bench_corpus_uncompressed_lens = NULL;
+static unsigned int * bench_corpus_compressed_lens = NULL;
+
+void BenchCorpusSetup(int argc, char ** argv) {
+    const char * path = (argc > 1) ? argv[1] : BENCH_CORPUS_PATH;
+    uint32_t shard = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : BENCH_CORPUS_SHARD;
+    uint32_t num_shards = (argc > 3) ? (uint32_t)strtoul(argv[3], NULL, 0) : BENCH_CORPUS_NUM_SHARDS;
+
+    BenchCorpusLoad(path, NULL, shard, num_shards);
+}
+
+void BenchCorpusLoad(const char * path, const char * manifest_path, uint32_t shard, uint32_t num_shards) {
+    int ret = (manifest_path != NULL) ? BenchCorpusOpenManifest(&bench_corpus, path, manifest_path, shard)
+                                      : BenchCorpusOpen(&bench_corpus, path, shard, num_shards);
+    if (ret != 0) {
+        if (manifest_path != NULL) {
+            printf("FAIL: could not load benchmark corpus %s, shard %" PRIu32 " of manifest %s\n",
+                   path, shard, manifest_path);
+        } else {
+            printf("FAIL: could not load benchmark corpus %s, shard %" PRIu32 " of %" PRIu32 "\n",
+                   path, shard, num_shards);
+        }
+        exit(1);
+    }
+
+    uint32_t n = bench_corpus.num_entries;
+    bench_corpus_names = (char **)malloc(n * sizeof(char *) + 1);
+    bench_corpus_uncompressed_lens = (unsigned int *)malloc(n * sizeof(unsigned int) + 1);
+    bench_corpus_compressed_lens = (unsigned int *)malloc(n * sizeof(unsigned int) + 1);
+    benchmark_names = (char ***)malloc(n * sizeof(char **) + 1);
+    benchmark_uncompressed_data_arrays = (unsigned char **)malloc(n * sizeof(unsigned char *) + 1);
+    benchmark_uncompressed_data_len_array = (unsigned int **)malloc(n * sizeof(unsigned int *) + 1);
+    benchmark_compressed_data_arrays = (unsigned char **)malloc(n * sizeof(unsigned char *) + 1);
+    benchmark_compressed_data_len_array = (unsigned int **)malloc(n * sizeof(unsigned int *) + 1);
+    benchmark_uncompressed_hash_array = (uint64_t *)malloc(n * sizeof(uint64_t) + 1);
+
+    for (uint32_t i = 0; i < n; i++) {
+        bench_corpus_entry_t * entry = &bench_corpus.entries[i];
+        // the generated headers have 32 bit lengths too
+        if ((entry->uncompressed_len > UINT32_MAX) || (entry->compressed_len > UINT32_MAX)) {
+            printf("FAIL: benchmark %s is too large\n", entry->name);
+            exit(1);
+        }
+        bench_corpus_names[i] = (char *)entry->name;
+        bench_corpus_uncompressed_lens[i] = (unsigned int)entry->uncompressed_len;
+        bench_corpus_compressed_lens[i] = (unsigned int)entry->compressed_len;
+
+        benchmark_names[i] = &bench_corpus_names[i];
+        benchmark_uncompressed_data_arrays[i] = entry->uncompressed;
+        benchmark_uncompressed_data_len_array[i] = &bench_corpus_uncompressed_lens[i];
+        benchmark_compressed_data_arrays[i] = entry->compressed;
+        benchmark_compressed_data_len_array[i] = &bench_corpus_compressed_lens[i];
+        benchmark_uncompressed_hash_array[i] = entry->uncompressed_hash;
+    }
+    num_benchmarks = n;
+
+    if (manifest_path != NULL) {
+        printf("Loaded %" PRIu32 " benchmarks from %s, shard %" PRIu32 " of manifest %s\n",
+               n, path, shard, manifest_path);
+    } else {
+        printf("Loaded %" PRIu32 " benchmarks from %s, shard %" PRIu32 " of %" PRIu32 "\n",
+               n, path, shard, num_shards);
+    }
+}
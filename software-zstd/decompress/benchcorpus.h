@@ -0,0 +1,119 @@
+#ifndef __BENCH_CORPUS_H
+#define __BENCH_CORPUS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Benchmark corpus archive
+//
+// One file holding every benchmark of a directory (built by corpus.py), so a
+// single binary can run any shard, picked at runtime, instead of having
+// splitter.py compile each shard into its own binary. Host builds
+// (RUN_ON_HOST) mmap the file; on bare metal only the selected shard's blobs
+// are read, through the HTIF syscall proxy.
+//
+// Layout, all fields little-endian:
+//
+//   header (64B)    magic "HCBCORP1", version, num_entries, blob alignment,
+//                   then the index and name table offsets and the file size
+//   index           num_entries x bench_corpus_index_entry_t
+//   names           NUL terminated, referenced by name_offset
+//   blobs           uncompressed then compressed data of each entry, each
+//                   starting on a blob alignment boundary
+//
+// Entries are stored in the order splitter.py hands them out, so shard s of
+// n holds entries s, s + n, s + 2n, ... the same benchmarks the generated
+// headers for chunk s of n would. A shard manifest from shardplan.py can
+// pick the shard's entries instead (BenchCorpusOpenManifest).
+
+#define BENCH_CORPUS_MAGIC "HCBCORP1"
+#define BENCH_CORPUS_VERSION 1
+#define BENCH_CORPUS_HEADER_BYTES 64
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t num_entries;
+  uint32_t align;
+  uint32_t reserved0;
+  uint64_t index_offset;
+  uint64_t names_offset;
+  uint64_t names_bytes;
+  uint64_t file_size;
+  uint64_t reserved1;
+} bench_corpus_header_t;
+
+typedef struct {
+  uint64_t uncompressed_offset;
+  uint64_t uncompressed_len;
+  uint64_t compressed_offset;
+  uint64_t compressed_len;
+  uint32_t name_offset;
+  uint32_t name_len;
+  uint64_t uncompressed_hash; // BenchHash64, 0 if not computed
+} bench_corpus_index_entry_t;
+
+typedef struct {
+  const char * name;
+  unsigned char * uncompressed;
+  uint64_t uncompressed_len;
+  unsigned char * compressed;
+  uint64_t compressed_len;
+  uint64_t uncompressed_hash;
+} bench_corpus_entry_t;
+
+typedef struct {
+  uint32_t num_entries; // in the selected shard
+  bench_corpus_entry_t * entries;
+
+  // backing storage: the mapping on the host, the loaded shard on bare metal
+  unsigned char * storage;
+  size_t storage_bytes;
+  char * names;
+} bench_corpus_t;
+
+// Opens the corpus at path and loads shard `shard` of `num_shards` (0 or 1
+// shards: every entry). Returns 0, -1 if the file can't be read or is not a
+// corpus.
+int BenchCorpusOpen(bench_corpus_t * corpus, const char * path, uint32_t shard, uint32_t num_shards);
+
+// The same, loading shard `shard` of a shard manifest written by
+// shardplan.py (its number of shards comes from the manifest). Also -1 if
+// the manifest can't be read, has no such shard, or lists a benchmark the
+// corpus doesn't have.
+#define BENCH_CORPUS_MANIFEST_MAGIC "hcb-shard-manifest/1"
+int BenchCorpusOpenManifest(bench_corpus_t * corpus, const char * path, const char * manifest_path, uint32_t shard);
+
+void BenchCorpusClose(bench_corpus_t * corpus);
+
+// Drop-in for benchmark_data_helper.h: the same names, filled in by
+// BenchCorpusSetup from argv[1] (corpus path), argv[2] (shard) and argv[3]
+// (number of shards). Missing arguments fall back to the BENCH_CORPUS_PATH,
+// BENCH_CORPUS_SHARD and BENCH_CORPUS_NUM_SHARDS build defaults, for targets
+// that can't pass arguments. Exits if the corpus can't be loaded.
+#ifndef BENCH_CORPUS_PATH
+#define BENCH_CORPUS_PATH "benchmarks.corpus"
+#endif
+#ifndef BENCH_CORPUS_SHARD
+#define BENCH_CORPUS_SHARD 0
+#endif
+#ifndef BENCH_CORPUS_NUM_SHARDS
+#define BENCH_CORPUS_NUM_SHARDS 1
+#endif
+
+extern unsigned int num_benchmarks;
+extern char *** benchmark_names;
+extern unsigned char ** benchmark_uncompressed_data_arrays;
+extern unsigned int ** benchmark_uncompressed_data_len_array;
+extern unsigned char ** benchmark_compressed_data_arrays;
+extern unsigned int ** benchmark_compressed_data_len_array;
+extern uint64_t * benchmark_uncompressed_hash_array;
+
+void BenchCorpusSetup(int argc, char ** argv);
+
+// BenchCorpusSetup for drivers that parse their own arguments. With a
+// manifest_path, shard is a shard of that manifest and num_shards is unused.
+void BenchCorpusLoad(const char * path, const char * manifest_path, uint32_t shard, uint32_t num_shards);
+
+#endif //__BENCH_CORPUS_H
@@ -2,6 +2,9 @@ set -ex
 
 BASEDIR=$(pwd)
 
+# sources shared with the Snappy harnesses
+COMMONDIR="$BASEDIR/../../software-common"
+
 NUMCHUNKS=200
 PARALLELISM_MAX=10
 ZSTD_BINARY_PATH="$BASEDIR/../../software/zstd/zstd"
@@ -11,10 +14,7 @@ COMP_OR_DECOMP=decompress
 
 function buildbench(){
     FINAL_OUTPUT_DIR="$BASEDIR/zstd-$COMP_OR_DECOMP-$1-baremetal/"
-    mkdir -p $FINAL_OUTPUT_DIR/RoCC
-    mkdir -p $FINAL_OUTPUT_DIR/Chiplet
-    mkdir -p $FINAL_OUTPUT_DIR/PCIeC
-    mkdir -p $FINAL_OUTPUT_DIR/PCIeNC
+    mkdir -p $FINAL_OUTPUT_DIR
     OUTPUTDIR="$FINAL_OUTPUT_DIR/build-$3/"
     
     mkdir -p $OUTPUTDIR
@@ -24,23 +24,27 @@ function buildbench(){
     cp $BASEDIR/splitter.py .
     cp $BASEDIR/*.c .
     cp $BASEDIR/*.h .
+    # the CPU path of route=1 (zstdcpu.c) builds the reference decoder
+    cp $BASEDIR/../compress/zstd_decompress.c $BASEDIR/../compress/zstd_decompress.h .
 
-    python3 splitter.py $BENCH_DATA_DIR $OUTPUTDIR $NUMCHUNKS $3 $ZSTD_BINARY_PATH
+    PYTHONPATH=$COMMONDIR python3 splitter.py $BENCH_DATA_DIR $OUTPUTDIR $NUMCHUNKS $3 $ZSTD_BINARY_PATH $MANIFEST
 
+    # one binary sweeps every placement, see the sweep configuration in
+    # test-decompress.c; add -DBENCH_DECOMPRESS_CONFIG=... to narrow it
     riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c accellib.c
-    riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c test-decompress-rocc.c
-    riscv64-unknown-elf-gcc -static -specs=htif_nano.specs accellib.o test-decompress-rocc.o -o $FINAL_OUTPUT_DIR/RoCC/$3.riscv
-
-    riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c test-decompress-chiplet.c
-    riscv64-unknown-elf-gcc -static -specs=htif_nano.specs accellib.o test-decompress-chiplet.o -o $FINAL_OUTPUT_DIR/Chiplet/$3.riscv
-
-    riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c test-decompress-pciec.c
-    riscv64-unknown-elf-gcc -static -specs=htif_nano.specs accellib.o test-decompress-pciec.o -o $FINAL_OUTPUT_DIR/PCIeC/$3.riscv
-
-    riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c test-decompress-pcienc.c
-    riscv64-unknown-elf-gcc -static -specs=htif_nano.specs accellib.o test-decompress-pcienc.o -o $FINAL_OUTPUT_DIR/PCIeNC/$3.riscv
+    riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -I. -c $COMMONDIR/benchverify.c
+    riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c $COMMONDIR/benchreport.c
+    riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -I. -c $COMMONDIR/accelrouter.c
+    riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -c zstdcpu.c
+    riscv64-unknown-elf-gcc -fno-common -fno-builtin-printf -specs=htif_nano.specs -I$COMMONDIR -c test-decompress.c
+    riscv64-unknown-elf-gcc -static -specs=htif_nano.specs accellib.o benchverify.o benchreport.o accelrouter.o zstdcpu.o test-decompress.o -o $FINAL_OUTPUT_DIR/$3.riscv
 }
 
+# balance shards by predicted simulation time, see shardplan.py
+MANIFEST="$BASEDIR/zstd-$COMP_OR_DECOMP-external-baremetal/shards.manifest"
+mkdir -p $(dirname $MANIFEST)
+python3 $COMMONDIR/shardplan.py $BENCH_DATA_DIR $NUMCHUNKS zstd $COMP_OR_DECOMP $MANIFEST
+
 END_INDEX=$((NUMCHUNKS/PARALLELISM_MAX))
 
 for ((j=0; j < $END_INDEX; j++))
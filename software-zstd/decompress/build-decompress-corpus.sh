@@ -0,0 +1,43 @@
+set -ex
+
+# Corpus flavor of build-decompress-bench.sh: packs every benchmark into one
+# archive and builds one binary that sweeps every accelerator placement. The
+# shard is picked at runtime, from the shard manifest planned here:
+#   decompress.riscv corpus=<corpus> manifest=<manifest> shard=<shard>
+# or round-robin:
+#   decompress.riscv corpus=<corpus> shard=<shard> shards=<num shards>
+# For targets that can't pass arguments, build with
+# -DBENCH_DECOMPRESS_CONFIG='"manifest=shards.manifest shard=N"' to bake in
+# a default.
+
+BASEDIR=$(pwd)
+
+# sources shared with the Snappy harnesses
+COMMONDIR="$BASEDIR/../../software-common"
+
+NUMCHUNKS=200
+
+ZSTD_BINARY_PATH="$BASEDIR/../../software/zstd/zstd"
+
+BENCH_DATA_DIR="$BASEDIR/../../software/benchmarks/HyperCompressBench/extracted_benchmarks/ZSTD-DECOMPRESS"
+COMP_OR_DECOMP=decompress
+
+FINAL_OUTPUT_DIR="$BASEDIR/zstd-$COMP_OR_DECOMP-external-baremetal-corpus/"
+mkdir -p $FINAL_OUTPUT_DIR
+
+PYTHONPATH=$COMMONDIR python3 corpus.py $BENCH_DATA_DIR $FINAL_OUTPUT_DIR/benchmarks.corpus $ZSTD_BINARY_PATH
+python3 $COMMONDIR/shardplan.py $BENCH_DATA_DIR $NUMCHUNKS zstd $COMP_OR_DECOMP $FINAL_OUTPUT_DIR/shards.manifest
+
+CFLAGS="-DBENCH_CORPUS -fno-common -fno-builtin-printf -specs=htif_nano.specs"
+
+cd $FINAL_OUTPUT_DIR
+
+riscv64-unknown-elf-gcc $CFLAGS -I$BASEDIR -c $BASEDIR/accellib.c
+riscv64-unknown-elf-gcc $CFLAGS -I$BASEDIR -c $BASEDIR/benchcorpus.c
+riscv64-unknown-elf-gcc $CFLAGS -I$BASEDIR -c $COMMONDIR/benchverify.c
+riscv64-unknown-elf-gcc $CFLAGS -I$BASEDIR -c $COMMONDIR/benchreport.c
+riscv64-unknown-elf-gcc $CFLAGS -I$BASEDIR -c $COMMONDIR/accelrouter.c
+riscv64-unknown-elf-gcc $CFLAGS -I$BASEDIR -I$BASEDIR/../compress -c $BASEDIR/zstdcpu.c
+
+riscv64-unknown-elf-gcc $CFLAGS -I$BASEDIR -I$COMMONDIR -c $BASEDIR/test-decompress.c
+riscv64-unknown-elf-gcc -static -specs=htif_nano.specs accellib.o benchcorpus.o benchverify.o benchreport.o accelrouter.o zstdcpu.o test-decompress.o -o $FINAL_OUTPUT_DIR/decompress.riscv
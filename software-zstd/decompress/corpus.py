@@ -0,0 +1,131 @@
+
+
+# Packs a benchmark directory into one corpus archive (see benchcorpus.h),
+# instead of splitter.py's per-shard C headers.
+#
+# required arguments:
+# abs path to benchmark input files
+# output corpus file
+# ZSTD binary path (for generated compressed version of input)
+#
+# entries are stored in the order splitter.py deals them out to chunks, so
+# shard N of M at runtime is the same set of benchmarks as chunk N of M.
+
+
+
+import sys
+
+assert len(sys.argv) == 4
+
+input_path = sys.argv[1]
+output_file = sys.argv[2]
+ZSTD_BINARY_PATH = sys.argv[3]
+
+BLOB_ALIGN = 64
+HEADER_BYTES = 64
+INDEX_ENTRY_BYTES = 48
+
+
+import os
+import struct
+import subprocess
+from benchhash import bench_hash64_file
+
+all_benchmarks = os.listdir(input_path)
+
+
+filenames_with_size = []
+
+for filename in all_benchmarks:
+    if not filename.endswith(".comp"):
+        filenames_with_size.append([filename, os.stat(input_path + "/" + filename).st_size])
+
+
+filenames_with_size = sorted(filenames_with_size, key=lambda x: x[0])
+#filenames_with_size = sorted(filenames_with_size, key=lambda x: x[1], reverse=True)
+filenames_with_size = sorted(filenames_with_size, key=lambda x: x[1])
+
+
+def align_up(v):
+    return (v + BLOB_ALIGN - 1) & ~(BLOB_ALIGN - 1)
+
+
+entries = []
+
+for fileinfo in filenames_with_size:
+    filename = fileinfo[0]
+
+    input_file_raw = f"{input_path}/{filename}"
+    filename_fixed = filename.replace(".raw", '')
+    filename_fixed_comp = f"{filename_fixed}.comp"
+    input_file_comp = f"{input_path}/{filename_fixed_comp}"
+
+    # check if compressed input file existed, otherwise make it
+    if filename_fixed_comp not in all_benchmarks:
+        # need to compress file
+
+        compression_level = int(filename_fixed_comp.split("_")[1].replace("cl", ""))
+
+        compression_level_command = ""
+
+        if compression_level == 0:
+            compression_level = 3
+
+        if compression_level < 0:
+            negate_compression_level = -1 * compression_level
+            compression_level_command = f"--fast={negate_compression_level}"
+        else:
+            if compression_level > 19:
+                compression_level_command = f"--ultra -{compression_level}"
+            else:
+                compression_level_command = f"-{compression_level}"
+
+        subprocess.run(f"{ZSTD_BINARY_PATH} {compression_level_command} {input_file_raw} -o {input_file_comp}", shell=True, check=True)
+
+    entries.append([filename_fixed, input_file_raw, input_file_comp])
+
+
+names = b""
+name_offsets = []
+for entry in entries:
+    name_offsets.append(len(names))
+    names += entry[0].encode("utf-8") + b"\0"
+
+index_offset = HEADER_BYTES
+names_offset = index_offset + len(entries) * INDEX_ENTRY_BYTES
+blob_offset = align_up(names_offset + len(names))
+
+index = b""
+blob_layout = []
+for entryno, entry in enumerate(entries):
+    raw_len = os.stat(entry[1]).st_size
+    comp_len = os.stat(entry[2]).st_size
+
+    raw_offset = blob_offset
+    comp_offset = align_up(raw_offset + raw_len)
+    blob_offset = align_up(comp_offset + comp_len)
+
+    index += struct.pack("<QQQQIIQ", raw_offset, raw_len, comp_offset, comp_len,
+                         name_offsets[entryno], len(entry[0].encode("utf-8")),
+                         bench_hash64_file(entry[1]))
+    blob_layout.append([raw_offset, entry[1]])
+    blob_layout.append([comp_offset, entry[2]])
+
+file_size = blob_offset
+
+header = struct.pack("<8sIIIIQQQQQ", b"HCBCORP1", 1, len(entries), BLOB_ALIGN, 0,
+                     index_offset, names_offset, len(names), file_size, 0)
+assert len(header) == HEADER_BYTES
+
+
+with open(output_file, 'wb') as f:
+    f.write(header)
+    f.write(index)
+    f.write(names)
+    for offset, path in blob_layout:
+        f.write(b"\0" * (offset - f.tell()))
+        with open(path, 'rb') as blob:
+            f.write(blob.read())
+    f.write(b"\0" * (file_size - f.tell()))
+
+print(f"{output_file}: {len(entries)} benchmarks, {file_size} bytes")
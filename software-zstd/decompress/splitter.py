@@ -1,15 +1,17 @@
 import sys
 
-assert len(sys.argv) == 6
+assert len(sys.argv) in (6, 7)
 
 input_path = sys.argv[1]
 output_path = sys.argv[2]
 num_chunks = int(sys.argv[3])
 this_chunk = int(sys.argv[4])
 ZSTD_BINARY_PATH = sys.argv[5]
+manifest_file = sys.argv[6] if len(sys.argv) == 7 else None
 
 
 import os
+from benchhash import bench_hash64_file
 
 all_benchmarks = os.listdir(input_path)
 
@@ -34,6 +36,23 @@ chunks_list = [ [] for chunk in range(num_chunks) ]
 for index, filename_size_pair in enumerate(filenames_with_size):
     chunks_list[index % len(chunks_list)].append(filename_size_pair)
 
+
+# with a shard manifest from shardplan.py, the chunks are its shards
+if manifest_file is not None:
+    files_by_name = {}
+    for filename_size_pair in filenames_with_size:
+        files_by_name[filename_size_pair[0].replace(".raw", '')] = filename_size_pair
+
+    chunks_list = [ [] for chunk in range(num_chunks) ]
+    with open(manifest_file, 'r', encoding='utf-8') as f:
+        for line in f:
+            if line.startswith("# hcb-shard-manifest/1"):
+                assert f" shards={num_chunks} " in line, f"{manifest_file} is not a plan for {num_chunks} chunks"
+            if line.startswith("#") or not line.strip():
+                continue
+            shard, name = line.rstrip("\n").split(" ", 1)
+            chunks_list[int(shard)].append(files_by_name[name])
+
 import subprocess
 
 my_chunk = chunks_list[this_chunk]
@@ -46,6 +65,7 @@ uncompressed_arrays = []
 uncompressed_lens_array = []
 compressed_arrays = []
 compressed_lens_array = []
+uncompressed_hashes = []
 
 
 for benchno, fileinfo in enumerate(my_chunk):
@@ -108,6 +128,7 @@ for benchno, fileinfo in enumerate(my_chunk):
     uncompressed_lens_array.append(f"&{uncompressed_varname}_len")
     compressed_arrays.append(f"(char*)(&{compressed_varname})")
     compressed_lens_array.append(f"&{compressed_varname}_len")
+    uncompressed_hashes.append(f"0x{bench_hash64_file(input_file_raw):016x}ULL")
 
 
 overall_header = f"{output_path}/benchmark_data_helper.h"
@@ -136,4 +157,9 @@ with open(overall_header, 'w', encoding='utf-8') as f:
 
     f.write("unsigned int * benchmark_compressed_data_len_array[] = {\n")
     f.write(",\n".join(compressed_lens_array))
+    f.write("};\n\n")
+
+    # BenchHash64 of each uncompressed input, see benchverify.h
+    f.write("uint64_t benchmark_uncompressed_hash_array[] = {\n")
+    f.write(",\n".join(uncompressed_hashes))
     f.write("};\n\n")
\ No newline at end of file
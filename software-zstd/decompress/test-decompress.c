@@ -2,128 +2,325 @@
 #include "accellib.h"
 #include <stddef.h>
 #include <stdint.h>
+#ifdef BENCH_CORPUS
+#include "benchcorpus.h"
+#else
 #include "benchmark_data_helper.h"
+#endif
 #include <inttypes.h>
 #include <stdlib.h>
+#include <string.h>
 #include "encoding.h"
+#include "benchverify.h"
+#include "benchreport.h"
+#include "accelrouter.h"
+#include "zstdcpu.h"
 
 // #define DO_PRINT
 
-uint32_t latency_injection_cycles = 0; //in cycles. 
-bool has_intermediate_cache = false;
+// Sweep configuration
+//
+// One launch runs every (placement, hist SRAM size) pair of the sweep. The
+// configuration is read from BENCH_DECOMPRESS_CONFIG, built in for targets
+// that get no arguments, then from argv. Both are whitespace separated
+// key=value settings, later ones win:
+//
+//   placements=rocc,chiplet,pciec,pcienc  accelerator placements to model
+//   hist=65536,32768,...                  hist SRAM sizes, in bytes
+//   warmup=N                              unreported passes per placement,
+//                                         at the first hist SRAM size
+//   verify=0|1                            check output against the input,
+//                                         see benchverify.h
+//   reps=N                                reported passes per hist SRAM size
+//   route=0|1                             send calls through accelrouter.h:
+//                                         those below the placement's
+//                                         calibrated crossover decode on
+//                                         the core (zstdcpu.c)
+//   records=none|summary|calls            JSON line records, see
+//                                         benchreport.h: none, one per
+//                                         hist SRAM size and size bucket,
+//                                         or also one per benchmark
+//   corpus=PATH shard=S shards=N          BENCH_CORPUS builds only
+//   manifest=PATH                         BENCH_CORPUS builds only: take
+//                                         shard S of this shardplan.py
+//                                         manifest, instead of the
+//                                         round-robin shard S of N
+//
+// e.g. -DBENCH_DECOMPRESS_CONFIG='"placements=rocc verify=1"'
+
+#ifndef BENCH_DECOMPRESS_CONFIG
+#define BENCH_DECOMPRESS_CONFIG ""
+#endif
 
-bool zstd_run_benchmark(char * benchmark_compressed_data, size_t benchmark_compressed_data_len,
-        char * write_region, char * benchmark_uncompressed_data, size_t benchmark_uncompressed_data_len,
-        char * bench_name, unsigned int benchno, uint64_t sram_size, char * workspace_area,
-        size_t * total_data_uncompressed_processed, size_t * total_data_compressed_processed, uint64_t * total_cycles_taken, size_t * num_bench_pass, uint64_t * benchmark_sum_overall) {
+#define MAX_SWEEP_PLACEMENTS 8
+#define MAX_SWEEP_HIST_SIZES 16
+
+// route=1 crossovers, one "zstd-uncompress-<placement>" line each; missing
+// ones are calibrated on this shard's benchmarks and written back
+#define ROUTER_PROFILE_PATH "zstd-decompress-router.profile"
+
+typedef struct {
+    const char * name;  // in the sweep configuration
+    const char * label; // in TOTAL lines, as process-resultdir-decompress.py names it
+    uint32_t latency_injection_cycles;
+    bool has_intermediate_cache;
+} decompress_placement_t;
+
+static const decompress_placement_t decompress_placements[] = {
+    { "rocc",    "RoCC",           0,   false },
+    { "chiplet", "Chiplet",        50,  false },
+    { "pciec",   "PCIeLocalCache", 400, true  },
+    { "pcienc",  "PCIeNoCache",    400, false },
+};
+
+#define NUM_DECOMPRESS_PLACEMENTS (sizeof(decompress_placements) / sizeof(decompress_placements[0]))
+
+typedef enum {
+    SWEEP_RECORDS_NONE,
+    SWEEP_RECORDS_SUMMARY,
+    SWEEP_RECORDS_CALLS,
+} sweep_records_t;
+
+typedef struct {
+    const decompress_placement_t * placements[MAX_SWEEP_PLACEMENTS];
+    unsigned int num_placements;
+    uint64_t sram_sizes[MAX_SWEEP_HIST_SIZES];
+    unsigned int num_sram_sizes;
+    unsigned int num_warmups;
+    bool verify;
+    bool route;
+    unsigned int num_reps;
+    sweep_records_t records;
+#ifdef BENCH_CORPUS
+    const char * corpus_path;
+    const char * corpus_manifest;
+    uint32_t corpus_shard;
+    uint32_t corpus_num_shards;
+#endif
+} decompress_sweep_t;
 
-// #ifdef DO_PRINT
-    printf("Starting benchmark num %d: %s\n", benchno, bench_name);
-// #endif
+static void SweepDefaults(decompress_sweep_t * sweep) {
+    memset(sweep, 0, sizeof(*sweep));
+    for (unsigned int i = 0; i < NUM_DECOMPRESS_PLACEMENTS; i++) {
+        sweep->placements[sweep->num_placements++] = &decompress_placements[i];
+    }
+    for (uint64_t sram_size = 64 << 10; sram_size >= (2 << 10); sram_size >>= 1) {
+        sweep->sram_sizes[sweep->num_sram_sizes++] = sram_size;
+    }
+    sweep->num_warmups = 2;
+    sweep->verify = false;
+    sweep->num_reps = 1;
+    sweep->records = SWEEP_RECORDS_SUMMARY;
+#ifdef BENCH_CORPUS
+    sweep->corpus_path = BENCH_CORPUS_PATH;
+    sweep->corpus_shard = BENCH_CORPUS_SHARD;
+    sweep->corpus_num_shards = BENCH_CORPUS_NUM_SHARDS;
+#endif
+}
+
+static const decompress_placement_t * SweepFindPlacement(const char * name, size_t len) {
+    for (unsigned int i = 0; i < NUM_DECOMPRESS_PLACEMENTS; i++) {
+        if ((strlen(decompress_placements[i].name) == len) &&
+            (strncmp(decompress_placements[i].name, name, len) == 0)) {
+            return &decompress_placements[i];
+        }
+    }
+    return NULL;
+}
 
-    // zero-out parts of workspace region to ensure past correct results don't count
-    uint64_t * workspace_region_zero_by8 = (uint64_t *) workspace_area;
-    size_t bench_expected_workspace_num_words = benchmark_uncompressed_data_len / 8;
-    size_t bench_expected_workspace_tail_start = bench_expected_workspace_num_words * 8;
+static bool SweepParseUnsigned(const char * value, uint64_t * result) {
+    char * end;
+    if (*value == '\0') {
+        return false;
+    }
+    *result = strtoull(value, &end, 0);
+    return (*end == '\0') || (*end == ',');
+}
 
-    for (size_t i = 0; i < bench_expected_workspace_num_words; i++) {
-        workspace_region_zero_by8[i] = 0;
+// Applies one key=value setting, false if it isn't one.
+static bool SweepApply(decompress_sweep_t * sweep, const char * setting) {
+    const char * value = strchr(setting, '=');
+    if (value == NULL) {
+        return false;
     }
-    for (size_t i = bench_expected_workspace_tail_start; i < benchmark_uncompressed_data_len; i++) {
-        workspace_area[i] = 0;
+    size_t key_len = value - setting;
+    value++;
+    uint64_t n;
+
+#define SWEEP_KEY_IS(k) ((key_len == strlen(k)) && (strncmp(setting, k, key_len) == 0))
+    if (SWEEP_KEY_IS("placements")) {
+        sweep->num_placements = 0;
+        while (*value != '\0') {
+            size_t len = strcspn(value, ",");
+            const decompress_placement_t * placement = SweepFindPlacement(value, len);
+            if ((placement == NULL) || (sweep->num_placements == MAX_SWEEP_PLACEMENTS)) {
+                return false;
+            }
+            sweep->placements[sweep->num_placements++] = placement;
+            value += len + (value[len] == ',');
+        }
+        return sweep->num_placements > 0;
+    } else if (SWEEP_KEY_IS("hist")) {
+        sweep->num_sram_sizes = 0;
+        while (*value != '\0') {
+            if (!SweepParseUnsigned(value, &n) || (n == 0) ||
+                (sweep->num_sram_sizes == MAX_SWEEP_HIST_SIZES)) {
+                return false;
+            }
+            sweep->sram_sizes[sweep->num_sram_sizes++] = n;
+            size_t len = strcspn(value, ",");
+            value += len + (value[len] == ',');
+        }
+        return sweep->num_sram_sizes > 0;
+    } else if (SWEEP_KEY_IS("warmup")) {
+        if (!SweepParseUnsigned(value, &n) || (strchr(value, ',') != NULL)) {
+            return false;
+        }
+        sweep->num_warmups = (unsigned int)n;
+    } else if (SWEEP_KEY_IS("verify")) {
+        if (!SweepParseUnsigned(value, &n) || (n > 1)) {
+            return false;
+        }
+        sweep->verify = (n == 1);
+    } else if (SWEEP_KEY_IS("route")) {
+        if (!SweepParseUnsigned(value, &n) || (n > 1)) {
+            return false;
+        }
+        sweep->route = (n == 1);
+    } else if (SWEEP_KEY_IS("reps")) {
+        if (!SweepParseUnsigned(value, &n) || (n == 0) || (strchr(value, ',') != NULL)) {
+            return false;
+        }
+        sweep->num_reps = (unsigned int)n;
+    } else if (SWEEP_KEY_IS("records")) {
+        if (strcmp(value, "none") == 0) {
+            sweep->records = SWEEP_RECORDS_NONE;
+        } else if (strcmp(value, "summary") == 0) {
+            sweep->records = SWEEP_RECORDS_SUMMARY;
+        } else if (strcmp(value, "calls") == 0) {
+            sweep->records = SWEEP_RECORDS_CALLS;
+        } else {
+            return false;
+        }
+#ifdef BENCH_CORPUS
+    } else if (SWEEP_KEY_IS("corpus")) {
+        sweep->corpus_path = value;
+    } else if (SWEEP_KEY_IS("manifest")) {
+        sweep->corpus_manifest = value;
+    } else if (SWEEP_KEY_IS("shard")) {
+        if (!SweepParseUnsigned(value, &n) || (strchr(value, ',') != NULL)) {
+            return false;
+        }
+        sweep->corpus_shard = (uint32_t)n;
+    } else if (SWEEP_KEY_IS("shards")) {
+        if (!SweepParseUnsigned(value, &n) || (strchr(value, ',') != NULL)) {
+            return false;
+        }
+        sweep->corpus_num_shards = (uint32_t)n;
+#endif
+    } else {
+        return false;
     }
+#undef SWEEP_KEY_IS
+    return true;
+}
 
-    // zero-out parts of write region to ensure past correct results don't count
-    uint64_t * write_region_zero_by8 = (uint64_t *) write_region;
-    size_t bench_expected_write_num_words = benchmark_uncompressed_data_len / 8;
-    size_t bench_expected_tail_start = bench_expected_write_num_words * 8;
+static void SweepConfigure(decompress_sweep_t * sweep, int argc, char ** argv) {
+    SweepDefaults(sweep);
 
-    for (size_t i = 0; i < bench_expected_write_num_words; i++) {
-        write_region_zero_by8[i] = 0;
+    // settings from the built-in config are kept for the whole run, since
+    // corpus= and manifest= point into them
+    static char config[] = BENCH_DECOMPRESS_CONFIG;
+    for (char * setting = strtok(config, " \t\n"); setting != NULL; setting = strtok(NULL, " \t\n")) {
+        if (!SweepApply(sweep, setting)) {
+            printf("FAIL: bad setting in BENCH_DECOMPRESS_CONFIG: %s\n", setting);
+            exit(1);
+        }
     }
-    for (size_t i = bench_expected_tail_start; i < benchmark_uncompressed_data_len; i++) {
-        write_region[i] = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!SweepApply(sweep, argv[i])) {
+            printf("FAIL: bad setting: %s\n", argv[i]);
+            exit(1);
+        }
     }
 
-    uint64_t * benchmark_compressed_data_by8 = (uint64_t *) benchmark_compressed_data;
-    size_t bench_compressed_num_words = benchmark_compressed_data_len / 8;
-    size_t compressed_tail_start = bench_compressed_num_words * 8;
-
-    for (size_t i = 0; i < bench_compressed_num_words; i++) {
-        *benchmark_sum_overall += benchmark_compressed_data_by8[i];
+    printf("Sweep: placements");
+    for (unsigned int i = 0; i < sweep->num_placements; i++) {
+        printf("%c%s", (i == 0) ? '=' : ',', sweep->placements[i]->name);
     }
-    for (size_t i = compressed_tail_start; i < benchmark_compressed_data_len; i++) {
-        *benchmark_sum_overall += benchmark_compressed_data[i];
+    printf(" hist");
+    for (unsigned int i = 0; i < sweep->num_sram_sizes; i++) {
+        printf("%c%" PRIu64, (i == 0) ? '=' : ',', sweep->sram_sizes[i]);
     }
+    static const char * records_names[] = { "none", "summary", "calls" };
+    printf(" warmup=%u verify=%d route=%d reps=%u records=%s\n", sweep->num_warmups, sweep->verify, sweep->route,
+           sweep->num_reps, records_names[sweep->records]);
+}
+
+// Route of the current placement, -1 unless route=1.
+static int uncompress_route = -1;
+
+// Times both paths of route on one benchmark per log2 compressed size,
+// smallest first. dst must hold the largest uncompressed benchmark.
+static void calibrate_zstd_route(int route, unsigned char * dst, size_t dst_capacity) {
+    const unsigned char * inputs[BENCH_REPORT_NUM_BUCKETS];
+    size_t input_lens[BENCH_REPORT_NUM_BUCKETS];
+    int num_inputs = 0;
+    for (unsigned int bucket = 0; bucket < BENCH_REPORT_NUM_BUCKETS; bucket++) {
+        for (unsigned int i = 0; i < num_benchmarks; i++) {
+            unsigned int comp_len = *(benchmark_compressed_data_len_array[i]);
+            if (BenchReportSizeBucket(comp_len) == bucket) {
+                inputs[num_inputs] = (const unsigned char *) benchmark_compressed_data_arrays[i];
+                input_lens[num_inputs] = comp_len;
+                num_inputs++;
+                break;
+            }
+        }
+    }
+    AccelRouterCalibrateInputs(route, inputs, input_lens, num_inputs, dst, dst_capacity);
+}
+
+bool zstd_run_benchmark(char * benchmark_compressed_data, size_t benchmark_compressed_data_len,
+        char * write_region, char * benchmark_uncompressed_data, size_t benchmark_uncompressed_data_len,
+        uint64_t benchmark_uncompressed_hash,
+        char * bench_name, unsigned int benchno, uint64_t sram_size, char * workspace_area,
+        size_t * total_data_uncompressed_processed, size_t * total_data_compressed_processed, uint64_t * total_cycles_taken, size_t * num_bench_pass,
+        uint64_t * call_cycles, bool verify, uint64_t generation) {
 
 #ifdef DO_PRINT
-    printf("Benchmark sum: %" PRIu64 "\n", *benchmark_sum_overall);
+    printf("Starting benchmark num %d: %s\n", benchno, bench_name);
 #endif
 
+    // tag the write region so past correct results don't count
+    if (verify) {
+        BenchVerifyStamp((unsigned char *) write_region, benchmark_uncompressed_data_len, generation);
+    }
+
     uint64_t t1 = rdcycle();
-    ZStdAccelUncompress(benchmark_compressed_data, benchmark_compressed_data_len, workspace_area, write_region);
+    if (uncompress_route >= 0) {
+        AccelRouterRun(uncompress_route, (const unsigned char *) benchmark_compressed_data, benchmark_compressed_data_len,
+                       (unsigned char *) write_region, benchmark_uncompressed_data_len);
+    } else {
+        ZStdAccelUncompress(benchmark_compressed_data, benchmark_compressed_data_len, workspace_area, write_region);
+    }
     uint64_t t2 = rdcycle();
 
     //printf("Start cycle: %" PRIu64 "\n", t1);
     //printf("End cycle: %" PRIu64 "\n", t2);
-// #ifdef DO_PRINT
-    printf("Took %" PRIu64 " cycles, produced %" PRIu64 " uncompressed bytes. comp size: %" PRIu64 " for benchmark: %s, with histsram: %" PRIu64 "\n", t2 - t1, benchmark_uncompressed_data_len, benchmark_compressed_data_len, bench_name, sram_size);
-// #endif
-
-    //printf("Got output:\n");
-    //for (size_t i = 0; i < benchmark_uncompressed_data_len; i++) {
-    //    printf("0x%02x\n", (uint32_t)((uint8_t)result_area[i]));
-    //}
-
 #ifdef DO_PRINT
-    printf("Checking uncompressed output correctness:\n");
+    printf("Took %" PRIu64 " cycles, produced %" PRIu64 " uncompressed bytes. comp size: %" PRIu64 " for benchmark: %s, with histsram: %" PRIu64 "\n", t2 - t1, benchmark_uncompressed_data_len, benchmark_compressed_data_len, bench_name, sram_size);
 #endif
 
-    uint64_t * benchmark_uncompressed_data_by8 = (uint64_t *) benchmark_uncompressed_data;
-    uint64_t * result_area_by8 = (uint64_t *) write_region;
-    size_t bench_num_words = benchmark_uncompressed_data_len / 8;
-    size_t tail_start = bench_num_words * 8;
-
     bool fail = false;
-    bool first_fail = true;
 
-    for (size_t i = 0; i < bench_num_words; i++) {
-        if (benchmark_uncompressed_data_by8[i] != result_area_by8[i]) {
-            printf("FAIL: mismatch on word %" PRIu64 ": expected: 0x%016" PRIx64 ", got: 0x%016" PRIx64 "\n", i, (uint64_t)((uint64_t)benchmark_uncompressed_data_by8[i]), (uint64_t)((uint64_t)result_area_by8[i]));
-            fail = true;
-            if (first_fail) {
-                printf("FAIL ON BENCHMARK! N: %d, name: %s, with histsram: %" PRIu64 "\n", benchno, bench_name, sram_size);
-                first_fail = false;
-                break;
-            }
-        }
-        if ((((i*8) % 10000000) == 0) && !fail) {
+    if (verify) {
 #ifdef DO_PRINT
-            printf("Good after %" PRIu64 " bytes\n", i*8);
+        printf("Checking uncompressed output correctness:\n");
 #endif
-
-        }
-    }
-
-    for (size_t i = tail_start; i < benchmark_uncompressed_data_len; i++) {
-        if (fail) {
-            break;
-        }
-        if (benchmark_uncompressed_data[i] != write_region[i]) {
+        if (!BenchVerifyOutput((unsigned char *) write_region, (unsigned char *) benchmark_uncompressed_data,
+                               benchmark_uncompressed_data_len, benchmark_uncompressed_hash, bench_name)) {
+            printf("FAIL ON BENCHMARK! N: %d, name: %s, with histsram: %" PRIu64 "\n", benchno, bench_name, sram_size);
             fail = true;
-            if (first_fail) {
-                printf("FAIL ON BENCHMARK! N: %d, name: %s, with histsram: %" PRIu64 "\n", benchno, bench_name, sram_size);
-                first_fail = false;
-            }
-            printf("FAIL: mismatch on char %" PRIu64 ": expected: 0x%02x, got: 0x%02x\n", i, (uint32_t)((uint8_t)benchmark_uncompressed_data[i]), (uint32_t)((uint8_t)write_region[i]));
-
-
-        }
-        if (((i % 100000) == 0) && !fail) {
-#ifdef DO_PRINT
-            printf("Good after %" PRIu64 " bytes\n", i);
-#endif
-
         }
     }
 
@@ -133,97 +330,233 @@ bool zstd_run_benchmark(char * benchmark_compressed_data, size_t benchmark_compr
         *total_cycles_taken += (t2 - t1);
         *num_bench_pass += 1;
     }
+    *call_cycles = fail ? BENCH_REPORT_NO_SAMPLE : (t2 - t1);
 
     return fail;
 }
-void run_zstd(){
-    size_t total_benchmarks_uncompressed_size = 0;
+
+// One pass over every benchmark, fail set on mismatch. call_cycles gets
+// each benchmark's cycles.
+static void run_zstd_pass(unsigned char * result_area, unsigned char * workspace_area,
+        uint64_t sram_size, bool verify, uint64_t generation, bool * fail,
+        size_t * total_data_uncompressed_processed, size_t * total_data_compressed_processed,
+        uint64_t * total_cycles_taken, size_t * num_bench_passed, uint64_t * call_cycles) {
+    unsigned char * result_area2 = result_area;
     for (unsigned int i = 0; i < num_benchmarks; i++) {
+        if(zstd_run_benchmark((benchmark_compressed_data_arrays[i]), *(benchmark_compressed_data_len_array[i]),
+            result_area2, (benchmark_uncompressed_data_arrays[i]), *(benchmark_uncompressed_data_len_array[i]),
+            benchmark_uncompressed_hash_array[i],
+            *(benchmark_names[i]), i, sram_size, workspace_area, total_data_uncompressed_processed, total_data_compressed_processed, total_cycles_taken, num_bench_passed,
+            &call_cycles[i], verify, generation)) {
+            *fail = true;
+        }
         size_t this_bench_size = *(benchmark_uncompressed_data_len_array[i]);
         this_bench_size = ((this_bench_size / 32) + 1) * 32;
-        total_benchmarks_uncompressed_size += this_bench_size;
-    }
 
-    // ensure at least one page
-    total_benchmarks_uncompressed_size += 4096;
+        result_area2 += this_bench_size;
+    }
+}
 
-    unsigned int num_sram_sizes = 6; //8
-    uint64_t sram_sizes[] = {
+// One record per log2 uncompressed size bucket with benchmarks in it.
+// samples gets the bucket's call cycles, scratch is for BenchReportDist.
+static void report_zstd_buckets(const decompress_sweep_t * sweep, const decompress_placement_t * placement,
+        uint64_t sram_size, const uint64_t * call_cycles, uint64_t * samples, uint64_t * scratch) {
+    unsigned int num_reps = sweep->num_reps;
+    for (unsigned int bucket = 0; bucket < BENCH_REPORT_NUM_BUCKETS; bucket++) {
+        unsigned int calls = 0;
+        uint64_t uncomp_bytes = 0;
+        uint64_t comp_bytes = 0;
+        size_t num_samples = 0;
+        uint64_t timed_uncomp_bytes = 0;
+        uint64_t timed_cycles = 0;
+        for (unsigned int i = 0; i < num_benchmarks; i++) {
+            unsigned int uncomp_len = *(benchmark_uncompressed_data_len_array[i]);
+            if (BenchReportSizeBucket(uncomp_len) != bucket) {
+                continue;
+            }
+            calls++;
+            uncomp_bytes += uncomp_len;
+            comp_bytes += *(benchmark_compressed_data_len_array[i]);
+            for (unsigned int rep = 0; rep < num_reps; rep++) {
+                uint64_t cycles = call_cycles[(size_t)rep * num_benchmarks + i];
+                samples[num_samples++] = cycles;
+                if (cycles != BENCH_REPORT_NO_SAMPLE) {
+                    timed_uncomp_bytes += uncomp_len;
+                    timed_cycles += cycles;
+                }
+            }
+        }
+        if (calls == 0) {
+            continue;
+        }
 
-        // 64 << 10, // warmup
-        // 64 << 10, // warmup
+        bench_dist_t dist;
+        BenchReportDist(samples, num_samples, 1, scratch, &dist);
+
+        printf("{\"schema\":\"" BENCH_REPORT_BUCKET_SCHEMA "\",\"placement\":");
+        BenchReportPrintString(placement->label);
+        printf(",\"hist\":%" PRIu64 ",\"bucket\":%u,\"calls\":%u,\"reps\":%u,\"failed\":%" PRIu64
+               ",\"uncomp_bytes\":%" PRIu64 ",\"comp_bytes\":%" PRIu64
+               ",\"timed_calls\":%" PRIu64 ",\"timed_uncomp_bytes\":%" PRIu64 ",\"timed_cycles\":%" PRIu64,
+               sram_size, bucket, calls, num_reps, (uint64_t)num_samples - dist.count,
+               uncomp_bytes, comp_bytes, dist.count, timed_uncomp_bytes, timed_cycles);
+        BenchReportPrintDist("call_cycles", &dist, true);
+        printf("}\n");
+    }
+}
 
-        64 << 10,
-        32 << 10,
-        16 << 10,
-        8 << 10,
-        4 << 10,
-        2 << 10
-    };
+// call_cycles is num_reps rows of num_benchmarks, rep_cycles the per-rep
+// totals. samples and scratch hold num_reps * num_benchmarks entries.
+static void report_zstd(const decompress_sweep_t * sweep, const decompress_placement_t * placement,
+        uint64_t sram_size, const uint64_t * call_cycles, const uint64_t * rep_cycles,
+        uint64_t * samples, uint64_t * scratch) {
+    unsigned int num_reps = sweep->num_reps;
+    uint64_t uncomp_bytes = 0;
+    uint64_t comp_bytes = 0;
+    for (unsigned int i = 0; i < num_benchmarks; i++) {
+        uncomp_bytes += *(benchmark_uncompressed_data_len_array[i]);
+        comp_bytes += *(benchmark_compressed_data_len_array[i]);
+    }
 
+    bench_dist_t totals, calls;
+    BenchReportDist(rep_cycles, num_reps, 1, scratch, &totals);
+    BenchReportDist(call_cycles, (size_t)num_reps * num_benchmarks, 1, scratch, &calls);
 
-    bool is_warmup[] = {
+    printf("{\"schema\":\"" BENCH_REPORT_SUMMARY_SCHEMA "\",\"placement\":");
+    BenchReportPrintString(placement->label);
+    printf(",\"hist\":%" PRIu64 ",\"calls\":%u,\"reps\":%u,\"failed\":%" PRIu64
+           ",\"uncomp_bytes\":%" PRIu64 ",\"comp_bytes\":%" PRIu64,
+           sram_size, num_benchmarks, num_reps, (uint64_t)num_reps * num_benchmarks - calls.count,
+           uncomp_bytes, comp_bytes);
+    BenchReportPrintDist("total_cycles", &totals, false);
+    BenchReportPrintDist("call_cycles", &calls, true);
+    printf("}\n");
 
-        // true, // warmup
-        // true, // warmup
+    report_zstd_buckets(sweep, placement, sram_size, call_cycles, samples, scratch);
 
-        false,
-        false,
-        false,
-        false,
-        false,
-        false
-    };
+    if (sweep->records != SWEEP_RECORDS_CALLS) {
+        return;
+    }
+    for (unsigned int i = 0; i < num_benchmarks; i++) {
+        bench_dist_t bench;
+        BenchReportDist(&call_cycles[i], num_reps, num_benchmarks, scratch, &bench);
+
+        printf("{\"schema\":\"" BENCH_REPORT_CALL_SCHEMA "\",\"placement\":");
+        BenchReportPrintString(placement->label);
+        printf(",\"hist\":%" PRIu64 ",\"bench\":", sram_size);
+        BenchReportPrintString(*(benchmark_names[i]));
+        printf(",\"benchno\":%u,\"uncomp_bytes\":%u,\"comp_bytes\":%u,\"reps\":%u,\"failed\":%" PRIu64,
+               i, *(benchmark_uncompressed_data_len_array[i]), *(benchmark_compressed_data_len_array[i]),
+               num_reps, (uint64_t)num_reps - bench.count);
+        BenchReportPrintDist("cycles", &bench, true);
+        printf("}\n");
+    }
+}
 
+void run_zstd(const decompress_sweep_t * sweep){
+    size_t total_benchmarks_uncompressed_size = 0;
+    for (unsigned int i = 0; i < num_benchmarks; i++) {
+        size_t this_bench_size = *(benchmark_uncompressed_data_len_array[i]);
+        this_bench_size = ((this_bench_size / 32) + 1) * 32;
+        total_benchmarks_uncompressed_size += this_bench_size;
+    }
 
+    // ensure at least one page
+    total_benchmarks_uncompressed_size += 4096;
 
 #ifdef DO_PRINT
     printf("Setting up...\n");
 #endif
 
-    unsigned char * result_area = ZStdDecompressAccelSetup(total_benchmarks_uncompressed_size, sram_sizes[0]);
+    unsigned char * result_area = ZStdDecompressAccelSetup(total_benchmarks_uncompressed_size, sweep->sram_sizes[0]);
     unsigned char * workspace_area = ZStdDecompressWorkspaceSetup(total_benchmarks_uncompressed_size);
 
-    DecompressSetLatencyInjection(latency_injection_cycles, has_intermediate_cache);
+    // samples of one (placement, hist SRAM size) pair, for the records
+    size_t num_samples = (size_t)sweep->num_reps * num_benchmarks;
+    uint64_t * call_cycles = (uint64_t *) malloc((num_samples + sweep->num_reps) * sizeof(uint64_t) + 1);
+    uint64_t * rep_cycles = call_cycles + num_samples;
+    uint64_t * scratch = (uint64_t *) malloc((num_samples + sweep->num_reps) * sizeof(uint64_t) + 1);
+    uint64_t * bucket_samples = (uint64_t *) malloc(num_samples * sizeof(uint64_t) + 1);
+    if ((call_cycles == NULL) || (scratch == NULL) || (bucket_samples == NULL)) {
+        printf("FAIL: could not allocate %" PRIu64 " cycle samples\n", (uint64_t)num_samples);
+        exit(1);
+    }
+
+    // the accelerator's cost depends on the placement, so each gets its own
+    // crossover
+    int placement_routes[MAX_SWEEP_PLACEMENTS];
+    if (sweep->route) {
+        for (unsigned int p = 0; p < sweep->num_placements; p++) {
+            char route_name[ACCEL_ROUTER_NAME_LEN];
+            snprintf(route_name, sizeof(route_name), "zstd-uncompress-%s", sweep->placements[p]->name);
+            placement_routes[p] = AccelRouterAddRoute(route_name,
+                                                      ZStdAccelUncompressCodec, workspace_area,
+                                                      ZstdCpuUncompressCodec, NULL,
+                                                      NULL, NULL);
+        }
+        AccelRouterLoadProfile(ROUTER_PROFILE_PATH);
+    }
 
     bool fail = false;
-    uint64_t benchmark_sum_overall = 0;
+    unsigned int pass = 0;
+
+    for (unsigned int p = 0; p < sweep->num_placements; p++) {
+        const decompress_placement_t * placement = sweep->placements[p];
+        DecompressSetLatencyInjection(placement->latency_injection_cycles, placement->has_intermediate_cache);
+
+        if (sweep->route) {
+            uncompress_route = placement_routes[p];
+            if (!AccelRouterGetRoute(uncompress_route)->calibrated) {
+                ZStdDecompressSetDynamicHistSize(sweep->sram_sizes[0]);
+                calibrate_zstd_route(uncompress_route, result_area, total_benchmarks_uncompressed_size);
+                AccelRouterSaveProfile(ROUTER_PROFILE_PATH);
+            }
+        }
 
-    for (unsigned int j = 0; j < num_sram_sizes; j++) {
-        ZStdDecompressSetDynamicHistSize(sram_sizes[j]);
+        for (unsigned int j = 0; j < sweep->num_warmups + sweep->num_sram_sizes; j++) {
+            bool is_warmup = j < sweep->num_warmups;
+            uint64_t sram_size = is_warmup ? sweep->sram_sizes[0] : sweep->sram_sizes[j - sweep->num_warmups];
+            ZStdDecompressSetDynamicHistSize(sram_size);
 #ifdef DO_PRINT
-        printf("Using SRAM size: %" PRIu64 "\n", sram_sizes[j]);
+            printf("Using placement %s, SRAM size: %" PRIu64 "\n", placement->label, sram_size);
 #endif
 
-        size_t total_data_uncompressed_processed = 0;
-        size_t total_data_compressed_processed = 0;
-        uint64_t total_cycles_taken = 0;
-        size_t num_bench_passed = 0;
-
-        // offset write region on each iter to make sure first iter's correct
-        // results don't count for later iters
-        unsigned char * result_area2 = result_area + (j * 32);
-        for (unsigned int i = 0; i < num_benchmarks; i++) {
-            if(zstd_run_benchmark((benchmark_compressed_data_arrays[i]), *(benchmark_compressed_data_len_array[i]),
-                result_area2, (benchmark_uncompressed_data_arrays[i]), *(benchmark_uncompressed_data_len_array[i]),
-                *(benchmark_names[i]), i, sram_sizes[j], workspace_area, &total_data_uncompressed_processed, &total_data_compressed_processed, &total_cycles_taken, &num_bench_passed,
-                &benchmark_sum_overall)) {
-                fail = true;
+            unsigned int num_reps = is_warmup ? 1 : sweep->num_reps;
+            for (unsigned int rep = 0; rep < num_reps; rep++, pass++) {
+                size_t total_data_uncompressed_processed = 0;
+                size_t total_data_compressed_processed = 0;
+                uint64_t total_cycles_taken = 0;
+                size_t num_bench_passed = 0;
+
+                // offset write region on each pass to make sure earlier passes'
+                // correct results don't count for later ones (the page of
+                // slack above bounds the offset)
+                run_zstd_pass(result_area + ((pass % 128) * 32), workspace_area,
+                              sram_size, sweep->verify, pass, &fail,
+                              &total_data_uncompressed_processed, &total_data_compressed_processed,
+                              &total_cycles_taken, &num_bench_passed,
+                              &call_cycles[(size_t)rep * num_benchmarks]);
+                rep_cycles[rep] = total_cycles_taken;
+
+                if (!is_warmup) {
+                    printf("TOTAL: Took %" PRIu64 " cycles produced %" PRIu64 " uncompressed bytes comp size %" PRIu64 " bytes SuccessNBenchmarks %d TotalNBenchmarks %d with histsram %" PRIu64 " placement %s rep %u\n", total_cycles_taken, total_data_uncompressed_processed, total_data_compressed_processed, num_bench_passed, num_benchmarks, sram_size, placement->label, rep);
+                }
             }
-            size_t this_bench_size = *(benchmark_uncompressed_data_len_array[i]);
-            this_bench_size = ((this_bench_size / 32) + 1) * 32;
 
-            result_area2 += this_bench_size;
+            if (!is_warmup && (sweep->records != SWEEP_RECORDS_NONE)) {
+                report_zstd(sweep, placement, sram_size, call_cycles, rep_cycles, bucket_samples, scratch);
+            }
         }
+    }
 
-        if (!is_warmup[j]) {
-            printf("TOTAL: Took %" PRIu64 " cycles produced %" PRIu64 " uncompressed bytes comp size %" PRIu64 " bytes SuccessNBenchmarks %d TotalNBenchmarks %d with histsram %" PRIu64 "\n", total_cycles_taken, total_data_uncompressed_processed, total_data_compressed_processed, num_bench_passed, num_benchmarks, sram_sizes[j]);
-        }
+    free(call_cycles);
+    free(scratch);
+    free(bucket_samples);
 
+    if (sweep->route) {
+        AccelRouterPrintStats();
     }
 
-    printf("FINAL: Benchmark sum: %" PRIu64 "\n", benchmark_sum_overall);
-
     if (fail) {
         printf("TEST FAILED!\n");
         exit(1);
@@ -233,8 +566,11 @@ void run_zstd(){
 }
 
 ///////////////////////////////////////////////////////////////
-int main() {
-    run_zstd();
-    // run_snappy();
+int main(int argc, char ** argv) {
+    decompress_sweep_t sweep;
+    SweepConfigure(&sweep, argc, argv);
+#ifdef BENCH_CORPUS
+    BenchCorpusLoad(sweep.corpus_path, sweep.corpus_manifest, sweep.corpus_shard, sweep.corpus_num_shards);
+#endif
+    run_zstd(&sweep);
 }
-
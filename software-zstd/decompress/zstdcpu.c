@@ -0,0 +1,13 @@
+#include <stdio.h>
+#include "zstdcpu.h"
+
+#define ZDEC_NO_PRINT
+#include "zstd_decompress.c"
+
+uint64_t ZstdCpuUncompressCodec(const unsigned char* src,
+                                size_t src_len,
+                                unsigned char* dst,
+                                size_t dst_capacity,
+                                void* ctx) {
+    return (uint64_t)ZSTD_decompress(dst, dst_capacity, src, src_len);
+}
@@ -0,0 +1,19 @@
+#ifndef __ZSTD_CPU_H
+#define __ZSTD_CPU_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// The in-tree reference decoder (software-zstd/compress/zstd_decompress.c,
+// which build-decompress-bench.sh copies next to this file) as the CPU side
+// of the accelerator router. Its trace printfs are compiled out.
+
+// accel_codec_fn adapter for accelrouter.h. Returns the decompressed size;
+// the reference decoder exits on a malformed frame.
+uint64_t ZstdCpuUncompressCodec(const unsigned char* src,
+                                size_t src_len,
+                                unsigned char* dst,
+                                size_t dst_capacity,
+                                void* ctx);
+
+#endif //__ZSTD_CPU_H
@@ -22,6 +22,10 @@ for directory in all_result_directories:
         final_dir_map["Spec32"].append(results_basedir + directory)
     elif directory.endswith("-ZSTD-DECOMPRESS-SPEC4"):
         final_dir_map["Spec4"].append(results_basedir + directory)
+    elif directory.endswith("-ZSTD-DECOMPRESS-SWEEP"):
+        # one run covers every placement, TOTAL lines carry the placement
+        for conf in ["RoCC", "Spec16", "Chiplet", "PCIeLocalCache", "PCIeNoCache"]:
+            final_dir_map[conf].append(results_basedir + directory)
 
 
 config_order = [
@@ -49,8 +53,14 @@ area_cached = {
     2**11: 1.736
 }
 
+# TOTAL line placement tag of each config, for sweep runs
+sweep_placement = {
+    "Spec16": "RoCC",
+}
+
 def collect_data_for_dir(directories, placement):
     inputdirs = directories
+    line_placement = sweep_placement.get(placement, placement)
 
     all_files = []
     if placement == 'Spec32':
@@ -76,6 +86,7 @@ def collect_data_for_dir(directories, placement):
                 sram = None
                 cycles = None
                 dataproc = None
+                tagged_placement = line_placement
                 for ind, val in enumerate(l):
                     if val == "histsram":
                         sram = int(l[ind+1])
@@ -83,6 +94,11 @@ def collect_data_for_dir(directories, placement):
                         cycles = int(l[ind+1])
                     if val == "produced":
                         dataproc = int(l[ind+1])
+                    if val == "placement":
+                        tagged_placement = l[ind+1]
+
+                if tagged_placement != line_placement:
+                    continue
 
                 cycles_by_sram_size[sram] += cycles
                 data_by_sram_size[sram] += dataproc
@@ -19,6 +19,15 @@ class StreamInfo extends Bundle {
   val isize = UInt(64.W)
 }
 
+class GatherStreamInfo extends StreamInfo {
+  val more_segments = Bool()
+}
+
+class DictStreamInfo extends StreamInfo {
+  val dict_size = UInt(64.W)
+  val dict_resident = Bool()
+}
+
 class DstInfo extends Bundle {
   val op = UInt(64.W)
   val cmpflag = UInt(64.W)
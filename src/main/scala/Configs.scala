@@ -37,6 +37,10 @@ case object CompressAccelPrintfEnable extends Field[Boolean](false)
 case object CompressAccelLatencyInjectEnable extends Field[Boolean](false)
 case object CompressAccelLatencyInjectCycles extends Field[Integer](400)
 case object CompressAccelFarAccelLocalCache extends Field[Boolean](false)
+// Print a WRITE_BYTE line per byte written by the memwriters built with
+// printWriteBytes. Harnesses that dump their outputs (benchdump.h) don't need
+// them, and the printfs dominate log size and simulation time.
+case object CompressAccelWriteByteLog extends Field[Boolean](true)
 
 
 
@@ -379,3 +383,7 @@ class WithCompressAccelPrintf extends Config((site, here, up) => {
   case CompressAccelPrintfEnable => true
 })
 
+class WithoutCompressAccelWriteByteLog extends Config((site, here, up) => {
+  case CompressAccelWriteByteLog => false
+})
+
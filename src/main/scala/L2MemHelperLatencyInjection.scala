@@ -37,6 +37,8 @@ class L2MemHelperLatencyInjectionModule(outer: L2MemHelperLatencyInjection, prin
     val sfence = Input(Bool())
     val ptw = new TLBPTWIO
     val status = Flipped(Valid(new MStatus))
+
+    val perf = Output(new L2MemHelperPerf)
   })
 
   val (dmem, edge) = outer.masterNode.out.head
@@ -127,6 +129,12 @@ class L2MemHelperLatencyInjectionModule(outer: L2MemHelperLatencyInjection, prin
 
   io.userif.no_memops_inflight := global_memop_accepted === global_memop_ackd
 
+  val perf_inflight_cycles = RegInit(0.U(64.W))
+  perf_inflight_cycles := perf_inflight_cycles + (global_memop_accepted - global_memop_ackd)
+  io.perf.reqs := global_memop_accepted
+  io.perf.acks := global_memop_ackd
+  io.perf.inflight_cycles := perf_inflight_cycles
+
   val free_outstanding_op_slots = (global_memop_sent - global_memop_ackd) < (1 << outer.tlTagBits).U
   val assert_free_outstanding_op_slots = (global_memop_sent - global_memop_ackd) <= (1 << outer.tlTagBits).U
 
@@ -229,7 +237,7 @@ class L2MemHelperLatencyInjectionModule(outer: L2MemHelperLatencyInjection, prin
         global_memop_sent,
         sendtag)
 
-      if (printWriteBytes) {
+      if (printWriteBytes && p(CompressAccelWriteByteLog)) {
         for (i <- 0 until 32) {
           when (i.U < (1.U << request_input.bits.size)) {
             CompressAccelLogger.logInfo("WRITE_BYTE ADDR: 0x%x BYTE: 0x%x " + printInfo + "\n", request_input.bits.addr + i.U, (request_input.bits.data >> (i*8).U)(7, 0))
@@ -24,6 +24,8 @@ class HashTableReadResult extends Bundle {
   // then, you can easily figure out whether the match is too far away
   // without having to check the buf
   val absolute_addr_output_val = UInt(64.W)
+  // distance back in the history buffer to the matched bytes
+  val offset = UInt(64.W)
   // result addr is in range and table value matches
   val has_match = Bool()
 }
@@ -40,6 +42,12 @@ class HashTableBasic(numEntriesLog2HW: Int = 14)(implicit p: Parameters) extends
     val write_req = Flipped(Valid(new HashTableWriteRequest))
     val MAX_OFFSET_ALLOWED = Input(UInt(64.W))
     val RUNTIME_HT_NUM_ENTRIES_LOG2 = Input(UInt(5.W))
+    // resident dictionary at [0, DICT_END), current input from INPUT_BASE.
+    // entries in between are earlier inputs under the same request id and
+    // never match; a dictionary entry's offset skips that gap.
+    val DICT_END = Input(UInt(48.W))
+    val INPUT_BASE = Input(UInt(48.W))
+    val DICT_VISIBLE = Input(Bool())
   })
 
   val numEntriesHW = 1 << numEntriesLog2HW
@@ -64,9 +72,13 @@ class HashTableBasic(numEntriesLog2HW: Int = 14)(implicit p: Parameters) extends
 
   val result_identical = (read_data >> 32) === last_cycle_read_current_absolute_addr
   val MAX_OFFSET_ALLOWED = io.MAX_OFFSET_ALLOWED
-  val result_diff = (last_cycle_read_current_absolute_addr - (read_data >> 32))
+  val result_addr_in_request = (read_data >> 32)(47, 0)
+  val result_in_dict = result_addr_in_request < io.DICT_END
+  val result_stale = Mux(result_in_dict, !io.DICT_VISIBLE, result_addr_in_request < io.INPUT_BASE)
+  val result_diff = (last_cycle_read_current_absolute_addr - (read_data >> 32)) - Mux(result_in_dict, io.INPUT_BASE - io.DICT_END, 0.U)
   val result_too_large =  result_diff > MAX_OFFSET_ALLOWED
-  io.read_resp.has_match := ((read_data & BigInt("FFFFFFFF", 16).U((64+32).W)) === last_cycle_read_unhashed_input_key) && ((read_data >> 80) === (last_cycle_read_current_absolute_addr >> 48)) && (!result_identical) && (!result_too_large)
+  io.read_resp.offset := result_diff
+  io.read_resp.has_match := ((read_data & BigInt("FFFFFFFF", 16).U((64+32).W)) === last_cycle_read_unhashed_input_key) && ((read_data >> 80) === (last_cycle_read_current_absolute_addr >> 48)) && (!result_identical) && (!result_too_large) && (!result_stale)
 
   when (((read_data & BigInt("FFFFFFFF", 16).U((64+32).W)) === last_cycle_read_unhashed_input_key) && ((read_data >> 80) === (last_cycle_read_current_absolute_addr >> 48))) {
     when (result_identical) {
@@ -135,6 +147,13 @@ class LZ77HashMatcher()(implicit p: Parameters) extends Module {
     val memloader_optional_hbsram_in = Flipped(Valid(new HBSRAMWrite))
     // for each request, we need to be provided with the total input len
     val src_info = Flipped(Decoupled(new StreamInfo))
+    // the first src_info_dict_size bytes of the stream are a dictionary:
+    // they go into the hash table and history but produce no output
+    val src_info_dict_size = Input(UInt(64.W))
+    // the hash table still holds the dictionary indexed for an earlier call
+    // (or this call has none and should keep it): the dictionary bytes only
+    // refill the history, 32 per cycle
+    val src_info_dict_resident = Input(Bool())
 
     val memwrites_out = Decoupled(new CompressWriterBundle)
     val MAX_OFFSET_ALLOWED = Input(UInt(64.W))
@@ -167,9 +186,28 @@ class LZ77HashMatcher()(implicit p: Parameters) extends Module {
   // this will be reset to zero every time we start a new input buffer to compress
   val absolute_address_base = RegInit(0.U(48.W))
 
-  val absolute_internal_address = Cat(rotating_request_id, absolute_address_base)
+  // dictionary and input share a request id, so matches in the input can
+  // reach back into the dictionary
+  val priming = absolute_address_base < io.src_info_dict_size
 
-  history_buffer.io.read_req_in.bits.offset := absolute_internal_address - hash_table.io.read_resp.absolute_addr_output_val
+  // calls that keep a resident dictionary keep the request id: the
+  // dictionary is indexed at [0, dict_end) and each call's input is placed
+  // after the previous one's, from input_base, so the hash table can tell
+  // earlier inputs' entries from dictionary ones
+  val dict_end = RegInit(0.U(48.W))
+  val input_base = RegInit(0.U(48.W))
+  val next_input_base = RegInit(0.U(48.W))
+  val dict_visible = RegInit(false.B)
+  val dict_indexed = RegInit(false.B)
+
+  val absolute_internal_address = Cat(rotating_request_id,
+    Mux(priming, absolute_address_base, absolute_address_base - io.src_info_dict_size(47, 0) + input_base))
+
+  hash_table.io.DICT_END := dict_end
+  hash_table.io.INPUT_BASE := input_base
+  hash_table.io.DICT_VISIBLE := dict_visible
+
+  history_buffer.io.read_req_in.bits.offset := hash_table.io.read_resp.offset
 
 
   val NUM_BITS_FOR_STATES = 2
@@ -236,7 +274,7 @@ class LZ77HashMatcher()(implicit p: Parameters) extends Module {
   // end of message addr reg management
   when (io.memloader_in.output_last_chunk && (io.memloader_in.available_output_bytes === io.memloader_in.user_consumed_bytes) && io.memloader_in.output_valid && io.memloader_in.output_ready) {
     // end of buffer condition
-    rotating_request_id := rotating_request_id + 1.U
+    next_input_base := input_base + io.src_info.bits.isize
     absolute_address_base := 0.U
     io.src_info.ready := true.B
   }
@@ -262,12 +300,60 @@ class LZ77HashMatcher()(implicit p: Parameters) extends Module {
       io.memwrites_out.bits.length_header := true.B
 
       when (io.memwrites_out.ready && io.src_info.valid) {
-        CompressAccelLogger.logCritical("Write header for rqid: %d\n", rotating_request_id)
+        // the id this call's addresses use
+        CompressAccelLogger.logCritical("Write header for rqid: %d\n",
+          Mux(io.src_info_dict_resident, rotating_request_id, rotating_request_id + 1.U))
         compressorState := sClockInHTRead
+
+        dict_visible := io.src_info_dict_size =/= 0.U
+        when (io.src_info_dict_resident) {
+          input_base := next_input_base
+          dict_indexed := true.B
+        } .otherwise {
+          // new request id: nothing in the table matches any more
+          rotating_request_id := rotating_request_id + 1.U
+          dict_end := io.src_info_dict_size
+          input_base := io.src_info_dict_size
+          dict_indexed := false.B
+        }
       }
     }
     is (sClockInHTRead) {
-      when (io.memloader_in.output_last_chunk && (io.memloader_in.available_output_bytes < 4.U)) {
+      when (priming && dict_indexed) {
+        // dictionary already in the hash table: only the history needs it.
+        // stops at the end of the dictionary, the input always follows.
+        val dict_bytes_left = io.src_info_dict_size - absolute_address_base
+        val dict_bytes_now = Mux(dict_bytes_left < io.memloader_in.available_output_bytes,
+          dict_bytes_left(5, 0),
+          io.memloader_in.available_output_bytes)
+
+        io.memloader_in.output_ready := true.B
+        io.memloader_in.user_consumed_bytes := dict_bytes_now
+
+        history_buffer.io.read_advance_ptr.bits.advance_bytes := dict_bytes_now
+
+        when (io.memloader_in.output_valid) {
+          history_buffer.io.read_advance_ptr.valid := true.B
+          absolute_address_base := absolute_address_base + dict_bytes_now
+        }
+      } .elsewhen (priming) {
+        // dictionary prefix: index every position, one byte per cycle. the
+        // input always follows, so this never consumes the last chunk.
+        io.memloader_in.output_ready := true.B
+        io.memloader_in.user_consumed_bytes := 1.U
+
+        history_buffer.io.read_advance_ptr.bits.advance_bytes := 1.U
+
+        hash_table.io.write_req.bits.unhashed_input_key := io.memloader_in.output_data(31, 0)
+        hash_table.io.write_req.bits.absolute_addr_input_val := absolute_internal_address
+
+        when (io.memloader_in.output_valid) {
+          history_buffer.io.read_advance_ptr.valid := true.B
+          // fewer than 4 bytes buffered: no full key, skip the insert
+          hash_table.io.write_req.valid := io.memloader_in.available_output_bytes >= 4.U
+          absolute_address_base := absolute_address_base + 1.U
+        }
+      } .elsewhen (io.memloader_in.output_last_chunk && (io.memloader_in.available_output_bytes < 4.U)) {
         // fewer than 3 bytes are remaining, end of buffer
         io.memloader_in.output_ready := io.memwrites_out.ready
         io.memloader_in.user_consumed_bytes := io.memloader_in.available_output_bytes
@@ -314,8 +400,8 @@ class LZ77HashMatcher()(implicit p: Parameters) extends Module {
         // TODO(perf improvement): make the next stage start reading hist buf
         // at +4 instead of +0
         skip_amt := 32.U
-        in_progress_offset := absolute_internal_address - hash_table.io.read_resp.absolute_addr_output_val
-        when ((absolute_internal_address - hash_table.io.read_resp.absolute_addr_output_val) === 0.U) {
+        in_progress_offset := hash_table.io.read_resp.offset
+        when (hash_table.io.read_resp.offset === 0.U) {
           CompressAccelLogger.logInfo("ERROR: got zero offset. absolute_internal_addres: 0x%x, hash_table_result: 0x%x\n",
             absolute_internal_address,
             hash_table.io.read_resp.absolute_addr_output_val
@@ -21,6 +21,13 @@ class LZ77HashMatcherMemLoader()(implicit p: Parameters) extends Module
     val l2helperUser = new L2MemHelperBundle
 
     val src_info = Flipped(Decoupled(new StreamInfo))
+    // src_info is a non-final segment of a gathered input: its bytes are
+    // streamed out back to back with the next segment's, as one buffer
+    val src_info_more_segments = Input(Bool())
+    // one per input, the length of the whole buffer: taken with the first
+    // load of its first segment, so the consumer can drain leading segments
+    // while later ones are still loading
+    val src_info_total = Flipped(Decoupled(UInt(64.W)))
 
     val consumer = new MemLoaderConsumerBundle
 
@@ -66,19 +73,27 @@ class LZ77HashMatcherMemLoader()(implicit p: Parameters) extends Module
     CompressAccelLogger.logInfo("COMPLETED INPUT LOAD FOR DECOMPRESSION\n")
   }
 
+  val addrinc = RegInit(0.U(64.W))
+
+  val gather_first_segment = RegInit(true.B)
+  when (io.src_info.fire) {
+    gather_first_segment := !io.src_info_more_segments
+  }
+  val opens_buf = gather_first_segment && (addrinc === 0.U)
+  val total_known = !opens_buf || io.src_info_total.valid
+
   val request_fire = DecoupledHelper(
     io.l2helperUser.req.ready,
     io.src_info.valid,
     buf_info_queue.io.enq.ready,
-    load_info_queue.io.enq.ready
+    load_info_queue.io.enq.ready,
+    total_known
   )
 
   io.l2helperUser.req.bits.cmd := M_XRD
   io.l2helperUser.req.bits.size := log2Ceil(32).U
   io.l2helperUser.req.bits.data := 0.U
 
-  val addrinc = RegInit(0.U(64.W))
-
   load_info_queue.io.enq.bits.start_byte := Mux(addrinc === 0.U, base_addr_start_index, 0.U)
   load_info_queue.io.enq.bits.end_byte := Mux(addrinc === words_to_load_minus_one, base_addr_end_index_inclusive, 31.U)
 
@@ -93,10 +108,12 @@ class LZ77HashMatcherMemLoader()(implicit p: Parameters) extends Module
                                             addrinc === words_to_load_minus_one)
 
   buf_info_queue.io.enq.valid := request_fire.fire(buf_info_queue.io.enq.ready,
-                                            addrinc === 0.U)
+                                            opens_buf)
+  io.src_info_total.ready := request_fire.fire(total_known,
+                                            opens_buf)
   load_info_queue.io.enq.valid := request_fire.fire(load_info_queue.io.enq.ready)
 
-  buf_info_queue.io.enq.bits.len_bytes := base_len
+  buf_info_queue.io.enq.bits.len_bytes := io.src_info_total.bits
 
   io.l2helperUser.req.bits.addr := (base_addr_bytes_aligned) + (addrinc << 5)
   io.l2helperUser.req.valid := request_fire.fire(io.l2helperUser.req.ready)
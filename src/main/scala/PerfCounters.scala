@@ -0,0 +1,117 @@
+package compressacc
+
+import chisel3._
+import chisel3.util._
+import chisel3.{Printable}
+import org.chipsalliance.cde.config._
+
+// Free-running performance counters, read out through each accelerator's
+// READ_PERF_COUNTER funct (rs1 = counter index). Software snapshots them
+// around a job and diffs, so none of them are ever cleared.
+
+class L2MemHelperPerf extends Bundle {
+  val reqs = UInt(64.W)            // requests accepted from the user
+  val acks = UInt(64.W)            // requests acked by the L2
+  val inflight_cycles = UInt(64.W) // sum over cycles of accepted-but-unacked requests
+}
+
+object L2MemHelperPerf {
+  def sum(perfs: Seq[L2MemHelperPerf]): L2MemHelperPerf = {
+    val total = Wire(new L2MemHelperPerf)
+    total.reqs := perfs.map(_.reqs).reduce(_ + _)
+    total.acks := perfs.map(_.acks).reduce(_ + _)
+    total.inflight_cycles := perfs.map(_.inflight_cycles).reduce(_ + _)
+    total
+  }
+}
+
+class HistoryLookupPerf extends Bundle {
+  val onchip_hits = UInt(64.W)    // copies served from on-chip history
+  val offchip_misses = UInt(64.W) // copies that had to read history back from memory
+}
+
+// Counts jobs, cycles with at least one job in flight, and cycles within
+// those where the unit is held up by memory (stall).
+class BusyStallCounter extends Module {
+  val io = IO(new Bundle {
+    val job_start = Input(Bool())
+    val job_done = Input(Bool())
+    val stall = Input(Bool())
+
+    val jobs = Output(UInt(64.W))
+    val busy_cycles = Output(UInt(64.W))
+    val stall_cycles = Output(UInt(64.W))
+  })
+
+  val inflight = RegInit(0.U(16.W))
+  inflight := inflight + io.job_start.asUInt - io.job_done.asUInt
+
+  val jobs = RegInit(0.U(64.W))
+  val busy_cycles = RegInit(0.U(64.W))
+  val stall_cycles = RegInit(0.U(64.W))
+
+  val busy = inflight =/= 0.U
+  when (io.job_start) {
+    jobs := jobs + 1.U
+  }
+  when (busy) {
+    busy_cycles := busy_cycles + 1.U
+  }
+  when (busy && io.stall) {
+    stall_cycles := stall_cycles + 1.U
+  }
+
+  io.jobs := jobs
+  io.busy_cycles := busy_cycles
+  io.stall_cycles := stall_cycles
+}
+
+object L2Stalled {
+  def apply(userifs: Seq[L2MemHelperBundle]): Bool = {
+    userifs.map(u => u.req.valid && !u.req.ready).reduce(_ || _)
+  }
+}
+
+object CompressorPerfCounters {
+  val MF_JOBS = 0
+  val MF_BUSY_CYCLES = 1
+  val MF_STALL_CYCLES = 2
+  val HUF_JOBS = 3
+  val HUF_BUSY_CYCLES = 4
+  val HUF_STALL_CYCLES = 5
+  val FSE_JOBS = 6
+  val FSE_BUSY_CYCLES = 7
+  val FSE_STALL_CYCLES = 8
+  val L2_REQS = 9
+  val L2_ACKS = 10
+  val L2_INFLIGHT_CYCLES = 11
+  val MF_L2_READ_REQS = 12
+  val MF_L2_READ_INFLIGHT_CYCLES = 13
+
+  val NUM_COUNTERS = 14
+}
+
+object DecompressorPerfCounters {
+  val HIST_ONCHIP_HITS = 0
+  val HIST_OFFCHIP_MISSES = 1
+  val L2_REQS = 2
+  val L2_ACKS = 3
+  val L2_INFLIGHT_CYCLES = 4
+  val HIST_L2_ACKS = 5
+  val HIST_L2_INFLIGHT_CYCLES = 6
+
+  val NUM_COUNTERS = 7
+
+  def apply(hist: HistoryLookupPerf, hist_l2: L2MemHelperPerf, all_l2: Seq[L2MemHelperPerf]): Vec[UInt] = {
+    val total_l2 = L2MemHelperPerf.sum(all_l2)
+    val counters = Wire(Vec(NUM_COUNTERS, UInt(64.W)))
+    counters(HIST_ONCHIP_HITS) := hist.onchip_hits
+    counters(HIST_OFFCHIP_MISSES) := hist.offchip_misses
+    counters(L2_REQS) := total_l2.reqs
+    counters(L2_ACKS) := total_l2.acks
+    counters(L2_INFLIGHT_CYCLES) := total_l2.inflight_cycles
+    counters(HIST_L2_ACKS) := hist_l2.acks
+    counters(HIST_L2_INFLIGHT_CYCLES) := hist_l2.inflight_cycles
+    counters
+  }
+}
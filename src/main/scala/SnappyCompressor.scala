@@ -54,6 +54,8 @@ with MemoryOpConstants {
   val memloader = Module(new LZ77HashMatcherMemLoader)
   outer.mem_comp_ireader.module.io.userif <> memloader.io.l2helperUser
   memloader.io.src_info <> cmd_router.io.compress_src_info
+  memloader.io.src_info_more_segments := cmd_router.io.compress_src_info_more_segments
+  memloader.io.src_info_total <> cmd_router.io.compress_src_info_total
 
   val lz77hashmatcher = Module(new LZ77HashMatcher)
   lz77hashmatcher.io.MAX_OFFSET_ALLOWED := cmd_router.io.MAX_OFFSET_ALLOWED
@@ -63,6 +65,8 @@ with MemoryOpConstants {
   lz77hashmatcher.io.memloader_in <> memloader.io.consumer
   lz77hashmatcher.io.memloader_optional_hbsram_in <> memloader.io.optional_hbsram_write
   lz77hashmatcher.io.src_info <> cmd_router.io.compress_src_info2
+  lz77hashmatcher.io.src_info_dict_size := 0.U
+  lz77hashmatcher.io.src_info_dict_resident := false.B
 
   when (lz77hashmatcher.io.memwrites_out.fire) {
     CompressAccelLogger.logInfo("LZ77-MEMWRITEFIRE: data: 0x%x, validbytes: %d, EOM: %d, is_copy: %d, length_header: %d\n",
@@ -104,6 +108,7 @@ with MemoryOpConstants {
   memwriter.io.memwrites_in <> compress_litlen_injector.io.memwrites_out
   outer.mem_comp_writer.module.io.userif <> memwriter.io.l2io
   memwriter.io.compress_dest_info <> cmd_router.io.compress_dest_info
+  memwriter.io.compress_dest_segment <> cmd_router.io.compress_dest_segment
   cmd_router.io.bufs_completed := memwriter.io.bufs_completed
   cmd_router.io.no_writes_inflight := memwriter.io.no_writes_inflight
 
@@ -14,6 +14,8 @@ import freechips.rocketchip.rocket.constants.MemoryOpConstants
 class SnappyCompressDestInfo extends Bundle {
   val op = UInt(64.W)
   val boolptr = UInt(64.W)
+  // DEST_SEGMENTs queued ahead of this call, filled before op
+  val num_segments = UInt(8.W)
 }
 
 class SnappyCompressorCommandRouter()(implicit p: Parameters) extends Module {
@@ -24,6 +26,13 @@ class SnappyCompressorCommandRouter()(implicit p: Parameters) extends Module {
   val FUNCT_CHECK_COMPLETION = 3.U
   val FUNCT_MAX_OFFSET_ALLOWED = 4.U
   val FUNCT_RUNTIME_HT_NUM_ENTRIES_LOG2 = 5.U
+  val FUNCT_SRC_SEGMENT = 6.U
+  val FUNCT_DEST_SEGMENT = 7.U
+
+  // most SRC_SEGMENTs + SRC_INFO (or DEST_SEGMENTs + DEST_INFO) in one call:
+  // a gathered input's segments must all fit in the queue, since the
+  // memloader only starts on it once SRC_INFO gives the total length
+  val GATHER_MAX_SEGMENTS = 16
 
 
   val io = IO(new Bundle{
@@ -34,9 +43,12 @@ class SnappyCompressorCommandRouter()(implicit p: Parameters) extends Module {
     val dmem_status_out = Valid(new RoCCCommand)
 
     val compress_src_info = Decoupled(new StreamInfo)
+    val compress_src_info_more_segments = Output(Bool())
+    val compress_src_info_total = Decoupled(UInt(64.W))
     val compress_src_info2 = Decoupled(new StreamInfo)
 
     val compress_dest_info = Decoupled(new SnappyCompressDestInfo)
+    val compress_dest_segment = Decoupled(new StreamInfo)
 
     val bufs_completed = Input(UInt(64.W))
     val no_writes_inflight = Input(Bool())
@@ -96,8 +108,17 @@ class SnappyCompressorCommandRouter()(implicit p: Parameters) extends Module {
     RUNTIME_HT_NUM_ENTRIES_LOG2 := io.rocc_in.bits.rs1
   }
 
-  val compress_src_info_queue = Module(new Queue(new StreamInfo, 4))
-  io.compress_src_info <> compress_src_info_queue.io.deq
+  // SRC_SEGMENT queues leading segments of a gathered input for the memloader
+  // only; the SRC_INFO that follows is the last segment and carries the job.
+  val compress_src_info_queue = Module(new Queue(new GatherStreamInfo, GATHER_MAX_SEGMENTS))
+  io.compress_src_info.valid := compress_src_info_queue.io.deq.valid
+  io.compress_src_info.bits.ip := compress_src_info_queue.io.deq.bits.ip
+  io.compress_src_info.bits.isize := compress_src_info_queue.io.deq.bits.isize
+  io.compress_src_info_more_segments := compress_src_info_queue.io.deq.bits.more_segments
+  compress_src_info_queue.io.deq.ready := io.compress_src_info.ready
+
+  val compress_src_info_total_queue = Module(new Queue(UInt(64.W), 4))
+  io.compress_src_info_total <> compress_src_info_total_queue.io.deq
 
   val compress_src_info_queue2 = Module(new Queue(new StreamInfo, 4))
   io.compress_src_info2 <> compress_src_info_queue2.io.deq
@@ -105,19 +126,41 @@ class SnappyCompressorCommandRouter()(implicit p: Parameters) extends Module {
   val compress_dest_info_queue = Module(new Queue(new SnappyCompressDestInfo, 4))
   io.compress_dest_info <> compress_dest_info_queue.io.deq
 
+  // DEST_SEGMENT queues leading output segments for the memwriter; the
+  // DEST_INFO that follows gives the region the rest of the output goes to.
+  val compress_dest_segment_queue = Module(new Queue(new StreamInfo, GATHER_MAX_SEGMENTS))
+  io.compress_dest_segment <> compress_dest_segment_queue.io.deq
+
   val compress_src_info_fire = DecoupledHelper(
     io.rocc_in.valid,
     compress_src_info_queue.io.enq.ready,
     compress_src_info_queue2.io.enq.ready,
+    compress_src_info_total_queue.io.enq.ready,
     current_funct === FUNCT_SRC_INFO
   )
 
+  val compress_src_segment_fire = DecoupledHelper(
+    io.rocc_in.valid,
+    compress_src_info_queue.io.enq.ready,
+    current_funct === FUNCT_SRC_SEGMENT
+  )
+
+  val gather_len_so_far = RegInit(0.U(64.W))
+  when (compress_src_segment_fire.fire) {
+    gather_len_so_far := gather_len_so_far + io.rocc_in.bits.rs2
+  } .elsewhen (compress_src_info_fire.fire) {
+    gather_len_so_far := 0.U
+  }
+
   compress_src_info_queue.io.enq.bits.ip := io.rocc_in.bits.rs1
   compress_src_info_queue.io.enq.bits.isize := io.rocc_in.bits.rs2
-  compress_src_info_queue.io.enq.valid := compress_src_info_fire.fire(compress_src_info_queue.io.enq.ready)
+  compress_src_info_queue.io.enq.bits.more_segments := current_funct === FUNCT_SRC_SEGMENT
+  compress_src_info_queue.io.enq.valid := compress_src_info_fire.fire(compress_src_info_queue.io.enq.ready) || compress_src_segment_fire.fire(compress_src_info_queue.io.enq.ready)
   compress_src_info_queue2.io.enq.bits.ip := io.rocc_in.bits.rs1
-  compress_src_info_queue2.io.enq.bits.isize := io.rocc_in.bits.rs2
+  compress_src_info_queue2.io.enq.bits.isize := gather_len_so_far + io.rocc_in.bits.rs2
   compress_src_info_queue2.io.enq.valid := compress_src_info_fire.fire(compress_src_info_queue2.io.enq.ready)
+  compress_src_info_total_queue.io.enq.bits := gather_len_so_far + io.rocc_in.bits.rs2
+  compress_src_info_total_queue.io.enq.valid := compress_src_info_fire.fire(compress_src_info_total_queue.io.enq.ready)
 
   val compress_dest_info_fire = DecoupledHelper(
     io.rocc_in.valid,
@@ -125,8 +168,26 @@ class SnappyCompressorCommandRouter()(implicit p: Parameters) extends Module {
     current_funct === FUNCT_DEST_INFO_AND_START
   )
 
+  val compress_dest_segment_fire = DecoupledHelper(
+    io.rocc_in.valid,
+    compress_dest_segment_queue.io.enq.ready,
+    current_funct === FUNCT_DEST_SEGMENT
+  )
+
+  val dest_segments_so_far = RegInit(0.U(8.W))
+  when (compress_dest_segment_fire.fire) {
+    dest_segments_so_far := dest_segments_so_far + 1.U
+  } .elsewhen (compress_dest_info_fire.fire) {
+    dest_segments_so_far := 0.U
+  }
+
+  compress_dest_segment_queue.io.enq.bits.ip := io.rocc_in.bits.rs1
+  compress_dest_segment_queue.io.enq.bits.isize := io.rocc_in.bits.rs2
+  compress_dest_segment_queue.io.enq.valid := compress_dest_segment_fire.fire(compress_dest_segment_queue.io.enq.ready)
+
   compress_dest_info_queue.io.enq.bits.op := io.rocc_in.bits.rs1
   compress_dest_info_queue.io.enq.bits.boolptr := io.rocc_in.bits.rs2
+  compress_dest_info_queue.io.enq.bits.num_segments := dest_segments_so_far
   compress_dest_info_queue.io.enq.valid := compress_dest_info_fire.fire(compress_dest_info_queue.io.enq.ready)
 
   val do_check_completion_fire = DecoupledHelper(
@@ -146,7 +207,7 @@ class SnappyCompressorCommandRouter()(implicit p: Parameters) extends Module {
   io.rocc_out.bits.rd := io.rocc_in.bits.inst.rd
   io.rocc_out.bits.data := track_dispatched_src_infos
 
-  io.rocc_in.ready := sfence_fire.fire(io.rocc_in.valid) || compress_src_info_fire.fire(io.rocc_in.valid) ||  compress_dest_info_fire.fire(io.rocc_in.valid) || do_check_completion_fire.fire(io.rocc_in.valid) || max_offset_allowed_fire.fire(io.rocc_in.valid) || runtime_ht_num_entries_fire.fire(io.rocc_in.valid)
+  io.rocc_in.ready := sfence_fire.fire(io.rocc_in.valid) || compress_src_info_fire.fire(io.rocc_in.valid) || compress_src_segment_fire.fire(io.rocc_in.valid) ||  compress_dest_info_fire.fire(io.rocc_in.valid) || compress_dest_segment_fire.fire(io.rocc_in.valid) || do_check_completion_fire.fire(io.rocc_in.valid) || max_offset_allowed_fire.fire(io.rocc_in.valid) || runtime_ht_num_entries_fire.fire(io.rocc_in.valid)
 
 }
 
@@ -21,6 +21,7 @@ class SnappyCompressorMemwriter()(implicit p: Parameters) extends Module
     val memwrites_in = Flipped(Decoupled(new CompressWriterBundle))
     val l2io = new L2MemHelperBundle
     val compress_dest_info = Flipped(Decoupled(new SnappyCompressDestInfo))
+    val compress_dest_segment = Flipped(Decoupled(new StreamInfo))
 
     val bufs_completed = Output(UInt(64.W))
     val no_writes_inflight = Output(Bool())
@@ -158,12 +159,28 @@ class SnappyCompressorMemwriter()(implicit p: Parameters) extends Module
 
 
   val backend_bytes_written = RegInit(0.U(64.W))
-  val backend_next_write_addr = compress_dest_info_Q.io.deq.bits.op + backend_bytes_written
 
-  val throttle_end = Mux(buf_lens_Q.io.deq.valid,
+  // scattered output: the first num_segments regions are the call's
+  // DEST_SEGMENTs, each filled to its length in order, then op takes the rest.
+  // region_bytes_written is the offset in the current region.
+  val dest_segments_done = RegInit(0.U(8.W))
+  val region_bytes_written = RegInit(0.U(64.W))
+  val in_dest_segment = dest_segments_done < compress_dest_info_Q.io.deq.bits.num_segments
+  val region_bytes_left = io.compress_dest_segment.bits.isize - region_bytes_written
+  val dest_region_ready = !in_dest_segment || io.compress_dest_segment.valid
+
+  val backend_next_write_addr = Mux(in_dest_segment,
+    io.compress_dest_segment.bits.ip,
+    compress_dest_info_Q.io.deq.bits.op) + region_bytes_written
+
+  val buf_throttle_end = Mux(buf_lens_Q.io.deq.valid,
     buf_lens_Q.io.deq.bits - backend_bytes_written,
     32.U)
 
+  val throttle_end = Mux(in_dest_segment && (region_bytes_left < buf_throttle_end),
+    region_bytes_left,
+    buf_throttle_end)
+
   val throttle_end_writeable = Mux(throttle_end >= 32.U, 32.U,
                                     Mux(throttle_end(4), 16.U,
                                       Mux(throttle_end(3), 8.U,
@@ -243,14 +260,21 @@ class SnappyCompressorMemwriter()(implicit p: Parameters) extends Module
     io.l2io.req.ready,
     enough_data,
     !write_ptr_override,
-    compress_dest_info_Q.io.deq.valid
+    compress_dest_info_Q.io.deq.valid,
+    dest_region_ready
   )
 
+  // segments the output did not reach (or empty ones) are dropped one per
+  // cycle, so the next call starts with its own
+  val dest_segment_skip = compress_dest_info_Q.io.deq.valid && in_dest_segment &&
+    io.compress_dest_segment.valid && (write_ptr_override || (region_bytes_left === 0.U))
+
   val bool_ptr_write_fire = DecoupledHelper(
     io.l2io.req.ready,
     buf_lens_Q.io.deq.valid,
     buf_lens_Q.io.deq.bits === backend_bytes_written,
-    compress_dest_info_Q.io.deq.valid
+    compress_dest_info_Q.io.deq.valid,
+    !in_dest_segment
   )
 
   for (queueno <- 0 until NUM_QUEUES) {
@@ -260,7 +284,6 @@ class SnappyCompressorMemwriter()(implicit p: Parameters) extends Module
   when (mem_write_fire.fire) {
     read_start_index := (read_start_index +& bytes_to_write) % NUM_QUEUES.U
     backend_bytes_written := backend_bytes_written + bytes_to_write
-    backend_bytes_written := backend_bytes_written + bytes_to_write
     CompressAccelLogger.logInfo("[memwriter-snappycomp] writefire: addr: 0x%x, data 0x%x, size %d\n",
       io.l2io.req.bits.addr,
       io.l2io.req.bits.data,
@@ -275,6 +298,16 @@ class SnappyCompressorMemwriter()(implicit p: Parameters) extends Module
   io.l2io.req.bits.data := Mux(write_ptr_override, final_output_len, remapped_write_data)
   io.l2io.req.bits.cmd := M_XWR
 
+  val dest_segment_filled = mem_write_fire.fire && in_dest_segment && (bytes_to_write === region_bytes_left)
+  io.compress_dest_segment.ready := dest_segment_filled || dest_segment_skip
+
+  when (dest_segment_filled || dest_segment_skip) {
+    dest_segments_done := dest_segments_done + 1.U
+    region_bytes_written := 0.U
+  } .elsewhen (mem_write_fire.fire) {
+    region_bytes_written := region_bytes_written + bytes_to_write
+  }
+
   buf_lens_Q.io.deq.ready := bool_ptr_write_fire.fire(buf_lens_Q.io.deq.valid)
   compress_dest_info_Q.io.deq.ready := bool_ptr_write_fire.fire(compress_dest_info_Q.io.deq.valid)
 
@@ -288,6 +321,8 @@ class SnappyCompressorMemwriter()(implicit p: Parameters) extends Module
   when (bool_ptr_write_fire.fire) {
     bufs_completed := bufs_completed + 1.U
     backend_bytes_written := 0.U
+    dest_segments_done := 0.U
+    region_bytes_written := 0.U
     CompressAccelLogger.logInfo("[memwriter-snappycomp] write resultlen addr: 0x%x, write final output len 0x%x\n", compress_dest_info_Q.io.deq.bits.boolptr, final_output_len)
   }
 
@@ -89,6 +89,10 @@ with MemoryOpConstants {
 
   cmd_router.io.bufs_completed := command_expander.io.bufs_completed
   cmd_router.io.no_writes_inflight := command_expander.io.no_writes_inflight
+  cmd_router.io.perf_counters := RegNext(DecompressorPerfCounters(
+    offchip_history_lookup.io.perf,
+    outer.mem_decomp_readbackref.module.io.perf,
+    Seq(outer.mem_decomp_ireader, outer.mem_decomp_writer, outer.mem_decomp_readbackref).map(_.module.io.perf)))
 
   outer.mem_decomp_ireader.module.io.sfence <> cmd_router.io.sfence_out
   outer.mem_decomp_ireader.module.io.status.valid := cmd_router.io.dmem_status_out.valid
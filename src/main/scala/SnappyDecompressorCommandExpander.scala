@@ -24,7 +24,7 @@ class SnappyDecompressorOffchipHistoryLookup()(implicit p: Parameters) extends M
 
     val onChipHistLenConfig = Input(UInt(32.W))
 
-
+    val perf = Output(new HistoryLookupPerf)
   })
 
   val hist_memloader = Module(new MemLoader())
@@ -223,6 +223,18 @@ class SnappyDecompressorOffchipHistoryLookup()(implicit p: Parameters) extends M
       )
     }
   }
+
+  val perf_onchip_hits = RegInit(0.U(64.W))
+  val perf_offchip_misses = RegInit(0.U(64.W))
+  when (io.internal_commands.fire && io.internal_commands.bits.is_copy) {
+    when (io.internal_commands.bits.copy_offset <= onChipHistLen) {
+      perf_onchip_hits := perf_onchip_hits + 1.U
+    } .otherwise {
+      perf_offchip_misses := perf_offchip_misses + 1.U
+    }
+  }
+  io.perf.onchip_hits := perf_onchip_hits
+  io.perf.offchip_misses := perf_offchip_misses
 }
 
 class SnappyDecompressorCommandExpander()(implicit p: Parameters) extends Module with MemoryOpConstants {
@@ -23,6 +23,7 @@ class SnappyDecompressorCommandRouter()(implicit p: Parameters) extends Module {
   val FUNCT_DEST_INFO_AND_START = 2.U
   val FUNCT_CHECK_COMPLETION = 3.U
   val FUNCT_SET_ONCHIP_HIST = 4.U
+  val FUNCT_READ_PERF_COUNTER = 5.U
 
   val io = IO(new Bundle{
     val rocc_in = Flipped(Decoupled(new RoCCCommand))
@@ -39,6 +40,8 @@ class SnappyDecompressorCommandRouter()(implicit p: Parameters) extends Module {
     val no_writes_inflight = Input(Bool())
 
     val onChipHistLenConfig = Output(UInt(32.W))
+
+    val perf_counters = Input(Vec(DecompressorPerfCounters.NUM_COUNTERS, UInt(64.W)))
   })
 
   val track_dispatched_src_infos = RegInit(0.U(64.W))
@@ -131,11 +134,19 @@ class SnappyDecompressorCommandRouter()(implicit p: Parameters) extends Module {
       io.no_writes_inflight, io.bufs_completed, track_dispatched_src_infos, io.rocc_out.ready)
   }
 
-  io.rocc_out.valid := do_check_completion_fire.fire(io.rocc_out.ready)
+  val read_perf_counter_fire = DecoupledHelper(
+    io.rocc_in.valid,
+    current_funct === FUNCT_READ_PERF_COUNTER,
+    io.rocc_out.ready
+  )
+  val perf_counter_value = Mux(io.rocc_in.bits.rs1 < DecompressorPerfCounters.NUM_COUNTERS.U,
+                               io.perf_counters(io.rocc_in.bits.rs1), 0.U)
+
+  io.rocc_out.valid := do_check_completion_fire.fire(io.rocc_out.ready) || read_perf_counter_fire.fire(io.rocc_out.ready)
   io.rocc_out.bits.rd := io.rocc_in.bits.inst.rd
-  io.rocc_out.bits.data := track_dispatched_src_infos
+  io.rocc_out.bits.data := Mux(current_funct === FUNCT_READ_PERF_COUNTER, perf_counter_value, track_dispatched_src_infos)
 
-  io.rocc_in.ready := sfence_fire.fire(io.rocc_in.valid) || decompress_src_info_fire.fire(io.rocc_in.valid) ||  decompress_dest_info_fire.fire(io.rocc_in.valid) || do_check_completion_fire.fire(io.rocc_in.valid) || set_onchip_hist_fire.fire(io.rocc_in.valid)
+  io.rocc_in.ready := sfence_fire.fire(io.rocc_in.valid) || decompress_src_info_fire.fire(io.rocc_in.valid) ||  decompress_dest_info_fire.fire(io.rocc_in.valid) || do_check_completion_fire.fire(io.rocc_in.valid) || set_onchip_hist_fire.fire(io.rocc_in.valid) || read_perf_counter_fire.fire(io.rocc_in.valid)
 
 }
 
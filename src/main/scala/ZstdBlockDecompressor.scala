@@ -97,6 +97,8 @@ class ZstdBlockDecompressorIO(implicit val p: Parameters) extends Bundle {
   val snappy_decompress_dest_info_offchip = Flipped(Decoupled(new SnappyDecompressDestInfo))
   val snappy_bufs_completed = Output(UInt(64.W))
   val snappy_no_writes_inflight = Output(Bool())
+
+  val hist_perf = Output(new HistoryLookupPerf)
 }
 
 /* The ZstdBlockDecompressor decompresses each Zstd block within the current frame.
@@ -458,6 +460,7 @@ class ZstdBlockDecompressor(zstdTop: ZstdDecompressor, cmd_que_depth: Int)
   }
   
   io.l2_fse_memhelpers.read_histlookup_userif <> seqExecHistoryLookup.io.l2helperUser
+  io.hist_perf := seqExecHistoryLookup.io.perf
 
   val seqExecWriter = Module(new ZstdSeqExecWriterSRAM32(65536))
   io.l2_fse_memhelpers.write_seqexec_userif <> seqExecWriter.io.l2helperUser
@@ -174,6 +174,60 @@ class ZstdCompressorImp(outer: ZstdCompressor)(implicit p: Parameters)
   controller.io.zstd_control.seqbytes_written <> seq_compressor.io.bytes_written
 
 
+  ////////////////////////////////////////////////////////////////////////////
+  // Performance counters
+  ////////////////////////////////////////////////////////////////////////////
+
+  val mf_perf = Module(new BusyStallCounter)
+  mf_perf.io.job_start := matchfinder.io.src.compress_src_info.fire
+  mf_perf.io.job_done := matchfinder.io.buff_consumed.seq_consumed_bytes.fire
+  mf_perf.io.stall := L2Stalled(Seq(outer.l2_mf_reader.module.io.userif,
+                                    outer.l2_mf_seqwriter.module.io.userif,
+                                    outer.l2_mf_litwriter.module.io.userif))
+
+  val huf_perf = Module(new BusyStallCounter)
+  huf_perf.io.job_start := lit_compressor.io.src_info.fire
+  huf_perf.io.job_done := lit_compressor.io.bytes_written.fire
+  huf_perf.io.stall := L2Stalled(Seq(outer.l2_huf_lit_reader.module.io.userif,
+                                     outer.l2_huf_dic_reader.module.io.userif,
+                                     outer.l2_huf_dic_writer.module.io.userif,
+                                     outer.l2_huf_hdr_writer.module.io.userif,
+                                     outer.l2_huf_jt_writer.module.io.userif,
+                                     outer.l2_huf_lit_writer.module.io.userif))
+
+  val fse_perf = Module(new BusyStallCounter)
+  fse_perf.io.job_start := seq_compressor.io.src_info.fire
+  fse_perf.io.job_done := seq_compressor.io.bytes_written.fire
+  fse_perf.io.stall := L2Stalled(Seq(outer.l2_seq_reader.module.io.userif,
+                                     outer.l2_seq_reader2.module.io.userif,
+                                     outer.l2_seq_writer.module.io.userif))
+
+  val l2_perf = L2MemHelperPerf.sum(Seq(
+    outer.l2_fhdr_writer, outer.l2_bhdr_writer,
+    outer.l2_mf_reader, outer.l2_mf_seqwriter, outer.l2_mf_litwriter,
+    outer.l2_huf_lit_reader, outer.l2_huf_dic_reader, outer.l2_huf_dic_writer,
+    outer.l2_huf_hdr_writer, outer.l2_huf_jt_writer, outer.l2_huf_lit_writer,
+    outer.l2_seq_reader, outer.l2_seq_reader2, outer.l2_seq_writer,
+    outer.l2_raw_block_reader, outer.l2_raw_block_writer,
+    outer.l2_raw_lit_reader, outer.l2_raw_lit_writer).map(_.module.io.perf))
+
+  import CompressorPerfCounters._
+  cmd_router.io.perf_counters(MF_JOBS) := mf_perf.io.jobs
+  cmd_router.io.perf_counters(MF_BUSY_CYCLES) := mf_perf.io.busy_cycles
+  cmd_router.io.perf_counters(MF_STALL_CYCLES) := mf_perf.io.stall_cycles
+  cmd_router.io.perf_counters(HUF_JOBS) := huf_perf.io.jobs
+  cmd_router.io.perf_counters(HUF_BUSY_CYCLES) := huf_perf.io.busy_cycles
+  cmd_router.io.perf_counters(HUF_STALL_CYCLES) := huf_perf.io.stall_cycles
+  cmd_router.io.perf_counters(FSE_JOBS) := fse_perf.io.jobs
+  cmd_router.io.perf_counters(FSE_BUSY_CYCLES) := fse_perf.io.busy_cycles
+  cmd_router.io.perf_counters(FSE_STALL_CYCLES) := fse_perf.io.stall_cycles
+  cmd_router.io.perf_counters(L2_REQS) := RegNext(l2_perf.reqs)
+  cmd_router.io.perf_counters(L2_ACKS) := RegNext(l2_perf.acks)
+  cmd_router.io.perf_counters(L2_INFLIGHT_CYCLES) := RegNext(l2_perf.inflight_cycles)
+  cmd_router.io.perf_counters(MF_L2_READ_REQS) := outer.l2_mf_reader.module.io.perf.reqs
+  cmd_router.io.perf_counters(MF_L2_READ_INFLIGHT_CYCLES) := outer.l2_mf_reader.module.io.perf.inflight_cycles
+
+
   ////////////////////////////////////////////////////////////////////////////
   // Latency Injection
   ////////////////////////////////////////////////////////////////////////////
@@ -43,6 +43,8 @@ class ZstdCompressorCommandRouterIO()(implicit val p: Parameters)
 
   val zstd_finished_cnt = Flipped(Decoupled(UInt(64.W)))
   val snappy_finished_cnt = Flipped(Decoupled(UInt(64.W)))
+
+  val perf_counters = Input(Vec(CompressorPerfCounters.NUM_COUNTERS, UInt(64.W)))
 }
 
 class ZstdCompressorCommandRouter(implicit p: Parameters) 
@@ -61,6 +63,7 @@ class ZstdCompressorCommandRouter(implicit p: Parameters)
   val FUNCT_SNPY_RUNTIME_HT_NUM_ENTRIES_LOG2 = 9.U
   val FUNCT_LATENCY_INJECTION_INFO           = 10.U
   val FUNCT_CHECK_COMPLETION                 = 11.U
+  val FUNCT_READ_PERF_COUNTER                = 12.U
 
   val snappy_dispatched_src_info = RegInit(0.U(64.W))
   val zstd_dispatched_src_info = RegInit(0.U(64.W))
@@ -238,8 +241,14 @@ class ZstdCompressorCommandRouter(implicit p: Parameters)
                                   compression_done
                                   )
 
-  zstd_finished_q.io.deq.ready := do_check_completion_fire.fire(compression_done)
-  snappy_finished_q.io.deq.ready := do_check_completion_fire.fire(compression_done)
+  // Jobs retired by polling their completion flag (several in flight on one
+  // instance) never get a CHECK_COMPLETION of their own. Drop finished counts
+  // that lag the dispatched count so they can't wedge the queue heads.
+  val zstd_finished_stale = zstd_finished_q.io.deq.valid && (zstd_finished_q.io.deq.bits =/= zstd_dispatched_src_info)
+  val snappy_finished_stale = snappy_finished_q.io.deq.valid && (snappy_finished_q.io.deq.bits =/= snappy_dispatched_src_info)
+
+  zstd_finished_q.io.deq.ready := do_check_completion_fire.fire(compression_done) || zstd_finished_stale
+  snappy_finished_q.io.deq.ready := do_check_completion_fire.fire(compression_done) || snappy_finished_stale
 
   when (do_check_completion_fire.fire) {
     CompressAccelLogger.logInfo("Zstd Compressor CommandRouter, do_check_completion_fire.fire\n")
@@ -247,6 +256,14 @@ class ZstdCompressorCommandRouter(implicit p: Parameters)
     CompressAccelLogger.logInfo("Snappy Compressor CommandRouter, Snappy_dispatched_src_info: %d\n", snappy_dispatched_src_info)
   }
 
+  val read_perf_counter_fire = DecoupledHelper(
+    io.rocc_in.valid,
+    cur_funct === FUNCT_READ_PERF_COUNTER,
+    io.rocc_out.ready
+  )
+  val perf_counter_value = Mux(cur_rs1 < CompressorPerfCounters.NUM_COUNTERS.U,
+                               io.perf_counters(cur_rs1), 0.U)
+
   io.rocc_in.ready := sfence_fire.fire(io.rocc_in.valid) ||
                       runtime_ht_num_entries_fire.fire(io.rocc_in.valid) ||
                       max_offset_allowed_fire.fire(io.rocc_in.valid) ||
@@ -256,9 +273,12 @@ class ZstdCompressorCommandRouter(implicit p: Parameters)
                       dst_info_fire.fire(io.rocc_in.valid) ||
                       clevel_info_fire.fire(io.rocc_in.valid) ||
                       latency_injection_info_fire.fire(io.rocc_in.valid) ||
-                      do_check_completion_fire.fire(io.rocc_in.valid)
+                      do_check_completion_fire.fire(io.rocc_in.valid) ||
+                      read_perf_counter_fire.fire(io.rocc_in.valid)
 
-  io.rocc_out.valid := do_check_completion_fire.fire
+  io.rocc_out.valid := do_check_completion_fire.fire || read_perf_counter_fire.fire
   io.rocc_out.bits.rd := io.rocc_in.bits.inst.rd
-  io.rocc_out.bits.data := Mux(ALGORITHM === ZSTD.U, zstd_dispatched_src_info, snappy_dispatched_src_info)
+  io.rocc_out.bits.data := Mux(cur_funct === FUNCT_READ_PERF_COUNTER,
+                               perf_counter_value,
+                               Mux(ALGORITHM === ZSTD.U, zstd_dispatched_src_info, snappy_dispatched_src_info))
 }
@@ -204,7 +204,9 @@ class ZstdCompressorFrameController(implicit p: Parameters) extends ZstdCompress
   val seq_buff_idx = RegInit(0.U(64.W))
   val seq_buff_base_addr = io.buff_info.seq.bits.ip
   val seq_buff_chunk_bytes = max_sequences * ZSTD_SEQUENCE_COMMAND_BYTES.U + 8.U // add extra 8B padding for safety
-  val seq_buff_chunk_cnt = io.buff_info.seq.bits.isize / seq_buff_chunk_bytes
+  // the free vector tracks at most 256 chunks; any workspace beyond that is unused
+  val seq_buff_chunk_cnt_raw = io.buff_info.seq.bits.isize / seq_buff_chunk_bytes
+  val seq_buff_chunk_cnt = Mux(seq_buff_chunk_cnt_raw > 256.U, 256.U, seq_buff_chunk_cnt_raw)
   val seq_buff_offset = seq_buff_chunk_bytes * seq_buff_idx
   val seq_buff_start_addr = seq_buff_base_addr + seq_buff_offset
 
@@ -213,7 +215,8 @@ class ZstdCompressorFrameController(implicit p: Parameters) extends ZstdCompress
   val lit_buff_idx = RegInit(0.U(64.W))
   val lit_buff_base_addr = io.buff_info.lit.bits.ip
   val lit_buff_chunk_bytes = block_bytes + 8.U
-  val lit_buff_chunk_cnt = io.buff_info.lit.bits.isize / lit_buff_chunk_bytes
+  val lit_buff_chunk_cnt_raw = io.buff_info.lit.bits.isize / lit_buff_chunk_bytes
+  val lit_buff_chunk_cnt = Mux(lit_buff_chunk_cnt_raw > 256.U, 256.U, lit_buff_chunk_cnt_raw)
   val lit_buff_offset = lit_buff_chunk_bytes * lit_buff_idx
   val lit_buff_start_addr = lit_buff_base_addr + lit_buff_offset
 
@@ -128,6 +128,18 @@ class ZstdDecompressorImp(outer: ZstdDecompressor)(implicit p: Parameters)
   outer.frame_decompressor.module.io.frame_content <> cmd_expander.io.frame_content
   cmd_expander.io.decompressed_frame <> outer.frame_decompressor.module.io.decompressed_frame
 
+  ////////////////////////////////////////////////////////////////////////////
+  // Performance counters
+  ////////////////////////////////////////////////////////////////////////////
+  cmd_router.io.perf_counters := RegNext(DecompressorPerfCounters(
+    outer.frame_decompressor.module.io.hist_perf,
+    outer.mem_decomp_ireader_histlookup.module.io.perf,
+    Seq(outer.l2_cmpflag_writer, outer.l2_fhdr_reader, outer.l2_bhdr_reader,
+        outer.l2_huf_literal_reader, outer.l2_huf_header_reader, outer.l2_huf_literal_writer,
+        outer.mem_decomp_ireader_dtbuilder, outer.mem_decomp_ireader_dtreader,
+        outer.mem_decomp_ireader_histlookup, outer.mem_decomp_ireader_seqexec,
+        outer.mem_decomp_writer_seqexec, outer.mem_decomp_ireader_rawrle).map(_.module.io.perf)))
+
   ////////////////////////////////////////////////////////////////////////////
   // Latency Injection
   ////////////////////////////////////////////////////////////////////////////
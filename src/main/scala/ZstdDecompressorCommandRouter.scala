@@ -38,6 +38,8 @@ class ZstdDecompressorCommandRouterIO()(implicit val p: Parameters)
   val snappy_decompress_dest_info_offchip = Decoupled(new SnappyDecompressDestInfo)
   val snappy_bufs_completed = Input(UInt(64.W))
   val snappy_no_writes_inflight = Input(Bool())
+
+  val perf_counters = Input(Vec(DecompressorPerfCounters.NUM_COUNTERS, UInt(64.W)))
 }
 
 class ZstdDecompressorCommandRouter(val cmd_que_depth: Int)(implicit p: Parameters) 
@@ -59,6 +61,8 @@ class ZstdDecompressorCommandRouter(val cmd_que_depth: Int)(implicit p: Paramete
   val FUNCT_SNAPPY_DEST_INFO_AND_START    = 9.U 
   val FUNCT_SNAPPY_CHECK_COMPLETION       = 10.U 
   val FUNCT_SNAPPY_SET_ONCHIP_HIST        = 11.U 
+  //Common
+  val FUNCT_READ_PERF_COUNTER             = 12.U
 
   val algorithm = RegInit(0.U(1.W)) //0: Zstd, 1: Snappy
   val latency_injection_cycles = RegInit(0.U(32.W))
@@ -171,7 +175,11 @@ class ZstdDecompressorCommandRouter(val cmd_que_depth: Int)(implicit p: Paramete
     dispatched_src_info === finished_q.io.deq.bits
   )
 
-  finished_q.io.deq.ready := zstd_do_check_completion_fire.fire(finished_q.io.deq.valid)
+  // Jobs retired by polling their cmpflag (chunked submission keeps several in
+  // flight) never get a CHECK_COMPLETION of their own. Drop finished counts that
+  // lag the dispatched count so they can't wedge the queue head.
+  val finished_cnt_stale = finished_q.io.deq.valid && (finished_q.io.deq.bits =/= dispatched_src_info)
+  finished_q.io.deq.ready := zstd_do_check_completion_fire.fire(finished_q.io.deq.valid) || finished_cnt_stale
 
   when (zstd_do_check_completion_fire.fire) {
     CompressAccelLogger.logInfo("Zstd Decompressor CommandRouter, zstd_do_check_completion_fire.fire\n")
@@ -284,5 +292,16 @@ class ZstdDecompressorCommandRouter(val cmd_que_depth: Int)(implicit p: Paramete
       max_offset_allowed_fire.fire(io.rocc_in.valid)
   }
   ////////// Common Part /////////
+  val read_perf_counter_fire = DecoupledHelper(
+    io.rocc_in.valid,
+    cur_funct === FUNCT_READ_PERF_COUNTER,
+    io.rocc_out.ready
+  )
+  when (cur_funct === FUNCT_READ_PERF_COUNTER) {
+    io.rocc_out.valid := read_perf_counter_fire.fire
+    io.rocc_out.bits.data := Mux(cur_rs1 < DecompressorPerfCounters.NUM_COUNTERS.U,
+                                 io.perf_counters(cur_rs1), 0.U)
+    io.rocc_in.ready := read_perf_counter_fire.fire(io.rocc_in.valid)
+  }
   io.rocc_out.bits.rd := io.rocc_in.bits.inst.rd
 }
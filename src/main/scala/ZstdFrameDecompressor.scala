@@ -48,6 +48,8 @@ class ZstdFrameDecompressorIO(implicit val p: Parameters) extends Bundle {
   val snappy_decompress_dest_info_offchip = Flipped(Decoupled(new SnappyDecompressDestInfo))
   val snappy_bufs_completed = Output(UInt(64.W))
   val snappy_no_writes_inflight = Output(Bool())
+
+  val hist_perf = Output(new HistoryLookupPerf)
 }
 
 
@@ -82,6 +84,7 @@ class ZstdFrameDecompressorImp(outer: ZstdFrameDecompressor, zstdTop: ZstdDecomp
   block_decompressor.io.snappy_decompress_dest_info_offchip <> io.snappy_decompress_dest_info_offchip
   io.snappy_bufs_completed := block_decompressor.io.snappy_bufs_completed
   io.snappy_no_writes_inflight := block_decompressor.io.snappy_no_writes_inflight
+  io.hist_perf := block_decompressor.io.hist_perf
 
   
 
@@ -81,6 +81,9 @@ class ZstdMatchFinder(removeSnappy: Boolean)(implicit p: Parameters) extends Mod
   val memloader = Module(new LZ77HashMatcherMemLoader)
   io.l2io.memloader_userif <> memloader.io.l2helperUser
   memloader.io.src_info <> io.src.compress_src_info
+  memloader.io.src_info_more_segments := false.B
+  memloader.io.src_info_total.valid := true.B
+  memloader.io.src_info_total.bits := io.src.compress_src_info.bits.isize
 
   val use_zstd = io.ALGORITHM === ZSTD.U
 
@@ -91,6 +94,8 @@ class ZstdMatchFinder(removeSnappy: Boolean)(implicit p: Parameters) extends Mod
   lz77hashmatcher.io.memloader_in <> memloader.io.consumer
   lz77hashmatcher.io.memloader_optional_hbsram_in <> memloader.io.optional_hbsram_write
   lz77hashmatcher.io.src_info <> io.src.compress_src_info2
+  lz77hashmatcher.io.src_info_dict_size := 0.U
+  lz77hashmatcher.io.src_info_dict_resident := false.B
 
   if (!removeSnappy) {
     println("Snappy accelerator merged\n")
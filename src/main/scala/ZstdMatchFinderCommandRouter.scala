@@ -20,6 +20,8 @@ class ZstdMatchFinderCommandRouter()(implicit p: Parameters) extends Module {
   val FUNCT_SEQ_DST_INFO = 3.U
   val FUNCT_MAX_OFFSET_ALLOWED = 4.U
   val FUNCT_CHECK_COMPLETION = 5.U
+  val FUNCT_RUNTIME_HT_NUM_ENTRIES_LOG2 = 6.U
+  val FUNCT_DICT_INFO = 7.U
 
   val io = IO(new Bundle{
     val rocc_in = Flipped(Decoupled(new RoCCCommand))
@@ -29,7 +31,11 @@ class ZstdMatchFinderCommandRouter()(implicit p: Parameters) extends Module {
     val dmem_status_out = Valid(new RoCCCommand)
 
     val compress_src_info = Decoupled(new StreamInfo)
+    val compress_src_info_more_segments = Output(Bool())
+    val compress_src_info_total = Decoupled(UInt(64.W))
     val compress_src_info2 = Decoupled(new StreamInfo)
+    val compress_src_info2_dict_size = Output(UInt(64.W))
+    val compress_src_info2_dict_resident = Output(Bool())
 
     val lit_dst_info = Decoupled(new DstInfo)
     val seq_dst_info = Decoupled(new DstInfo)
@@ -38,6 +44,7 @@ class ZstdMatchFinderCommandRouter()(implicit p: Parameters) extends Module {
     val no_writes_inflight = Input(Bool())
 
     val MAX_OFFSET_ALLOWED = Output(UInt(64.W))
+    val RUNTIME_HT_NUM_ENTRIES_LOG2 = Output(UInt(5.W))
   })
 
   val track_dispatched_src_infos = RegInit(0.U(64.W))
@@ -82,25 +89,118 @@ class ZstdMatchFinderCommandRouter()(implicit p: Parameters) extends Module {
     MAX_OFFSET_ALLOWED := io.rocc_in.bits.rs1
   }
 
-  val compress_src_info_queue = Module(new Queue(new StreamInfo, 4))
-  io.compress_src_info <> compress_src_info_queue.io.deq
+  val RUNTIME_HT_NUM_ENTRIES_LOG2 = RegInit(14.U(5.W))
+  io.RUNTIME_HT_NUM_ENTRIES_LOG2 := RUNTIME_HT_NUM_ENTRIES_LOG2
 
-  val compress_src_info_queue2 = Module(new Queue(new StreamInfo, 4))
-  io.compress_src_info2 <> compress_src_info_queue2.io.deq
+  val runtime_ht_num_entries_fire = DecoupledHelper(
+    io.rocc_in.valid,
+    current_funct === FUNCT_RUNTIME_HT_NUM_ENTRIES_LOG2
+  )
+
+  when (runtime_ht_num_entries_fire.fire) {
+    RUNTIME_HT_NUM_ENTRIES_LOG2 := io.rocc_in.bits.rs1
+  }
+
+  // DICT_INFO sets a dictionary that is streamed ahead of every following
+  // SRC_INFO (until it is set again, a size of 0 turns it off). The
+  // memloader gets it as a leading gather segment, the hash matcher gets its
+  // size so it only primes the hash table and history with those bytes.
+  //
+  // The hash matcher keeps the last dictionary it indexed in the table for
+  // later calls with the same address and size, or with no dictionary, so
+  // those only refill the history. Changing the table size or an SFENCE
+  // drops it.
+  val dict_addr = RegInit(0.U(64.W))
+  val dict_size = RegInit(0.U(64.W))
+
+  val dict_info_fire = DecoupledHelper(
+    io.rocc_in.valid,
+    current_funct === FUNCT_DICT_INFO
+  )
+
+  when (dict_info_fire.fire) {
+    dict_addr := io.rocc_in.bits.rs1
+    dict_size := io.rocc_in.bits.rs2
+  }
+
+  val compress_src_info_queue = Module(new Queue(new GatherStreamInfo, 8))
+  io.compress_src_info.valid := compress_src_info_queue.io.deq.valid
+  io.compress_src_info.bits.ip := compress_src_info_queue.io.deq.bits.ip
+  io.compress_src_info.bits.isize := compress_src_info_queue.io.deq.bits.isize
+  io.compress_src_info_more_segments := compress_src_info_queue.io.deq.bits.more_segments
+  compress_src_info_queue.io.deq.ready := io.compress_src_info.ready
+
+  // dictionary plus input, for the memloader to open the buffer with when it
+  // starts on the dictionary segment
+  val compress_src_info_total_queue = Module(new Queue(UInt(64.W), 4))
+  io.compress_src_info_total <> compress_src_info_total_queue.io.deq
+
+  val compress_src_info_queue2 = Module(new Queue(new DictStreamInfo, 4))
+  io.compress_src_info2.valid := compress_src_info_queue2.io.deq.valid
+  io.compress_src_info2.bits.ip := compress_src_info_queue2.io.deq.bits.ip
+  io.compress_src_info2.bits.isize := compress_src_info_queue2.io.deq.bits.isize
+  io.compress_src_info2_dict_size := compress_src_info_queue2.io.deq.bits.dict_size
+  io.compress_src_info2_dict_resident := compress_src_info_queue2.io.deq.bits.dict_resident
+  compress_src_info_queue2.io.deq.ready := io.compress_src_info2.ready
+
+  // with a dictionary set, SRC_INFO takes two cycles: the first queues the
+  // dictionary segment, the second the call's own input
+  val dict_segment_queued = RegInit(false.B)
+  val need_dict_segment = (dict_size =/= 0.U) && !dict_segment_queued
+
+  val compress_dict_segment_fire = DecoupledHelper(
+    io.rocc_in.valid,
+    compress_src_info_queue.io.enq.ready,
+    compress_src_info_total_queue.io.enq.ready,
+    current_funct === FUNCT_SRC_INFO,
+    need_dict_segment
+  )
+
+  when (compress_dict_segment_fire.fire) {
+    dict_segment_queued := true.B
+  }
 
   val compress_src_info_fire = DecoupledHelper(
     io.rocc_in.valid,
     compress_src_info_queue.io.enq.ready,
     compress_src_info_queue2.io.enq.ready,
-    current_funct === FUNCT_SRC_INFO
+    compress_src_info_total_queue.io.enq.ready,
+    current_funct === FUNCT_SRC_INFO,
+    !need_dict_segment
   )
 
-  compress_src_info_queue.io.enq.bits.ip := io.rocc_in.bits.rs1
-  compress_src_info_queue.io.enq.bits.isize := io.rocc_in.bits.rs2
-  compress_src_info_queue.io.enq.valid := compress_src_info_fire.fire(compress_src_info_queue.io.enq.ready)
+  when (compress_src_info_fire.fire) {
+    dict_segment_queued := false.B
+  }
+
+  val table_dict_valid = RegInit(false.B)
+  val table_dict_addr = RegInit(0.U(64.W))
+  val table_dict_size = RegInit(0.U(64.W))
+  val dict_resident = table_dict_valid &&
+    ((dict_size === 0.U) || ((dict_addr === table_dict_addr) && (dict_size === table_dict_size)))
+
+  when (compress_src_info_fire.fire && (dict_size =/= 0.U)) {
+    table_dict_valid := true.B
+    table_dict_addr := dict_addr
+    table_dict_size := dict_size
+  }
+  when (sfence_fire.fire || runtime_ht_num_entries_fire.fire) {
+    table_dict_valid := false.B
+  }
+
+  compress_src_info_queue.io.enq.bits.ip := Mux(need_dict_segment, dict_addr, io.rocc_in.bits.rs1)
+  compress_src_info_queue.io.enq.bits.isize := Mux(need_dict_segment, dict_size, io.rocc_in.bits.rs2)
+  compress_src_info_queue.io.enq.bits.more_segments := need_dict_segment
+  compress_src_info_queue.io.enq.valid := compress_src_info_fire.fire(compress_src_info_queue.io.enq.ready) || compress_dict_segment_fire.fire(compress_src_info_queue.io.enq.ready)
   compress_src_info_queue2.io.enq.bits.ip := io.rocc_in.bits.rs1
   compress_src_info_queue2.io.enq.bits.isize := io.rocc_in.bits.rs2
+  compress_src_info_queue2.io.enq.bits.dict_size := dict_size
+  compress_src_info_queue2.io.enq.bits.dict_resident := dict_resident
   compress_src_info_queue2.io.enq.valid := compress_src_info_fire.fire(compress_src_info_queue2.io.enq.ready)
+  // the total goes with the first segment: the dictionary's when there is one
+  compress_src_info_total_queue.io.enq.bits := dict_size + io.rocc_in.bits.rs2
+  compress_src_info_total_queue.io.enq.valid := compress_dict_segment_fire.fire(compress_src_info_total_queue.io.enq.ready) ||
+    (compress_src_info_fire.fire(compress_src_info_total_queue.io.enq.ready) && (dict_size === 0.U))
 
   val lit_dst_info_queue = Module(new Queue(new DstInfo, 4))
   io.lit_dst_info <> lit_dst_info_queue.io.deq
@@ -150,6 +250,8 @@ class ZstdMatchFinderCommandRouter()(implicit p: Parameters) extends Module {
                       lit_dst_info_fire.fire(io.rocc_in.valid) ||
                       seq_dst_info_fire.fire(io.rocc_in.valid) ||
                       do_check_completion_fire.fire(io.rocc_in.valid) ||
-                      max_offset_allowed_fire.fire(io.rocc_in.valid)
+                      max_offset_allowed_fire.fire(io.rocc_in.valid) ||
+                      runtime_ht_num_entries_fire.fire(io.rocc_in.valid) ||
+                      dict_info_fire.fire(io.rocc_in.valid)
 }
 
@@ -50,12 +50,18 @@ with MemoryOpConstants {
   val memloader = Module(new LZ77HashMatcherMemLoader)
   outer.mem_comp_ireader.module.io.userif <> memloader.io.l2helperUser
   memloader.io.src_info <> cmd_router.io.compress_src_info
+  memloader.io.src_info_more_segments := cmd_router.io.compress_src_info_more_segments
+  memloader.io.src_info_total <> cmd_router.io.compress_src_info_total
 
   val lz77hashmatcher = Module(new LZ77HashMatcher)
+  lz77hashmatcher.io.write_snappy_header := false.B
   lz77hashmatcher.io.MAX_OFFSET_ALLOWED := cmd_router.io.MAX_OFFSET_ALLOWED
+  lz77hashmatcher.io.RUNTIME_HT_NUM_ENTRIES_LOG2 := cmd_router.io.RUNTIME_HT_NUM_ENTRIES_LOG2
   lz77hashmatcher.io.memloader_in <> memloader.io.consumer
   lz77hashmatcher.io.memloader_optional_hbsram_in <> memloader.io.optional_hbsram_write
   lz77hashmatcher.io.src_info <> cmd_router.io.compress_src_info2
+  lz77hashmatcher.io.src_info_dict_size := cmd_router.io.compress_src_info2_dict_size
+  lz77hashmatcher.io.src_info_dict_resident := cmd_router.io.compress_src_info2_dict_resident
 
   val compress_litlen_injector = Module(new ZstdMatchFinderLitLenInjector)
   compress_litlen_injector.io.memwrites_in <> lz77hashmatcher.io.memwrites_out
@@ -64,11 +70,15 @@ with MemoryOpConstants {
   seq_memwriter.io.memwrites_in <> compress_litlen_injector.io.seq_memwrites_out
   outer.mem_seq_writer.module.io.userif <> seq_memwriter.io.l2io
   seq_memwriter.io.compress_dest_info <> cmd_router.io.seq_dst_info
+  // the host entropy codes each block itself, so both writers report the
+  // block's literal/sequence byte counts through their cmpflag
+  seq_memwriter.io.force_write := true.B
 
   val lit_memwriter = Module(new ZstdMatchFinderMemwriter("lit-writer"))
   lit_memwriter.io.memwrites_in <> compress_litlen_injector.io.lit_memwrites_out
   outer.mem_lit_writer.module.io.userif <> lit_memwriter.io.l2io
   lit_memwriter.io.compress_dest_info <> cmd_router.io.lit_dst_info
+  lit_memwriter.io.force_write := true.B
 
   lit_memwriter.io.written_bytes.ready := true.B
   seq_memwriter.io.written_bytes.ready := true.B
@@ -27,6 +27,7 @@ class ZstdOffchipHistoryLookup(history_len: Int)(implicit p: Parameters)
     val literal_chunks_out = (Decoupled(new LiteralChunk)) //to SeqExecWriter
     // val final_command_out = (Decoupled(Bool())) //to SeqExecWriter
     val MAX_OFFSET_ALLOWED = Input(UInt(64.W))
+    val perf = Output(new HistoryLookupPerf)
   })
   val nosnappy = p(NoSnappy)
 
@@ -188,4 +189,16 @@ class ZstdOffchipHistoryLookup(history_len: Int)(implicit p: Parameters)
     final_literal_chunks.io.enq.valid := far_copy_fire_s2.fire(final_literal_chunks.io.enq.ready)
     intermediate_internal_commands.io.deq.ready := far_copy_fire_s2.fire(intermediate_internal_commands.io.deq.valid)
   }
+
+  val perf_onchip_hits = RegInit(0.U(64.W))
+  val perf_offchip_misses = RegInit(0.U(64.W))
+  when (io.internal_commands.fire && io.internal_commands.bits.is_match) {
+    when (io.internal_commands.bits.offset <= io.MAX_OFFSET_ALLOWED) {
+      perf_onchip_hits := perf_onchip_hits + 1.U
+    } .otherwise {
+      perf_offchip_misses := perf_offchip_misses + 1.U
+    }
+  }
+  io.perf.onchip_hits := perf_onchip_hits
+  io.perf.offchip_misses := perf_offchip_misses
 }